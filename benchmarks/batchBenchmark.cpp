@@ -0,0 +1,122 @@
+#include "benchUtils.hpp"
+#include "core/matchingEngine.hpp"
+#include "utils/types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t kMidPrice = 100'000;
+constexpr std::size_t kResting = 1'000'000;
+constexpr std::size_t kCommands = 1'000'000;
+
+EngineConfig makeConfig() {
+    return EngineConfig{.book = {.referencePrice = kMidPrice},
+                        .orderPool = {.initialCapacity = kResting + kCommands},
+                        .orderMapCapacity = 4 * kResting};
+}
+
+OrderCommand newOrder(std::uint64_t id, std::mt19937_64& rng) {
+    // passive on both sides, the book keeps its size
+    const bool buy = rng() % 2 == 0;
+    const std::uint64_t offset = 1 + rng() % 1'000;
+    return OrderCommand{.command = CommandType::NEW_ORDER,
+                        .orderID = OrderID{id},
+                        .clientID = ClientID{1 + id % 64},
+                        .clientOrderID = ClientOrderID{id},
+                        .qty = Qty{10},
+                        .price = Price{buy ? kMidPrice - offset : kMidPrice + offset},
+                        .instrumentID = InstrumentID{1},
+                        .side = buy ? OrderSide::BUY : OrderSide::SELL};
+}
+
+// A million resting orders, then a stream that cancels a random resting order for
+// every new one. Cancels hit cold entries of a large order index, which is where
+// looking a few commands ahead pays off.
+struct Workload {
+    std::vector<OrderCommand> fill;
+    std::vector<OrderCommand> commands;
+
+    Workload() {
+        std::mt19937_64 rng(17);
+        std::vector<OrderCommand> live;
+        for (std::uint64_t id = 1; id <= kResting; ++id) {
+            fill.push_back(newOrder(id, rng));
+        }
+        live = fill;
+
+        std::uint64_t nextID = kResting;
+        while (commands.size() < kCommands) {
+            const std::size_t pick = rng() % live.size();
+            commands.push_back(OrderCommand{.command = CommandType::CANCEL,
+                                            .orderID = live[pick].orderID,
+                                            .clientID = live[pick].clientID});
+            live[pick] = newOrder(++nextID, rng);
+            commands.push_back(live[pick]);
+        }
+    }
+};
+
+void load(MatchingEngine& engine, const Workload& work) {
+    std::vector<CommandResult> results(work.fill.size());
+    engine.processBatch(work.fill, results);
+}
+
+void benchOneByOne(const Workload& work) {
+    MatchingEngine engine(nullptr, nullptr, InstrumentID{1}, makeConfig());
+    load(engine, work);
+
+    auto ns = bench::timeNs([&] {
+        for (const OrderCommand& command : work.commands) {
+            if (command.command == CommandType::CANCEL) {
+                bench::doNotOptimize(engine.cancelOrder(command.clientID, command.orderID));
+            } else {
+                bench::doNotOptimize(engine.processOrder(
+                    engine.makeOrder(command.orderID, command.clientID,
+                                     command.clientOrderID, command.qty, command.price,
+                                     command.goodTill, Timestamp{0}, command.instrumentID,
+                                     command.tif, command.side, command.type,
+                                     OrderStatus::NEW),
+                    [](const TradeEvent&) {}));
+            }
+        }
+    });
+    bench::report("one call per command", work.commands.size(), ns);
+}
+
+void benchBatched(const Workload& work, std::size_t batchSize) {
+    MatchingEngine engine(nullptr, nullptr, InstrumentID{1}, makeConfig());
+    load(engine, work);
+
+    std::vector<CommandResult> results(batchSize);
+    const std::span<const OrderCommand> commands{work.commands};
+    auto ns = bench::timeNs([&] {
+        for (std::size_t begin = 0; begin < commands.size(); begin += batchSize) {
+            const std::size_t count = std::min(batchSize, commands.size() - begin);
+            bench::doNotOptimize(
+                engine.processBatch(commands.subspan(begin, count), results));
+        }
+    });
+    bench::report("processBatch(), " + std::to_string(batchSize) + " per call",
+                  work.commands.size(), ns);
+}
+
+} // namespace
+
+int main() {
+    const Workload work;
+    std::cout << "--- " << kCommands << " cancels and new orders, " << kResting
+              << " resting ---\n";
+    benchOneByOne(work);
+    benchBatched(work, 1);
+    benchBatched(work, 16);
+    benchBatched(work, 64);
+    return 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+namespace bench {
+
+template <typename T> inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// runs f() once and returns the elapsed wall time in nanoseconds
+template <typename F> std::uint64_t timeNs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+inline void report(std::string_view name, std::size_t ops, std::uint64_t ns) {
+    double nsPerOp = static_cast<double>(ns) / static_cast<double>(ops);
+    double opsPerSec = 1e9 / nsPerOp;
+    std::cout << std::left << std::setw(44) << name << std::right << std::setw(10)
+              << std::fixed << std::setprecision(2) << nsPerOp << " ns/op"
+              << std::setw(14) << std::setprecision(0) << opsPerSec << " ops/s\n";
+}
+
+struct Percentiles {
+    std::uint64_t p50;
+    std::uint64_t p99;
+    std::uint64_t p999;
+    std::uint64_t max;
+};
+
+inline Percentiles percentiles(std::vector<std::uint64_t>& samples) {
+    if (samples.empty()) {
+        return {};
+    }
+    std::ranges::sort(samples);
+    auto at = [&](double q) {
+        auto idx = static_cast<std::size_t>(q * static_cast<double>(samples.size() - 1));
+        return samples[idx];
+    };
+    return {at(0.50), at(0.99), at(0.999), samples.back()};
+}
+
+inline void reportLatency(std::string_view name, std::vector<std::uint64_t>& samples) {
+    Percentiles p = percentiles(samples);
+    std::cout << std::left << std::setw(44) << name << std::right << " p50=" << p.p50
+              << "ns p99=" << p.p99 << "ns p99.9=" << p.p999 << "ns max=" << p.max
+              << "ns\n";
+}
+
+} // namespace bench
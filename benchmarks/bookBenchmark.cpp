@@ -0,0 +1,250 @@
+#include "benchUtils.hpp"
+#include "core/matchingEngine.hpp"
+#include "utils/priceLadder.hpp"
+#include "utils/types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t kMidPrice = 100'000;
+constexpr std::size_t kOps = 2'000'000;
+
+using Level = std::deque<std::uint64_t>;
+
+struct BookOp {
+    Price price;
+    bool consume;
+};
+
+std::vector<BookOp> makeOps(std::uint64_t spread, std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<std::uint64_t> priceDist(kMidPrice - spread,
+                                                           kMidPrice + spread);
+    std::bernoulli_distribution consumeDist(0.3);
+
+    std::vector<BookOp> ops;
+    ops.reserve(kOps);
+    for (std::size_t i = 0; i < kOps; ++i) {
+        ops.push_back({Price{priceDist(rng)}, consumeDist(rng)});
+    }
+    return ops;
+}
+
+// adds resting quantity at random prices and takes it out from the top of the book,
+// the same access pattern matchOrder_ and addToBook_ have on a book side
+template <typename Side>
+std::uint64_t runBookSide(Side& side, const std::vector<BookOp>& ops) {
+    std::uint64_t checksum = 0;
+    for (const auto& op : ops) {
+        if (op.consume) {
+            if (side.empty()) {
+                continue;
+            }
+            auto it = side.begin();
+            checksum += it->first.value();
+            it->second.pop_front();
+            if (it->second.empty()) {
+                side.erase(it->first);
+            }
+        } else {
+            side[op.price].push_back(op.price.value());
+        }
+    }
+    return checksum;
+}
+
+void benchBookSides(std::uint64_t spread) {
+    auto ops = makeOps(spread, 42);
+    std::cout << "--- book side, prices within +/-" << spread << " ticks ---\n";
+
+    {
+        std::map<Price, Level, std::less<Price>> side;
+        std::uint64_t checksum = 0;
+        auto ns = bench::timeNs([&] { checksum = runBookSide(side, ops); });
+        bench::doNotOptimize(checksum);
+        bench::report("std::map", ops.size(), ns);
+    }
+
+    {
+        utils::PriceLadder<Price, Level, std::less<Price>> side(
+            utils::PriceLadderConfig{.referencePrice = kMidPrice, .ticks = 4096});
+        std::uint64_t checksum = 0;
+        auto ns = bench::timeNs([&] { checksum = runBookSide(side, ops); });
+        bench::doNotOptimize(checksum);
+        bench::report("PriceLadder", ops.size(), ns);
+    }
+}
+
+void benchEngine() {
+    constexpr std::size_t kOrders = 500'000;
+
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<std::uint64_t> priceDist(kMidPrice - 200,
+                                                           kMidPrice + 200);
+    std::uniform_int_distribution<std::uint64_t> qtyDist(1, 100);
+    std::bernoulli_distribution sideDist(0.5);
+
+    std::vector<std::unique_ptr<Order>> orders;
+    orders.reserve(kOrders);
+    for (std::size_t i = 0; i < kOrders; ++i) {
+        bool isBuy = sideDist(rng);
+        orders.push_back(std::make_unique<Order>(
+            OrderID{i + 1}, ClientID{isBuy ? 1u : 2u}, ClientOrderID{i + 1},
+            Qty{qtyDist(rng)}, Price{priceDist(rng)}, Timestamp{0}, Timestamp{0},
+            InstrumentID{1}, TimeInForce::GOOD_TILL_CANCELLED,
+            isBuy ? OrderSide::BUY : OrderSide::SELL, OrderType::LIMIT,
+            OrderStatus::NEW));
+    }
+
+    MatchingEngine engine(nullptr, nullptr, InstrumentID{1},
+                          EngineConfig{.book = {.referencePrice = kMidPrice}});
+
+    std::size_t trades = 0;
+    auto ns = bench::timeNs([&] {
+        for (auto& order : orders) {
+            trades += engine.processOrder(std::move(order)).tradeVec.size();
+        }
+    });
+    bench::doNotOptimize(trades);
+
+#ifdef MINIEXCHANGE_MAP_BOOK
+    bench::report("MatchingEngine::processOrder (std::map)", kOrders, ns);
+#else
+    bench::report("MatchingEngine::processOrder (PriceLadder)", kOrders, ns);
+#endif
+}
+
+// every round a maker refills the best ask and a taker buys at takerPrice, with the
+// default arguments the taker takes exactly the refill and never rests
+void benchTaker(const char* name, TimeInForce tif, std::uint64_t takerQty = 10,
+                std::uint64_t takerPrice = kMidPrice) {
+    constexpr std::size_t kRounds = 1'000'000;
+    constexpr std::uint64_t kLevels = 100;
+
+    MatchingEngine engine(nullptr, nullptr, InstrumentID{1},
+                          EngineConfig{.book = {.referencePrice = kMidPrice}});
+
+    std::uint64_t nextID = 0;
+    auto submit = [&](ClientID client, OrderSide side, Qty qty, Price price,
+                      TimeInForce orderTif) {
+        ++nextID;
+        return engine.processOrder(
+            engine.makeOrder(OrderID{nextID}, client, ClientOrderID{nextID}, qty, price,
+                             Timestamp{0}, Timestamp{0}, InstrumentID{1}, orderTif, side,
+                             OrderType::LIMIT, OrderStatus::NEW),
+            [](const TradeEvent&) {});
+    };
+
+    // resting depth behind the best ask for the taker to look past
+    for (std::uint64_t level = 1; level <= kLevels; ++level) {
+        for (int i = 0; i < 10; ++i) {
+            (void)submit(ClientID{2}, OrderSide::SELL, Qty{10}, Price{kMidPrice + level},
+                         TimeInForce::GOOD_TILL_CANCELLED);
+        }
+    }
+
+    std::size_t filled = 0;
+    auto ns = bench::timeNs([&] {
+        for (std::size_t r = 0; r < kRounds; ++r) {
+            (void)submit(ClientID{2}, OrderSide::SELL, Qty{10}, Price{kMidPrice},
+                         TimeInForce::GOOD_TILL_CANCELLED);
+            filled += submit(ClientID{1}, OrderSide::BUY, Qty{takerQty},
+                             Price{takerPrice}, tif)
+                          .status == OrderStatus::FILLED;
+        }
+    });
+    bench::doNotOptimize(filled);
+    bench::report(name, kRounds, ns);
+}
+
+// 64 levels of 1000 orders each, compares folding over the orders of every level (what
+// makeSnapshot used to do) with copying the cached level aggregates
+void benchDepth() {
+    constexpr std::size_t kLevels = 64;
+    constexpr std::size_t kOrdersPerLevel = 1'000;
+    constexpr std::size_t kSnapshots = 10'000;
+
+    std::vector<Order> orders;
+    orders.reserve(kLevels * kOrdersPerLevel);
+    auto bids = makeBookSide<BookSide<std::greater<Price>>>(
+        utils::PriceLadderConfig{.referencePrice = kMidPrice});
+
+    for (std::uint64_t level = 0; level < kLevels; ++level) {
+        for (std::size_t i = 0; i < kOrdersPerLevel; ++i) {
+            const std::uint64_t id = orders.size() + 1;
+            orders.push_back(Order{OrderID{id}, ClientID{1}, ClientOrderID{id}, Qty{10},
+                                   Price{kMidPrice - level}, Timestamp{0}, Timestamp{0},
+                                   InstrumentID{1}, TimeInForce::GOOD_TILL_CANCELLED,
+                                   OrderSide::BUY, OrderType::LIMIT, OrderStatus::NEW});
+            bids[orders.back().price].push_back(&orders.back());
+        }
+    }
+
+    std::array<LevelSummary, kLevels> out{};
+    std::uint64_t checksum = 0;
+
+    auto foldNs = bench::timeNs([&] {
+        for (std::size_t i = 0; i < kSnapshots; ++i) {
+            std::size_t n = 0;
+            for (const auto& [price, queue] : bids) {
+                Qty total{0};
+                for (const Order* order : queue) {
+                    total += order->qty;
+                }
+                out[n++] = LevelSummary{price, total, queue.size()};
+            }
+            checksum += out[kLevels - 1].qty.value();
+        }
+    });
+    bench::doNotOptimize(checksum);
+    bench::report("64 levels, sum over every order", kSnapshots, foldNs);
+
+    auto cachedNs = bench::timeNs([&] {
+        for (std::size_t i = 0; i < kSnapshots; ++i) {
+            std::size_t n = 0;
+            for (const auto& [price, queue] : bids) {
+                out[n++] = LevelSummary{price, queue.totalQty(), queue.size()};
+            }
+            checksum += out[kLevels - 1].qty.value();
+        }
+    });
+    bench::doNotOptimize(checksum);
+    bench::report("64 levels, cached level aggregates", kSnapshots, cachedNs);
+
+    // the queues only link the orders, drop the links before the storage goes away
+    bids.clear();
+}
+
+} // namespace
+
+int main() {
+    benchBookSides(64);
+    benchBookSides(1024);
+    // most of the prices land in the overflow map
+    benchBookSides(16384);
+
+    std::cout << "--- engine throughput ---\n";
+    benchEngine();
+
+    std::cout << "--- maker refill + taker, by time in force ---\n";
+    benchTaker("limit (GTC), fully filled", TimeInForce::GOOD_TILL_CANCELLED);
+    benchTaker("IOC, fully filled", TimeInForce::IMMEDIATE_OR_CANCEL);
+    benchTaker("FOK, fully filled", TimeInForce::FILL_OR_KILL);
+    // crosses all 101 levels and is still short, the level totals reject it
+    benchTaker("FOK, killed after 101 levels", TimeInForce::FILL_OR_KILL, 1'000'000'000,
+               kMidPrice + 100);
+
+    std::cout << "--- depth snapshot ---\n";
+    benchDepth();
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "benchUtils.hpp"
+#include "core/matchingEngine.hpp"
+#include "utils/types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kDepth = 10'000;
+constexpr Price kLevelPrice{5'000};
+
+std::unique_ptr<Order> makeOrder(std::uint64_t id) {
+    return std::make_unique<Order>(OrderID{id}, ClientID{1}, ClientOrderID{id}, Qty{10},
+                                   kLevelPrice, Timestamp{0}, Timestamp{0},
+                                   InstrumentID{1}, TimeInForce::GOOD_TILL_CANCELLED,
+                                   OrderSide::BUY, OrderType::LIMIT, OrderStatus::NEW);
+}
+
+// cancel order: every other order from the middle of the level outwards
+std::vector<std::uint64_t> middleOutIDs() {
+    std::vector<std::uint64_t> ids;
+    ids.reserve(kDepth / 2);
+    for (std::size_t i = 0; i < kDepth / 2; i += 2) {
+        ids.push_back(kDepth / 2 + i + 1);
+        ids.push_back(kDepth / 2 - i);
+    }
+    return ids;
+}
+
+// what removeFromBook_ used to do: walk the deque level until the orderID matches
+void benchDequeScan(const std::vector<std::uint64_t>& ids) {
+    std::deque<std::unique_ptr<Order>> level;
+    for (std::uint64_t id = 1; id <= kDepth; ++id) {
+        level.push_back(makeOrder(id));
+    }
+
+    auto ns = bench::timeNs([&] {
+        for (std::uint64_t id : ids) {
+            auto it = std::ranges::find_if(level, [id](const auto& order) {
+                return order->orderID == OrderID{id};
+            });
+            level.erase(it);
+        }
+    });
+    bench::report("deque scan + erase (previous OrderQueue)", ids.size(), ns);
+}
+
+void benchEngineCancel(const std::vector<std::uint64_t>& ids) {
+    MatchingEngine engine;
+    for (std::uint64_t id = 1; id <= kDepth; ++id) {
+        engine.processOrder(makeOrder(id));
+    }
+
+    std::size_t cancelled = 0;
+    auto ns = bench::timeNs([&] {
+        for (std::uint64_t id : ids) {
+            cancelled += engine.cancelOrder(ClientID{1}, OrderID{id});
+        }
+    });
+    bench::doNotOptimize(cancelled);
+    bench::report("MatchingEngine::cancelOrder (intrusive)", ids.size(), ns);
+}
+
+} // namespace
+
+int main() {
+    auto ids = middleOutIDs();
+    std::cout << "--- cancel from the middle of a " << kDepth << " deep level ---\n";
+    benchDequeScan(ids);
+    benchEngineCancel(ids);
+    return 0;
+}
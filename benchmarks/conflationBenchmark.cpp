@@ -0,0 +1,129 @@
+#include "benchUtils.hpp"
+#include "core/matchingEngine.hpp"
+#include "market-data/bookEvent.hpp"
+#include "market-data/conflator.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t kMidPrice = 100'000;
+constexpr std::size_t kOrders = 100'000;
+constexpr std::size_t kRingCapacity = 4095;
+// quotes a side keeps resting, each on its own level next to the touch
+constexpr std::uint64_t kQuoteLevels = 5;
+
+using L2Queue = utils::spsc_queue_shm<L2OrderBookUpdate>;
+
+// the ring lives behind the queue object, as in the shared memory region
+struct L2Ring {
+    L2Ring()
+        : memory(new (std::align_val_t{64})
+                     std::byte[sizeof(L2Queue) + sizeof(L2OrderBookUpdate) *
+                                                     std::bit_ceil(kRingCapacity + 1)]),
+          queue(new (memory) L2Queue(kRingCapacity)) {}
+    ~L2Ring() {
+        queue->~L2Queue();
+        ::operator delete[](memory, std::align_val_t{64});
+    }
+
+    std::byte* memory;
+    L2Queue* queue;
+};
+
+// A market maker requoting a few levels on both sides while takers hit the touch, the
+// L2 updates the engine writes for it in order
+std::vector<L2OrderBookUpdate> recordBurst() {
+    L2Ring ring;
+    MatchingEngine engine(ring.queue, nullptr, InstrumentID{1},
+                          EngineConfig{.book = {.referencePrice = kMidPrice}});
+    std::mt19937_64 rng(11);
+    std::uniform_int_distribution<std::uint64_t> level(1, kQuoteLevels);
+    std::uniform_int_distribution<std::uint64_t> lot(1, 10);
+
+    std::vector<L2OrderBookUpdate> burst;
+    std::vector<OrderID> quotes;
+    auto submit = [&](OrderSide side, std::uint64_t price, ClientID client) {
+        const std::uint64_t id = engine.getNextOrderID().value();
+        bench::doNotOptimize(engine.processOrder(
+            engine.makeOrder(OrderID{id}, client, ClientOrderID{id}, Qty{lot(rng)},
+                             Price{price}, Timestamp{0}, Timestamp{0}, InstrumentID{1},
+                             TimeInForce::GOOD_TILL_CANCELLED, side, OrderType::LIMIT,
+                             OrderStatus::NEW),
+            [](const TradeEvent&) {}));
+        return OrderID{id};
+    };
+
+    for (std::size_t i = 0; i < kOrders; ++i) {
+        const bool buy = rng() % 2 == 0;
+        if (i % 4 == 3) {
+            // taker crossing into the best level of the other side
+            submit(buy ? OrderSide::BUY : OrderSide::SELL,
+                   buy ? kMidPrice + kQuoteLevels : kMidPrice - kQuoteLevels,
+                   ClientID{2});
+        } else if (quotes.size() > 200 && rng() % 2 == 0) {
+            const std::size_t pick = rng() % quotes.size();
+            engine.cancelOrder(ClientID{1}, quotes[pick]);
+            quotes[pick] = quotes.back();
+            quotes.pop_back();
+        } else {
+            quotes.push_back(submit(buy ? OrderSide::BUY : OrderSide::SELL,
+                                    buy ? kMidPrice - level(rng)
+                                        : kMidPrice + level(rng),
+                                    ClientID{1}));
+        }
+
+        for (auto updates = ring.queue->peek(); !updates.empty();
+             updates = ring.queue->peek()) {
+            burst.insert(burst.end(), updates.begin(), updates.end());
+            ring.queue->commit(updates.size());
+        }
+    }
+    return burst;
+}
+
+// replays the burst through a conflator flushed every `drain` updates, the way the
+// publisher flushes at the end of a drain (or of a window that lets `drain` updates in)
+void replay(const std::vector<L2OrderBookUpdate>& burst, std::size_t drain) {
+    market_data::Conflator conflator;
+    std::size_t packets = 0;
+    const std::uint64_t ns = bench::timeNs([&] {
+        for (std::size_t i = 0; i < burst.size(); ++i) {
+            conflator.add(burst[i]);
+            if ((i + 1) % drain == 0 || i + 1 == burst.size()) {
+                packets += conflator.flush([](const L2OrderBookUpdate& update) {
+                    bench::doNotOptimize(update);
+                });
+            }
+        }
+    });
+
+    bench::report("conflated, " + std::to_string(drain) + " updates a flush",
+                  burst.size(), ns);
+    std::cout << "    packets: " << burst.size() << " -> " << packets << " ("
+              << std::fixed << std::setprecision(1)
+              << static_cast<double>(burst.size()) / static_cast<double>(packets)
+              << "x fewer)\n";
+}
+
+} // namespace
+
+int main() {
+    const std::vector<L2OrderBookUpdate> burst = recordBurst();
+    std::cout << "--- " << burst.size() << " L2 updates from " << kOrders
+              << " orders on " << 2 * kQuoteLevels << " levels ---\n";
+    for (std::size_t drain : std::vector<std::size_t>{1, 8, 64, 512, 4096}) {
+        replay(burst, drain);
+    }
+    return 0;
+}
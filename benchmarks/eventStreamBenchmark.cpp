@@ -0,0 +1,151 @@
+#include "benchUtils.hpp"
+#include "core/matchingEngine.hpp"
+#include "market-data/bookEvent.hpp"
+#include "market-data/eventObserver.hpp"
+#include "market-data/l3Observer.hpp"
+#include "market-data/observer.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <string>
+
+namespace {
+
+constexpr std::uint64_t kMidPrice = 100'000;
+constexpr std::size_t kRounds = 200;
+// makers rested and then taken out one fill each, per round
+constexpr std::size_t kMakers = 256;
+constexpr std::size_t kRingCapacity = 4095;
+
+// the ring lives behind the queue object, as in the shared memory region
+template <typename T> struct Ring {
+    Ring()
+        : memory(new (std::align_val_t{64})
+                     std::byte[sizeof(utils::spsc_queue_shm<T>) +
+                               sizeof(T) * std::bit_ceil(kRingCapacity + 1)]),
+          queue(new (memory) utils::spsc_queue_shm<T>(kRingCapacity)) {}
+    ~Ring() {
+        queue->~spsc_queue_shm<T>();
+        ::operator delete[](memory, std::align_val_t{64});
+    }
+
+    std::byte* memory;
+    utils::spsc_queue_shm<T>* queue;
+};
+
+template <typename T> void discard(utils::spsc_queue<T>& queue) {
+    for (auto items = queue.peek(); !items.empty(); items = queue.peek()) {
+        queue.commit(items.size());
+    }
+}
+
+// Rests kMakers sells, then takes each out with one buy: every maker is one add and one
+// fill. drain() runs the market data stage after every order, as an observer keeping
+// up with the engine would.
+template <typename Drain>
+std::uint64_t run(MatchingEngine& engine, Drain&& drain, std::uint64_t& nextID) {
+    auto order = [&](OrderSide side, ClientID client) {
+        const std::uint64_t id = nextID++;
+        return engine.makeOrder(OrderID{id}, client, ClientOrderID{id}, Qty{10},
+                                Price{kMidPrice}, Timestamp{0}, Timestamp{0},
+                                InstrumentID{1}, TimeInForce::GOOD_TILL_CANCELLED, side,
+                                OrderType::LIMIT, OrderStatus::NEW);
+    };
+
+    return bench::timeNs([&] {
+        for (std::size_t round = 0; round < kRounds; ++round) {
+            for (std::size_t i = 0; i < kMakers; ++i) {
+                bench::doNotOptimize(engine.processOrder(
+                    order(OrderSide::SELL, ClientID{1}), [](const TradeEvent&) {}));
+                drain();
+            }
+            for (std::size_t i = 0; i < kMakers; ++i) {
+                bench::doNotOptimize(engine.processOrder(
+                    order(OrderSide::BUY, ClientID{2}), [](const TradeEvent&) {}));
+                drain();
+            }
+        }
+    });
+}
+
+void reportRun(const std::string& name, std::uint64_t ns, std::size_t ringBytesPerFill,
+               std::size_t pushesPerFill) {
+    bench::report(name, kRounds * kMakers * 2, ns);
+    std::cout << "    per fill: " << pushesPerFill << " ring push(es), "
+              << ringBytesPerFill << " bytes of shared memory\n";
+}
+
+void legacy() {
+    Ring<L2OrderBookUpdate> l2Ring;
+    Ring<L3Update> l3Ring;
+    utils::spsc_queue<L2OrderBookUpdate> l2Out(kRingCapacity + 1);
+    utils::spsc_queue<L3Update> l3Out(kRingCapacity + 1);
+
+    MatchingEngine engine(l2Ring.queue, l3Ring.queue, InstrumentID{1},
+                          EngineConfig{.book = {.referencePrice = kMidPrice}});
+    Level2OrderBook l2Book;
+    Level3OrderBook l3Book({.referencePrice = kMidPrice});
+    market_data::Observer observer(l2Ring.queue, &l2Out, l2Book, l3Book,
+                                   InstrumentID{1});
+    market_data::L3Observer l3Observer(l3Ring.queue, &l3Out, l3Book, InstrumentID{1});
+
+    std::uint64_t nextID = 1;
+    const std::uint64_t ns = run(
+        engine,
+        [&] {
+            observer.drainQueue();
+            l3Observer.drainQueue();
+            discard(l2Out);
+            discard(l3Out);
+        },
+        nextID);
+    reportRun("separate L2 + L3 rings", ns, sizeof(L2OrderBookUpdate) + sizeof(L3Update),
+              2);
+}
+
+void unified() {
+    Ring<EngineEvent> eventRing;
+    utils::spsc_queue<L2OrderBookUpdate> l2Out(kRingCapacity + 1);
+    utils::spsc_queue<L3Update> l3Out(kRingCapacity + 1);
+    utils::spsc_queue<EngineEvent> tradeOut(kRingCapacity + 1);
+
+    MatchingEngine engine(nullptr, nullptr, InstrumentID{1},
+                          EngineConfig{.book = {.referencePrice = kMidPrice},
+                                       .eventQueue = eventRing.queue});
+    Level2OrderBook l2Book;
+    Level3OrderBook l3Book({.referencePrice = kMidPrice});
+    market_data::Observer observer(nullptr, nullptr, l2Book, l3Book, InstrumentID{1});
+    market_data::L3Observer l3Observer(nullptr, nullptr, l3Book, InstrumentID{1});
+    market_data::EventObserver events(eventRing.queue, {.l2 = &observer,
+                                                        .l2Queue = &l2Out,
+                                                        .l3 = &l3Observer,
+                                                        .l3Queue = &l3Out,
+                                                        .trades = &tradeOut});
+
+    std::uint64_t nextID = 1;
+    const std::uint64_t ns = run(
+        engine,
+        [&] {
+            events.drainQueue();
+            discard(l2Out);
+            discard(l3Out);
+            discard(tradeOut);
+        },
+        nextID);
+    reportRun("unified event ring", ns, sizeof(EngineEvent), 1);
+}
+
+} // namespace
+
+int main() {
+    std::cout << "--- " << kRounds * kMakers << " adds and " << kRounds * kMakers
+              << " fills, market data drained after every order ---\n";
+    legacy();
+    unified();
+    return 0;
+}
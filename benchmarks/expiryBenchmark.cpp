@@ -0,0 +1,125 @@
+#include "benchUtils.hpp"
+#include "core/matchingEngine.hpp"
+#include "utils/types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t kMidPrice = 100'000;
+constexpr std::uint64_t kTickNs = 1'000'000; // 1ms wheel resolution
+
+std::uint64_t nowNs() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+OrderHandle makeBuy(MatchingEngine& engine, std::uint64_t id, std::uint64_t price,
+                    TimeInForce tif, Timestamp goodTill) {
+    return engine.makeOrder(OrderID{id}, ClientID{1}, ClientOrderID{id}, Qty{10},
+                            Price{price}, goodTill, Timestamp{0}, InstrumentID{1}, tif,
+                            OrderSide::BUY, OrderType::LIMIT, OrderStatus::NEW);
+}
+
+// GOOD_TILL_DATE orders with deadlines spread over a minute, the clock then moves in
+// 1ms steps; the cost per expiry includes taking the order off the book
+void benchGoodTillDate() {
+    constexpr std::size_t kOrders = 1'000'000;
+    constexpr std::uint64_t kSpanNs = 60'000'000'000;
+    constexpr Timestamp kStart = 1'000'000'000'000'000'000;
+
+    MatchingEngine engine(nullptr, nullptr, InstrumentID{1},
+                          EngineConfig{.book = {.referencePrice = kMidPrice},
+                                       .orderPool = {.initialCapacity = kOrders},
+                                       .orderMapCapacity = 2 * kOrders,
+                                       .expiry = {.tickNs = kTickNs}});
+
+    std::mt19937_64 rng(3);
+    for (std::uint64_t id = 1; id <= kOrders; ++id) {
+        (void)engine.processOrder(makeBuy(engine, id, kMidPrice - rng() % 200,
+                                          TimeInForce::GOOD_TILL_DATE,
+                                          kStart + rng() % kSpanNs),
+                                  [](const TradeEvent&) {});
+    }
+    (void)engine.expireOrders(kStart, [](const Order&) {});
+
+    std::size_t expired = 0;
+    auto ns = bench::timeNs([&] {
+        for (Timestamp now = kStart; now <= kStart + kSpanNs; now += kTickNs) {
+            expired += engine.expireOrders(now, [](const Order&) {});
+        }
+    });
+    bench::report("GTD expiry, 1M orders over 60k ticks", expired, ns);
+}
+
+// Two million END_OF_DAY orders all expire at the same tick. Between two expiry calls
+// the engine handles one new order, like the gateway loop does when a purge has used
+// up its budget.
+void benchEndOfDayPurge(std::chrono::nanoseconds budget) {
+    constexpr std::size_t kOrders = 2'000'000;
+    constexpr Timestamp kEndOfDay = 1'000'000'000'000'000'000;
+
+    MatchingEngine engine(nullptr, nullptr, InstrumentID{1},
+                          EngineConfig{.book = {.referencePrice = kMidPrice},
+                                       .orderPool = {.initialCapacity = kOrders + 16},
+                                       .orderMapCapacity = 2 * kOrders,
+                                       .expiry = {.tickNs = kTickNs,
+                                                  .endOfDay = kEndOfDay,
+                                                  .budget = budget}});
+
+    for (std::uint64_t id = 1; id <= kOrders; ++id) {
+        (void)engine.processOrder(
+            makeBuy(engine, id, kMidPrice - id % 500, TimeInForce::END_OF_DAY, 0),
+            [](const TradeEvent&) {});
+    }
+
+    std::vector<std::uint64_t> expirySamples;
+    std::vector<std::uint64_t> orderSamples;
+    std::uint64_t nextID = kOrders;
+    std::size_t expired = 0;
+
+    auto totalNs = bench::timeNs([&] {
+        while (engine.hasPendingExpiries(kEndOfDay)) {
+            std::uint64_t start = nowNs();
+            expired += engine.expireOrders(kEndOfDay, [](const Order&) {});
+            expirySamples.push_back(nowNs() - start);
+
+            ++nextID;
+            start = nowNs();
+            (void)engine.processOrder(
+                engine.makeOrder(OrderID{nextID}, ClientID{2}, ClientOrderID{nextID},
+                                 Qty{10}, Price{kMidPrice + 10}, Timestamp{0},
+                                 Timestamp{0}, InstrumentID{1},
+                                 TimeInForce::GOOD_TILL_CANCELLED, OrderSide::SELL,
+                                 OrderType::LIMIT, OrderStatus::NEW),
+                [](const TradeEvent&) {});
+            orderSamples.push_back(nowNs() - start);
+            (void)engine.cancelOrder(ClientID{2}, OrderID{nextID});
+        }
+    });
+
+    std::cout << "--- end of day purge, " << expired << " orders, budget "
+              << budget.count() / 1000 << "us, " << expirySamples.size()
+              << " calls ---\n";
+    bench::report("expired orders", expired, totalNs);
+    bench::reportLatency("expireOrders() call", expirySamples);
+    bench::reportLatency("new order between calls", orderSamples);
+}
+
+} // namespace
+
+int main() {
+    std::cout << "--- good till date ---\n";
+    benchGoodTillDate();
+
+    benchEndOfDayPurge(std::chrono::microseconds{50});
+    benchEndOfDayPurge(std::chrono::microseconds{200});
+    return 0;
+}
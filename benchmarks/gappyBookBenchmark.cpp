@@ -0,0 +1,121 @@
+#include "benchUtils.hpp"
+#include "core/matchingEngine.hpp"
+#include "utils/occupancyBitmap.hpp"
+#include "utils/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kTicks = 1 << 18;
+
+// visits every occupied tick in order, the way the ladder moves on to the next best
+// level each time one is swept
+void benchNextOccupied(std::size_t gap) {
+    std::vector<std::uint8_t> bytes(kTicks, 0);
+    utils::OccupancyBitmap bitmap(kTicks);
+    std::size_t levels = 0;
+    for (std::size_t tick = 0; tick < kTicks; tick += gap) {
+        bytes[tick] = 1;
+        bitmap.set(tick);
+        ++levels;
+    }
+
+    constexpr int kRounds = 50;
+    std::cout << "--- next occupied tick, one level every " << gap << " ticks ---\n";
+
+    std::size_t checksum = 0;
+    auto scanNs = bench::timeNs([&] {
+        for (int r = 0; r < kRounds; ++r) {
+            for (std::size_t tick = 0; tick < kTicks; ++tick) {
+                if (bytes[tick]) {
+                    checksum += tick;
+                }
+            }
+        }
+    });
+    bench::doNotOptimize(checksum);
+    bench::report("linear byte scan", levels * kRounds, scanNs);
+
+    auto bitmapNs = bench::timeNs([&] {
+        for (int r = 0; r < kRounds; ++r) {
+            for (std::size_t tick = bitmap.findNext(0);
+                 tick != utils::OccupancyBitmap::npos; tick = bitmap.findNext(tick + 1)) {
+                checksum += tick;
+            }
+        }
+    });
+    bench::doNotOptimize(checksum);
+    bench::report("OccupancyBitmap::findNext", levels * kRounds, bitmapNs);
+}
+
+// asks spread across a wide window with big gaps between them, every market buy sweeps
+// kSweep levels which are then put back
+void benchEngineSweep(std::uint64_t gap) {
+    constexpr std::uint64_t kMid = 1'000'000;
+    constexpr std::size_t kLevels = 200;
+    constexpr std::size_t kSweep = 50;
+    constexpr std::size_t kRounds = 20'000;
+    constexpr std::uint64_t kLevelQty = 10;
+
+    MatchingEngine engine(
+        nullptr, nullptr, InstrumentID{1},
+        EngineConfig{.book = {.referencePrice = kMid, .ticks = 2 * kLevels * gap}});
+
+    std::uint64_t nextID = 0;
+    auto addAsk = [&](std::uint64_t price) {
+        ++nextID;
+        (void)engine.processOrder(
+            engine.makeOrder(OrderID{nextID}, ClientID{2}, ClientOrderID{nextID},
+                             Qty{kLevelQty}, Price{price}, Timestamp{0}, Timestamp{0},
+                             InstrumentID{1}, TimeInForce::GOOD_TILL_CANCELLED,
+                             OrderSide::SELL, OrderType::LIMIT, OrderStatus::NEW),
+            [](const TradeEvent&) {});
+    };
+
+    for (std::size_t level = 0; level < kLevels; ++level) {
+        addAsk(kMid + level * gap);
+    }
+
+    std::size_t trades = 0;
+    auto ns = bench::timeNs([&] {
+        for (std::size_t r = 0; r < kRounds; ++r) {
+            ++nextID;
+            (void)engine.processOrder(
+                engine.makeOrder(OrderID{nextID}, ClientID{1}, ClientOrderID{nextID},
+                                 Qty{kSweep * kLevelQty}, Price{0}, Timestamp{0},
+                                 Timestamp{0}, InstrumentID{1},
+                                 TimeInForce::GOOD_TILL_CANCELLED, OrderSide::BUY,
+                                 OrderType::MARKET, OrderStatus::NEW),
+                [&trades](const TradeEvent&) { ++trades; });
+
+            for (std::size_t level = 0; level < kSweep; ++level) {
+                addAsk(kMid + level * gap);
+            }
+        }
+    });
+    bench::doNotOptimize(trades);
+
+#ifdef MINIEXCHANGE_MAP_BOOK
+    const char* name = "50 level market sweep + refill (std::map)";
+#else
+    const char* name = "50 level market sweep + refill (PriceLadder)";
+#endif
+    std::cout << "--- engine, " << kLevels << " asks " << gap << " ticks apart ---\n";
+    bench::report(name, kRounds, ns);
+}
+
+} // namespace
+
+int main() {
+    benchNextOccupied(16);
+    benchNextOccupied(256);
+    benchNextOccupied(4096);
+
+    benchEngineSweep(10);
+    benchEngineSweep(500);
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "benchUtils.hpp"
+#include "utils/flatIndex.hpp"
+#include "utils/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kLive = 1'000'000;
+constexpr std::size_t kOps = 2'000'000;
+
+// adapters so both containers run the exact same workload
+struct StdMap {
+    std::unordered_map<OrderID, Order*> map;
+    void insert(OrderID id, Order* order) { map[id] = order; }
+    Order* find(OrderID id) const {
+        auto it = map.find(id);
+        return it == map.end() ? nullptr : it->second;
+    }
+    void erase(OrderID id) { map.erase(id); }
+};
+
+struct Flat {
+    utils::FlatIndex<OrderID, Order> index{16 * 1024};
+    void insert(OrderID id, Order* order) { index.insert(id, order); }
+    Order* find(OrderID id) const { return index.find(id); }
+    void erase(OrderID id) { index.erase(id); }
+};
+
+// fills the index with kLive monotonic ids, then runs the engine's pattern: a lookup
+// of a random live order (cancel/modify/fill) and retiring the oldest order in favour
+// of a freshly numbered one
+template <typename Index> void run(const char* name, Order* dummy) {
+    Index index;
+
+    auto fillNs = bench::timeNs([&] {
+        for (std::uint64_t id = 1; id <= kLive; ++id) {
+            index.insert(OrderID{id}, dummy);
+        }
+    });
+    bench::report((std::string(name) + " insert").c_str(), kLive, fillNs);
+
+    std::mt19937_64 rng(5);
+    std::vector<std::uint64_t> probes(kOps);
+    for (auto& p : probes) {
+        p = rng() % kLive;
+    }
+
+    std::size_t hits = 0;
+    auto churnNs = bench::timeNs([&] {
+        std::uint64_t oldest = 1;
+        std::uint64_t next = kLive + 1;
+        for (std::uint64_t p : probes) {
+            hits += index.find(OrderID{oldest + p}) != nullptr;
+            index.erase(OrderID{oldest++});
+            index.insert(OrderID{next++}, dummy);
+        }
+    });
+    bench::doNotOptimize(hits);
+    bench::report((std::string(name) + " find + erase + insert").c_str(), kOps, churnNs);
+
+    if constexpr (requires { index.index.stats(); }) {
+        auto stats = index.index.stats();
+        std::cout << std::setprecision(3) << "    size=" << stats.size
+                  << " capacity=" << stats.capacity << " loadFactor=" << stats.loadFactor
+                  << " meanProbe=" << stats.meanProbe << " maxProbe=" << stats.maxProbe
+                  << "\n";
+    }
+}
+
+} // namespace
+
+int main() {
+    Order dummy{OrderID{1},
+                ClientID{1},
+                ClientOrderID{1},
+                Qty{1},
+                Price{1},
+                Timestamp{0},
+                Timestamp{0},
+                InstrumentID{1},
+                TimeInForce::GOOD_TILL_CANCELLED,
+                OrderSide::BUY,
+                OrderType::LIMIT,
+                OrderStatus::NEW};
+
+    std::cout << "--- order id index, " << kLive << " live orders ---\n";
+    run<StdMap>("std::unordered_map", &dummy);
+    run<Flat>("utils::FlatIndex", &dummy);
+    return 0;
+}
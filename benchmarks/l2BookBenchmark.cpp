@@ -0,0 +1,180 @@
+#include "benchUtils.hpp"
+#include "utils/types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t kMid = 1'000'000;
+constexpr std::uint64_t kLevels = 5'000;
+constexpr std::size_t kOps = 200'000;
+constexpr std::size_t kSnapshotDepth = 64;
+constexpr std::size_t kSnapshots = 20'000;
+
+// The sorted vector the observer and the receiver used to keep, best level first and
+// searched from the worst one
+class VectorBook {
+public:
+    void add(OrderSide side, Price price, Qty qty) {
+        auto& book = side_(side);
+        auto it = std::find_if(book.rbegin(), book.rend(), [&](const auto& level) {
+            return level.first == price || !betterOrEqual_(price, level.first, side);
+        });
+        if (it != book.rend() && it->first == price) {
+            it->second += qty;
+            return;
+        }
+        book.insert(it == book.rend() ? book.begin() : it.base(), {price, qty});
+    }
+
+    void reduce(OrderSide side, Price price, Qty qty) {
+        auto& book = side_(side);
+        for (auto it = book.rbegin(); it != book.rend(); ++it) {
+            if (it->first == price) {
+                it->second -= qty;
+                if (it->second == Qty{0}) {
+                    book.erase(std::next(it).base());
+                }
+                return;
+            }
+        }
+    }
+
+    std::vector<std::pair<Price, Qty>> depth(OrderSide side, std::size_t levels) {
+        const auto& book = side_(side);
+        const auto count = static_cast<std::ptrdiff_t>(std::min(levels, book.size()));
+        return {book.begin(), book.begin() + count};
+    }
+
+private:
+    std::vector<std::pair<Price, Qty>>& side_(OrderSide side) {
+        return side == OrderSide::BUY ? bids_ : asks_;
+    }
+    static bool betterOrEqual_(Price incoming, Price resting, OrderSide side) {
+        return side == OrderSide::BUY ? incoming >= resting : resting >= incoming;
+    }
+
+    std::vector<std::pair<Price, Qty>> bids_;
+    std::vector<std::pair<Price, Qty>> asks_;
+};
+
+struct Update {
+    OrderSide side;
+    bool add;
+    Price price;
+    Qty qty;
+};
+
+Price priceAt(OrderSide side, std::uint64_t distance) {
+    return Price{side == OrderSide::BUY ? kMid - distance : kMid + distance};
+}
+
+std::size_t slot(OrderSide side, std::uint64_t distance) {
+    return side == OrderSide::BUY ? distance : kLevels + 1 + distance;
+}
+
+// kLevels levels a side, then kOps adds and reduces at a distance from the touch drawn
+// from `distance`. Reduces take out part of a level or all of it, so levels keep
+// disappearing and coming back while the book stays around kLevels deep.
+template <typename Distance> std::vector<Update> makeUpdates(Distance distance) {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<std::uint64_t> lot(1, 10);
+    std::bernoulli_distribution buy(0.5);
+    std::vector<std::uint64_t> resting(2 * (kLevels + 1), 0);
+
+    std::vector<Update> updates;
+    updates.reserve(2 * kLevels + kOps);
+    for (OrderSide side : {OrderSide::BUY, OrderSide::SELL}) {
+        for (std::uint64_t d = 1; d <= kLevels; ++d) {
+            const std::uint64_t qty = 10 * lot(rng);
+            resting[slot(side, d)] = qty;
+            updates.push_back({side, true, priceAt(side, d), Qty{qty}});
+        }
+    }
+
+    while (updates.size() < 2 * kLevels + kOps) {
+        const OrderSide side = buy(rng) ? OrderSide::BUY : OrderSide::SELL;
+        const std::uint64_t d = std::min<std::uint64_t>(distance(rng) + 1, kLevels);
+        std::uint64_t& qty = resting[slot(side, d)];
+        const bool add = qty == 0 || lot(rng) > 5;
+        const std::uint64_t amount = add ? lot(rng) : std::min(qty, 3 * lot(rng));
+        qty = add ? qty + amount : qty - amount;
+        updates.push_back({side, add, priceAt(side, d), Qty{amount}});
+    }
+    return updates;
+}
+
+template <typename Book> void apply(Book& book, const std::vector<Update>& updates) {
+    for (const Update& update : updates) {
+        if (update.add) {
+            book.add(update.side, update.price, update.qty);
+        } else {
+            book.reduce(update.side, update.price, update.qty);
+        }
+    }
+}
+
+template <typename Distance> void run(const char* name, Distance distance) {
+    const std::vector<Update> updates = makeUpdates(distance);
+    const auto built = updates.begin() + 2 * static_cast<std::ptrdiff_t>(kLevels);
+    const std::vector<Update> build(updates.begin(), built);
+    const std::vector<Update> churn(built, updates.end());
+
+    std::cout << "--- " << kLevels << " levels a side, " << kOps << " updates " << name
+              << " ---\n";
+
+    VectorBook vectorBook;
+    apply(vectorBook, build);
+    bench::report("sorted vector, update",
+                  churn.size(), bench::timeNs([&] { apply(vectorBook, churn); }));
+
+    // wide enough for every level to sit in the tick window
+    Level2OrderBook ladderBook({.referencePrice = kMid, .ticks = 4 * kLevels});
+    apply(ladderBook, build);
+    bench::report("Level2OrderBook, update",
+                  churn.size(), bench::timeNs([&] { apply(ladderBook, churn); }));
+
+    if (vectorBook.depth(OrderSide::BUY, kLevels) !=
+            ladderBook.depth(OrderSide::BUY, kLevels) ||
+        vectorBook.depth(OrderSide::SELL, kLevels) !=
+            ladderBook.depth(OrderSide::SELL, kLevels)) {
+        std::cout << "books differ\n";
+    }
+
+    std::size_t checksum = 0;
+    bench::report("sorted vector, top " + std::to_string(kSnapshotDepth) + " snapshot",
+                  kSnapshots, bench::timeNs([&] {
+                      for (std::size_t i = 0; i < kSnapshots; ++i) {
+                          checksum += vectorBook.depth(OrderSide::BUY, kSnapshotDepth)
+                                          .back()
+                                          .second.value();
+                      }
+                  }));
+    bench::report("Level2OrderBook, top " + std::to_string(kSnapshotDepth) +
+                      " snapshot",
+                  kSnapshots, bench::timeNs([&] {
+                      for (std::size_t i = 0; i < kSnapshots; ++i) {
+                          checksum += ladderBook.depth(OrderSide::BUY, kSnapshotDepth)
+                                          .back()
+                                          .second.value();
+                      }
+                  }));
+    bench::doNotOptimize(checksum);
+}
+
+} // namespace
+
+int main() {
+    // most of the activity is near the touch, as on a real book
+    run("near the touch", std::geometric_distribution<std::uint64_t>(0.02));
+    run("spread over the book", std::uniform_int_distribution<std::uint64_t>(0, kLevels));
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "benchUtils.hpp"
+#include "api/api.hpp"
+#include "core/engineShards.hpp"
+#include "core/matchingEngine.hpp"
+#include "gateway/gateway.hpp"
+#include "protocol/clientMessages.hpp"
+#include "protocol/messages.hpp"
+#include "protocol/protocolHandler.hpp"
+#include "protocol/serialize.hpp"
+#include "protocol/serverMessages.hpp"
+#include "sessions/sessionManager.hpp"
+#include "utils/types.hpp"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kWarmup = 10'000;
+constexpr std::size_t kOrders = 100'000;
+
+// A blocking TCP client that sends one message and waits for its ack.
+class Client {
+public:
+    explicit Client(std::uint16_t port) {
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            throw std::runtime_error("connect failed");
+        }
+        int flag = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    }
+    ~Client() { ::close(fd_); }
+
+    template <typename Payload> void send(MessageType type, const Payload& payload) {
+        MessageHeader header{};
+        header.messageType = +type;
+        header.protocolVersionFlag = MessageHeader::traits::PROTOCOL_VERSION;
+        header.payloadLength = Payload::traits::payloadSize;
+        header.clientMsgSqn = ++clientSqn_;
+        buffer_.clear();
+        serializeMessageInto(buffer_, type, header, payload);
+        ::send(fd_, buffer_.data(), buffer_.size(), 0);
+    }
+
+    // reads until a whole message of the given payload type has arrived
+    template <typename Payload> Message<Payload> receive() {
+        constexpr std::size_t size = sizeof(MessageHeader) + sizeof(Payload);
+        std::byte bytes[size];
+        std::size_t got = 0;
+        while (got < size) {
+            ssize_t n = ::recv(fd_, bytes + got, size - got, 0);
+            if (n <= 0) {
+                throw std::runtime_error("connection lost");
+            }
+            got += static_cast<std::size_t>(n);
+        }
+        return *deserializeMessage<Payload>(std::span<const std::byte>{bytes, size});
+    }
+
+private:
+    int fd_{-1};
+    std::uint32_t clientSqn_{0};
+    std::vector<std::byte> buffer_;
+};
+
+client::NewOrderPayload makeOrder(std::uint64_t clientID, std::size_t i) {
+    // passive on both sides, every order gets exactly one ack and no trade
+    const bool buy = i % 2 == 0;
+    client::NewOrderPayload payload{};
+    payload.serverClientID = clientID;
+    payload.clientOrderID = i + 1;
+    payload.instrumentID = 1;
+    payload.orderSide = +(buy ? OrderSide::BUY : OrderSide::SELL);
+    payload.orderType = +OrderType::LIMIT;
+    payload.timeInForce = +TimeInForce::GOOD_TILL_CANCELLED;
+    payload.qty = 1;
+    payload.price = buy ? 90 + i % 10 : 110 + i % 10;
+    return payload;
+}
+
+void run(const char* name, std::uint16_t port, bool withEngineThread, int engineCpu) {
+    MatchingEngine engine(nullptr, nullptr, InstrumentID{1},
+                          EngineConfig{.orderPool = {.initialCapacity = 2 * kOrders}});
+    SessionManager sessions;
+    MiniExchangeAPI api(engine, sessions);
+    MatchingEngine* const engines[] = {&engine};
+    std::unique_ptr<EngineShards> shards;
+    if (withEngineThread) {
+        shards = std::make_unique<EngineShards>(engines, sessions,
+                                                EngineShardsConfig{.cpus = {engineCpu}});
+        shards->start();
+    }
+    ProtocolHandler handler(sessions, api, shards.get());
+    MiniExchangeGateway gateway(handler, sessions, port);
+    std::jthread gatewayThread([&gateway] { gateway.run(); });
+
+    std::vector<std::uint64_t> samples;
+    samples.reserve(kOrders);
+    {
+        Client client(port);
+        client.send(MessageType::HELLO, client::HelloPayload{});
+        const std::uint64_t clientID =
+            client.receive<server::HelloAckPayload>().payload.serverClientID;
+
+        for (std::size_t i = 0; i < kWarmup + kOrders; ++i) {
+            const client::NewOrderPayload order = makeOrder(clientID, i);
+            const auto start = std::chrono::steady_clock::now();
+            client.send(MessageType::NEW_ORDER, order);
+            bench::doNotOptimize(client.receive<server::OrderAckPayload>());
+            const auto end = std::chrono::steady_clock::now();
+            if (i >= kWarmup) {
+                samples.push_back(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                        .count()));
+            }
+        }
+    }
+
+    gateway.stop();
+    gatewayThread.join();
+    bench::reportLatency(name, samples);
+}
+
+} // namespace
+
+// usage: loopbackBenchmark [engine cpu], the engine thread floats if no cpu is given
+int main(int argc, char** argv) {
+    const int engineCpu = argc > 1 ? std::atoi(argv[1]) : -1;
+
+    if (std::thread::hardware_concurrency() < 3) {
+        // client, gateway and engine all spin, sharing cores measures the scheduler
+        std::cout << "warning: fewer than 3 cores, the engine thread numbers are not "
+                     "meaningful\n";
+    }
+    std::cout << "--- order to ack over loopback TCP, " << kOrders << " orders ---\n";
+    run("gateway thread matches", 24'601, false, engineCpu);
+    run("engine thread behind a ring", 24'602, true, engineCpu);
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "benchUtils.hpp"
+#include "core/matchingEngine.hpp"
+#include "market-data/bookEvent.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t kMidPrice = 100'000;
+constexpr std::size_t kQuotes = 10'000;
+constexpr std::size_t kLevelsPerSide = 50;
+constexpr std::size_t kRounds = 50;
+constexpr std::size_t kQueueCapacity = 64 * 1024;
+
+using L2Queue = utils::spsc_queue_shm<L2OrderBookUpdate>;
+
+// a market maker quotes kQuotes orders, 100 per level on both sides, and pulls them all
+struct QuotingBook {
+    void* queueMem = nullptr;
+    L2Queue* l2queue = nullptr;
+    MatchingEngine engine;
+    std::uint64_t nextID = 0;
+
+    QuotingBook()
+        : queueMem(std::malloc(sizeof(L2Queue) + sizeof(L2OrderBookUpdate) *
+                                                     std::bit_ceil(kQueueCapacity + 1))),
+          l2queue(new (queueMem) L2Queue(kQueueCapacity)),
+          engine(l2queue, nullptr, InstrumentID{1},
+                 EngineConfig{.book = {.referencePrice = kMidPrice}}) {}
+
+    ~QuotingBook() {
+        l2queue->~L2Queue();
+        std::free(queueMem);
+    }
+
+    QuotingBook(const QuotingBook&) = delete;
+    QuotingBook& operator=(const QuotingBook&) = delete;
+
+    std::uint64_t quote() {
+        const std::uint64_t first = nextID + 1;
+        for (std::size_t i = 0; i < kQuotes; ++i) {
+            const bool buy = i % 2 == 0;
+            const std::uint64_t offset = 1 + (i / 2) % kLevelsPerSide;
+            ++nextID;
+            (void)engine.processOrder(
+                engine.makeOrder(OrderID{nextID}, ClientID{1}, ClientOrderID{nextID},
+                                 Qty{10},
+                                 Price{buy ? kMidPrice - offset : kMidPrice + offset},
+                                 Timestamp{0}, Timestamp{0}, InstrumentID{1},
+                                 TimeInForce::GOOD_TILL_CANCELLED,
+                                 buy ? OrderSide::BUY : OrderSide::SELL,
+                                 OrderType::LIMIT, OrderStatus::NEW),
+                [](const TradeEvent&) {});
+        }
+        return first;
+    }
+
+    std::size_t drain() {
+        std::size_t events = 0;
+        for (L2OrderBookUpdate update{}; l2queue->try_pop(update);) {
+            ++events;
+        }
+        return events;
+    }
+};
+
+template <typename Pull> void benchPull(std::string_view name, Pull&& pull) {
+    QuotingBook book;
+    std::uint64_t ns = 0;
+    std::size_t events = 0;
+    for (std::size_t round = 0; round < kRounds; ++round) {
+        const std::uint64_t first = book.quote();
+        book.drain();
+        ns += bench::timeNs([&] { pull(book.engine, first); });
+        events += book.drain();
+    }
+    bench::report(name, kRounds, ns);
+    std::cout << std::left << std::setw(44) << "  L2 updates per pull" << std::right
+              << std::setw(10) << events / kRounds << "\n";
+}
+
+} // namespace
+
+int main() {
+    std::cout << "--- pulling " << kQuotes << " quotes on " << 2 * kLevelsPerSide
+              << " levels ---\n";
+
+    benchPull("one cancelOrder() per quote", [](MatchingEngine& engine,
+                                                 std::uint64_t first) {
+        for (std::uint64_t id = first; id < first + kQuotes; ++id) {
+            (void)engine.cancelOrder(ClientID{1}, OrderID{id});
+        }
+    });
+
+    benchPull("massCancel()", [](MatchingEngine& engine, std::uint64_t) {
+        bench::doNotOptimize(engine.massCancel(ClientID{1}));
+    });
+    return 0;
+}
@@ -0,0 +1,169 @@
+// the replacement operator new below is malloc based, GCC cannot see that the matching
+// deletes are replaced as well
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+#include "benchUtils.hpp"
+#include "core/matchingEngine.hpp"
+#include "utils/objectPool.hpp"
+#include "utils/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <utility>
+#include <vector>
+
+// counts every trip to the global allocator made by this process
+namespace {
+std::size_t gAllocations = 0;
+}
+
+void* operator new(std::size_t size) {
+    ++gAllocations;
+    if (void* p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr std::size_t kOrders = 1'000'000;
+constexpr std::size_t kLive = 10'000;
+
+Order makeOrder(std::uint64_t id, OrderSide side = OrderSide::BUY,
+                Price price = Price{100}, Qty qty = Qty{10},
+                ClientID client = ClientID{1}) {
+    return Order{OrderID{id},
+                 client,
+                 ClientOrderID{id},
+                 qty,
+                 price,
+                 Timestamp{0},
+                 Timestamp{0},
+                 InstrumentID{1},
+                 TimeInForce::GOOD_TILL_CANCELLED,
+                 side,
+                 OrderType::LIMIT,
+                 OrderStatus::NEW};
+}
+
+// keeps kLive orders alive and replaces a random one on every step, the churn a book
+// sees from new orders and cancels
+template <typename Make> void benchChurn(const char* name, Make make) {
+    using Ptr = decltype(make(std::uint64_t{0}));
+    std::vector<Ptr> live;
+    live.reserve(kLive);
+    for (std::uint64_t id = 0; id < kLive; ++id) {
+        live.push_back(make(id));
+    }
+
+    std::mt19937_64 rng(11);
+    std::vector<std::size_t> slots(kOrders);
+    for (auto& slot : slots) {
+        slot = rng() % kLive;
+    }
+
+    std::size_t before = gAllocations;
+    auto ns = bench::timeNs([&] {
+        for (std::size_t i = 0; i < kOrders; ++i) {
+            live[slots[i]] = make(kLive + i);
+        }
+    });
+    std::size_t allocs = gAllocations - before;
+
+    bench::doNotOptimize(live);
+    bench::report(name, kOrders, ns);
+    std::cout << "    heap allocations per order: "
+              << static_cast<double>(allocs) / static_cast<double>(kOrders) << "\n";
+}
+
+void benchEngine() {
+    MatchingEngine engine;
+
+    // warm up: grows the pool and the book to the working set
+    for (std::uint64_t id = 1; id <= kLive; ++id) {
+        engine.processOrder(engine.makeOrder(makeOrder(id)));
+    }
+
+    std::size_t before = gAllocations;
+    auto ns = bench::timeNs([&] {
+        for (std::uint64_t id = kLive + 1; id <= kLive + kOrders; ++id) {
+            engine.processOrder(engine.makeOrder(makeOrder(id)));
+            (void)engine.cancelOrder(ClientID{1}, OrderID{id - kLive});
+        }
+    });
+    std::size_t allocs = gAllocations - before;
+
+    bench::report("MatchingEngine add + cancel", kOrders, ns);
+    std::cout << "    heap allocations per order: "
+              << static_cast<double>(allocs) / static_cast<double>(kOrders) << "\n";
+
+    const auto& stats = engine.getOrderPoolStats();
+    std::cout << "    pool capacity=" << stats.capacity << " highWaterMark="
+              << stats.highWaterMark << " chunks=" << stats.chunks << "\n";
+}
+
+// rebuilds 50 ask levels and sweeps all of them with a single buy
+void benchSweep() {
+    constexpr std::size_t kLevels = 50;
+    constexpr std::size_t kRounds = 20'000;
+    constexpr std::uint64_t kBase = 1'000;
+
+    MatchingEngine engine(nullptr, nullptr, InstrumentID{1},
+                          EngineConfig{.book = {.referencePrice = kBase}});
+
+    std::uint64_t nextID = 1;
+    std::size_t trades = 0;
+    auto round = [&] {
+        for (std::uint64_t level = 1; level <= kLevels; ++level) {
+            auto ask = engine.makeOrder(makeOrder(
+                nextID++, OrderSide::SELL, Price{kBase + level}, Qty{10}, ClientID{2}));
+            (void)engine.processOrder(std::move(ask), [](const TradeEvent&) {});
+        }
+        (void)engine.processOrder(
+            engine.makeOrder(makeOrder(nextID++, OrderSide::BUY, Price{kBase + kLevels},
+                                       Qty{10 * kLevels}, ClientID{1})),
+            [&trades](const TradeEvent&) { ++trades; });
+    };
+
+    round(); // warm up
+
+    std::size_t before = gAllocations;
+    auto ns = bench::timeNs([&] {
+        for (std::size_t i = 0; i < kRounds; ++i) {
+            round();
+        }
+    });
+    std::size_t allocs = gAllocations - before;
+
+    bench::doNotOptimize(trades);
+    bench::report("50 level sweep (trade sink)", kRounds, ns);
+    std::cout << "    trades per sweep: " << trades / (kRounds + 1)
+              << ", heap allocations per sweep: "
+              << static_cast<double>(allocs) / static_cast<double>(kRounds) << "\n";
+}
+
+} // namespace
+
+int main() {
+    std::cout << "--- order allocation, " << kLive << " live orders ---\n";
+    benchChurn("std::make_unique<Order>",
+               [](std::uint64_t id) { return std::make_unique<Order>(makeOrder(id)); });
+
+    OrderPool pool;
+    benchChurn("OrderPool::make",
+               [&pool](std::uint64_t id) { return pool.make(makeOrder(id)); });
+
+    std::cout << "--- engine ---\n";
+    benchEngine();
+    benchSweep();
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include "benchUtils.hpp"
+#include "market-data/MDPublisher.hpp"
+#include "market-data/bookEvent.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// updates the observer hands over between two drains of the publisher
+constexpr std::size_t kDrain = 256;
+constexpr std::size_t kUpdates = kDrain * 800;
+constexpr std::uint16_t kPort = 9105;
+
+std::uint64_t threadCpuNs() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000 +
+           static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+// Publishes kUpdates L2 deltas over loopback multicast, kDrain at a time, and sends
+// the datagrams of a drain `batch` to a syscall
+void run(const std::string& name, const market_data::PacketConfig& packing,
+         std::size_t batch) {
+    utils::spsc_queue<L2OrderBookUpdate> queue(kDrain + 1);
+    market_data::MarketDataPublisher publisher(
+        &queue, utils::PriceLadderConfig{}, InstrumentID{1},
+        market_data::PublisherConfig{.packing = packing,
+                                     .transport = {.port = kPort, .batch = batch}});
+
+    L2OrderBookUpdate update{};
+    update.type = BookUpdateEventType::ADD;
+    update.amount = Qty{1};
+    const std::uint64_t cpuStart = threadCpuNs();
+    const std::uint64_t ns = bench::timeNs([&] {
+        for (std::size_t sent = 0; sent < kUpdates; sent += kDrain) {
+            for (std::size_t i = 0; i < kDrain; ++i) {
+                const bool buy = i % 2 == 0;
+                update.side = buy ? OrderSide::BUY : OrderSide::SELL;
+                update.price = Price{buy ? 99 - i % 8 : 101 + i % 8};
+                queue.try_push(update);
+            }
+            bench::doNotOptimize(publisher.publishDelta());
+        }
+    });
+    const std::uint64_t cpuNs = threadCpuNs() - cpuStart;
+
+    bench::report(name, kUpdates, ns);
+    const auto packets = static_cast<double>(publisher.packetCount());
+    const auto syscalls = static_cast<double>(publisher.syscallCount());
+    std::cout << "    " << publisher.packetCount() << " packets, " << std::fixed
+              << std::setprecision(0) << packets * 1e9 / static_cast<double>(ns)
+              << " packets/s, " << std::setprecision(1)
+              << static_cast<double>(kUpdates) / packets << " deltas a packet\n";
+    std::cout << "    " << publisher.syscallCount() << " syscalls, "
+              << std::setprecision(0) << syscalls * 1e9 / static_cast<double>(ns) << " syscalls/s, "
+              << std::setprecision(1)
+              << static_cast<double>(cpuNs) / static_cast<double>(kUpdates)
+              << " cpu ns/delta\n";
+}
+
+} // namespace
+
+int main() {
+    try {
+        std::cout << "--- " << kUpdates << " deltas, " << kDrain << " per drain ---\n";
+        run("one delta a datagram, sendto", {.mtu = 0}, 1);
+        run("one delta a datagram, sendmmsg x64", {.mtu = 0}, 64);
+        run("packed 1400, sendto", {.mtu = 1400}, 1);
+        run("packed 1400, sendmmsg x64", {.mtu = 1400}, 64);
+        run("packed 8972, sendto", {.mtu = 8972}, 1);
+        run("packed 8972, sendmmsg x64", {.mtu = 8972}, 64);
+    } catch (const std::exception& e) {
+        std::cerr << "no loopback multicast: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
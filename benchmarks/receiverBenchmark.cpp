@@ -0,0 +1,98 @@
+#include "benchUtils.hpp"
+#include "client/mdReceiver.hpp"
+#include "market-data/MDPublisher.hpp"
+#include "market-data/bookEvent.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// deltas a round, few enough that their datagrams fit in the receive buffer
+constexpr std::size_t kDrain = 64;
+constexpr std::size_t kRounds = 800;
+constexpr std::uint16_t kPort = 9106;
+
+enum class Receive { ONE, BATCH };
+
+// A local publisher sends a drain of L2 deltas over loopback multicast, the receiver
+// then reads the socket until it is empty. Only the receive side is timed.
+void run(const std::string& name, std::size_t mtu, Receive mode) {
+    utils::spsc_queue<L2OrderBookUpdate> queue(kDrain + 1);
+    MDReceiver receiver(MDConfig{.port = kPort});
+    receiver.initialize();
+    market_data::MarketDataPublisher publisher(
+        &queue, utils::PriceLadderConfig{}, InstrumentID{1},
+        market_data::PublisherConfig{.packing = {.mtu = mtu},
+                                     .transport = {.port = kPort}});
+
+    std::size_t deltas = 0;
+    std::size_t gaps = 0;
+    receiver.setOnDelta([&](Price, Qty, OrderSide, MDDeltatype, std::uint64_t) {
+        ++deltas;
+    });
+    receiver.setOnGapDetected([&](std::uint64_t, std::uint64_t) { ++gaps; });
+
+    std::size_t calls = 0;
+    auto drainSocket = [&] {
+        if (mode == Receive::ONE) {
+            while (receiver.receiveOne()) {
+                ++calls;
+            }
+        } else {
+            while (receiver.pollBatch() != 0) {
+                ++calls;
+            }
+        }
+        ++calls;
+    };
+
+    publisher.publishSnapshot();
+    drainSocket();
+    calls = 0;
+
+    L2OrderBookUpdate update{};
+    update.type = BookUpdateEventType::ADD;
+    update.amount = Qty{1};
+    std::uint64_t ns = 0;
+    for (std::size_t round = 0; round < kRounds; ++round) {
+        for (std::size_t i = 0; i < kDrain; ++i) {
+            const bool buy = i % 2 == 0;
+            update.side = buy ? OrderSide::BUY : OrderSide::SELL;
+            update.price = Price{buy ? 99 - i % 8 : 101 + i % 8};
+            queue.try_push(update);
+        }
+        bench::doNotOptimize(publisher.publishDelta());
+        ns += bench::timeNs(drainSocket);
+    }
+
+    bench::report(name, deltas, ns);
+    std::cout << "    " << deltas << "/" << kDrain * kRounds << " deltas applied, "
+              << gaps << " gaps, " << calls << " receive calls, " << std::fixed
+              << std::setprecision(1)
+              << static_cast<double>(deltas) / static_cast<double>(calls)
+              << " deltas a call\n";
+}
+
+} // namespace
+
+int main() {
+    try {
+        std::cout << "--- " << kDrain * kRounds << " deltas, " << kDrain
+                  << " per round ---\n";
+        run("one delta a datagram, receiveOne", 0, Receive::ONE);
+        run("one delta a datagram, pollBatch", 0, Receive::BATCH);
+        run("packed 1400, receiveOne", 1400, Receive::ONE);
+        run("packed 1400, pollBatch", 1400, Receive::BATCH);
+    } catch (const std::exception& e) {
+        std::cerr << "no loopback multicast: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
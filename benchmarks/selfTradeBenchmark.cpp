@@ -0,0 +1,69 @@
+#include "benchUtils.hpp"
+#include "core/matchingEngine.hpp"
+#include "utils/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace {
+
+constexpr std::uint64_t kMidPrice = 100'000;
+constexpr std::size_t kTakes = 200'000;
+constexpr ClientID kMaker{1};
+constexpr ClientID kOther{2};
+
+OrderHandle makeOrder(MatchingEngine& engine, std::uint64_t id, ClientID clientID,
+                      OrderSide side, std::uint64_t price, std::uint64_t qty,
+                      TimeInForce tif = TimeInForce::GOOD_TILL_CANCELLED) {
+    return engine.makeOrder(OrderID{id}, clientID, ClientOrderID{id}, Qty{qty},
+                            Price{price}, Timestamp{0}, Timestamp{0}, InstrumentID{1},
+                            tif, side, OrderType::LIMIT, OrderStatus::NEW);
+}
+
+// A market maker quotes ownQuotes asks on each of the two best levels, another client
+// has a deep ask behind them. The maker then lifts that ask one lot at a time with
+// IOC orders that cross its own quotes on the way.
+void benchTakeBehindOwnQuotes(std::size_t ownQuotes) {
+    MatchingEngine engine(nullptr, nullptr, InstrumentID{1},
+                          EngineConfig{.book = {.referencePrice = kMidPrice}});
+
+    std::uint64_t id = 0;
+    for (std::uint64_t offset = 1; offset <= 2; ++offset) {
+        for (std::size_t i = 0; i < ownQuotes; ++i) {
+            (void)engine.processOrder(
+                makeOrder(engine, ++id, kMaker, OrderSide::SELL, kMidPrice + offset, 10),
+                [](const TradeEvent&) {});
+        }
+    }
+    (void)engine.processOrder(
+        makeOrder(engine, ++id, kOther, OrderSide::SELL, kMidPrice + 3, kTakes),
+        [](const TradeEvent&) {});
+
+    std::size_t trades = 0;
+    auto ns = bench::timeNs([&] {
+        for (std::size_t i = 0; i < kTakes; ++i) {
+            bench::doNotOptimize(engine.processOrder(
+                makeOrder(engine, ++id, kMaker, OrderSide::BUY, kMidPrice + 3, 1,
+                          TimeInForce::IMMEDIATE_OR_CANCEL),
+                [&trades](const TradeEvent&) { ++trades; }));
+        }
+    });
+
+    if (trades != kTakes) {
+        std::cout << "unexpected trade count " << trades << "\n";
+    }
+    bench::report(std::to_string(ownQuotes) + " own quotes per level", kTakes, ns);
+}
+
+} // namespace
+
+int main() {
+    std::cout << "--- IOC buy behind two levels of own asks (SKIP) ---\n";
+    constexpr std::size_t kOwnQuotes[] = {0, 1, 100, 10'000};
+    for (std::size_t ownQuotes : kOwnQuotes) {
+        benchTakeBehindOwnQuotes(ownQuotes);
+    }
+    return 0;
+}
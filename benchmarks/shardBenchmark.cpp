@@ -0,0 +1,137 @@
+#include "benchUtils.hpp"
+#include "core/engineShards.hpp"
+#include "core/matchingEngine.hpp"
+#include "sessions/sessionManager.hpp"
+#include "utils/threading.hpp"
+#include "utils/types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t kMidPrice = 100'000;
+constexpr std::size_t kInstruments = 64;
+constexpr std::size_t kOrders = 1'000'000;
+
+// One stream of new orders over all instruments, the instrument of each order drawn
+// uniformly or from a Zipf distribution (s = 1), where the first instrument gets about
+// a fifth of the flow. Prices straddle the mid, so about half of the orders trade.
+std::vector<EngineRequest> makeRequests(bool zipf) {
+    std::vector<double> cdf(kInstruments);
+    double total = 0;
+    for (std::size_t i = 0; i < kInstruments; ++i) {
+        total += zipf ? 1.0 / static_cast<double>(i + 1) : 1.0;
+        cdf[i] = total;
+    }
+
+    std::mt19937_64 rng(23);
+    std::uniform_real_distribution<double> uniform(0, total);
+    std::vector<EngineRequest> requests;
+    requests.reserve(kOrders);
+    for (std::uint64_t id = 1; id <= kOrders; ++id) {
+        const auto instrument = static_cast<std::uint32_t>(
+            std::ranges::lower_bound(cdf, uniform(rng)) - cdf.begin());
+        const bool buy = rng() % 2 == 0;
+        const std::uint64_t price = kMidPrice - 5 + rng() % 11;
+        const ClientID clientID{1 + id % 64};
+        requests.push_back(EngineRequest{
+            .type = EngineRequestType::ORDER,
+            .sessionID = clientID,
+            .command = {.command = CommandType::NEW_ORDER,
+                        .clientID = clientID,
+                        .clientOrderID = ClientOrderID{id},
+                        .qty = Qty{10},
+                        .price = Price{price},
+                        .instrumentID = InstrumentID{1 + std::min<std::uint32_t>(
+                                                             instrument, kInstruments - 1)},
+                        .side = buy ? OrderSide::BUY : OrderSide::SELL}});
+    }
+    return requests;
+}
+
+// Pushes every request from this thread, the way the gateway does, and waits for the
+// ack of each one. Shard i is pinned to cpus[i] when enough cores were given.
+void run(std::string_view mix, const std::vector<EngineRequest>& requests,
+         std::size_t shardCount, const std::vector<int>& cpus) {
+    std::vector<std::unique_ptr<MatchingEngine>> owned;
+    std::vector<MatchingEngine*> engines;
+    for (std::uint32_t i = 1; i <= kInstruments; ++i) {
+        owned.push_back(std::make_unique<MatchingEngine>(
+            nullptr, nullptr, InstrumentID{i},
+            EngineConfig{.book = {.referencePrice = kMidPrice},
+                         .orderPool = {.initialCapacity = kOrders / kInstruments}}));
+        engines.push_back(owned.back().get());
+    }
+
+    EngineShardsConfig config{.cpus = std::vector<int>(shardCount, -1)};
+    if (cpus.size() >= shardCount) {
+        std::copy_n(cpus.begin(), shardCount, config.cpus.begin());
+    }
+    SessionManager sessions;
+    EngineShards shards(engines, sessions, config);
+    shards.start();
+
+    std::size_t acks = 0;
+    EngineResponse response;
+    auto drain = [&] {
+        for (std::size_t shard = 0; shard < shards.shardCount(); ++shard) {
+            while (shards.tryPop(shard, response)) {
+                acks += response.type == EngineResponseType::ORDER_ACK;
+            }
+        }
+    };
+
+    auto ns = bench::timeNs([&] {
+        for (const EngineRequest& request : requests) {
+            const std::size_t shard = shards.shardOf(request);
+            while (!shards.tryPush(shard, request)) {
+                drain();
+                utils::cpuRelax();
+            }
+        }
+        while (acks < requests.size()) {
+            drain();
+        }
+    });
+    shards.stop();
+
+    bench::report(std::string(mix) + ", " + std::to_string(shardCount) + " shard(s)",
+                  requests.size(), ns);
+}
+
+} // namespace
+
+// usage: shardBenchmark [maxShards] [cpu,cpu,...]
+int main(int argc, char** argv) {
+    const std::size_t maxShards =
+        argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1]))
+                 : std::max(1u, std::thread::hardware_concurrency() - 1);
+    std::vector<int> cpus;
+    if (argc > 2) {
+        for (std::string_view list = argv[2]; !list.empty();) {
+            const std::size_t comma = list.find(',');
+            cpus.push_back(std::atoi(std::string(list.substr(0, comma)).c_str()));
+            list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+        }
+    }
+
+    std::cout << "--- " << kOrders << " new orders over " << kInstruments
+              << " instruments ---\n";
+    for (const bool zipf : {false, true}) {
+        const std::vector<EngineRequest> requests = makeRequests(zipf);
+        for (std::size_t shardCount = 1; shardCount <= maxShards; ++shardCount) {
+            run(zipf ? "zipf" : "uniform", requests, shardCount, cpus);
+        }
+    }
+    return 0;
+}
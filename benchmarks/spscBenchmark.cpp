@@ -0,0 +1,269 @@
+#include "benchUtils.hpp"
+#include "market-data/bookEvent.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/threading.hpp"
+#include "utils/types.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <memory>
+#include <span>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t kItems = 20'000'000;
+constexpr std::size_t kCapacity = 4096;
+constexpr std::size_t kChunk = 32;
+
+// The queue as it was before the cached indices: every push loads head and every pop
+// loads tail, so the two index lines move between the cores on each item.
+template <typename T> class UncachedQueue {
+public:
+    explicit UncachedQueue(std::size_t capacity)
+        : buffer_(std::make_unique<T[]>(std::bit_ceil(capacity))),
+          size_(std::bit_ceil(capacity)), mask_(size_ - 1) {}
+
+    bool try_push(const T& item) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t head = head_.load(std::memory_order_acquire);
+        if (tail - head >= size_ - 1) {
+            return false;
+        }
+        buffer_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& item) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t tail = tail_.load(std::memory_order_acquire);
+        if (head == tail) {
+            return false;
+        }
+        item = buffer_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::unique_ptr<T[]> buffer_;
+    const std::size_t size_;
+    const std::size_t mask_;
+
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+// Cache misses of this process and the threads it starts while the counter is open,
+// -1 where perf events are not available (containers, perf_event_paranoid).
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd_ >= 0) {
+            ::ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+    ~CacheMissCounter() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    // an inherited counter includes the child threads once they have exited
+    [[nodiscard]] std::int64_t read() const {
+        std::int64_t count = -1;
+        if (fd_ < 0 || ::read(fd_, &count, sizeof(count)) != sizeof(count)) {
+            return -1;
+        }
+        return count;
+    }
+
+private:
+    int fd_{-1};
+};
+
+int g_producerCpu = -1;
+int g_consumerCpu = -1;
+
+L2OrderBookUpdate makeUpdate(std::size_t i) {
+    L2OrderBookUpdate update{};
+    update.price = Price{i};
+    update.amount = Qty{1};
+    return update;
+}
+
+// Runs produce() and consume() on two threads and reports ops/s and cache misses per
+// item. Both return once kItems have gone through.
+template <typename Produce, typename Consume>
+void run(const std::string& name, Produce&& produce, Consume&& consume) {
+    CacheMissCounter misses;
+    std::uint64_t sum = 0;
+    auto ns = bench::timeNs([&] {
+        std::jthread producer([&] {
+            utils::pinThisThread(g_producerCpu);
+            produce();
+        });
+        std::jthread consumer([&] {
+            utils::pinThisThread(g_consumerCpu);
+            sum = consume();
+        });
+    });
+    bench::doNotOptimize(sum);
+    bench::report(name, kItems, ns);
+
+    const std::int64_t count = misses.read();
+    std::cout << "    cache misses/item: ";
+    if (count < 0) {
+        std::cout << "n/a\n";
+    } else {
+        std::cout << static_cast<double>(count) / static_cast<double>(kItems) << "\n";
+    }
+}
+
+void benchUncached() {
+    UncachedQueue<L2OrderBookUpdate> queue(kCapacity);
+    run(
+        "uncached try_push/try_pop",
+        [&] {
+            for (std::size_t i = 0; i < kItems; ++i) {
+                while (!queue.try_push(makeUpdate(i))) {
+                    utils::cpuRelax();
+                }
+            }
+        },
+        [&] {
+            std::uint64_t sum = 0;
+            L2OrderBookUpdate update{};
+            for (std::size_t i = 0; i < kItems; ++i) {
+                while (!queue.try_pop(update)) {
+                    utils::cpuRelax();
+                }
+                sum += update.price.value();
+            }
+            return sum;
+        });
+}
+
+void benchCached() {
+    utils::spsc_queue<L2OrderBookUpdate> queue(kCapacity);
+    run(
+        "cached try_push/try_pop",
+        [&] {
+            for (std::size_t i = 0; i < kItems; ++i) {
+                while (!queue.try_push(makeUpdate(i))) {
+                    utils::cpuRelax();
+                }
+            }
+        },
+        [&] {
+            std::uint64_t sum = 0;
+            L2OrderBookUpdate update{};
+            for (std::size_t i = 0; i < kItems; ++i) {
+                while (!queue.try_pop(update)) {
+                    utils::cpuRelax();
+                }
+                sum += update.price.value();
+            }
+            return sum;
+        });
+}
+
+void benchBulk() {
+    utils::spsc_queue<L2OrderBookUpdate> queue(kCapacity);
+    run(
+        "try_push_n/try_pop_n, " + std::to_string(kChunk) + " per call",
+        [&] {
+            std::array<L2OrderBookUpdate, kChunk> chunk{};
+            for (std::size_t i = 0; i < kItems;) {
+                const std::size_t count = std::min(kChunk, kItems - i);
+                for (std::size_t j = 0; j < count; ++j) {
+                    chunk[j] = makeUpdate(i + j);
+                }
+                for (std::span<const L2OrderBookUpdate> rest{chunk.data(), count};
+                     !rest.empty();) {
+                    rest = rest.subspan(queue.try_push_n(rest));
+                }
+                i += count;
+            }
+        },
+        [&] {
+            std::uint64_t sum = 0;
+            std::array<L2OrderBookUpdate, kChunk> out{};
+            for (std::size_t popped = 0; popped < kItems;) {
+                const std::size_t count = queue.try_pop_n(out);
+                for (std::size_t j = 0; j < count; ++j) {
+                    sum += out[j].price.value();
+                }
+                popped += count;
+            }
+            return sum;
+        });
+}
+
+void benchPeek() {
+    utils::spsc_queue<L2OrderBookUpdate> queue(kCapacity);
+    run(
+        "try_push/peek+commit",
+        [&] {
+            for (std::size_t i = 0; i < kItems; ++i) {
+                while (!queue.try_push(makeUpdate(i))) {
+                    utils::cpuRelax();
+                }
+            }
+        },
+        [&] {
+            std::uint64_t sum = 0;
+            for (std::size_t popped = 0; popped < kItems;) {
+                auto ready = queue.peek();
+                for (const L2OrderBookUpdate& update : ready) {
+                    sum += update.price.value();
+                }
+                queue.commit(ready.size());
+                popped += ready.size();
+            }
+            return sum;
+        });
+}
+
+} // namespace
+
+// usage: spscBenchmark [producerCpu consumerCpu]
+int main(int argc, char** argv) {
+    if (argc > 2) {
+        g_producerCpu = std::atoi(argv[1]);
+        g_consumerCpu = std::atoi(argv[2]);
+    }
+
+    std::cout << "--- " << kItems << " L2 updates through a " << kCapacity
+              << " slot ring ---\n";
+    benchUncached();
+    benchCached();
+    benchBulk();
+    benchPeek();
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include "benchUtils.hpp"
+#include "core/matchingEngine.hpp"
+#include "market-data/bookEvent.hpp"
+#include "market-data/observer.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+#include "utils/waitStrategy.hpp"
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr std::uint64_t kMidPrice = 100'000;
+constexpr std::size_t kOrders = 20'000;
+constexpr std::size_t kRingCapacity = 1023;
+// one order every 10us, the stages are idle most of the time as in a quiet market
+constexpr auto kGap = 10us;
+
+using L2Queue = utils::spsc_queue_shm<L2OrderBookUpdate>;
+
+std::uint64_t nowNs() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+std::uint64_t threadCpuNs() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000 +
+           static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+// The L2 ring lives behind the queue object, as in the shared memory region
+struct L2Ring {
+    L2Ring()
+        : memory(new (std::align_val_t{64})
+                     std::byte[sizeof(L2Queue) + sizeof(L2OrderBookUpdate) *
+                                                     std::bit_ceil(kRingCapacity + 1)]),
+          queue(new (memory) L2Queue(kRingCapacity)) {}
+    ~L2Ring() {
+        queue->~L2Queue();
+        ::operator delete[](memory, std::align_val_t{64});
+    }
+
+    std::byte* memory;
+    L2Queue* queue;
+};
+
+// Engine -> observer -> publisher, the observer and publisher threads idling with the
+// given strategy. Every order rests and produces one L2 update, the publisher stage
+// stamps the arrival of update i against the submit time of order i.
+void run(const std::string& name, const utils::WaitConfig& wait) {
+    L2Ring ring;
+    utils::spsc_queue<L2OrderBookUpdate> mdQueue(kRingCapacity + 1);
+    utils::WaitSignal observerSignal;
+    utils::WaitSignal publisherSignal;
+
+    MatchingEngine engine(ring.queue, nullptr, InstrumentID{1},
+                          EngineConfig{.book = {.referencePrice = kMidPrice},
+                                       .orderPool = {.initialCapacity = kOrders},
+                                       .observerSignal = &observerSignal});
+    Level2OrderBook level2Book;
+    Level3OrderBook level3Book;
+    market_data::Observer observer(ring.queue, &mdQueue, level2Book, level3Book,
+                                   InstrumentID{1}, &publisherSignal);
+
+    std::vector<std::uint64_t> submitted(kOrders);
+    std::vector<std::uint64_t> latencies;
+    latencies.reserve(kOrders);
+    std::atomic<bool> done{false};
+    std::uint64_t observerCpu = 0;
+    std::uint64_t publisherCpu = 0;
+
+    const std::uint64_t start = nowNs();
+    {
+        std::jthread observerThread([&] {
+            utils::Waiter waiter(wait, &observerSignal);
+            while (!done.load(std::memory_order_relaxed)) {
+                if (observer.drainQueue() == 0) {
+                    waiter.idle([&] { return observer.hasPending(); });
+                } else {
+                    waiter.reset();
+                }
+            }
+            observerCpu = threadCpuNs();
+        });
+
+        std::jthread publisherThread([&] {
+            utils::Waiter waiter(wait, &publisherSignal);
+            while (latencies.size() < kOrders) {
+                auto updates = mdQueue.peek();
+                if (updates.empty()) {
+                    waiter.idle([&] { return !mdQueue.empty(); });
+                    continue;
+                }
+                waiter.reset();
+                const std::uint64_t arrival = nowNs();
+                for (std::size_t i = 0; i < updates.size(); ++i) {
+                    latencies.push_back(arrival - submitted[latencies.size()]);
+                }
+                mdQueue.commit(updates.size());
+            }
+            publisherCpu = threadCpuNs();
+        });
+
+        for (std::uint64_t id = 1; id <= kOrders; ++id) {
+            const bool buy = id % 2 == 0;
+            const std::uint64_t offset = 1 + id % 500;
+            submitted[id - 1] = nowNs();
+            bench::doNotOptimize(engine.processOrder(
+                engine.makeOrder(OrderID{id}, ClientID{1}, ClientOrderID{id}, Qty{10},
+                                 Price{buy ? kMidPrice - offset : kMidPrice + offset},
+                                 Timestamp{0}, Timestamp{0}, InstrumentID{1},
+                                 TimeInForce::GOOD_TILL_CANCELLED,
+                                 buy ? OrderSide::BUY : OrderSide::SELL,
+                                 OrderType::LIMIT, OrderStatus::NEW),
+                [](const TradeEvent&) {}));
+            const std::uint64_t next = submitted[id - 1] + kGap.count() * 1'000;
+            while (nowNs() < next) {
+            }
+        }
+        publisherThread.join();
+        done.store(true, std::memory_order_relaxed);
+    }
+    const double wallNs = static_cast<double>(nowNs() - start);
+
+    bench::reportLatency(name + " engine->publisher", latencies);
+    std::cout << "    cpu: observer " << std::fixed << std::setprecision(1)
+              << 100.0 * static_cast<double>(observerCpu) / wallNs << "%, publisher "
+              << 100.0 * static_cast<double>(publisherCpu) / wallNs << "%\n";
+}
+
+} // namespace
+
+int main() {
+    std::cout << "--- " << kOrders << " resting orders, one every " << kGap.count()
+              << "us ---\n";
+    run("busy spin", {.policy = utils::WaitPolicy::BUSY_SPIN});
+    run("spin then yield", {.policy = utils::WaitPolicy::SPIN_YIELD});
+    run("blocking, 1ms max park", {.policy = utils::WaitPolicy::BLOCKING});
+    run("timed, 100us", {.policy = utils::WaitPolicy::TIMED, .period = 100us});
+    run("timed, 1ms", {.policy = utils::WaitPolicy::TIMED, .period = 1ms});
+    return 0;
+}
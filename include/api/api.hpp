@@ -5,18 +5,176 @@
 #include "sessions/sessionManager.hpp"
 #include "utils/types.hpp"
 
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
 class MiniExchangeAPI {
 public:
-    MiniExchangeAPI(MatchingEngine& engine, SessionManager& sm)
-        : engine_(engine), sessionManager_(sm), instrumentID_(engine.getInstrumentID()) {}
+    MiniExchangeAPI(MatchingEngine& engine, SessionManager& sm) : sessionManager_(sm) {
+        addEngine_(engine);
+    }
+
+    // One engine per instrument, every request goes to the engine of its instrumentID
+    // and is rejected if no engine trades it.
+    MiniExchangeAPI(std::span<MatchingEngine* const> engines, SessionManager& sm)
+        : sessionManager_(sm) {
+        for (MatchingEngine* engine : engines) {
+            addEngine_(*engine);
+        }
+    }
 
     [[nodiscard]] MatchResult processNewOrder(const client::NewOrderPayload& payload);
     [[nodiscard]] bool cancelOrder(const client::CancelOrderPayload& payload);
     [[nodiscard]] ModifyResult modifyOrder(const client::ModifyOrderPayload& payload);
 
+    // non-allocating variants, see MatchingEngine::processOrder(OrderHandle, Sink&&)
+    template <typename Sink>
+    [[nodiscard]] MatchResult processNewOrder(const client::NewOrderPayload& payload,
+                                              Sink&& sink) {
+        MatchingEngine* engine = route_(InstrumentID{payload.instrumentID});
+        if (!engine) {
+            return rejected_(payload);
+        }
+        MatchResult result =
+            engine->processOrder(makeOrder_(*engine, payload), std::forward<Sink>(sink));
+        useBuffersOf_(*engine);
+        return result;
+    }
+
+    template <typename Sink>
+    [[nodiscard]] ModifyResult modifyOrder(const client::ModifyOrderPayload& payload,
+                                           Sink&& sink) {
+        MatchingEngine* engine = route_(InstrumentID{payload.instrumentID});
+        if (!engine) {
+            return notFound_(payload);
+        }
+        ModifyResult result = engine->modifyOrder(
+            ClientID{payload.serverClientID}, OrderID{payload.serverOrderID},
+            Qty{payload.newQty}, Price{payload.newPrice}, std::forward<Sink>(sink));
+        useBuffersOf_(*engine);
+        return result;
+    }
+
+    // See MatchingEngine::processBatch, the commands come from makeCommand(). Each run
+    // of commands for one instrument goes to its engine in one call.
+    std::size_t processBatch(std::span<const OrderCommand> commands,
+                             std::span<CommandResult> results);
+
+    // the engine gives a new order its server order id when it processes the command
+    [[nodiscard]] static OrderCommand makeCommand(const client::NewOrderPayload& payload);
+    [[nodiscard]] static OrderCommand makeCommand(const client::CancelOrderPayload& payload);
+    [[nodiscard]] static OrderCommand makeCommand(const client::ModifyOrderPayload& payload);
+
+    // trades of the last order, modify or batch
+    [[nodiscard]] std::span<const TradeEvent> getTrades() const { return trades_; }
+
+    // see MatchingEngine::getSelfTradeCancels
+    [[nodiscard]] std::span<const SelfTradeCancel> getSelfTradeCancels() const {
+        return selfTradeCancels_;
+    }
+
+    // See MatchingEngine::expireOrders. The engines share one ExpiryConfig::budget, the
+    // call stops once it is used up and the next one resumes at the engine where this
+    // one stopped, so a purge over many instruments stalls the caller no longer than
+    // a single engine would.
+    template <typename Sink> std::size_t expireOrders(Timestamp now, Sink&& onExpired) {
+        if (engines_.empty()) {
+            return 0;
+        }
+        const auto deadline =
+            std::chrono::steady_clock::now() + engines_[expiryCursor_]->getExpiryBudget();
+        std::size_t expired = 0;
+        for (std::size_t visited = 0; visited < engines_.size(); ++visited) {
+            MatchingEngine* engine = engines_[expiryCursor_];
+            expired += engine->expireOrders(now, onExpired, deadline);
+            if (engine->hasPendingExpiries(now)) {
+                break;
+            }
+            expiryCursor_ = (expiryCursor_ + 1) % engines_.size();
+            if (std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+        }
+        return expired;
+    }
+
+    [[nodiscard]] bool hasPendingExpiries(Timestamp now) const {
+        for (const MatchingEngine* engine : engines_) {
+            if (engine->hasPendingExpiries(now)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Number of cancelled orders, nullopt when the request names an unknown instrument
+    // or side. onCancelled(const Order&) sees every order, see
+    // MatchingEngine::massCancel.
+    template <typename Sink>
+    [[nodiscard]] std::optional<std::size_t>
+    massCancel(const client::MassCancelPayload& payload, Sink&& onCancelled) {
+        MatchingEngine* engine = route_(InstrumentID{payload.instrumentID});
+        std::optional<MassCancelFilter> filter = makeFilter_(payload);
+        if (!engine || !filter) {
+            return std::nullopt;
+        }
+        return engine->massCancel(ClientID{payload.serverClientID}, *filter,
+                                  std::forward<Sink>(onCancelled));
+    }
+
+    // cancel on disconnect, the client is gone so nobody is told about the orders
+    std::size_t cancelAllOrders(ClientID clientID) {
+        std::size_t cancelled = 0;
+        for (MatchingEngine* engine : engines_) {
+            cancelled += engine->massCancel(clientID);
+        }
+        return cancelled;
+    }
+
+    // nullptr if no engine trades the instrument
+    [[nodiscard]] MatchingEngine* getEngine(InstrumentID instrumentID) const noexcept {
+        return route_(instrumentID);
+    }
+
 private:
-    [[maybe_unused]] MatchingEngine& engine_;
+    // throws std::invalid_argument if another engine trades the same instrument
+    void addEngine_(MatchingEngine& engine);
+
+    [[nodiscard]] MatchingEngine* route_(InstrumentID instrumentID) const noexcept {
+        const std::uint32_t index = instrumentID.value();
+        return index < byInstrument_.size() ? byInstrument_[index] : nullptr;
+    }
+
+    void useBuffersOf_(const MatchingEngine& engine) {
+        trades_ = engine.getTrades();
+        selfTradeCancels_ = engine.getSelfTradeCancels();
+    }
+
+    static OrderHandle makeOrder_(MatchingEngine& engine,
+                                  const client::NewOrderPayload& payload);
+    static MatchResult rejected_(const client::NewOrderPayload& payload);
+    static ModifyResult notFound_(const client::ModifyOrderPayload& payload);
+    static void rejectAll_(std::span<const OrderCommand> commands,
+                           std::span<CommandResult> results);
+    static std::optional<MassCancelFilter>
+    makeFilter_(const client::MassCancelPayload& payload);
+
+    // indexed by instrument id, nullptr for instruments nobody trades
+    std::vector<MatchingEngine*> byInstrument_;
+    std::vector<MatchingEngine*> engines_;
+    // engine the next expireOrders() starts at
+    std::size_t expiryCursor_{0};
+
     [[maybe_unused]] SessionManager& sessionManager_;
 
-    const InstrumentID instrumentID_;
+    // what getTrades() and getSelfTradeCancels() show, the engine's own buffers unless
+    // a batch spanned several instruments
+    std::span<const TradeEvent> trades_;
+    std::span<const SelfTradeCancel> selfTradeCancels_;
+    std::vector<TradeEvent> batchTrades_;
+    std::vector<SelfTradeCancel> batchSelfTradeCancels_;
 };
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "utils/types.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <optional>
+#include <unordered_map>
+
+/**
+ * @brief Client side market-by-order book, built by MDReceiver from the L3 feed.
+ *
+ * Every level keeps its orders in queue order, so the quantity ahead of an order can
+ * be read off for queue-position estimates. Applies the feed's semantics: an add of a
+ * known order id increases it and moves it to the back of its level, a reduce that
+ * leaves nothing removes the order.
+ */
+class MBOBook {
+public:
+    struct Entry {
+        OrderID orderID;
+        Price price;
+        Qty qty;
+        OrderSide side;
+    };
+    using Level = std::list<Entry>;
+
+    void add(OrderID orderID, Price price, Qty qty, OrderSide side);
+    void reduce(OrderID orderID, Qty amount);
+    void cancel(OrderID orderID);
+    void clear();
+
+    [[nodiscard]] const Entry* find(OrderID orderID) const;
+    [[nodiscard]] std::optional<Qty> qtyAhead(OrderID orderID) const;
+    // total resting qty at a price, 0 for an empty level
+    [[nodiscard]] Qty levelQty(OrderSide side, Price price) const;
+    [[nodiscard]] std::size_t orderCount() const noexcept { return index_.size(); }
+
+    // best price first
+    const std::map<Price, Level, std::greater<Price>>& bids() const { return bids_; }
+    const std::map<Price, Level, std::less<Price>>& asks() const { return asks_; }
+
+private:
+    void erase_(std::unordered_map<OrderID, Level::iterator>::iterator it);
+
+    std::map<Price, Level, std::greater<Price>> bids_;
+    std::map<Price, Level, std::less<Price>> asks_;
+    std::unordered_map<OrderID, Level::iterator> index_;
+};
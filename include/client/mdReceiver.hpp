@@ -1,13 +1,16 @@
 #pragma once
 
+#include "client/mboBook.hpp"
 #include "market-data/messages.hpp"
 #include "utils/types.hpp"
 #include <arpa/inet.h>
 #include <cstddef>
 #include <fcntl.h>
 #include <functional>
+#include <optional>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <cstdint>
@@ -19,6 +22,12 @@ struct MDConfig {
     std::string multicastGroup = "239.0.0.1";
     std::uint16_t port = 9001;
     std::string interfaceIP = "0.0.0.0";
+    // messages of other instruments on the same group and port are skipped, 0 applies
+    // every instrument's messages to the one book
+    std::uint32_t instrumentID = 0;
+    // datagrams one pollBatch() takes from the socket, each into a buffer of its own
+    std::size_t batch = 32;
+    std::size_t datagramSize = 16 * 1024;
 };
 
 using OnSnapshotCallback =
@@ -29,6 +38,9 @@ using OnGapDetectedCallback =
     std::function<void(std::uint64_t expected, std::uint64_t received)>;
 using OnBookValidCallback = std::function<void()>;
 using OnBookInvalidCallback = std::function<void()>;
+using OnOrderSnapshotCallback = std::function<void(const MBOBook&, std::uint64_t seqNum)>;
+using OnOrderDeltaCallback = std::function<void(OrderID, Price, Qty, OrderSide,
+                                                MDOrderEventType, std::uint64_t seqNum)>;
 
 class MDReceiver {
 public:
@@ -41,44 +53,73 @@ public:
         }
     }
 
+    // reads one datagram, false when none is waiting
     bool receiveOne();
+    // Reads up to MDConfig::batch waiting datagrams with one recvmmsg and applies
+    // them in order. Returns the number of messages applied, 0 when none was waiting.
+    std::size_t pollBatch();
     void initialize();
 
-    const std::vector<std::pair<Price, Qty>>& getBook(OrderSide side) const;
-    std::vector<std::pair<Price, Qty>>& getBook(OrderSide side);
-
     const Level2OrderBook& getOrderBook() const { return book_; }
 
     bool isBookValid() const { return bookValid_; }
 
+    // market-by-order book of the L3 feed (MDConfig::port 9002 by default on the
+    // publisher side), valid once a complete order snapshot came in
+    const MBOBook& getMBOBook() const { return mboBook_; }
+    bool isMBOBookValid() const { return mboBookValid_; }
+
     void setOnSnapshot(OnSnapshotCallback cb) { onSnapshot_ = std::move(cb); }
     void setOnDelta(OnDeltaCallback cb) { onDelta_ = std::move(cb); }
     void setOnGapDetected(OnGapDetectedCallback cb) { onGapDetected_ = std::move(cb); }
     void setOnBookValid(OnBookValidCallback cb) { onBookValid_ = std::move(cb); }
     void setOnBookInvalid(OnBookInvalidCallback cb) { onBookInvalid_ = std::move(cb); }
+    void setOnOrderSnapshot(OnOrderSnapshotCallback cb) {
+        onOrderSnapshot_ = std::move(cb);
+    }
+    void setOnOrderDelta(OnOrderDeltaCallback cb) { onOrderDelta_ = std::move(cb); }
 
 private:
-    void processMessage_(std::span<const std::byte> msgBytes);
+    // every message of a datagram, in order, returns how many there were
+    std::size_t processMessage_(std::span<const std::byte> msgBytes);
+    void dispatch_(const MarketDataHeader& header, std::span<const std::byte> payload);
     MarketDataHeader parseHeader_(std::span<const std::byte>& hdrBytes);
     void processDelta_(std::span<const std::byte> payloadBytes, std::uint64_t sqn);
     void processSnapshot_(std::span<const std::byte> payloadBytes, std::uint64_t sqn);
-
-    bool priceBetterOrEqual_(Price incoming, Price resting, OrderSide side);
-    void addAtPrice_(Price price, Qty amount, OrderSide side);
-    void reduceAtPrice_(Price price, Qty amount, OrderSide side);
-
-    void checkSequence_(std::uint64_t receivedSqn);
-    void handleGap_(std::uint64_t expected, std::uint64_t received);
+    void processOrderDelta_(std::span<const std::byte> payloadBytes, std::uint64_t sqn);
+    void processOrderSnapshot_(std::span<const std::byte> payloadBytes,
+                               std::uint64_t sqn);
+
+    // the L2 and L3 channels are sequenced independently, a gap invalidates the book
+    // of its channel
+    void checkSequence_(std::optional<std::uint64_t>& expectedSqn,
+                        std::uint64_t receivedSqn, void (MDReceiver::*invalidate)());
+    void handleGap_(std::uint64_t expected, std::uint64_t received,
+                    void (MDReceiver::*invalidate)());
     void markBookValid();
     void markBookInvalid();
+    void markMBOBookValid();
+    void markMBOBookInvalid();
 
     MDConfig mdConfig_;
     std::vector<std::byte> mdBuffer_;
 
+    // pollBatch() receives into batch buffers of datagramSize bytes, one header each
+    std::vector<std::byte> batchBuffers_;
+    std::vector<mmsghdr> batchMsgs_;
+    std::vector<iovec> batchIovecs_;
+
     Level2OrderBook book_;
     bool bookValid_;
 
     std::optional<std::uint64_t> expectedMDSqn_;
+
+    MBOBook mboBook_;
+    bool mboBookValid_{false};
+    std::optional<std::uint64_t> expectedL3Sqn_;
+    // next part of the order snapshot being assembled
+    std::optional<std::uint16_t> nextSnapshotPart_;
+
     int sockfd_{-1};
 
     OnSnapshotCallback onSnapshot_;
@@ -86,4 +127,6 @@ private:
     OnGapDetectedCallback onGapDetected_;
     OnBookValidCallback onBookValid_;
     OnBookInvalidCallback onBookInvalid_;
+    OnOrderSnapshotCallback onOrderSnapshot_;
+    OnOrderDeltaCallback onOrderDelta_;
 };
@@ -10,6 +10,7 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <thread>
 
@@ -45,6 +46,11 @@ public:
     void sendModify(ClientOrderID clientOrderID, OrderID serverOrderID, Qty newQty,
                     Price newPrice, InstrumentID instrumentID);
 
+    // no side cancels both sides, maxPrice 0 leaves the range open at the top
+    void sendMassCancel(InstrumentID instrumentID,
+                        std::optional<OrderSide> side = std::nullopt,
+                        Price minPrice = Price{0}, Price maxPrice = Price{0});
+
     using HelloAckCallback = std::function<void(const Message<server::HelloAckPayload>&)>;
     using LogoutAckCallback =
         std::function<void(const Message<server::LogoutAckPayload>&)>;
@@ -54,6 +60,8 @@ public:
     using ModifyAckCallback =
         std::function<void(const Message<server::ModifyAckPayload>&)>;
     using TradeCallback = std::function<void(const Message<server::TradePayload>&)>;
+    using MassCancelAckCallback =
+        std::function<void(const Message<server::MassCancelAckPayload>&)>;
 
     void setHelloAckCallback(HelloAckCallback cb) { helloAckCallback_ = std::move(cb); }
     void setLogoutAckCallback(LogoutAckCallback cb) {
@@ -67,6 +75,9 @@ public:
         modifyAckCallback_ = std::move(cb);
     }
     void setTradeCallback(TradeCallback cb) { tradeCallback_ = std::move(cb); }
+    void setMassCancelAckCallback(MassCancelAckCallback cb) {
+        massCancelAckCallback_ = std::move(cb);
+    }
 
     ClientOrderID getNextClientOrderID() { return session_.getNextOrderID(); }
 
@@ -98,6 +109,7 @@ private:
     CancelAckCallback cancelAckCallback_;
     ModifyAckCallback modifyAckCallback_;
     TradeCallback tradeCallback_;
+    MassCancelAckCallback massCancelAckCallback_;
 
     std::unique_ptr<MDReceiver> mdReceiver_;
 };
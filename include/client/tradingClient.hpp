@@ -44,6 +44,9 @@ public:
                      Timestamp goodTill = Timestamp{0});
 
     bool cancelOrder(ClientOrderID clientOrderID);
+    // one MASS_CANCEL, the open orders are updated by the cancel acks that follow
+    void cancelAllOrders(InstrumentID instrumentID,
+                         std::optional<OrderSide> side = std::nullopt);
     void modifyOrder(ClientOrderID clientOrderID, Qty newQty, Price newPrice);
 
     std::optional<ClientOrder> getOrder(ClientOrderID clientOrderID) const;
@@ -77,6 +80,9 @@ protected:
                                [[maybe_unused]] Qty fillQty) {}
     virtual void onOrderCancelled([[maybe_unused]] ClientOrderID clientOrderID) {}
     virtual void onCancelRejected([[maybe_unused]] ClientOrderID clientOrderID) {}
+    virtual void onMassCancelAck([[maybe_unused]] InstrumentID instrumentID,
+                                 [[maybe_unused]] std::uint64_t cancelledCount,
+                                 [[maybe_unused]] bool accepted) {}
     virtual void onModifyAccepted([[maybe_unused]] ClientOrderID clientOrderID,
                                   [[maybe_unused]] OrderID newServerOrderID,
                                   [[maybe_unused]] Qty newQty,
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "api/api.hpp"
+#include "core/engineThread.hpp"
+#include "core/matchingEngine.hpp"
+#include "sessions/sessionManager.hpp"
+#include "utils/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+struct EngineShardsConfig {
+    // one engine thread per entry, pinned to that core (-1 leaves it to the scheduler)
+    std::vector<int> cpus{-1};
+    // ring sizes, batching and timers of every shard, cpu is taken from cpus
+    EngineThreadConfig thread{};
+};
+
+/**
+ * @brief Spreads the instruments over several engine threads.
+ *
+ * Every shard is an EngineThread with its own MiniExchangeAPI over the engines of the
+ * instruments assigned to it, so a MatchingEngine is only ever touched by the thread of
+ * its shard and the shards share no mutable state. The gateway thread routes a request
+ * with shardOf() and pushes it into the request ring of that shard, a cancel on
+ * disconnect goes to every shard. The assignment table is a flat array indexed by
+ * instrument id. Instruments start out round-robin over the shards and can be moved
+ * with assign() while the shards are stopped.
+ */
+class EngineShards {
+public:
+    // the engines must outlive the shards, throws std::invalid_argument if two engines
+    // trade the same instrument or cpus is empty
+    EngineShards(std::span<MatchingEngine* const> engines, SessionManager& sm,
+                 EngineShardsConfig config = {});
+    ~EngineShards() { stop(); }
+
+    EngineShards(const EngineShards&) = delete;
+    EngineShards& operator=(const EngineShards&) = delete;
+
+    void start();
+    // joins every shard, requests still in the rings are dropped
+    void stop();
+    [[nodiscard]] bool running() const noexcept { return running_; }
+
+    // Moves an instrument to another shard. Throws std::logic_error while running and
+    // std::out_of_range for an unknown instrument or shard.
+    void assign(InstrumentID instrumentID, std::size_t shard);
+
+    [[nodiscard]] std::size_t shardCount() const noexcept { return shards_.size(); }
+
+    // instruments nobody trades go to shard 0, whose API rejects them
+    [[nodiscard]] std::size_t shardOf(InstrumentID instrumentID) const noexcept {
+        const std::uint32_t index = instrumentID.value();
+        return index < assignment_.size() ? assignment_[index] : 0;
+    }
+    // CANCEL_ALL has no instrument, it has to be pushed to every shard
+    [[nodiscard]] std::size_t shardOf(const EngineRequest& request) const noexcept {
+        return request.type == EngineRequestType::MASS_CANCEL
+                   ? shardOf(InstrumentID{request.massCancel.instrumentID})
+                   : shardOf(request.command.instrumentID);
+    }
+
+    // gateway thread side, false when the shard's ring is full or empty
+    [[nodiscard]] bool tryPush(std::size_t shard, const EngineRequest& request) {
+        return shards_[shard].thread->tryPush(request);
+    }
+    [[nodiscard]] bool tryPop(std::size_t shard, EngineResponse& response) {
+        return shards_[shard].thread->tryPop(response);
+    }
+
+private:
+    struct Shard {
+        std::unique_ptr<MiniExchangeAPI> api;
+        std::unique_ptr<EngineThread> thread;
+    };
+
+    // rebuilds the API and engine thread of every shard from the assignment table
+    void build_();
+
+    std::vector<MatchingEngine*> engines_;
+    SessionManager& sessionManager_;
+    const EngineShardsConfig config_;
+
+    // shard of each instrument, indexed by instrument id
+    std::vector<std::uint16_t> assignment_;
+    std::vector<Shard> shards_;
+    bool running_{false};
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "api/api.hpp"
+#include "protocol/clientMessages.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+enum class EngineRequestType : std::uint8_t { ORDER = 0, MASS_CANCEL, CANCEL_ALL };
+
+// A request of the gateway thread. sessionID is the client whose session gets the acks.
+// ORDER carries command, MASS_CANCEL massCancel, CANCEL_ALL (cancel on disconnect)
+// pulls every order of sessionID and is not answered.
+struct EngineRequest {
+    EngineRequestType type{EngineRequestType::ORDER};
+    ClientID sessionID{0};
+    OrderCommand command{};
+    client::MassCancelPayload massCancel{};
+};
+
+enum class EngineResponseType : std::uint8_t {
+    ORDER_ACK = 0,
+    MODIFY_ACK,
+    CANCEL_ACK,
+    MASS_CANCEL_ACK,
+    TRADE
+};
+
+// A result on its way back to the gateway thread, flat so that it fits the ring.
+// sessionID is the client the ack goes to, a TRADE goes to both sides of trade.
+struct EngineResponse {
+    EngineResponseType type{EngineResponseType::ORDER_ACK};
+    // OrderStatus, ModifyStatus or status::CancelStatus, depending on type
+    std::uint8_t status{0};
+    ClientID sessionID{0};
+    ClientOrderID clientOrderID{0};
+    OrderID orderID{0};    // MODIFY_ACK: the replaced order
+    OrderID newOrderID{0}; // MODIFY_ACK only
+    Qty qty{0};            // remaining qty of an ORDER_ACK, new qty of a MODIFY_ACK
+    Price price{0};
+    Timestamp timestamp{0};
+    InstrumentID instrumentID{0};
+    std::size_t cancelledCount{0}; // MASS_CANCEL_ACK
+    TradeEvent trade{};
+};
+
+static_assert(std::is_trivially_copyable_v<EngineRequest>);
+static_assert(std::is_trivially_copyable_v<EngineResponse>);
+
+struct EngineThreadConfig {
+    // slots of the request ring and of the response ring
+    std::size_t ringCapacity{4096};
+    // most order commands handed to processBatch() in one call
+    std::size_t maxBatch{64};
+    // core the engine thread is pinned to, -1 leaves it to the scheduler
+    int cpu{-1};
+    // upper bound on the time between two runs of the order expiry
+    std::chrono::milliseconds timerInterval{10};
+};
+
+/**
+ * @brief Runs the matching engine on its own busy-polling thread.
+ *
+ * The gateway thread pushes decoded requests with tryPush() and collects the acks,
+ * trades and unsolicited cancels with tryPop(), both rings are single producer, single
+ * consumer. The engine thread drains up to maxBatch requests at a time and hands the
+ * order commands among them to one processBatch() call, a mass cancel or a cancel on
+ * disconnect is processed after the commands queued ahead of it. The order expiry runs
+ * on the engine thread too. Once started, the API (and its engine) must only be used
+ * through the rings.
+ */
+class EngineThread {
+public:
+    explicit EngineThread(MiniExchangeAPI& api, const EngineThreadConfig& config = {});
+    ~EngineThread() { stop(); }
+
+    EngineThread(const EngineThread&) = delete;
+    EngineThread& operator=(const EngineThread&) = delete;
+
+    void start();
+    // joins the engine thread, requests still in the ring are dropped
+    void stop();
+
+    // gateway thread side, false when the ring is full or empty
+    [[nodiscard]] bool tryPush(const EngineRequest& request) {
+        return requests_.try_push(request);
+    }
+    [[nodiscard]] bool tryPop(EngineResponse& response) {
+        return responses_.try_pop(response);
+    }
+
+private:
+    void run_(std::stop_token stop);
+    void processBatch_();
+    void massCancel_(const EngineRequest& request);
+    void runTimers_();
+    // waits for space while the gateway is behind on the responses
+    void respond_(const EngineResponse& response);
+
+    MiniExchangeAPI& api_;
+    const EngineThreadConfig config_;
+
+    utils::spsc_queue<EngineRequest> requests_;
+    utils::spsc_queue<EngineResponse> responses_;
+
+    // owned by the engine thread
+    std::vector<OrderCommand> batch_;
+    std::vector<ClientID> batchSessions_;
+    std::vector<CommandResult> batchResults_;
+    std::chrono::steady_clock::time_point nextTimerRun_{};
+    std::stop_token stop_;
+
+    std::jthread thread_;
+};
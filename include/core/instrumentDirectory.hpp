@@ -0,0 +1,97 @@
+#pragma once
+
+#include "core/matchingEngine.hpp"
+#include "utils/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct InstrumentSpec {
+    InstrumentID id{0};
+    std::string symbol;
+    PriceRules prices{};
+    // centre of the engine's price ladder, 0 anchors it on the first order
+    std::uint64_t referencePrice{0};
+    // The L2, L3 and conflated L2 feeds go to mdPort, mdPort + 1 and mdPort + 2. 0 lets
+    // InstrumentDirectory::add pick the ports after the highest ones taken.
+    std::uint16_t mdPort{0};
+    // resting orders the order pools and indexes of the instrument are sized for up
+    // front, they still grow past it. 0 keeps the sizes of the base EngineConfig.
+    std::size_t orderCapacity{0};
+
+    [[nodiscard]] std::uint16_t l2Port() const noexcept { return mdPort; }
+    [[nodiscard]] std::uint16_t l3Port() const noexcept {
+        return static_cast<std::uint16_t>(mdPort + 1);
+    }
+    [[nodiscard]] std::uint16_t conflatedPort() const noexcept {
+        return static_cast<std::uint16_t>(mdPort + 2);
+    }
+};
+
+/**
+ * @brief The instruments the exchange lists, loaded once at startup.
+ *
+ * Instrument ids are expected to be small and dense, find(InstrumentID) is a lookup in
+ * a flat array indexed by the id. The directory is read-only once the engines are
+ * created from it.
+ */
+class InstrumentDirectory {
+public:
+    // keeps the id lookup table at a few hundred KiB at most
+    static constexpr std::uint32_t kMaxInstrumentID = 65'535;
+    // ports of the first instrument's feeds when none are given, and how many
+    // consecutive ports every instrument takes
+    static constexpr std::uint16_t kFirstMarketDataPort = 9001;
+    static constexpr std::uint16_t kMarketDataPorts = 3;
+
+    // One instrument per line,
+    // "id,symbol,tickSize,minPrice,maxPrice[,referencePrice[,mdPort[,orderCapacity]]]",
+    // an empty mdPort picks the ports as if it was left out. Empty lines and lines
+    // starting with # are skipped. Throws std::runtime_error on a malformed line or a
+    // duplicate id, symbol or market data port.
+    [[nodiscard]] static InstrumentDirectory parse(std::istream& in);
+    [[nodiscard]] static InstrumentDirectory load(const std::string& path);
+
+    // throws std::runtime_error on id 0, an id above kMaxInstrumentID, a zero tick
+    // size, a duplicate id or symbol, or market data ports another instrument uses
+    void add(InstrumentSpec spec);
+
+    [[nodiscard]] const InstrumentSpec* find(InstrumentID id) const noexcept {
+        const std::uint32_t index = id.value();
+        if (index >= byID_.size() || byID_[index] == 0) {
+            return nullptr;
+        }
+        return &specs_[byID_[index] - 1];
+    }
+    [[nodiscard]] const InstrumentSpec* find(std::string_view symbol) const noexcept;
+
+    [[nodiscard]] std::span<const InstrumentSpec> instruments() const noexcept {
+        return specs_;
+    }
+    [[nodiscard]] std::size_t size() const noexcept { return specs_.size(); }
+    [[nodiscard]] bool empty() const noexcept { return specs_.empty(); }
+
+    // the engine config of one instrument, base supplies everything else
+    [[nodiscard]] static EngineConfig engineConfig(const InstrumentSpec& spec,
+                                                   EngineConfig base = {}) {
+        base.prices = spec.prices;
+        base.book.referencePrice = spec.referencePrice;
+        base.book.tickSize = spec.prices.tickSize;
+        if (spec.orderCapacity != 0) {
+            base.orderPool.initialCapacity = spec.orderCapacity;
+            // the index grows once it is 70% full
+            base.orderMapCapacity = spec.orderCapacity * 10 / 7 + 1;
+        }
+        return base;
+    }
+
+private:
+    std::vector<InstrumentSpec> specs_;
+    // position in specs_ plus one, indexed by instrument id, 0 for unlisted ids
+    std::vector<std::uint32_t> byID_;
+};
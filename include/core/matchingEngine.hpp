@@ -2,6 +2,8 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <concepts>
 #include <cstdlib>
 #include <deque>
 #include <functional>
@@ -9,29 +11,259 @@
 #include <memory>
 #include <optional>
 #include <ranges>
+#include <span>
 #include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "market-data/bookEvent.hpp"
 #include "utils/spsc_queue.hpp"
 #include "utils/timing.hpp"
 #include "utils/types.hpp"
+#include "utils/waitStrategy.hpp"
+
+struct ExpiryConfig {
+    // resolution of the expiry wheel, an order expires at most one tick after goodTill
+    std::uint64_t tickNs{1'000'000};
+    // expiry time of END_OF_DAY orders, 0 keeps them on the book until cancelled
+    Timestamp endOfDay{0};
+    // endOfDay moves on by this much once expireOrders() has seen it pass, 0 keeps it
+    // where it is
+    std::chrono::nanoseconds endOfDayRoll{0};
+    // how long a single expireOrders() call may keep the engine from matching
+    std::chrono::nanoseconds budget{std::chrono::microseconds{200}};
+};
+
+// limits on the prices of limit orders and modifies, set per instrument
+struct PriceRules {
+    // prices must be a multiple of the tick size
+    std::uint64_t tickSize{1};
+    // inclusive price band, a maxPrice of 0 leaves it open at the top
+    std::uint64_t minPrice{0};
+    std::uint64_t maxPrice{0};
+
+    [[nodiscard]] constexpr bool accepts(std::uint64_t price) const noexcept {
+        return price % tickSize == 0 && price >= minPrice &&
+               (maxPrice == 0 || price <= maxPrice);
+    }
+};
+
+struct EngineConfig {
+    utils::PriceLadderConfig book{};
+    utils::ObjectPoolConfig orderPool{};
+    // initial slot count of the order id index, grows past 70% load
+    std::size_t orderMapCapacity{16 * 1024};
+    // trades a single order can generate before the trade buffer has to grow
+    std::size_t tradeBufferReserve{1024};
+    ExpiryConfig expiry{};
+    // what an order does when it meets a resting order of its own client
+    SelfTradePrevention selfTrade{SelfTradePrevention::SKIP};
+    PriceRules prices{};
+    // how the engine waits while its L2 or L3 ring is full
+    utils::WaitConfig marketDataWait{};
+    // notified after every L2/L3 push so that a BLOCKING observer wakes up, may be null
+    utils::WaitSignal* observerSignal{nullptr};
+    // When set, every book change and trade goes out as one sequenced EngineEvent on
+    // this ring and the L2 and L3 rings are left alone
+    utils::spsc_queue_shm<EngineEvent>* eventQueue{nullptr};
+};
 
 class MatchingEngine {
 public:
     MatchingEngine(utils::spsc_queue_shm<L2OrderBookUpdate>* l2queue = nullptr,
                    utils::spsc_queue_shm<L3Update>* l3queue = nullptr,
-                   InstrumentID instrumentID = InstrumentID{1})
-        : instrumentID_(instrumentID), l2queue_(l2queue), l3queue_(l3queue) {
-        dispatchTable_[0][0] = &MatchingEngine::matchOrder_<BuySide, LimitOrderPolicy>;
-        dispatchTable_[0][1] = &MatchingEngine::matchOrder_<BuySide, MarketOrderPolicy>;
-        dispatchTable_[1][0] = &MatchingEngine::matchOrder_<SellSide, LimitOrderPolicy>;
-        dispatchTable_[1][1] = &MatchingEngine::matchOrder_<SellSide, MarketOrderPolicy>;
+                   InstrumentID instrumentID = InstrumentID{1},
+                   const EngineConfig& config = {})
+        : instrumentID_(instrumentID), orderPool_(config.orderPool),
+          book(config.book, config.orderMapCapacity), expiryConfig_(config.expiry),
+          ownLevelPool_({.initialCapacity = 256}), l2queue_(l2queue), l3queue_(l3queue),
+          selfTrade_(config.selfTrade), prices_(config.prices),
+          marketDataWaiter_(config.marketDataWait),
+          observerSignal_(config.observerSignal), eventQueue_(config.eventQueue) {
+        fillDispatchRow_<BuySide>(dispatchTable_[0]);
+        fillDispatchRow_<SellSide>(dispatchTable_[1]);
+        trades_.reserve(config.tradeBufferReserve);
+        selfTradeCancels_.reserve(64);
+    }
+
+    // The trades are handed to sink(const TradeEvent&) once matching is done and the
+    // returned result has an empty tradeVec, nothing on this path allocates.
+    template <typename Sink>
+        requires std::invocable<Sink&, const TradeEvent&>
+    MatchResult processOrder(OrderHandle order, Sink&& sink) {
+        beginCommand_();
+        MatchResult result = match_(std::move(order));
+        for (const TradeEvent& trade : trades_) {
+            sink(trade);
+        }
+        return result;
+    }
+
+    template <typename Sink>
+        requires std::invocable<Sink&, const TradeEvent&>
+    ModifyResult modifyOrder(const ClientID clientID, const OrderID orderID,
+                             const Qty newQty, const Price newPrice, Sink&& sink) {
+        beginCommand_();
+        ModifyResult result = modify_(clientID, orderID, newQty, newPrice);
+        for (const TradeEvent& trade : trades_) {
+            sink(trade);
+        }
+        return result;
     }
 
+    // the overloads without a sink copy the trades into MatchResult::tradeVec
+    MatchResult processOrder(OrderHandle order);
+    // copies the order into the pool, for callers that build orders on the heap
     MatchResult processOrder(std::unique_ptr<Order> order);
+
+    /**
+     * @brief Processes a burst of new, cancel and modify commands in arrival order.
+     *
+     * Writes one CommandResult per command and returns how many commands were
+     * processed, at most results.size(). New orders with orderID 0 are given the next
+     * server order id when they are matched. The new orders of the batch are validated in
+     * one pass before anything is matched, every event of the batch carries the same
+     * timestamp, and the order index entries of the cancels and modifies a few
+     * commands ahead are prefetched while the current one is matched. The trades and
+     * self-trade cancels of the whole batch are in getTrades() and
+     * getSelfTradeCancels() until the next call.
+     */
+    std::size_t processBatch(std::span<const OrderCommand> commands,
+                             std::span<CommandResult> results);
+
+    // trades of the last order, modify or batch
+    [[nodiscard]] std::span<const TradeEvent> getTrades() const noexcept {
+        return trades_;
+    }
+
+    // an empty handle means the pool has hit its maxCapacity
+    template <typename... Args> [[nodiscard]] OrderHandle makeOrder(Args&&... args) {
+        return orderPool_.make(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Cancels the GOOD_TILL_DATE and END_OF_DAY orders that are due at now.
+     *
+     * now is in the unit of Order::goodTill (nanoseconds since the epoch on the
+     * server). Every expired order is handed to onExpired(const Order&) while it is
+     * still intact and then leaves the book like a cancel, with the same L2/L3 events.
+     * Expiries are processed in small batches until ExpiryConfig::budget is used up,
+     * whatever is left stays due for the next call, see hasPendingExpiries(). Once now
+     * is past the end of day it is rolled forward by ExpiryConfig::endOfDayRoll, the
+     * END_OF_DAY orders added after that expire at the next one.
+     */
+    template <typename Sink>
+        requires std::invocable<Sink&, const Order&>
+    std::size_t expireOrders(Timestamp now, Sink&& onExpired) {
+        return expireOrders(now, std::forward<Sink>(onExpired),
+                            std::chrono::steady_clock::now() + expiryConfig_.budget);
+    }
+
+    // Same, but stops at deadline instead of after ExpiryConfig::budget. At least one
+    // batch is expired, so that several engines sharing a deadline all make progress.
+    template <typename Sink>
+        requires std::invocable<Sink&, const Order&>
+    std::size_t expireOrders(Timestamp now, Sink&& onExpired,
+                             std::chrono::steady_clock::time_point deadline) {
+        const std::uint64_t tick = now / expiryConfig_.tickNs;
+        eventTime_ = TSCClock::now();
+        rollEndOfDay_(now);
+
+        auto expire = [this, &onExpired](Order& order) {
+            order.status = OrderStatus::CANCELLED;
+            onExpired(std::as_const(order));
+            if (order.side == OrderSide::BUY) {
+                removeFromBook_(&order, book.bids);
+            } else {
+                removeFromBook_(&order, book.asks);
+            }
+        };
+
+        std::size_t expired = 0;
+        do {
+            expired += expiry_.advance(tick, expire, kExpiryBatch);
+        } while (expiry_.pending(tick) && std::chrono::steady_clock::now() < deadline);
+        return expired;
+    }
+
+    [[nodiscard]] std::chrono::nanoseconds getExpiryBudget() const noexcept {
+        return expiryConfig_.budget;
+    }
+
+    [[nodiscard]] bool hasPendingExpiries(Timestamp now) const noexcept {
+        return expiry_.pending(now / expiryConfig_.tickNs);
+    }
+
+    // applies to END_OF_DAY orders added from now on
+    void setEndOfDay(Timestamp endOfDay) noexcept { expiryConfig_.endOfDay = endOfDay; }
+
+    [[nodiscard]] std::size_t getScheduledExpiryCount() const noexcept {
+        return expiry_.size();
+    }
+
     bool cancelOrder(const ClientID clientID, const OrderID orderID);
+
+    /**
+     * @brief Cancels the resting orders of a client that pass the filter.
+     *
+     * Walks the client's own list of resting orders, the cost depends on how many
+     * orders the client has on the book and not on the size of the book. Every
+     * cancelled order is handed to onCancelled(const Order&) before it leaves the book.
+     * The L3 feed sees one event per order, the L2 feed one REDUCE per touched level
+     * carrying the summed quantity. On the event stream these are ORDER_MASS_CANCELLED
+     * records followed by one LEVEL_REDUCED per level.
+     */
+    template <typename Sink>
+        requires std::invocable<Sink&, const Order&>
+    std::size_t massCancel(ClientID clientID, const MassCancelFilter& filter,
+                           Sink&& onCancelled) {
+        ClientBook* client = clientIndex_.find(clientID);
+        if (!client) {
+            return 0;
+        }
+        const ClientOrderList* orders = &client->orders;
+        eventTime_ = TSCClock::now();
+
+        // the per level sums point into levelReduces_, it must not reallocate
+        levelReduces_.clear();
+        levelReduces_.reserve(orders->size());
+
+        std::size_t cancelled = 0;
+        for (Order* order = orders->front(); order;) {
+            Order* next = order->clientNext;
+            if (filter.matches(*order)) {
+                order->status = OrderStatus::CANCELLED;
+                onCancelled(std::as_const(*order));
+                addLevelReduce_(*order);
+                if (order->side == OrderSide::BUY) {
+                    removeFromBook_(order, book.bids, false);
+                } else {
+                    removeFromBook_(order, book.asks, false);
+                }
+                ++cancelled;
+            }
+            order = next;
+        }
+        publishLevelReduces_();
+        return cancelled;
+    }
+
+    std::size_t massCancel(ClientID clientID, const MassCancelFilter& filter = {}) {
+        return massCancel(clientID, filter, [](const Order&) {});
+    }
+
+    [[nodiscard]] std::size_t getClientOrderCount(ClientID clientID) const noexcept {
+        const ClientBook* client = clientIndex_.find(clientID);
+        return client ? client->orders.size() : 0;
+    }
+
+    // Resting orders that self-trade prevention cancelled while the last order or
+    // modify was matched, valid until the next one.
+    [[nodiscard]] std::span<const SelfTradeCancel> getSelfTradeCancels() const noexcept {
+        return selfTradeCancels_;
+    }
+
     ModifyResult modifyOrder(const ClientID clientID, const OrderID orderID,
                              const Qty newQty, const Price newPrice);
 
@@ -47,21 +279,25 @@ public:
     const Order* getOrder(OrderID orderID) const;
 
     [[nodiscard]] InstrumentID getInstrumentID() const noexcept { return instrumentID_; }
+    // sequence number of the last EngineEvent, 0 before the first one
+    [[nodiscard]] std::uint64_t getEventSequence() const noexcept { return eventSeq_; }
     OrderID getNextOrderID() { return ++orderID_; }
 
+    [[nodiscard]] const utils::ObjectPoolStats& getOrderPoolStats() const noexcept {
+        return orderPool_.stats();
+    }
+    [[nodiscard]] utils::FlatIndexStats getOrderMapStats() const noexcept {
+        return book.orderMap.stats();
+    }
+
+    // full depth, worst price first; every level is a copy of its cached aggregate
     static std::vector<std::pair<Price, Qty>> makeSnapshot(const auto& book) {
         std::vector<std::pair<Price, Qty>> snapshot;
         snapshot.reserve(book.size());
 
         for (const auto& [price, queue] : book) {
-            auto qtyView = std::views::transform([](const auto& order) {
-                return order->qty;
-            });
-
-            Qty total = std::ranges::fold_left(queue | qtyView, Qty{0}, std::plus{});
-
-            if (total > 0) {
-                snapshot.emplace_back(price, total);
+            if (queue.totalQty() > 0) {
+                snapshot.emplace_back(price, queue.totalQty());
             }
         }
 
@@ -77,46 +313,233 @@ public:
         }
     }
 
-    constexpr bool isValidOrder(const Order& order) {
-        std::uint8_t mask = 0;
+    // Top of book, best price first. Fills at most out.size() levels and returns how
+    // many were written, the cost only depends on the requested depth.
+    template <OrderSide Side> std::size_t getDepth(std::span<LevelSummary> out) const {
+        if constexpr (Side == OrderSide::BUY) {
+            return copyDepth_(book.bids, out);
+        } else {
+            return copyDepth_(book.asks, out);
+        }
+    }
+
+    template <OrderSide Side>
+    std::vector<LevelSummary> getDepth(std::size_t levels) const {
+        std::vector<LevelSummary> depth(levels);
+        depth.resize(getDepth<Side>(std::span<LevelSummary>{depth}));
+        return depth;
+    }
+
+    // takes an Order or an OrderCommand
+    constexpr bool isValidOrder(const auto& order) const {
+        std::uint16_t mask = 0;
 
-        constexpr std::uint8_t PRICE_BIT = 1u << 0;
-        constexpr std::uint8_t QTY_BIT = 1u << 1;
-        constexpr std::uint8_t SIDE_BIT = 1u << 2;
-        constexpr std::uint8_t TYPE_BIT = 1u << 3;
-        constexpr std::uint8_t INSTRUMENT_BIT = 1u << 4;
-        constexpr std::uint8_t MARKET_PRICE_BIT = 1u << 5;
+        constexpr std::uint16_t PRICE_BIT = 1u << 0;
+        constexpr std::uint16_t QTY_BIT = 1u << 1;
+        constexpr std::uint16_t SIDE_BIT = 1u << 2;
+        constexpr std::uint16_t TYPE_BIT = 1u << 3;
+        constexpr std::uint16_t INSTRUMENT_BIT = 1u << 4;
+        constexpr std::uint16_t MARKET_PRICE_BIT = 1u << 5;
+        constexpr std::uint16_t TIF_BIT = 1u << 6;
+        constexpr std::uint16_t GOOD_TILL_BIT = 1u << 7;
+        constexpr std::uint16_t PRICE_RULES_BIT = 1u << 8;
 
         mask |= (order.type == OrderType::LIMIT && order.price.value() == 0)
                     ? PRICE_BIT
-                    : std::uint8_t{0};
+                    : std::uint16_t{0};
 
-        mask |= (order.qty.value() == 0) ? QTY_BIT : std::uint8_t{0};
-        mask |= (+order.side > 1) ? SIDE_BIT : std::uint8_t{0};
-        mask |= (+order.type > 1) ? TYPE_BIT : std::uint8_t{0};
+        mask |= (order.qty.value() == 0) ? QTY_BIT : std::uint16_t{0};
+        mask |= (+order.side > 1) ? SIDE_BIT : std::uint16_t{0};
+        mask |= (+order.type > 1) ? TYPE_BIT : std::uint16_t{0};
 
         mask |= (order.instrumentID.value() != instrumentID_) ? INSTRUMENT_BIT
-                                                              : std::uint8_t{0};
+                                                              : std::uint16_t{0};
 
         mask |= ((order.type == OrderType::MARKET && order.price.value() != 0)
                      ? MARKET_PRICE_BIT
-                     : std::uint8_t{0});
+                     : std::uint16_t{0});
+
+        mask |= (+order.tif > +TimeInForce::IMMEDIATE_OR_CANCEL) ? TIF_BIT
+                                                                  : std::uint16_t{0};
+
+        mask |= (order.tif == TimeInForce::GOOD_TILL_DATE && order.goodTill == 0)
+                    ? GOOD_TILL_BIT
+                    : std::uint16_t{0};
+
+        mask |= (order.type == OrderType::LIMIT && !prices_.accepts(order.price.value()))
+                    ? PRICE_RULES_BIT
+                    : std::uint16_t{0};
 
         return mask == 0;
     }
 
 private:
     InstrumentID instrumentID_;
+    // declared before the book, the queues only link orders that live in the pool
+    OrderPool orderPool_;
     Level3OrderBook book;
 
+    // GOOD_TILL_DATE and END_OF_DAY orders that rest on the book, keyed on the expiry
+    // tick; the wheel only links orders, it is cleared together with the book
+    utils::TimerWheel<Order> expiry_;
+    ExpiryConfig expiryConfig_;
+    static constexpr std::size_t kExpiryBatch = 64;
+
+    // Resting orders of one client, as a list for mass cancels and summed per price so
+    // matching sees in O(1) how much of a level belongs to the aggressor.
+    struct OwnLevel {
+        std::size_t count{0};
+        Qty qty{0};
+    };
+    struct ClientBook {
+        ClientOrderList orders;
+        utils::FlatIndex<Price, OwnLevel> bids{8};
+        utils::FlatIndex<Price, OwnLevel> asks{8};
+
+        auto& levels(OrderSide side) noexcept {
+            return side == OrderSide::BUY ? bids : asks;
+        }
+        const auto& levels(OrderSide side) const noexcept {
+            return side == OrderSide::BUY ? bids : asks;
+        }
+    };
+
+    // every client seen so far; the books sit in a deque so the index can point at them
+    utils::FlatIndex<ClientID, ClientBook> clientIndex_;
+    std::deque<ClientBook> clientBooks_;
+    utils::ObjectPool<OwnLevel> ownLevelPool_;
+
+    // L2 reduces of a mass cancel summed per level, published once the orders are gone
+    struct LevelReduce {
+        OrderSide side;
+        Price price;
+        Qty qty;
+    };
+    std::vector<LevelReduce> levelReduces_;
+    utils::FlatIndex<Price, LevelReduce> bidReduces_{64};
+    utils::FlatIndex<Price, LevelReduce> askReduces_{64};
+
+    void addLevelReduce_(const Order& order) {
+        if (!l2queue_ && !eventQueue_) {
+            return;
+        }
+        auto& levels = order.side == OrderSide::BUY ? bidReduces_ : askReduces_;
+        if (LevelReduce* level = levels.find(order.price)) {
+            level->qty += order.qty;
+            return;
+        }
+        levels.insert(order.price,
+                      &levelReduces_.emplace_back(order.side, order.price, order.qty));
+    }
+    void publishLevelReduces_();
+
     utils::spsc_queue_shm<L2OrderBookUpdate>* l2queue_;
     utils::spsc_queue_shm<L3Update>* l3queue_;
 
-    using MatchFunction = MatchResult (MatchingEngine::*)(std::unique_ptr<Order>);
-    MatchFunction dispatchTable_[2][2];
+    SelfTradePrevention selfTrade_;
+    PriceRules prices_;
+    utils::Waiter marketDataWaiter_;
+    utils::WaitSignal* observerSignal_;
+    utils::spsc_queue_shm<EngineEvent>* eventQueue_;
+    std::uint64_t eventSeq_{0};
+    std::vector<SelfTradeCancel> selfTradeCancels_;
+
+    using MatchFunction = MatchResult (MatchingEngine::*)(OrderHandle);
+
+    // second index of the dispatch table
+    enum PolicyIndex : std::uint8_t {
+        LIMIT_POLICY = 0,
+        MARKET_POLICY,
+        IOC_POLICY,
+        FOK_LIMIT_POLICY,
+        FOK_MARKET_POLICY,
+        POLICY_COUNT
+    };
+
+    MatchFunction dispatchTable_[2][POLICY_COUNT];
+
+    template <typename SidePolicy>
+    void fillDispatchRow_(MatchFunction (&row)[POLICY_COUNT]) {
+        row[LIMIT_POLICY] = &MatchingEngine::matchOrder_<SidePolicy, LimitOrderPolicy>;
+        row[MARKET_POLICY] = &MatchingEngine::matchOrder_<SidePolicy, MarketOrderPolicy>;
+        row[IOC_POLICY] =
+            &MatchingEngine::matchOrder_<SidePolicy, ImmediateOrCancelPolicy>;
+        row[FOK_LIMIT_POLICY] =
+            &MatchingEngine::matchOrder_<SidePolicy, FillOrKillPolicy<true>>;
+        row[FOK_MARKET_POLICY] =
+            &MatchingEngine::matchOrder_<SidePolicy, FillOrKillPolicy<false>>;
+    }
+
+    static constexpr PolicyIndex policyIndex_(const Order& order) noexcept {
+        const bool isMarket = order.type == OrderType::MARKET;
+        switch (order.tif) {
+        case TimeInForce::FILL_OR_KILL:
+            return isMarket ? FOK_MARKET_POLICY : FOK_LIMIT_POLICY;
+        case TimeInForce::IMMEDIATE_OR_CANCEL:
+            // a market order never rests anyway
+            return isMarket ? MARKET_POLICY : IOC_POLICY;
+        default:
+            return isMarket ? MARKET_POLICY : LIMIT_POLICY;
+        }
+    }
+
+    // trades of the order that is being processed, reused between calls
+    std::vector<TradeEvent> trades_;
+
+    static std::size_t copyDepth_(const auto& bookSide, std::span<LevelSummary> out) {
+        std::size_t n = 0;
+        for (auto it = bookSide.begin(); it != bookSide.end() && n < out.size(); ++it) {
+            const OrderQueue& queue = it->second;
+            if (queue.totalQty() > 0) {
+                out[n++] = LevelSummary{it->first, queue.totalQty(), queue.size()};
+            }
+        }
+        return n;
+    }
+
+    // timestamp of the L3 events and trades of the command being processed, taken once
+    // per command (or batch) instead of once per event
+    Timestamp eventTime_{0};
+
+    void beginCommand_() {
+        trades_.clear();
+        selfTradeCancels_.clear();
+        eventTime_ = TSCClock::now();
+    }
+
+    MatchResult match_(OrderHandle order);
+    // matches an order that has been validated already
+    MatchResult dispatch_(OrderHandle order);
+    MatchResult rejected_(Qty qty) const;
+    bool cancel_(ClientID clientID, OrderID orderID);
+
+    // How far ahead of the command being processed processBatch() prefetches. The
+    // index slot is fetched first, a few commands later the order it points at.
+    static constexpr std::size_t kPrefetchSlotAhead = 8;
+    static constexpr std::size_t kPrefetchOrderAhead = 4;
+
+    void prefetchAhead_(std::span<const OrderCommand> commands,
+                        std::size_t pos) const noexcept {
+        if (pos + kPrefetchSlotAhead < commands.size()) {
+            const OrderCommand& ahead = commands[pos + kPrefetchSlotAhead];
+            if (ahead.command != CommandType::NEW_ORDER) {
+                book.orderMap.prefetch(ahead.orderID);
+            }
+        }
+        if (pos + kPrefetchOrderAhead < commands.size()) {
+            const OrderCommand& ahead = commands[pos + kPrefetchOrderAhead];
+            if (ahead.command != CommandType::NEW_ORDER) {
+                if (const Order* order = book.orderMap.find(ahead.orderID)) {
+                    __builtin_prefetch(order);
+                }
+            }
+        }
+    }
+    ModifyResult modify_(const ClientID clientID, const OrderID orderID, const Qty newQty,
+                         const Price newPrice);
 
     template <typename SidePolicy, typename OrderTypePolicy>
-    MatchResult matchOrder_(std::unique_ptr<Order> order);
+    MatchResult matchOrder_(OrderHandle order);
 
     void emitObserverEvent_(Price price, Qty amount, OrderSide side,
                             BookUpdateEventType type) {
@@ -133,9 +556,7 @@ private:
             return;
         }
 
-        while (!l2queue_->try_push(ev)) {
-            std::this_thread::yield();
-        }
+        pushMarketData_(*l2queue_, ev);
     }
 
     void emitL3ObserverEvent_(const L3Update& update) {
@@ -143,8 +564,42 @@ private:
             return;
         }
 
-        while (!l3queue_->try_push(update)) {
-            std::this_thread::yield();
+        pushMarketData_(*l3queue_, update);
+    }
+
+    // the single record that replaces the L2 and L3 pushes when eventQueue_ is set
+    void emitEvent_(EngineEventType type, const Order& order, Qty qty, Price price,
+                    OrderID aggressorOrderID = OrderID{0}, TradeID tradeID = TradeID{0}) {
+        emitEvent_(type, order.side, order.orderID, qty, price, aggressorOrderID,
+                   tradeID);
+    }
+    void emitEvent_(EngineEventType type, OrderSide side, OrderID orderID, Qty qty,
+                    Price price, OrderID aggressorOrderID = OrderID{0},
+                    TradeID tradeID = TradeID{0}) {
+        pushMarketData_(*eventQueue_, EngineEvent{.sequence = ++eventSeq_,
+                                                  .timestamp = eventTime_,
+                                                  .price = price,
+                                                  .qty = qty,
+                                                  .orderID = orderID,
+                                                  .aggressorOrderID = aggressorOrderID,
+                                                  .tradeID = tradeID,
+                                                  .instrumentID = instrumentID_,
+                                                  .type = type,
+                                                  .side = side,
+                                                  ._padding = 0});
+    }
+
+    // waits out a full ring with the configured strategy, the observer cannot drop
+    template <typename T>
+    void pushMarketData_(utils::spsc_queue_shm<T>& queue, const T& item) {
+        if (!queue.try_push(item)) {
+            do {
+                marketDataWaiter_.idle();
+            } while (!queue.try_push(item));
+            marketDataWaiter_.reset();
+        }
+        if (observerSignal_) {
+            observerSignal_->notify();
         }
     }
 
@@ -154,6 +609,7 @@ private:
             return orderPrice >= bestPrice;
         }
         constexpr static bool isBuyer() { return true; }
+        constexpr static OrderSide restingSide() { return OrderSide::SELL; }
     };
 
     struct SellSide {
@@ -162,12 +618,14 @@ private:
             return orderPrice <= bestPrice;
         }
         constexpr static bool isBuyer() { return false; }
+        constexpr static OrderSide restingSide() { return OrderSide::BUY; }
     };
 
     struct LimitOrderPolicy {
         constexpr static bool needsPriceCheck = true;
-        static OrderStatus finalize(std::unique_ptr<Order> order, Qty remaining,
-                                    Qty original, [[maybe_unused]] MatchingEngine& eng) {
+        constexpr static bool needsFillCheck = false;
+        static OrderStatus finalize(OrderHandle order, Qty remaining, Qty original,
+                                    [[maybe_unused]] MatchingEngine& eng) {
             OrderStatus status = OrderStatus::NEW;
             if (!remaining) {
                 order->status = OrderStatus::FILLED;
@@ -187,8 +645,10 @@ private:
 
     struct MarketOrderPolicy {
         constexpr static bool needsPriceCheck = false;
-        static OrderStatus finalize(std::unique_ptr<Order> order, Qty remaining,
-                                    Qty original, MatchingEngine&) {
+        constexpr static bool needsFillCheck = false;
+        // whatever is left of a market order is dropped, the handle frees it
+        static OrderStatus finalize(OrderHandle order, Qty remaining, Qty original,
+                                    MatchingEngine&) {
             OrderStatus status = OrderStatus::NEW;
             if (!remaining) {
                 order->status = OrderStatus::FILLED;
@@ -206,10 +666,179 @@ private:
         }
     };
 
-    void addToBook_(std::unique_ptr<Order> order);
+    // a limit order that takes what it can and drops the rest like a market order
+    struct ImmediateOrCancelPolicy {
+        constexpr static bool needsPriceCheck = true;
+        constexpr static bool needsFillCheck = false;
+        static OrderStatus finalize(OrderHandle order, Qty remaining, Qty original,
+                                    MatchingEngine& eng) {
+            return MarketOrderPolicy::finalize(std::move(order), remaining, original,
+                                               eng);
+        }
+    };
+
+    // matches only after canFill_ made sure the whole quantity is there, so a killed
+    // order never touches the book and a filled one always leaves remaining at zero
+    template <bool PriceCheck> struct FillOrKillPolicy {
+        constexpr static bool needsPriceCheck = PriceCheck;
+        constexpr static bool needsFillCheck = true;
+        static OrderStatus finalize(OrderHandle order, Qty remaining, Qty original,
+                                    MatchingEngine& eng) {
+            return MarketOrderPolicy::finalize(std::move(order), remaining, original,
+                                               eng);
+        }
+    };
+
+    // Whether matching would fill the order completely. The cached level totals are
+    // summed first, which rejects a short book without looking at a single order.
+    // Only when they cover the quantity are the client's own orders taken out, per
+    // level from its ClientBook. The modes that stop at the first own order walk the
+    // level where that happens, every other level costs O(1).
+    template <typename SidePolicy, typename OrderTypePolicy>
+    bool canFill_(const Order& order, const auto& bookSide) const {
+        auto crosses = [&order](Price levelPrice) {
+            if constexpr (OrderTypePolicy::needsPriceCheck) {
+                return SidePolicy::pricePasses(order.price, levelPrice);
+            } else {
+                return true;
+            }
+        };
+
+        Qty total{0};
+        for (auto it = bookSide.begin(); it != bookSide.end() && crosses(it->first);
+             ++it) {
+            total += it->second.totalQty();
+            if (total >= order.qty) {
+                break;
+            }
+        }
+        if (total < order.qty) {
+            return false;
+        }
+
+        // a decremented own order uses up quantity just like a trade
+        const ClientBook* self = clientIndex_.find(order.clientID);
+        if (!self || selfTrade_ == SelfTradePrevention::DECREMENT) {
+            return true;
+        }
+
+        const auto& ownLevels = self->levels(SidePolicy::restingSide());
+        const bool stopsAtOwn = selfTrade_ == SelfTradePrevention::CANCEL_NEWEST ||
+                                selfTrade_ == SelfTradePrevention::CANCEL_BOTH;
+
+        Qty available{0};
+        for (auto it = bookSide.begin(); it != bookSide.end() && crosses(it->first);
+             ++it) {
+            const OrderQueue& queue = it->second;
+            const OwnLevel* own = ownLevels.find(it->first);
+            if (!own) {
+                available += queue.totalQty();
+            } else if (!stopsAtOwn) {
+                available += queue.totalQty() - own->qty;
+            } else {
+                // the level holds an own order, so the walk ends before the queue does
+                for (const Order* resting = queue.front();
+                     resting->clientID != order.clientID; resting = resting->next) {
+                    available += resting->qty;
+                    if (available >= order.qty) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+            if (available >= order.qty) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void addToBook_(OrderHandle order);
+
+    // rounded up, an order never expires before its time
+    std::uint64_t expiryTick_(Timestamp time) const noexcept {
+        return (time + expiryConfig_.tickNs - 1) / expiryConfig_.tickNs;
+    }
+
+    // the first end of day after now, when the current one has gone by
+    void rollEndOfDay_(Timestamp now) noexcept {
+        const auto roll = static_cast<Timestamp>(expiryConfig_.endOfDayRoll.count());
+        if (roll == 0 || expiryConfig_.endOfDay == 0 || now < expiryConfig_.endOfDay) {
+            return;
+        }
+        expiryConfig_.endOfDay += ((now - expiryConfig_.endOfDay) / roll + 1) * roll;
+    }
+
+    ClientBook& clientBook_(ClientID clientID);
+    void trackOwn_(ClientBook& client, const Order& order);
+
+    void untrackOwn_(ClientBook& client, const Order& order) noexcept {
+        auto& levels = client.levels(order.side);
+        OwnLevel* own = levels.find(order.price);
+        own->qty -= order.qty;
+        if (--own->count == 0) {
+            levels.erase(order.price);
+            ownLevelPool_.release(own);
+        }
+    }
+
+    // takes a resting order out of every index and hands it back to the pool
+    void releaseResting_(Order* order, OrderQueue& queue) {
+        book.orderMap.erase(order->orderID); // BEFORE unlinking from the queue
+        expiry_.cancel(order->expiry);
+        ClientBook& client = *clientIndex_.find(order->clientID);
+        client.orders.erase(order);
+        untrackOwn_(client, *order);
+        // O(1) unlink through the intrusive links, then back to the freelist
+        orderPool_.release(queue.erase(order));
+    }
+
+    // lowers a resting order that stays on the book, fills go through here as well
+    void reduceResting_(Order* order, OrderQueue& queue, Qty amount) noexcept {
+        queue.reduce(order, amount);
+        clientIndex_.find(order->clientID)
+            ->levels(order->side)
+            .find(order->price)
+            ->qty -= amount;
+    }
+
+    // the L2 and L3 events of a resting order losing amount without a trade
+    void publishReduce_(const Order& order, Qty amount, bool publishLevel = true) {
+        if (eventQueue_) {
+            emitEvent_(publishLevel ? EngineEventType::ORDER_REDUCED
+                                    : EngineEventType::ORDER_MASS_CANCELLED,
+                       order, amount, order.price);
+            return;
+        }
+
+        if (publishLevel) {
+            emitObserverEvent_(order.price, amount, order.side,
+                               BookUpdateEventType::REDUCE);
+        }
+
+        L3Update update{.price = order.price,
+                        .qty = amount,
+                        .orderID = order.orderID,
+                        .clientOrderID = order.clientOrderID,
+                        .timestamp = eventTime_,
+                        .instrumentID = instrumentID_,
+                        .eventType = L3EventType::ORDER_FILL_OR_REDUCE,
+                        .orderType = OrderType::LIMIT,
+                        .orderSide = order.side};
+
+        emitL3ObserverEvent_(update);
+    }
+
+    // Applies the self-trade prevention mode to a resting order of the aggressor's
+    // client, the level stays on the book even if it empties. Returns true when the
+    // rest of the aggressor is cancelled.
+    bool preventSelfTrade_(Order* resting, OrderQueue& queue, Qty& remaining,
+                           Qty& decremented);
+    void cancelSelfTrade_(Order* resting, OrderQueue& queue);
 
+    // publishLevel = false leaves the L2 event to the caller, see massCancel
     template <typename Book>
-    bool removeFromBook_(const OrderID orderID, const Price price, Book& book);
+    bool removeFromBook_(Order* order, Book& bookSide, bool publishLevel = true);
 
     TradeID tradeID_{0};
     OrderID orderID_{0};
@@ -218,11 +847,13 @@ private:
 };
 
 template <typename SidePolicy, typename OrderTypePolicy>
-MatchResult MatchingEngine::matchOrder_(std::unique_ptr<Order> order) {
-    std::vector<TradeEvent> tradeVec{};
-
+MatchResult MatchingEngine::matchOrder_(OrderHandle order) {
     Qty remainingQty = order->qty;
     const Qty originalQty = remainingQty;
+    // taken off by DECREMENT, neither traded nor resting
+    Qty decrementedQty{0};
+    // self-trade prevention cancelled whatever is left of the order
+    bool selfTradeStop = false;
 
     auto& bookSide = SidePolicy::book(*this);
 
@@ -231,9 +862,17 @@ MatchResult MatchingEngine::matchOrder_(std::unique_ptr<Order> order) {
         bestPrice = order->price;
     }
 
-    while (remainingQty.value() && !bookSide.empty()) {
-        auto it = bookSide.begin();
+    bool canMatch = true;
+    if constexpr (OrderTypePolicy::needsFillCheck) {
+        canMatch = canFill_<SidePolicy, OrderTypePolicy>(*order, bookSide);
+    }
+
+    // the aggressor's own resting orders on the side it trades against
+    const ClientBook* self = clientIndex_.find(order->clientID);
+    const auto* ownLevels = self ? &self->levels(SidePolicy::restingSide()) : nullptr;
 
+    auto it = bookSide.begin();
+    while (canMatch && remainingQty.value() && !selfTradeStop && it != bookSide.end()) {
         bestPrice = it->first;
 
         if constexpr (OrderTypePolicy::needsPriceCheck) {
@@ -244,39 +883,56 @@ MatchResult MatchingEngine::matchOrder_(std::unique_ptr<Order> order) {
 
         auto& queue = it->second;
 
-        bool matched = false;
+        const OwnLevel* own = ownLevels ? ownLevels->find(bestPrice) : nullptr;
+        std::size_t othersLeft = queue.size() - (own ? own->count : 0);
+
+        // a level holding nothing but own orders is passed over without walking it
+        if (selfTrade_ == SelfTradePrevention::SKIP && othersLeft == 0) {
+            ++it;
+            continue;
+        }
+
+        for (Order* restingOrder = queue.front(); restingOrder && remainingQty > 0;) {
+            Order* next = restingOrder->next;
 
-        for (auto qIt = queue.begin(); qIt != queue.end() && remainingQty > 0;) {
-            Order* restingOrder = qIt->get();
             if (restingOrder->clientID == order->clientID) {
-                ++qIt;
+                if (preventSelfTrade_(restingOrder, queue, remainingQty,
+                                      decrementedQty)) {
+                    selfTradeStop = true;
+                    break;
+                }
+                restingOrder = next;
                 continue;
             }
-            matched = true;
 
             Qty matchQty = std::min(remainingQty, restingOrder->qty);
-            restingOrder->qty -= matchQty;
             remainingQty -= matchQty;
 
-            OrderSide eventSide =
-                SidePolicy::isBuyer() ? OrderSide::SELL : OrderSide::BUY;
-            emitObserverEvent_(bestPrice, matchQty, eventSide,
-                               BookUpdateEventType::REDUCE);
-
-            // LEVEL 3 ORDER FILLED EVENT
-            L3Update update{
-                .price = bestPrice,
-                .qty = matchQty,
-                .orderID = restingOrder->orderID,
-                .clientOrderID = restingOrder->clientOrderID,
-                .timestamp = TSCClock::now(),
-                .instrumentID = instrumentID_,
-                .eventType = L3EventType::ORDER_FILL_OR_REDUCE,
-                .orderType = OrderType::LIMIT,
-                .orderSide = SidePolicy::isBuyer() ? OrderSide::SELL : OrderSide::BUY,
-            };
-
-            emitL3ObserverEvent_(update);
+            const TradeID tradeID = getNextTradeID_();
+            if (eventQueue_) {
+                emitEvent_(EngineEventType::TRADE, *restingOrder, matchQty, bestPrice,
+                           order->orderID, tradeID);
+            } else {
+                OrderSide eventSide =
+                    SidePolicy::isBuyer() ? OrderSide::SELL : OrderSide::BUY;
+                emitObserverEvent_(bestPrice, matchQty, eventSide,
+                                   BookUpdateEventType::REDUCE);
+
+                // LEVEL 3 ORDER FILLED EVENT
+                L3Update update{
+                    .price = bestPrice,
+                    .qty = matchQty,
+                    .orderID = restingOrder->orderID,
+                    .clientOrderID = restingOrder->clientOrderID,
+                    .timestamp = eventTime_,
+                    .instrumentID = instrumentID_,
+                    .eventType = L3EventType::ORDER_FILL_OR_REDUCE,
+                    .orderType = OrderType::LIMIT,
+                    .orderSide = SidePolicy::isBuyer() ? OrderSide::SELL : OrderSide::BUY,
+                };
+
+                emitL3ObserverEvent_(update);
+            }
 
             OrderID sellerOrderID{}, buyerOrderID{};
             ClientID sellerID{}, buyerID{};
@@ -298,7 +954,7 @@ MatchResult MatchingEngine::matchOrder_(std::unique_ptr<Order> order) {
                 buyerClientOrderID = restingOrder->clientOrderID;
             }
 
-            tradeVec.emplace_back(TradeEvent{.tradeID = getNextTradeID_(),
+            trades_.emplace_back(TradeEvent{.tradeID = tradeID,
                                              .buyerOrderID = buyerOrderID,
                                              .sellerOrderID = sellerOrderID,
                                              .buyerID = buyerID,
@@ -307,31 +963,44 @@ MatchResult MatchingEngine::matchOrder_(std::unique_ptr<Order> order) {
                                              .sellerClientOrderID = sellerClientOrderID,
                                              .qty = matchQty,
                                              .price = bestPrice,
-                                             .timestamp = TSCClock::now(),
+                                             .timestamp = eventTime_,
                                              .instrumentID = instrumentID_});
 
-            if (restingOrder->qty == 0) {
+            if (matchQty == restingOrder->qty) {
                 restingOrder->status = OrderStatus::FILLED;
-                book.orderMap.erase(restingOrder->orderID);
-                qIt = queue.erase(qIt);
+                releaseResting_(restingOrder, queue);
             } else {
-                ++qIt;
+                reduceResting_(restingOrder, queue, matchQty);
             }
-        }
 
-        if (!matched) {
-            break;
+            // under SKIP only own orders are left behind the last one of another client
+            if (--othersLeft == 0 && selfTrade_ == SelfTradePrevention::SKIP) {
+                break;
+            }
+            restingOrder = next;
         }
 
         if (queue.empty()) {
-            bookSide.erase(bestPrice);
+            it = bookSide.erase(it);
+        } else {
+            ++it;
         }
     }
 
     OrderID orderID = order->orderID;
     Timestamp timestamp = order->timestamp;
-    OrderStatus status =
-        OrderTypePolicy::finalize(std::move(order), remainingQty, originalQty, *this);
+    OrderStatus status{};
+    if (selfTradeStop || (decrementedQty > 0 && remainingQty == 0)) {
+        // the rest is cancelled, the handle frees the order
+        status = remainingQty + decrementedQty < originalQty
+                     ? OrderStatus::PARTIALLY_FILLED
+                     : OrderStatus::CANCELLED;
+        order->status = status;
+        order->qty = remainingQty;
+    } else {
+        status = OrderTypePolicy::finalize(std::move(order), remainingQty, originalQty,
+                                           *this);
+    }
 
     MatchResult result{
         .orderID = orderID,
@@ -340,61 +1009,35 @@ MatchResult MatchingEngine::matchOrder_(std::unique_ptr<Order> order) {
         .acceptedPrice = bestPrice,
         .status = status,
         .instrumentID = instrumentID_,
-        .tradeVec = tradeVec,
+        .tradeVec{},
     };
 
     return result;
 }
 
 template <typename Book>
-bool MatchingEngine::removeFromBook_(OrderID orderID, Price price, Book& bookSide) {
-    auto it = bookSide.find(price);
+bool MatchingEngine::removeFromBook_(Order* order, Book& bookSide, bool publishLevel) {
+    auto it = bookSide.find(order->price);
     if (it == bookSide.end()) {
         return false;
     }
 
     OrderQueue& queue = it->second;
 
-    for (auto qIt = queue.begin(); qIt != queue.end(); ++qIt) {
-        Order* order = qIt->get();
-
-        if (order->orderID != orderID) {
-            continue;
-        }
-
 #ifndef NDEBUG
-        // the removal from the registry was not here in v2, it was in the caller. I moved
-        // this here, because it keeps the invariant clearer, the orders that are removed
-        // from the book are also being removed from the registry
-        auto mapIt = book.orderMap.find(orderID);
-        assert(mapIt != book.orderMap.end());
-        assert(mapIt->second == order);
+    // the removal from the registry was not here in v2, it was in the caller. I moved
+    // this here, because it keeps the invariant clearer, the orders that are removed
+    // from the book are also being removed from the registry
+    assert(book.orderMap.find(order->orderID) == order);
 #endif
-        emitObserverEvent_(order->price, order->qty, order->side,
-                           BookUpdateEventType::REDUCE);
-
-        // REDUCE_ORDER LEVEL 3 DATA
-        L3Update update{.price = order->price,
-                        .qty = order->qty,
-                        .orderID = order->orderID,
-                        .clientOrderID = order->clientOrderID,
-                        .timestamp = TSCClock::now(),
-                        .instrumentID = instrumentID_,
-                        .eventType = L3EventType::ORDER_FILL_OR_REDUCE,
-                        .orderType = OrderType::LIMIT,
-                        .orderSide = order->side};
+    // REDUCE_ORDER LEVEL 2 and LEVEL 3 DATA
+    publishReduce_(*order, order->qty, publishLevel);
 
-        emitL3ObserverEvent_(update);
-
-        book.orderMap.erase(orderID); // BEFORE erasing from the queue -- UB otherwise
-        queue.erase(qIt);
-
-        if (queue.empty()) {
-            bookSide.erase(it);
-        }
+    releaseResting_(order, queue);
 
-        return true;
+    if (queue.empty()) {
+        bookSide.erase(it);
     }
 
-    return false;
+    return true;
 }
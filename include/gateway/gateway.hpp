@@ -5,6 +5,7 @@
 #include <atomic>
 #include <cstdint>
 #include <sys/epoll.h>
+#include <vector>
 
 class MiniExchangeGateway {
 public:
@@ -38,10 +39,14 @@ private:
     std::uint16_t port_;
 
     static constexpr int MAX_EVENTS = 128;
+    // upper bound on the time between two runs of the order expiry
+    static constexpr int TIMER_INTERVAL_MS = 10;
     epoll_event events_[MAX_EVENTS];
 
     ProtocolHandler& handler_;
     SessionManager& sessionManager_;
+    // the fds armDirtyFDs_ is working through, kept for its capacity
+    std::vector<int> arming_;
 
     void setupListenSocket_();
     void setupEpoll_();
@@ -50,6 +55,8 @@ private:
     void handleRead_(int fd);
     void handleWrite_(int fd);
     void handleError_(int fd);
+    // requests EPOLLOUT for the sessions that have queued messages since the last pass
+    void armDirtyFDs_();
 
     void addToEpoll_(int fd, std::uint32_t events_);
     void modifyEpoll_(int fd, std::uint32_t events_);
@@ -1,40 +1,95 @@
 #pragma once
 
 #include "market-data/bookEvent.hpp"
+#include "market-data/conflator.hpp"
+#include "market-data/packetBuilder.hpp"
 #include "market-data/udpMulticastTransport.hpp"
+#include "utils/priceLadder.hpp"
 #include "utils/spsc_queue.hpp"
 #include "utils/types.hpp"
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <span>
+#include <vector>
 
 namespace market_data {
 
 struct PublisherConfig {
     std::size_t maxDepth{64};
     std::chrono::milliseconds snapShotInterval{1000};
+    // off by default, every update goes out as it is
+    ConflationConfig conflation{};
+    // several messages share a datagram, mtu 0 sends one message per datagram
+    PacketConfig packing{};
+    // transport.batch datagrams are held and sent by one sendmmsg
+    UDPConfig transport{};
 };
 
+/**
+ * @brief Market-by-price multicast feed.
+ *
+ * Drains the L2 updates of one instrument and sends a delta message per update (or per
+ * net change with conflation on). Every delta sent is applied to a replica book of the
+ * publisher's own, snapshots are taken from it, so a snapshot holds exactly the deltas
+ * up to its sequence number and never reads a book another thread is writing.
+ */
 struct MarketDataPublisher {
 public:
     MarketDataPublisher(utils::spsc_queue<L2OrderBookUpdate>* queue,
-                        const Level2OrderBook& book, InstrumentID instrumentID,
+                        const utils::PriceLadderConfig& book, InstrumentID instrumentID,
                         PublisherConfig cfg);
 
-    void runOnce();
+    // publishes a snapshot when one is due and the pending deltas, returns the number
+    // of deltas
+    std::size_t runOnce();
     void publishSnapshot();
-    void publishDelta();
+    // With conflation on the updates are merged and their net changes go out once the
+    // window is over. The messages are packed into datagrams of up to packing.mtu
+    // bytes, the full ones are held until transport.batch of them are waiting and go
+    // out together at the end of the drain (or once packing.maxDelay is over). Both
+    // timers are only checked here: a parked publisher thread sends what is pending
+    // at most one park later.
+    std::size_t publishDelta();
+    [[nodiscard]] bool hasPending() const { return queue_ && !queue_->empty(); }
+
+    // the levels as the deltas sent so far leave them
+    [[nodiscard]] const Level2OrderBook& book() const noexcept { return replica_; }
+
+    // datagrams sent so far, snapshots included
+    [[nodiscard]] std::uint64_t packetCount() const noexcept { return packetsSent_; }
+    // send calls made for them
+    [[nodiscard]] std::uint64_t syscallCount() const noexcept {
+        return transport_.syscallCount();
+    }
 
 private:
-    void sendPacket_(std::span<const std::byte> messageBytes);
+    void publishDelta_(const L2OrderBookUpdate& update);
+    void flushConflated_(bool force);
+    void sendMessage_(std::span<const std::byte> messageBytes);
+    void flushPackets_();
+    void sendPacket_(std::span<const std::byte> packetBytes);
 
     utils::spsc_queue<L2OrderBookUpdate>* queue_;
-    const Level2OrderBook& book_;
     InstrumentID instrumentID_;
     PublisherConfig cfg_;
 
+    Level2OrderBook replica_;
+
     std::uint64_t msgSqn_{0};
     std::chrono::steady_clock::time_point lastSnapshot_;
+    std::uint64_t packetsSent_{0};
+
+    Conflator conflator_;
+    // when the first update of the pending net changes came in
+    std::chrono::steady_clock::time_point windowStart_;
+
+    // the batch of datagrams being filled, packets_[current_] takes the next message
+    std::vector<PacketBuilder> packets_;
+    std::size_t current_{0};
+    std::vector<std::span<const std::byte>> datagrams_;
+    // when the first message of the pending batch was added
+    std::chrono::steady_clock::time_point packetStart_;
 
     market_data::UDPMulticastTransport transport_;
 };
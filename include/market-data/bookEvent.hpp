@@ -40,3 +40,78 @@ static_assert(sizeof(L3Update) == 48);
 static_assert(std::is_trivially_copyable_v<L3Update>);
 static_assert(std::is_standard_layout_v<L3Update>);
 static_assert(alignof(L3Update) == 8);
+
+enum class EngineEventType : std::uint8_t {
+    // an order rests on the book with qty at price
+    ORDER_ADDED,
+    // a resting order lost qty without a trade: qty-down modify, cancel, expiry,
+    // self-trade prevention. An order that reaches 0 has left the book.
+    ORDER_REDUCED,
+    // the resting order traded qty at price against aggressorOrderID
+    TRADE,
+    // a resting order left the book in a mass cancel, L3 only: the L2 change of its
+    // level follows as one LEVEL_REDUCED after the last order of the cancel
+    ORDER_MASS_CANCELLED,
+    // qty a mass cancel took off the level at price in total, L2 only, orderID is 0
+    LEVEL_REDUCED,
+};
+
+/**
+ * @brief One record of the engine's sequenced output stream.
+ *
+ * Every book change and trade of an engine is a single EngineEvent, numbered from 1
+ * without gaps, and the L2 update, the L3 update and the trade print are all derived
+ * from it (see toL2Update/toL3Update). A fill is one record instead of an L2 and an
+ * L3 push, and every consumer sees the same sequence number for it.
+ */
+struct alignas(8) EngineEvent {
+    std::uint64_t sequence;     // 8
+    Timestamp timestamp;        // 8
+    Price price;                // 8
+    Qty qty;                    // 8
+    OrderID orderID;            // 8, the resting order that changed
+    OrderID aggressorOrderID;   // 8, TRADE only
+    TradeID tradeID;            // 8, TRADE only
+    InstrumentID instrumentID;  // 4
+    EngineEventType type;       // 1
+    OrderSide side;             // 1, side of the resting order
+    std::uint16_t _padding;     // 2
+};
+
+static_assert(sizeof(EngineEvent) == 64);
+static_assert(std::is_trivially_copyable_v<EngineEvent>);
+static_assert(std::is_standard_layout_v<EngineEvent>);
+
+// whether the L2 and the L3 view change with the event
+inline bool hasL2Update(const EngineEvent& event) noexcept {
+    return event.type != EngineEventType::ORDER_MASS_CANCELLED;
+}
+inline bool hasL3Update(const EngineEvent& event) noexcept {
+    return event.type != EngineEventType::LEVEL_REDUCED;
+}
+
+inline L2OrderBookUpdate toL2Update(const EngineEvent& event) noexcept {
+    L2OrderBookUpdate update{};
+    update.price = event.price;
+    update.amount = event.qty;
+    update.side = event.side;
+    update.type = event.type == EngineEventType::ORDER_ADDED
+                      ? BookUpdateEventType::ADD
+                      : BookUpdateEventType::REDUCE;
+    return update;
+}
+
+// the stream does not carry client order ids, clientOrderID is left at 0
+inline L3Update toL3Update(const EngineEvent& event) noexcept {
+    return L3Update{.price = event.price,
+                    .qty = event.qty,
+                    .orderID = event.orderID,
+                    .clientOrderID = ClientOrderID{0},
+                    .timestamp = event.timestamp,
+                    .instrumentID = event.instrumentID,
+                    .eventType = event.type == EngineEventType::ORDER_ADDED
+                                     ? L3EventType::ORDER_ADD_OR_INCREASE
+                                     : L3EventType::ORDER_FILL_OR_REDUCE,
+                    .orderType = OrderType::LIMIT,
+                    .orderSide = event.side};
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "market-data/bookEvent.hpp"
+#include "utils/priceLadder.hpp"
+#include "utils/types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace market_data {
+
+struct ConflationConfig {
+    // merge the updates of a level and publish its net change only
+    bool enabled{false};
+    // how long updates are merged for, 0 publishes the net changes at the end of every
+    // drain of the publisher's ring
+    std::chrono::microseconds window{0};
+};
+
+/**
+ * @brief Merges L2 updates per (side, price) into the net change of each level.
+ *
+ * A level that is hit 200 times between two flushes comes out as a single ADD or
+ * REDUCE of the difference, a level that ends where it started does not come out at
+ * all. Applying the flushed updates to a book gives the same levels as applying every
+ * update that went in. The pending changes are kept in a price ladder per side, so
+ * add() never allocates once the window is anchored.
+ */
+class Conflator {
+public:
+    explicit Conflator(const utils::PriceLadderConfig& cfg = {})
+        : bids_(cfg), asks_(cfg) {}
+
+    void add(const L2OrderBookUpdate& update) {
+        const auto amount = static_cast<std::int64_t>(update.amount.value());
+        const std::int64_t change =
+            update.type == BookUpdateEventType::REDUCE ? -amount : amount;
+        if (update.side == OrderSide::BUY) {
+            bids_[update.price].qty += change;
+        } else {
+            asks_[update.price].qty += change;
+        }
+        ++pending_;
+    }
+
+    // updates merged since the last flush
+    [[nodiscard]] std::size_t pending() const noexcept { return pending_; }
+    [[nodiscard]] bool empty() const noexcept { return pending_ == 0; }
+
+    // Hands sink one L2OrderBookUpdate per level whose quantity changed, bids then
+    // asks, best price first, and starts over. Returns the number of updates handed out.
+    template <typename Sink> std::size_t flush(Sink&& sink) {
+        const std::size_t flushed =
+            flush_(bids_, OrderSide::BUY, sink) + flush_(asks_, OrderSide::SELL, sink);
+        pending_ = 0;
+        return flushed;
+    }
+
+private:
+    struct NetChange {
+        std::int64_t qty{0};
+
+        void clear() noexcept { qty = 0; }
+    };
+
+    template <typename Side, typename Sink>
+    static std::size_t flush_(Side& side, OrderSide orderSide, Sink& sink) {
+        std::size_t flushed = 0;
+        for (const auto& [price, change] : side) {
+            if (change.qty == 0) {
+                continue;
+            }
+            L2OrderBookUpdate update{};
+            update.price = price;
+            update.side = orderSide;
+            update.type =
+                change.qty > 0 ? BookUpdateEventType::ADD : BookUpdateEventType::REDUCE;
+            update.amount = Qty{static_cast<std::uint64_t>(
+                change.qty > 0 ? change.qty : -change.qty)};
+            sink(update);
+            ++flushed;
+        }
+        side.clear();
+        return flushed;
+    }
+
+    utils::PriceLadder<Price, NetChange, std::greater<Price>> bids_;
+    utils::PriceLadder<Price, NetChange, std::less<Price>> asks_;
+    std::size_t pending_{0};
+};
+
+} // namespace market_data
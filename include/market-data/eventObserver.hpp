@@ -0,0 +1,66 @@
+#pragma once
+
+#include "market-data/bookEvent.hpp"
+#include "market-data/l3Observer.hpp"
+#include "market-data/observer.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/waitStrategy.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace market_data {
+
+// Where EventObserver sends what it derives from the engine's event stream, every
+// member may be null
+struct EventViews {
+    // L2 book and the L2 publisher's ring
+    Observer* l2{nullptr};
+    utils::spsc_queue<L2OrderBookUpdate>* l2Queue{nullptr};
+    // the same L2 updates for the conflated L2 publisher
+    utils::spsc_queue<L2OrderBookUpdate>* l2ConflatedQueue{nullptr};
+    // market-by-order book and the L3 publisher's ring
+    L3Observer* l3{nullptr};
+    utils::spsc_queue<L3Update>* l3Queue{nullptr};
+    // the TRADE records as they are, for a trade publisher or a journal
+    utils::spsc_queue<EngineEvent>* trades{nullptr};
+};
+
+/**
+ * @brief Single consumer of an engine's EngineEvent ring.
+ *
+ * Derives the L2 update and the L3 update of every record (and passes trades on) in
+ * stream order, so the L2 book, the market-by-order book and the trade feed all move
+ * with the same sequence number. The observers it feeds are only used for their books,
+ * their own engine rings stay null.
+ */
+class EventObserver {
+public:
+    EventObserver(utils::spsc_queue_shm<EngineEvent>* engineQueue,
+                  const EventViews& views, utils::WaitSignal* mdSignal = nullptr)
+        : engineQueue_(engineQueue), views_(views), mdSignal_(mdSignal) {}
+
+    // Applies the pending events and forwards what was derived from them, the
+    // publishers' signal is notified. Returns the number of events taken off the ring.
+    std::size_t drainQueue();
+    [[nodiscard]] bool hasPending() const {
+        return engineQueue_ && !engineQueue_->empty();
+    }
+
+    void apply(const EngineEvent& event);
+
+    // sequence number of the last event applied, 0 before the first one
+    [[nodiscard]] std::uint64_t lastSequence() const noexcept { return lastSequence_; }
+    // events that did not follow the previous one, always 0 on an intact ring
+    [[nodiscard]] std::uint64_t gapCount() const noexcept { return gaps_; }
+
+private:
+    utils::spsc_queue_shm<EngineEvent>* engineQueue_;
+    EventViews views_;
+    utils::WaitSignal* mdSignal_;
+
+    std::uint64_t lastSequence_{0};
+    std::uint64_t gaps_{0};
+};
+
+} // namespace market_data
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "market-data/bookEvent.hpp"
+#include "utils/objectPool.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+#include "utils/waitStrategy.hpp"
+
+#include <cstddef>
+#include <optional>
+
+namespace market_data {
+
+/**
+ * @brief Market-by-order book built from the engine's L3 ring.
+ *
+ * Drains the L3Update ring of one engine, keeps every resting order in a
+ * Level3OrderBook keyed by order id (in the price-time order the engine matches in)
+ * and forwards the updates to the L3 publisher's ring. An ORDER_ADD_OR_INCREASE puts
+ * a new order at the back of its level, ORDER_FILL_OR_REDUCE lowers it by qty and
+ * removes it once nothing is left, ORDER_CANCELLED removes it. The orders come from
+ * a pool of their own, the book never allocates per update once warmed up.
+ */
+class L3Observer {
+public:
+    L3Observer(utils::spsc_queue_shm<L3Update>* engineQueue,
+               utils::spsc_queue<L3Update>* mdQueue, Level3OrderBook& book,
+               InstrumentID instrumentID, utils::WaitSignal* mdSignal = nullptr,
+               const utils::ObjectPoolConfig& pool = {})
+        : engineQueue_(engineQueue), mdQueue_(mdQueue), book_(book),
+          instrumentID_(instrumentID), mdSignal_(mdSignal), orders_(pool) {}
+
+    L3Observer(const L3Observer&) = delete;
+    L3Observer& operator=(const L3Observer&) = delete;
+
+    // Applies the pending updates and forwards them to the publisher, whose signal is
+    // notified. Returns the number of updates taken off the engine ring.
+    std::size_t drainQueue();
+    [[nodiscard]] bool hasPending() const {
+        return engineQueue_ && !engineQueue_->empty();
+    }
+
+    // applies a single update, drainQueue() calls this for every update it takes
+    void apply(const L3Update& update);
+
+    // the resting order with its remaining qty, nullptr once it left the book
+    [[nodiscard]] const Order* findOrder(OrderID orderID) const {
+        return book_.orderMap.find(orderID);
+    }
+    // quantity resting ahead of the order at its price level, nullopt for an order
+    // that is not on the book. Walks the level up to the order.
+    [[nodiscard]] std::optional<Qty> qtyAhead(OrderID orderID) const;
+    [[nodiscard]] std::size_t orderCount() const noexcept {
+        return orders_.stats().inUse;
+    }
+
+private:
+    void add_(const L3Update& update);
+    void reduce_(Order* order, Qty amount);
+    void remove_(Order* order);
+
+    utils::spsc_queue_shm<L3Update>* engineQueue_;
+    utils::spsc_queue<L3Update>* mdQueue_;
+    Level3OrderBook& book_;
+    InstrumentID instrumentID_;
+    utils::WaitSignal* mdSignal_;
+    OrderPool orders_;
+};
+
+} // namespace market_data
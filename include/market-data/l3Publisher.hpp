@@ -0,0 +1,74 @@
+#pragma once
+
+#include "market-data/bookEvent.hpp"
+#include "market-data/l3Observer.hpp"
+#include "market-data/messages.hpp"
+#include "market-data/udpMulticastTransport.hpp"
+#include "utils/objectPool.hpp"
+#include "utils/priceLadder.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace market_data {
+
+struct L3PublisherConfig {
+    std::chrono::milliseconds snapshotInterval{1000};
+    // a group/port of its own, next to the L2 feed on 9001
+    UDPConfig transport{.port = 9002};
+    // orders of the replica book, sized like the ones of the engine it follows
+    utils::ObjectPoolConfig orderPool{};
+    std::size_t orderMapCapacity{1024};
+};
+
+/**
+ * @brief Market-by-order multicast feed.
+ *
+ * Drains the L3 updates the L3Observer forwards and sends one ORDER_DELTA message per
+ * update, sequenced independently of the L2 feed. The publisher applies every update
+ * it sends to a replica book of its own, so an ORDER_SNAPSHOT (split in parts of up to
+ * MAX_ORDERS_PER_PART orders) is always consistent with the sequence number it
+ * follows, and never reads a book another thread is writing.
+ */
+class L3Publisher {
+public:
+    L3Publisher(utils::spsc_queue<L3Update>* queue, const utils::PriceLadderConfig& book,
+                InstrumentID instrumentID, const L3PublisherConfig& cfg = {});
+
+    L3Publisher(const L3Publisher&) = delete;
+    L3Publisher& operator=(const L3Publisher&) = delete;
+
+    // publishes a snapshot when one is due and the pending updates, returns the number
+    // of updates
+    std::size_t runOnce();
+    void publishSnapshot();
+    std::size_t publishDelta();
+    [[nodiscard]] bool hasPending() const { return queue_ && !queue_->empty(); }
+
+    [[nodiscard]] const L3Observer& book() const noexcept { return replica_; }
+
+private:
+    void publishDelta_(const L3Update& update);
+    void sendPacket_(std::span<const std::byte> messageBytes);
+
+    utils::spsc_queue<L3Update>* queue_;
+    InstrumentID instrumentID_;
+    L3PublisherConfig cfg_;
+
+    Level3OrderBook book_;
+    L3Observer replica_;
+    // reused by every snapshot part
+    std::vector<SnapshotOrder> snapshotOrders_;
+
+    std::uint64_t msgSqn_{0};
+    std::chrono::steady_clock::time_point lastSnapshot_;
+
+    UDPMulticastTransport transport_;
+};
+
+} // namespace market_data
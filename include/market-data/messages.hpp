@@ -3,8 +3,16 @@
 #include <cstdint>
 #include <utility>
 
-enum class MDMsgType : std::uint8_t { DELTA = 0, SNAPSHOT = 1 };
+enum class MDMsgType : std::uint8_t {
+    DELTA = 0,
+    SNAPSHOT = 1,
+    // market-by-order channel, sequenced independently of the L2 messages
+    ORDER_DELTA = 2,
+    ORDER_SNAPSHOT = 3
+};
 enum class MDDeltatype : std::uint8_t { ADD = 0, REDUCE = 1 };
+// same values as L3EventType
+enum class MDOrderEventType : std::uint8_t { ADD = 0, REDUCE = 1, CANCEL = 2 };
 
 #pragma pack(push, 1)
 struct MarketDataHeader {
@@ -47,7 +55,8 @@ public:
 
     struct traits {
         static constexpr std::size_t HEADER_SIZE = 16;
-        static constexpr std::uint8_t PROTOCOL_VERSION = 0x01;
+        // 0x02: a datagram may carry several messages
+        static constexpr std::uint8_t PROTOCOL_VERSION = 0x02;
     };
 };
 #pragma pack(pop)
@@ -183,3 +192,153 @@ public:
 #pragma pack(pop)
 
 static_assert(sizeof(SnapshotLevel) == 16);
+
+// An order entering the book (ADD, also an increase of a known order, which moves it to
+// the back of its level), losing qty to a fill or a modify (REDUCE) or leaving it
+// (CANCEL). qty is the amount added or removed.
+#pragma pack(push, 1)
+struct OrderDeltaPayload {
+    std::uint64_t orderID;
+    std::uint64_t price;
+    std::uint64_t qty;
+    std::uint8_t eventType;
+    std::uint8_t side;
+    std::uint8_t _padding[6];
+
+private:
+    template <typename F, typename Self>
+    static void iterateElementsWithNames(Self& self, F&& func) {
+        func("orderID", self.orderID);
+        func("price", self.price);
+        func("qty", self.qty);
+        func("eventType", self.eventType);
+        func("side", self.side);
+        func("_padding", self._padding);
+    }
+
+public:
+    template <typename F> void iterateElements(F&& func) {
+        iterateHelperWithNames(*this, [&](auto&&, auto& field) {
+            func(field);
+        });
+    }
+
+    template <typename F> void iterateElements(F&& func) const {
+        iterateHelperWithNames(*this, [&](auto&&, const auto& field) {
+            func(field);
+        });
+    }
+
+    template <typename F> void iterateElementsWithNames(F&& func) {
+        iterateHelperWithNames(*this, std::forward<F>(func));
+    }
+
+    template <typename F> void iterateElementsWithNames(F&& func) const {
+        iterateHelperWithNames(*this, std::forward<F>(func));
+    }
+
+    struct traits {
+        static constexpr std::size_t PAYLOAD_SIZE = 32;
+    };
+};
+#pragma pack(pop)
+
+static_assert(sizeof(OrderDeltaPayload) == 32);
+
+// A market-by-order snapshot spans several messages, each with its own sequence number.
+// partIndex counts from 0, the book is complete once the part with lastPart set is in.
+#pragma pack(push, 1)
+struct OrderSnapshotHeader {
+    std::uint32_t orderCount;
+    std::uint16_t partIndex;
+    std::uint8_t lastPart;
+    std::uint8_t _padding;
+
+private:
+    template <typename F, typename Self>
+    static void iterateElementsWithNames(Self& self, F&& func) {
+        func("orderCount", self.orderCount);
+        func("partIndex", self.partIndex);
+        func("lastPart", self.lastPart);
+        func("_padding", self._padding);
+    }
+
+public:
+    template <typename F> void iterateElements(F&& func) {
+        iterateHelperWithNames(*this, [&](auto&&, auto& field) {
+            func(field);
+        });
+    }
+
+    template <typename F> void iterateElements(F&& func) const {
+        iterateHelperWithNames(*this, [&](auto&&, const auto& field) {
+            func(field);
+        });
+    }
+
+    template <typename F> void iterateElementsWithNames(F&& func) {
+        iterateHelperWithNames(*this, std::forward<F>(func));
+    }
+
+    template <typename F> void iterateElementsWithNames(F&& func) const {
+        iterateHelperWithNames(*this, std::forward<F>(func));
+    }
+
+    struct traits {
+        static constexpr std::size_t SNAPSHOT_HEADER_SIZE = 8;
+        // an 8KB part fits MDReceiver's 16KB receive buffer
+        static constexpr std::size_t MAX_ORDERS_PER_PART = 256;
+    };
+};
+#pragma pack(pop)
+
+static_assert(sizeof(OrderSnapshotHeader) == 8);
+
+// Orders of a snapshot go bids then asks, best price first and in queue order within a
+// level, so appending them rebuilds every order's queue position.
+#pragma pack(push, 1)
+struct SnapshotOrder {
+    std::uint64_t orderID;
+    std::uint64_t price;
+    std::uint64_t qty;
+    std::uint8_t side;
+    std::uint8_t _padding[7];
+
+private:
+    template <typename F, typename Self>
+    static void iterateElementsWithNames(Self& self, F&& func) {
+        func("orderID", self.orderID);
+        func("price", self.price);
+        func("qty", self.qty);
+        func("side", self.side);
+        func("_padding", self._padding);
+    }
+
+public:
+    template <typename F> void iterateElements(F&& func) {
+        iterateHelperWithNames(*this, [&](auto&&, auto& field) {
+            func(field);
+        });
+    }
+
+    template <typename F> void iterateElements(F&& func) const {
+        iterateHelperWithNames(*this, [&](auto&&, const auto& field) {
+            func(field);
+        });
+    }
+
+    template <typename F> void iterateElementsWithNames(F&& func) {
+        iterateHelperWithNames(*this, std::forward<F>(func));
+    }
+
+    template <typename F> void iterateElementsWithNames(F&& func) const {
+        iterateHelperWithNames(*this, std::forward<F>(func));
+    }
+
+    struct traits {
+        static constexpr std::size_t ORDER_SIZE = 32;
+    };
+};
+#pragma pack(pop)
+
+static_assert(sizeof(SnapshotOrder) == 32);
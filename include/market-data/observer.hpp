@@ -3,34 +3,40 @@
 #include "market-data/bookEvent.hpp"
 #include "utils/spsc_queue.hpp"
 #include "utils/types.hpp"
+#include "utils/waitStrategy.hpp"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
 
 namespace market_data {
 class Observer {
 public:
     Observer(utils::spsc_queue_shm<L2OrderBookUpdate>* engineQueue,
              utils::spsc_queue<L2OrderBookUpdate>* mdQueue, Level2OrderBook& l2,
-             Level3OrderBook& l3, InstrumentID instrumentID)
+             Level3OrderBook& l3, InstrumentID instrumentID,
+             utils::WaitSignal* mdSignal = nullptr)
         : engineQueue_(engineQueue), mdQueue_(mdQueue), l2book_(l2), l3book_(l3),
-          instrumentID_(instrumentID) {}
+          instrumentID_(instrumentID), mdSignal_(mdSignal) {}
 
     ~Observer() = default;
 
-    void drainQueue();
-
-    template <OrderSide Side> auto getSnapshot() const {
-        if constexpr (Side == OrderSide::BUY) {
-            return l2book_.bids;
-        } else {
-            return l2book_.asks;
-        }
+    // Applies the pending updates and forwards them to the publisher, whose signal is
+    // notified. Returns the number of updates taken off the engine ring.
+    std::size_t drainQueue();
+    [[nodiscard]] bool hasPending() const {
+        return engineQueue_ && !engineQueue_->empty();
     }
 
-private:
-    inline auto& getBook_(OrderSide side);
+    // applies a single update, drainQueue() calls this for every update it takes
+    void apply(const L2OrderBookUpdate& update);
 
-    bool priceBetterOrEqual_(Price incoming, Price resting, OrderSide side);
+    // levels of one side, best first
+    template <OrderSide Side> std::vector<std::pair<Price, Qty>> getSnapshot() const {
+        return l2book_.depth(Side);
+    }
 
-    void addAtPrice_(Price price, Qty amount, OrderSide side);
+private:
     void reduceAtPrice_(Price price, Qty amount, OrderSide side);
 
     utils::spsc_queue_shm<L2OrderBookUpdate>* engineQueue_;
@@ -38,6 +44,7 @@ private:
     Level2OrderBook& l2book_;
     Level3OrderBook& l3book_;
     InstrumentID instrumentID_;
+    utils::WaitSignal* mdSignal_;
 };
 
 } // namespace market_data
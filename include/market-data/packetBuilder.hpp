@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace market_data {
+
+struct PacketConfig {
+    // largest datagram the publisher builds, 0 sends every message on its own
+    std::size_t mtu{1400};
+    // how long a packet may wait for more messages, 0 sends it at the end of every
+    // drain of the publisher's ring
+    std::chrono::microseconds maxDelay{0};
+};
+
+/**
+ * @brief Packs whole market data messages back to back into one datagram.
+ *
+ * Each message keeps its own MarketDataHeader, a receiver walks the datagram by the
+ * payloadLength of every header. The buffer is allocated once, append() copies the
+ * message in or refuses it when the packet has no room left for it.
+ */
+class PacketBuilder {
+public:
+    explicit PacketBuilder(std::size_t capacity) : buffer_(capacity) {}
+
+    // false when the message does not fit in what is left of the packet
+    bool append(std::span<const std::byte> message) {
+        if (message.size() > buffer_.size() - size_) {
+            return false;
+        }
+        std::memcpy(buffer_.data() + size_, message.data(), message.size());
+        size_ += message.size();
+        ++messages_;
+        return true;
+    }
+
+    [[nodiscard]] std::span<const std::byte> data() const noexcept {
+        return {buffer_.data(), size_};
+    }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] std::size_t capacity() const noexcept { return buffer_.size(); }
+    [[nodiscard]] std::size_t messageCount() const noexcept { return messages_; }
+
+    void clear() noexcept {
+        size_ = 0;
+        messages_ = 0;
+    }
+
+private:
+    std::vector<std::byte> buffer_;
+    std::size_t size_{0};
+    std::size_t messages_{0};
+};
+
+} // namespace market_data
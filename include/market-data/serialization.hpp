@@ -8,6 +8,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <span>
 #include <vector>
 
 namespace market_data {
@@ -83,13 +84,14 @@ inline std::array<std::byte, 40> serializeDeltaMessage(std::uint64_t sequenceNum
     return buffer;
 }
 
+// the top maxDepth levels of each side, best first
 inline std::vector<std::byte>
 serializeSnapshotMessage(std::uint64_t sequenceNumber, std::uint32_t instrumentID,
-                         const std::vector<std::pair<Price, Qty>>& bids,
-                         const std::vector<std::pair<Price, Qty>>& asks,
-                         std::size_t maxDepth) {
-    std::uint16_t bidCount = static_cast<std::uint16_t>(std::min(bids.size(), maxDepth));
-    std::uint16_t askCount = static_cast<std::uint16_t>(std::min(asks.size(), maxDepth));
+                         const Level2OrderBook& book, std::size_t maxDepth) {
+    std::uint16_t bidCount =
+        static_cast<std::uint16_t>(std::min(book.bids.size(), maxDepth));
+    std::uint16_t askCount =
+        static_cast<std::uint16_t>(std::min(book.asks.size(), maxDepth));
 
     std::size_t payloadSize = SnapshotHeader::traits::SNAPSHOT_HEADER_SIZE +
                               (bidCount + askCount) * SnapshotLevel::traits::LEVEL_SIZE;
@@ -117,21 +119,121 @@ serializeSnapshotMessage(std::uint64_t sequenceNumber, std::uint32_t instrumentI
     writeBytesAdvance(ptr, snapHeaderBytes.data(),
                       SnapshotHeader::traits::SNAPSHOT_HEADER_SIZE);
 
-    for (std::uint16_t i = 0; i < bidCount; ++i) {
-        SnapshotLevel level{};
-        level.price = bids[i].first.value();
-        level.qty = bids[i].second.value();
+    auto writeLevels = [&ptr](const auto& side, std::uint16_t count) {
+        auto it = side.begin();
+        for (std::uint16_t i = 0; i < count && it != side.end(); ++i, ++it) {
+            SnapshotLevel level{};
+            level.price = it->first.value();
+            level.qty = it->second.qty.value();
+            auto levelBytes = serializeLevel(level);
+            writeBytesAdvance(ptr, levelBytes.data(), SnapshotLevel::traits::LEVEL_SIZE);
+        }
+    };
+    writeLevels(book.bids, bidCount);
+    writeLevels(book.asks, askCount);
 
-        auto levelBytes = serializeLevel(level);
-        writeBytesAdvance(ptr, levelBytes.data(), SnapshotLevel::traits::LEVEL_SIZE);
-    }
+    return buffer;
+}
+
+inline std::array<std::byte, 32> serializeOrderDelta(const OrderDeltaPayload& delta) {
+    std::array<std::byte, 32> buffer{};
+    std::byte* ptr = buffer.data();
+
+    writeIntegerAdvance(ptr, delta.orderID);
+    writeIntegerAdvance(ptr, delta.price);
+    writeIntegerAdvance(ptr, delta.qty);
+    writeByteAdvance(ptr, static_cast<std::byte>(delta.eventType));
+    writeByteAdvance(ptr, static_cast<std::byte>(delta.side));
+
+    writeBytesAdvance(ptr, delta._padding, sizeof(delta._padding));
+
+    return buffer;
+}
+
+inline std::array<std::byte, 8>
+serializeOrderSnapshotHeader(const OrderSnapshotHeader& snapHeader) {
+    std::array<std::byte, 8> buffer{};
+    std::byte* ptr = buffer.data();
+
+    writeIntegerAdvance(ptr, snapHeader.orderCount);
+    writeIntegerAdvance(ptr, snapHeader.partIndex);
+    writeByteAdvance(ptr, static_cast<std::byte>(snapHeader.lastPart));
+    writeByteAdvance(ptr, static_cast<std::byte>(snapHeader._padding));
+
+    return buffer;
+}
+
+inline std::array<std::byte, 32> serializeSnapshotOrder(const SnapshotOrder& order) {
+    std::array<std::byte, 32> buffer{};
+    std::byte* ptr = buffer.data();
+
+    writeIntegerAdvance(ptr, order.orderID);
+    writeIntegerAdvance(ptr, order.price);
+    writeIntegerAdvance(ptr, order.qty);
+    writeByteAdvance(ptr, static_cast<std::byte>(order.side));
+
+    writeBytesAdvance(ptr, order._padding, sizeof(order._padding));
+
+    return buffer;
+}
+
+inline std::array<std::byte, 48>
+serializeOrderDeltaMessage(std::uint64_t sequenceNumber, std::uint32_t instrumentID,
+                           const OrderDeltaPayload& delta) {
+    std::array<std::byte, 48> buffer{};
+    MarketDataHeader header{};
+
+    header.sequenceNumber = sequenceNumber;
+    header.instrumentID = instrumentID;
+    header.payloadLength = OrderDeltaPayload::traits::PAYLOAD_SIZE;
+    header.mdMsgType = +MDMsgType::ORDER_DELTA;
+    header.version = MarketDataHeader::traits::PROTOCOL_VERSION;
+
+    auto headerBytes = serializeHeader(header);
+    std::memcpy(buffer.data(), headerBytes.data(), headerBytes.size());
+
+    auto payloadBytes = serializeOrderDelta(delta);
+    std::memcpy(buffer.data() + MarketDataHeader::traits::HEADER_SIZE,
+                payloadBytes.data(), payloadBytes.size());
+
+    return buffer;
+}
+
+// one part of a market-by-order snapshot, at most MAX_ORDERS_PER_PART orders
+inline std::vector<std::byte>
+serializeOrderSnapshotMessage(std::uint64_t sequenceNumber, std::uint32_t instrumentID,
+                              std::uint16_t partIndex, bool lastPart,
+                              std::span<const SnapshotOrder> orders) {
+    std::size_t payloadSize = OrderSnapshotHeader::traits::SNAPSHOT_HEADER_SIZE +
+                              orders.size() * SnapshotOrder::traits::ORDER_SIZE;
+    std::size_t totalSize = MarketDataHeader::traits::HEADER_SIZE + payloadSize;
+
+    std::vector<std::byte> buffer(totalSize);
+    std::byte* ptr = buffer.data();
+
+    MarketDataHeader header{};
+    header.sequenceNumber = sequenceNumber;
+    header.instrumentID = instrumentID;
+    header.payloadLength = static_cast<std::uint16_t>(payloadSize);
+    header.mdMsgType = +(MDMsgType::ORDER_SNAPSHOT);
+    header.version = MarketDataHeader::traits::PROTOCOL_VERSION;
+
+    auto headerBytes = serializeHeader(header);
+    writeBytesAdvance(ptr, headerBytes.data(), MarketDataHeader::traits::HEADER_SIZE);
+
+    OrderSnapshotHeader snapshotHeader{};
+    snapshotHeader.orderCount = static_cast<std::uint32_t>(orders.size());
+    snapshotHeader.partIndex = partIndex;
+    snapshotHeader.lastPart = lastPart ? 1 : 0;
+    snapshotHeader._padding = 0;
+
+    auto snapHeaderBytes = serializeOrderSnapshotHeader(snapshotHeader);
+    writeBytesAdvance(ptr, snapHeaderBytes.data(),
+                      OrderSnapshotHeader::traits::SNAPSHOT_HEADER_SIZE);
 
-    for (std::uint16_t i = 0; i < askCount; ++i) {
-        SnapshotLevel level{};
-        level.price = asks[i].first.value();
-        level.qty = asks[i].second.value();
-        auto levelBytes = serializeLevel(level);
-        writeBytesAdvance(ptr, levelBytes.data(), SnapshotLevel::traits::LEVEL_SIZE);
+    for (const SnapshotOrder& order : orders) {
+        auto orderBytes = serializeSnapshotOrder(order);
+        writeBytesAdvance(ptr, orderBytes.data(), SnapshotOrder::traits::ORDER_SIZE);
     }
 
     return buffer;
@@ -1,11 +1,16 @@
+#pragma once
+
 #include <arpa/inet.h>
+#include <cstddef>
 #include <cstdint>
 #include <netinet/in.h>
 #include <span>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <string>
+#include <vector>
 
 namespace market_data {
 
@@ -14,6 +19,8 @@ struct UDPConfig {
     std::uint16_t port = 9001;
     std::string interfaceIP = "0.0.0.0";
     int ttl = 1;
+    // most datagrams handed to the kernel by one sendmmsg, 1 sends each with sendto
+    std::size_t batch = 64;
 };
 
 class UDPMulticastTransport {
@@ -34,12 +41,25 @@ public:
     UDPMulticastTransport(UDPMulticastTransport&& other) noexcept = delete;
 
     void send(std::span<const std::byte> data);
+    // Sends the datagrams in order with one sendmmsg per config.batch of them. The
+    // message headers are set up once, a call only points them at the datagrams.
+    // Returns the number of datagrams sent, throws when the kernel refuses the first
+    // one of a call.
+    std::size_t sendBatch(std::span<const std::span<const std::byte>> datagrams);
+
+    [[nodiscard]] std::size_t batchSize() const noexcept { return msgs_.size(); }
+    // sendto and sendmmsg calls made so far
+    [[nodiscard]] std::uint64_t syscallCount() const noexcept { return syscalls_; }
 
 private:
     void initialize();
     UDPConfig config_;
     int sockfd_;
     sockaddr_in addr_;
+
+    std::vector<mmsghdr> msgs_;
+    std::vector<iovec> iovecs_;
+    std::uint64_t syscalls_{0};
 };
 
 } // namespace market_data
@@ -209,16 +209,65 @@ public:
 };
 #pragma pack(pop)
 
+#pragma pack(push, 1)
+struct MassCancelPayload {
+    // orderSide value that selects both sides
+    static constexpr std::uint8_t kBothSides = 2;
+
+    std::uint64_t serverClientID;
+    std::uint64_t minPrice; // inclusive
+    std::uint64_t maxPrice; // inclusive, 0 means no upper bound
+    std::uint32_t instrumentID;
+    std::uint8_t orderSide;
+    std::uint8_t padding[3]{};
+
+private:
+    template <typename F, typename Self>
+    static void iterateHelperWithNames(Self& self, F&& func) {
+        func("serverClientID", self.serverClientID);
+        func("minPrice", self.minPrice);
+        func("maxPrice", self.maxPrice);
+        func("instrumentID", self.instrumentID);
+        func("orderSide", self.orderSide);
+        func("padding", self.padding);
+    }
+
+public:
+    template <typename F> void iterateElements(F&& func) {
+        iterateHelperWithNames(*this, [&](auto&&, auto& field) { func(field); });
+    }
+
+    template <typename F> void iterateElements(F&& func) const {
+        iterateHelperWithNames(*this, [&](auto&&, auto& field) { func(field); });
+    }
+
+    template <typename F> void iterateElementsWithNames(F&& func) {
+        iterateHelperWithNames(*this, std::forward<F>(func));
+    }
+
+    template <typename F> void iterateElementsWithNames(F&& func) const {
+        iterateHelperWithNames(*this, std::forward<F>(func));
+    }
+
+    struct traits {
+        static constexpr std::size_t payloadSize = 32;
+        static constexpr MessageType type = MessageType::MASS_CANCEL;
+    };
+};
+#pragma pack(pop)
+
 static_assert(HelloPayload::traits::payloadSize == sizeof(HelloPayload));
 static_assert(LogoutPayload::traits::payloadSize == sizeof(LogoutPayload));
 static_assert(NewOrderPayload::traits::payloadSize == sizeof(NewOrderPayload));
 static_assert(CancelOrderPayload::traits::payloadSize == sizeof(CancelOrderPayload));
 static_assert(ModifyOrderPayload::traits::payloadSize == sizeof(ModifyOrderPayload));
+static_assert(MassCancelPayload::traits::payloadSize == sizeof(MassCancelPayload));
 
 static_assert(HelloPayload::traits::type == MessageType::HELLO);
 static_assert(LogoutPayload::traits::type == MessageType::LOGOUT);
 static_assert(NewOrderPayload::traits::type == MessageType::NEW_ORDER);
 static_assert(CancelOrderPayload::traits::type == MessageType::CANCEL_ORDER);
 static_assert(ModifyOrderPayload::traits::type == MessageType::MODIFY_ORDER);
+static_assert(MassCancelPayload::traits::type == MessageType::MASS_CANCEL);
 
 } // namespace client
@@ -1,25 +1,56 @@
 #pragma once
 
 #include "api/api.hpp"
+#include "core/engineShards.hpp"
+#include "core/engineThread.hpp"
 #include "protocol/messages.hpp"
 #include "protocol/serverMessages.hpp"
 #include "sessions/sessionManager.hpp"
 #include "utils/status.hpp"
 #include "utils/types.hpp"
 #include <optional>
+#include <span>
 #include <unordered_set>
+#include <vector>
 
 class ProtocolHandler {
 public:
-    ProtocolHandler(SessionManager& sm, MiniExchangeAPI& api)
-        : sessionManager_(sm), api_(api), dirtyFDs_() {}
+    // With engine threads the orders go through the rings of their instrument's shard
+    // and api is not touched, the gateway has to call drainResponses() to get the acks.
+    ProtocolHandler(SessionManager& sm, MiniExchangeAPI& api,
+                    EngineShards* shards = nullptr)
+        : sessionManager_(sm), api_(api), shards_(shards), dirtyFDs_() {}
 
     void onMessage(int fd);
     [[nodiscard]] std::unordered_set<int>& getDirtyFDs() { return dirtyFDs_; }
+    // fds that turned dirty since the last call, each listed once until it is cleared
+    // again. The gateway arms EPOLLOUT for these only.
+    [[nodiscard]] std::vector<int>& getNewlyDirtyFDs() { return newlyDirtyFDs_; }
 
     void clearDirtyFD(int fd) { dirtyFDs_.erase(fd); }
 
+    // Expires the orders that are due and queues an EXPIRED cancel ack for each of them.
+    // Returns whether expiries are still pending because the time budget ran out. A
+    // no-op with engine threads, which run the expiry themselves.
+    bool runTimers();
+
+    [[nodiscard]] bool usesEngineThread() const { return shards_ != nullptr; }
+
+    // Serializes what the engine threads have answered so far into the send buffers.
+    // Returns the number of responses taken off the rings.
+    std::size_t drainResponses();
+
+    // Cancel on disconnect, pulls every resting order of the session's client. Called
+    // by the gateway before the session is removed.
+    void onDisconnect(int fd);
+
 private:
+    void markDirty_(int fd) {
+        if (dirtyFDs_.insert(fd).second) {
+            newlyDirtyFDs_.push_back(fd);
+        }
+    }
+
     void processMessages_(Session& session);
     std::size_t handleMessage_(Session& session, std::span<const std::byte> messageBytes);
 
@@ -28,9 +59,22 @@ private:
     std::size_t handleNewOrder_(Session& session, std::span<const std::byte> msg);
     std::size_t handleModifyOrder_(Session& session, std::span<const std::byte> msg);
     std::size_t handleCancel_(Session& session, std::span<const std::byte> msg);
+    std::size_t handleMassCancel_(Session& session, std::span<const std::byte> msg);
 
     std::optional<MessageHeader> peekHeader_(std::span<const std::byte> view) const;
 
+    // Hands the order commands queued from the session's read burst to the engine in
+    // one processBatch() call and answers them in order.
+    void flushBatch_(Session& session);
+    // engine thread mode, waits for space in the request ring of the request's shard,
+    // a CANCEL_ALL goes to every shard
+    void pushRequest_(const EngineRequest& request);
+    void pushRequest_(std::size_t shard, const EngineRequest& request);
+    void handleResponse_(const EngineResponse& response);
+    void sendTrades_(std::span<const TradeEvent> trades);
+    // SELF_TRADE cancel acks for resting orders that self-trade prevention cancelled
+    void sendSelfTradeCancels_(std::span<const SelfTradeCancel> cancels);
+
     Message<server::HelloAckPayload> makeHelloAck_(Session& session,
                                                    status::HelloAckStatus statusCode);
     Message<server::LogoutAckPayload> makeLogoutAck_(Session& session,
@@ -45,10 +89,20 @@ private:
                                                      ClientOrderID clientOrderID);
     Message<server::CancelAckPayload> makeCancelAck_(Session& session, OrderID orderID,
                                                      ClientOrderID clientOrderID,
-                                                     InstrumentID instrID, bool success);
+                                                     InstrumentID instrID,
+                                                     status::CancelStatus statusCode);
+    Message<server::MassCancelAckPayload>
+    makeMassCancelAck_(Session& session, std::size_t cancelledCount, InstrumentID instrID,
+                       status::CancelStatus statusCode);
 
     SessionManager& sessionManager_;
     MiniExchangeAPI& api_;
+    EngineShards* shards_;
 
     std::unordered_set<int> dirtyFDs_;
+    std::vector<int> newlyDirtyFDs_;
+
+    // order commands of the read burst that is being processed, and their results
+    std::vector<OrderCommand> batch_;
+    std::vector<CommandResult> batchResults_;
 };
@@ -269,12 +269,55 @@ public:
 };
 #pragma pack(pop)
 
+#pragma pack(push, 1)
+struct MassCancelAckPayload {
+    std::uint64_t serverClientID;
+    std::uint64_t cancelledCount;
+    std::uint32_t instrumentID;
+    std::uint8_t status;
+    std::uint8_t padding[3]{};
+
+private:
+    template <typename F, typename Self>
+    static void iterateHelperWithNames(Self& self, F&& func) {
+        func("serverClientID", self.serverClientID);
+        func("cancelledCount", self.cancelledCount);
+        func("instrumentID", self.instrumentID);
+        func("status", self.status);
+        func("padding", self.padding);
+    }
+
+public:
+    template <typename F> void iterateElements(F&& func) {
+        iterateHelperWithNames(*this, [&](auto&&, auto& field) { func(field); });
+    }
+
+    template <typename F> void iterateElements(F&& func) const {
+        iterateHelperWithNames(*this, [&](auto&&, auto& field) { func(field); });
+    }
+
+    template <typename F> void iterateElementsWithNames(F&& func) {
+        iterateHelperWithNames(*this, std::forward<F>(func));
+    }
+
+    template <typename F> void iterateElementsWithNames(F&& func) const {
+        iterateHelperWithNames(*this, std::forward<F>(func));
+    }
+
+    struct traits {
+        static constexpr std::size_t payloadSize = 24;
+        static constexpr MessageType type = MessageType::MASS_CANCEL_ACK;
+    };
+};
+#pragma pack(pop)
+
 static_assert(HelloAckPayload::traits::payloadSize == sizeof(HelloAckPayload));
 static_assert(LogoutAckPayload::traits::payloadSize == sizeof(LogoutAckPayload));
 static_assert(OrderAckPayload::traits::payloadSize == sizeof(OrderAckPayload));
 static_assert(CancelAckPayload::traits::payloadSize == sizeof(CancelAckPayload));
 static_assert(ModifyAckPayload::traits::payloadSize == sizeof(ModifyAckPayload));
 static_assert(TradePayload::traits::payloadSize == sizeof(TradePayload));
+static_assert(MassCancelAckPayload::traits::payloadSize == sizeof(MassCancelAckPayload));
 
 static_assert(HelloAckPayload::traits::type == MessageType::HELLO_ACK);
 static_assert(LogoutAckPayload::traits::type == MessageType::LOGOUT_ACK);
@@ -282,5 +325,6 @@ static_assert(OrderAckPayload::traits::type == MessageType::ORDER_ACK);
 static_assert(CancelAckPayload::traits::type == MessageType::CANCEL_ACK);
 static_assert(ModifyAckPayload::traits::type == MessageType::MODIFY_ACK);
 static_assert(TradePayload::traits::type == MessageType::TRADE);
+static_assert(MassCancelAckPayload::traits::type == MessageType::MASS_CANCEL_ACK);
 
 } // namespace server
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+struct FlatIndexStats {
+    std::size_t size{0};
+    std::size_t capacity{0};
+    double loadFactor{0.0};
+    double meanProbe{0.0}; // average distance of an entry from its home slot
+    std::size_t maxProbe{0};
+};
+
+/**
+ * @brief Open-addressing index from an integer id to a non-owning pointer.
+ *
+ * Robin Hood linear probing over a flat power-of-two array of {key, pointer} pairs,
+ * the home slot of a key is `key & mask`. Engine order ids are handed out
+ * monotonically, so the live ids form a sliding window that maps onto the table like
+ * a ring and almost never collides. A null pointer marks an empty slot.
+ *
+ * Entries of a cluster are kept ordered by their home slot (an entry that is further
+ * from home takes the slot of one that is closer), which lets lookups of missing keys
+ * and deletions stop at the first entry that sits in its home slot instead of walking
+ * the whole cluster. Deletion shifts the following entries back by one rather than
+ * leaving tombstones, so the table never needs to be cleaned up.
+ *
+ * @tparam Key StrongType id exposing value()
+ * @tparam T pointee type, the index stores T*
+ */
+template <typename Key, typename T> class FlatIndex {
+public:
+    explicit FlatIndex(std::size_t initialCapacity = 1024)
+        : slots_(std::bit_ceil(std::max<std::size_t>(initialCapacity, 8))),
+          mask_(slots_.size() - 1) {}
+
+    // returns nullptr when the key is not present
+    [[nodiscard]] T* find(Key key) const noexcept {
+        const std::size_t pos = locate_(key.value());
+        return pos == npos ? nullptr : slots_[pos].value;
+    }
+
+    [[nodiscard]] bool contains(Key key) const noexcept { return find(key) != nullptr; }
+
+    // pulls the home slot of key into the cache ahead of a find()
+    void prefetch(Key key) const noexcept {
+        __builtin_prefetch(&slots_[home_(key.value())]);
+    }
+
+    // inserts or overwrites the entry for key, value must not be null
+    void insert(Key key, T* value) {
+        if ((size_ + 1) * kMaxLoadDen > slots_.size() * kMaxLoadNum) {
+            rehash_(slots_.size() * 2);
+        }
+        place_(Slot{key.value(), value});
+    }
+
+    bool erase(Key key) noexcept {
+        std::size_t hole = locate_(key.value());
+        if (hole == npos) {
+            return false;
+        }
+
+        // backward shift, the cluster ends at an empty slot or at an entry in its home
+        for (std::size_t j = (hole + 1) & mask_; slots_[j].value && distance_(j) != 0;
+             j = (j + 1) & mask_) {
+            slots_[hole] = slots_[j];
+            hole = j;
+        }
+
+        slots_[hole] = Slot{};
+        --size_;
+        return true;
+    }
+
+    void clear() noexcept {
+        std::fill(slots_.begin(), slots_.end(), Slot{});
+        size_ = 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] std::size_t capacity() const noexcept { return slots_.size(); }
+    [[nodiscard]] double loadFactor() const noexcept {
+        return static_cast<double>(size_) / static_cast<double>(slots_.size());
+    }
+
+    // walks the whole table, meant for diagnostics and benchmarks
+    [[nodiscard]] FlatIndexStats stats() const noexcept {
+        FlatIndexStats s{
+            .size = size_, .capacity = slots_.size(), .loadFactor = loadFactor()};
+
+        std::size_t totalProbe = 0;
+        for (std::size_t i = 0; i < slots_.size(); ++i) {
+            if (!slots_[i].value) {
+                continue;
+            }
+            const std::size_t probe = distance_(i);
+            totalProbe += probe;
+            s.maxProbe = std::max(s.maxProbe, probe);
+        }
+        if (size_) {
+            s.meanProbe = static_cast<double>(totalProbe) / static_cast<double>(size_);
+        }
+        return s;
+    }
+
+private:
+    struct Slot {
+        std::uint64_t key{0};
+        T* value{nullptr};
+    };
+
+    // grow once the table is 70% full
+    static constexpr std::size_t kMaxLoadNum = 7;
+    static constexpr std::size_t kMaxLoadDen = 10;
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    std::size_t home_(std::uint64_t key) const noexcept { return key & mask_; }
+
+    // how far the entry in slot i is from its home slot
+    std::size_t distance_(std::size_t i) const noexcept {
+        return (i - home_(slots_[i].key)) & mask_;
+    }
+
+    std::size_t locate_(std::uint64_t key) const noexcept {
+        std::size_t i = home_(key);
+        for (std::size_t dist = 0;; ++dist, i = (i + 1) & mask_) {
+            const Slot& slot = slots_[i];
+            // an entry closer to home than we are means the key would have been here
+            if (!slot.value || distance_(i) < dist) {
+                return npos;
+            }
+            if (slot.key == key) {
+                return i;
+            }
+        }
+    }
+
+    void place_(Slot entry) noexcept {
+        std::size_t i = home_(entry.key);
+        for (std::size_t dist = 0;; ++dist, i = (i + 1) & mask_) {
+            Slot& slot = slots_[i];
+            if (!slot.value) {
+                slot = entry;
+                ++size_;
+                return;
+            }
+            if (slot.key == entry.key) {
+                slot.value = entry.value;
+                return;
+            }
+
+            const std::size_t slotDist = distance_(i);
+            if (slotDist < dist) {
+                // take the slot from the entry that is closer to home and carry it on,
+                // from here on the key cannot be in the table anymore
+                std::swap(slot, entry);
+                displace_(entry, (i + 1) & mask_, slotDist + 1);
+                return;
+            }
+        }
+    }
+
+    void displace_(Slot entry, std::size_t i, std::size_t dist) noexcept {
+        for (;; ++dist, i = (i + 1) & mask_) {
+            Slot& slot = slots_[i];
+            if (!slot.value) {
+                slot = entry;
+                ++size_;
+                return;
+            }
+
+            const std::size_t slotDist = distance_(i);
+            if (slotDist < dist) {
+                std::swap(slot, entry);
+                dist = slotDist;
+            }
+        }
+    }
+
+    void rehash_(std::size_t newCapacity) {
+        std::vector<Slot> old(newCapacity);
+        old.swap(slots_);
+        mask_ = newCapacity - 1;
+        size_ = 0;
+
+        for (const Slot& slot : old) {
+            if (slot.value) {
+                displace_(slot, home_(slot.key), 0);
+            }
+        }
+    }
+
+    std::vector<Slot> slots_;
+    std::size_t mask_;
+    std::size_t size_{0};
+};
+
+} // namespace utils
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+struct ObjectPoolConfig {
+    std::size_t initialCapacity{16 * 1024};
+    // slots added when the freelist runs dry, 0 doubles the current capacity
+    std::size_t growBy{0};
+    // hard limit on the number of slots, 0 means unbounded
+    std::size_t maxCapacity{0};
+};
+
+struct ObjectPoolStats {
+    std::size_t capacity{0};
+    std::size_t inUse{0};
+    std::size_t highWaterMark{0};
+    std::size_t chunks{0};
+    std::size_t acquired{0}; // lifetime number of objects handed out
+};
+
+template <typename T> class ObjectPool;
+
+/**
+ * @brief Unique owner of an object that lives in an ObjectPool.
+ *
+ * Behaves like std::unique_ptr, the object goes back to the pool's freelist when the
+ * handle is destroyed or reset. release() gives up ownership without freeing, the
+ * caller is then responsible for handing the pointer back via ObjectPool::release.
+ */
+template <typename T> class PoolHandle {
+public:
+    PoolHandle() = default;
+    PoolHandle(T* ptr, ObjectPool<T>* pool) noexcept : ptr_(ptr), pool_(pool) {}
+
+    ~PoolHandle() { reset(); }
+
+    PoolHandle(const PoolHandle&) = delete;
+    PoolHandle& operator=(const PoolHandle&) = delete;
+
+    PoolHandle(PoolHandle&& other) noexcept
+        : ptr_(std::exchange(other.ptr_, nullptr)), pool_(other.pool_) {}
+
+    PoolHandle& operator=(PoolHandle&& other) noexcept {
+        if (this != &other) {
+            reset();
+            ptr_ = std::exchange(other.ptr_, nullptr);
+            pool_ = other.pool_;
+        }
+        return *this;
+    }
+
+    void reset() noexcept {
+        if (ptr_) {
+            pool_->release(std::exchange(ptr_, nullptr));
+        }
+    }
+
+    [[nodiscard]] T* release() noexcept { return std::exchange(ptr_, nullptr); }
+
+    T* get() const noexcept { return ptr_; }
+    T* operator->() const noexcept { return ptr_; }
+    T& operator*() const noexcept { return *ptr_; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+private:
+    T* ptr_{nullptr};
+    ObjectPool<T>* pool_{nullptr};
+};
+
+/**
+ * @brief Slab allocator with an intrusive LIFO freelist.
+ *
+ * Objects are carved out of cache-line aligned chunks, every slot is padded to a
+ * multiple of the cache line size so two objects never share a line. Chunks are only
+ * returned to the system when the pool is destroyed, so once the pool has grown to
+ * the working set acquire/release never touch the heap.
+ *
+ * The pool does not track live objects, T has to be trivially destructible so that
+ * dropping the chunks is enough to clean up whatever is still in use.
+ */
+template <typename T> class ObjectPool {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "pooled objects are not destroyed when the pool goes away");
+
+    static constexpr std::size_t kCacheLine = 64;
+
+    union alignas(kCacheLine) Slot {
+        Slot* next;
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+public:
+    explicit ObjectPool(const ObjectPoolConfig& cfg = ObjectPoolConfig{}) : cfg_(cfg) {
+        std::size_t initial = std::max<std::size_t>(cfg_.initialCapacity, 1);
+        if (cfg_.maxCapacity) {
+            initial = std::min(initial, cfg_.maxCapacity);
+        }
+        grow_(initial);
+    }
+
+    ~ObjectPool() {
+        for (auto& chunk : chunks_) {
+            ::operator delete(chunk.slots, std::align_val_t{alignof(Slot)});
+        }
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+    ObjectPool(ObjectPool&&) = delete;
+    ObjectPool& operator=(ObjectPool&&) = delete;
+
+    // returns an empty handle when the pool is at maxCapacity
+    template <typename... Args> [[nodiscard]] PoolHandle<T> make(Args&&... args) {
+        Slot* slot = acquire_();
+        if (!slot) {
+            return PoolHandle<T>{};
+        }
+
+        T* obj = ::new (static_cast<void*>(slot->storage)) T(std::forward<Args>(args)...);
+        return PoolHandle<T>{obj, this};
+    }
+
+    void release(T* obj) noexcept {
+        obj->~T();
+        Slot* slot = reinterpret_cast<Slot*>(obj);
+        slot->next = freeList_;
+        freeList_ = slot;
+        --stats_.inUse;
+    }
+
+    [[nodiscard]] const ObjectPoolStats& stats() const noexcept { return stats_; }
+    [[nodiscard]] static constexpr std::size_t slotSize() noexcept {
+        return sizeof(Slot);
+    }
+
+private:
+    struct Chunk {
+        Slot* slots;
+        std::size_t count;
+    };
+
+    Slot* acquire_() {
+        if (!freeList_ && !grow_(nextGrowth_())) {
+            return nullptr;
+        }
+
+        Slot* slot = freeList_;
+        freeList_ = slot->next;
+
+        ++stats_.acquired;
+        if (++stats_.inUse > stats_.highWaterMark) {
+            stats_.highWaterMark = stats_.inUse;
+        }
+        return slot;
+    }
+
+    std::size_t nextGrowth_() const {
+        std::size_t growth = cfg_.growBy ? cfg_.growBy : stats_.capacity;
+        if (cfg_.maxCapacity) {
+            growth = stats_.capacity >= cfg_.maxCapacity
+                         ? 0
+                         : std::min(growth, cfg_.maxCapacity - stats_.capacity);
+        }
+        return growth;
+    }
+
+    bool grow_(std::size_t count) {
+        if (count == 0) {
+            return false;
+        }
+
+        auto* slots = static_cast<Slot*>(
+            ::operator new(sizeof(Slot) * count, std::align_val_t{alignof(Slot)}));
+        chunks_.push_back(Chunk{slots, count});
+
+        // thread the new slots onto the freelist in address order
+        for (std::size_t i = count; i-- > 0;) {
+            slots[i].next = freeList_;
+            freeList_ = &slots[i];
+        }
+
+        stats_.capacity += count;
+        stats_.chunks = chunks_.size();
+        return true;
+    }
+
+    ObjectPoolConfig cfg_;
+    Slot* freeList_{nullptr};
+    std::vector<Chunk> chunks_;
+    ObjectPoolStats stats_;
+};
+
+} // namespace utils
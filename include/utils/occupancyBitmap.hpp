@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utils {
+
+/**
+ * @brief Multi-level bitset that finds the next set bit in O(levels).
+ *
+ * Level 0 has one bit per position, every bit of level n+1 says whether the matching
+ * 64-bit word of level n has any bit set. The top level is a single word, so with 64
+ * bit words 4096 positions need two levels and 262144 need three. findNext() climbs
+ * until a word with a set bit at or after the position is found and descends with
+ * countr_zero (tzcnt/bsf), no matter how many empty positions are skipped.
+ */
+class OccupancyBitmap {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    OccupancyBitmap() = default;
+    explicit OccupancyBitmap(std::size_t size) { resize(size); }
+
+    // resets every bit
+    void resize(std::size_t size) {
+        size_ = size;
+        levels_.clear();
+
+        std::size_t bits = size;
+        do {
+            const std::size_t words = (bits + kWordBits - 1) / kWordBits;
+            levels_.emplace_back(words, 0);
+            bits = words;
+        } while (bits > 1);
+    }
+
+    [[nodiscard]] bool test(std::size_t pos) const noexcept {
+        return (levels_[0][pos / kWordBits] >> (pos % kWordBits)) & 1u;
+    }
+
+    void set(std::size_t pos) noexcept {
+        for (auto& words : levels_) {
+            std::uint64_t& word = words[pos / kWordBits];
+            const bool wasEmpty = word == 0;
+            word |= bit_(pos);
+            if (!wasEmpty) {
+                break;
+            }
+            pos /= kWordBits;
+        }
+    }
+
+    void reset(std::size_t pos) noexcept {
+        for (auto& words : levels_) {
+            std::uint64_t& word = words[pos / kWordBits];
+            word &= ~bit_(pos);
+            if (word != 0) {
+                break;
+            }
+            pos /= kWordBits;
+        }
+    }
+
+    // first set position >= from, npos if there is none
+    [[nodiscard]] std::size_t findNext(std::size_t from) const noexcept {
+        if (from >= size_) {
+            return npos;
+        }
+
+        std::size_t level = 0;
+        std::size_t pos = from;
+        for (;;) {
+            const auto& words = levels_[level];
+            const std::size_t w = pos / kWordBits;
+            if (w >= words.size()) {
+                return npos;
+            }
+
+            const std::uint64_t bits =
+                words[w] & (~std::uint64_t{0} << (pos % kWordBits));
+            if (bits) {
+                pos = w * kWordBits + static_cast<std::size_t>(std::countr_zero(bits));
+                break;
+            }
+            if (level + 1 == levels_.size()) {
+                return npos;
+            }
+
+            // nothing left in this word, continue from the next word one level up
+            pos = w + 1;
+            ++level;
+        }
+
+        while (level-- > 0) {
+            pos = pos * kWordBits +
+                  static_cast<std::size_t>(std::countr_zero(levels_[level][pos]));
+        }
+        return pos;
+    }
+
+    [[nodiscard]] bool any() const noexcept {
+        return !levels_.empty() && levels_.back()[0] != 0;
+    }
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+    void clear() noexcept {
+        for (auto& words : levels_) {
+            std::fill(words.begin(), words.end(), 0);
+        }
+    }
+
+private:
+    static constexpr std::size_t kWordBits = 64;
+
+    static constexpr std::uint64_t bit_(std::size_t pos) noexcept {
+        return std::uint64_t{1} << (pos % kWordBits);
+    }
+
+    std::size_t size_{0};
+    std::vector<std::vector<std::uint64_t>> levels_;
+};
+
+} // namespace utils
@@ -0,0 +1,331 @@
+#pragma once
+
+#include "utils/occupancyBitmap.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+struct PriceLadderConfig {
+    // centre of the tick window, 0 means the window is anchored on the first price
+    // that is inserted into the ladder
+    std::uint64_t referencePrice{0};
+    std::size_t ticks{4096};
+    // price step between two levels of the window, every price inserted has to be a
+    // multiple of it (the PriceRules of an instrument only let such prices through)
+    std::uint64_t tickSize{1};
+};
+
+/**
+ * @brief Tick-indexed price level container with a std::map compatible interface.
+ *
+ * Levels inside a contiguous window of `ticks` prices, `tickSize` apart, around the
+ * reference price live in a flat array indexed by their distance in ticks from the
+ * best possible price of the window, prices that fall outside of the window are kept
+ * in a sparse std::map. The
+ * window is laid out in Compare order, so iteration is always best to worst:
+ *
+ *   [overflow levels better than the window] [window] [overflow levels worse]
+ *
+ * Inserting into a window level is O(1) and the best level is cached so begin() is
+ * O(1) as well. The occupied ticks are tracked in an OccupancyBitmap, so moving on to
+ * the next level after the best one is emptied costs a handful of word operations
+ * however wide the gap to it is.
+ *
+ * @tparam Key StrongType price, must be constructible from and expose value()
+ * @tparam T level payload, must be default constructible and provide clear()
+ * @tparam Compare std::less for asks (lowest first), std::greater for bids
+ */
+template <typename Key, typename T, typename Compare = std::less<Key>> class PriceLadder {
+    using map_type = std::map<Key, T, Compare>;
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = std::size_t;
+
+    template <bool Const> class basic_iterator {
+        using ladder_pointer =
+            std::conditional_t<Const, const PriceLadder*, PriceLadder*>;
+        using map_iterator = std::conditional_t<Const, typename map_type::const_iterator,
+                                                typename map_type::iterator>;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = PriceLadder::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+
+        basic_iterator() = default;
+
+        // iterator -> const_iterator
+        template <bool C = Const, typename = std::enable_if_t<C>>
+        basic_iterator(const basic_iterator<false>& other)
+            : ladder_(other.ladder_), rank_(other.rank_), mapIt_(other.mapIt_) {}
+
+        reference operator*() const {
+            return rank_ == npos ? *mapIt_ : ladder_->slots_[rank_];
+        }
+        pointer operator->() const { return &**this; }
+
+        basic_iterator& operator++() {
+            if (rank_ != npos) {
+                rank_ = ladder_->nextOccupied_(rank_ + 1);
+                if (rank_ == npos) {
+                    mapIt_ = ladder_->tailBegin_();
+                }
+                return *this;
+            }
+
+            bool wasHead = ladder_->isHead_(mapIt_->first);
+            ++mapIt_;
+            if (wasHead && (mapIt_ == ladder_->overflow_.end() ||
+                            !ladder_->isHead_(mapIt_->first))) {
+                // left the levels in front of the window, continue inside of it
+                if (ladder_->count_ != 0) {
+                    rank_ = ladder_->bestRank_;
+                    mapIt_ = ladder_->overflow_.end();
+                }
+            }
+            return *this;
+        }
+
+        basic_iterator operator++(int) {
+            basic_iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        bool operator==(const basic_iterator& other) const {
+            return rank_ == other.rank_ && mapIt_ == other.mapIt_;
+        }
+
+    private:
+        friend class PriceLadder;
+        template <bool> friend class basic_iterator;
+
+        basic_iterator(ladder_pointer ladder, size_type rank, map_iterator mapIt)
+            : ladder_(ladder), rank_(rank), mapIt_(mapIt) {}
+
+        ladder_pointer ladder_{nullptr};
+        size_type rank_{npos};
+        map_iterator mapIt_{};
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    explicit PriceLadder(const PriceLadderConfig& cfg = PriceLadderConfig{})
+        : cfg_(cfg) {
+        if (cfg_.ticks == 0) {
+            cfg_.ticks = 1;
+        }
+        if (cfg_.tickSize == 0) {
+            cfg_.tickSize = 1;
+        }
+        if (cfg_.referencePrice != 0) {
+            anchor_(cfg_.referencePrice);
+        }
+    }
+
+    T& operator[](const Key& key) {
+        assert(key.value() % cfg_.tickSize == 0 && "price off the tick grid");
+        if (!slots_) {
+            anchor_(key.value());
+        }
+
+        size_type rank = rankOf_(key);
+        if (rank == npos) {
+            return overflow_[key];
+        }
+
+        if (!occupied_.test(rank)) {
+            occupied_.set(rank);
+            if (count_ == 0 || rank < bestRank_) {
+                bestRank_ = rank;
+            }
+            ++count_;
+        }
+        return slots_[rank].second;
+    }
+
+    iterator begin() { return begin_(this); }
+    iterator end() { return iterator{this, npos, overflow_.end()}; }
+    const_iterator begin() const { return begin_(this); }
+    const_iterator end() const { return const_iterator{this, npos, overflow_.end()}; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    iterator find(const Key& key) {
+        size_type rank = rankOf_(key);
+        if (rank != npos) {
+            return occupied_.test(rank) ? iterator{this, rank, overflow_.end()} : end();
+        }
+        return iterator{this, npos, overflow_.find(key)};
+    }
+
+    const_iterator find(const Key& key) const {
+        size_type rank = rankOf_(key);
+        if (rank != npos) {
+            return occupied_.test(rank) ? const_iterator{this, rank, overflow_.end()}
+                                        : end();
+        }
+        return const_iterator{this, npos, overflow_.find(key)};
+    }
+
+    iterator erase(iterator pos) {
+        iterator next = std::next(pos);
+        if (pos.rank_ != npos) {
+            eraseRank_(pos.rank_);
+        } else {
+            overflow_.erase(pos.mapIt_);
+        }
+        return next;
+    }
+
+    size_type erase(const Key& key) {
+        size_type rank = rankOf_(key);
+        if (rank == npos) {
+            return overflow_.erase(key);
+        }
+        if (!occupied_.test(rank)) {
+            return 0;
+        }
+        eraseRank_(rank);
+        return 1;
+    }
+
+    void clear() {
+        for (size_type rank = nextOccupied_(0); rank != npos;
+             rank = nextOccupied_(rank + 1)) {
+            slots_[rank].second.clear();
+        }
+        occupied_.clear();
+        count_ = 0;
+        bestRank_ = 0;
+        overflow_.clear();
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return count_ == 0 && overflow_.empty(); }
+    [[nodiscard]] size_type size() const noexcept { return count_ + overflow_.size(); }
+
+    // number of levels that could not be placed in the tick window
+    [[nodiscard]] size_type overflowSize() const noexcept { return overflow_.size(); }
+    [[nodiscard]] const PriceLadderConfig& config() const noexcept { return cfg_; }
+
+private:
+    static constexpr size_type npos = static_cast<size_type>(-1);
+    static constexpr bool ascending_ = Compare{}(Key{0}, Key{1});
+    static constexpr std::size_t kCacheLine = 64;
+
+    template <typename Self> static auto begin_(Self* self) {
+        using It = std::conditional_t<std::is_const_v<Self>, const_iterator, iterator>;
+
+        auto first = self->overflow_.begin();
+        if (first != self->overflow_.end() && self->isHead_(first->first)) {
+            return It{self, npos, first};
+        }
+        if (self->count_ != 0) {
+            return It{self, self->bestRank_, self->overflow_.end()};
+        }
+        // nothing in front of or inside of the window, first is the tail (or end)
+        return It{self, npos, first};
+    }
+
+    void anchor_(std::uint64_t reference) {
+        const std::uint64_t half = cfg_.ticks / 2 * cfg_.tickSize;
+        base_ = reference > half ? reference - half : 0;
+        base_ -= base_ % cfg_.tickSize;
+
+        // the slots are never moved once built, so the payload does not need to be
+        // nothrow movable (std::deque of unique_ptr is not)
+        auto* raw = static_cast<value_type*>(::operator new(
+            sizeof(value_type) * cfg_.ticks, std::align_val_t{kCacheLine}));
+        for (size_type rank = 0; rank < cfg_.ticks; ++rank) {
+            std::construct_at(raw + rank, priceAt_(rank), T{});
+        }
+        slots_ = SlotArray(raw, SlotDeleter{cfg_.ticks});
+        occupied_.resize(cfg_.ticks);
+    }
+
+    Key priceAt_(size_type rank) const {
+        const size_type tick = ascending_ ? rank : cfg_.ticks - 1 - rank;
+        return Key{base_ + tick * cfg_.tickSize};
+    }
+
+    size_type rankOf_(const Key& key) const {
+        const std::uint64_t price = key.value();
+        if (!slots_ || price < base_) {
+            return npos;
+        }
+        size_type offset = price - base_;
+        if (cfg_.tickSize != 1) {
+            if (offset % cfg_.tickSize != 0) {
+                return npos;
+            }
+            offset /= cfg_.tickSize;
+        }
+        if (offset >= cfg_.ticks) {
+            return npos;
+        }
+        return ascending_ ? offset : cfg_.ticks - 1 - offset;
+    }
+
+    // overflow level that sorts in front of every price of the window
+    bool isHead_(const Key& key) const {
+        return slots_ && Compare{}(key, slots_[0].first);
+    }
+
+    auto tailBegin_() { return overflow_.lower_bound(slots_[0].first); }
+    auto tailBegin_() const { return overflow_.lower_bound(slots_[0].first); }
+
+    size_type nextOccupied_(size_type from) const {
+        if (count_ == 0) {
+            return npos;
+        }
+        return occupied_.findNext(from);
+    }
+
+    void eraseRank_(size_type rank) {
+        slots_[rank].second.clear();
+        occupied_.reset(rank);
+        --count_;
+        if (rank == bestRank_) {
+            size_type next = nextOccupied_(rank + 1);
+            bestRank_ = next == npos ? 0 : next;
+        }
+    }
+
+    PriceLadderConfig cfg_;
+    std::uint64_t base_{0};
+
+    struct SlotDeleter {
+        size_type count;
+        void operator()(value_type* slots) const {
+            std::destroy_n(slots, count);
+            ::operator delete(slots, std::align_val_t{kCacheLine});
+        }
+    };
+    using SlotArray = std::unique_ptr<value_type[], SlotDeleter>;
+
+    SlotArray slots_;
+    OccupancyBitmap occupied_;
+    size_type count_{0};
+    size_type bestRank_{0};
+
+    map_type overflow_;
+};
+
+} // namespace utils
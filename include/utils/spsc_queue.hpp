@@ -1,19 +1,30 @@
 #pragma once
 
 #include "market-data/bookEvent.hpp"
+#include <algorithm>
 #include <atomic>
 #include <bit>
 #include <cstddef>
 #include <cstring>
 #include <memory>
+#include <span>
 #include <type_traits>
 
 namespace utils {
+
+// Both queues keep a copy of the other side's index next to their own: the producer
+// only reloads head when its cached head says there is not enough room, the consumer
+// only reloads tail when its cached tail says there are not enough items, so the shared
+// cache lines bounce once per burst instead of once per item. The _n and peek/commit
+// variants move as many items as there are free slots (or ready items) with a single
+// index store.
+
 template <typename T> class spsc_queue_shm {
     using size_type = std::size_t;
 
     static_assert(std::is_trivially_copyable_v<L2OrderBookUpdate>);
     static_assert(std::is_trivially_copyable_v<L3Update>);
+    static_assert(std::is_trivially_copyable_v<EngineEvent>);
 
 public:
     explicit spsc_queue_shm(std::size_t capacity) {
@@ -23,32 +34,46 @@ public:
 
         head_m.store(0, std::memory_order_relaxed);
         tail_m.store(0, std::memory_order_relaxed);
+        tail_cache_m = 0;
+        head_cache_m = 0;
     }
 
     // producer calls this
     bool try_push(const T& item) {
         size_type current_tail = tail_m.load(std::memory_order_relaxed);
-        size_type current_head = head_m.load(std::memory_order_acquire);
-
-        size_type next_tail = current_tail + 1;
-
-        if (next_tail - current_head >= buffer_size_m) {
+        if (free_slots_(current_tail, 1) == 0) {
             return false;
         }
 
         size_type index = current_tail & mask_m;
         T* buffer = get_buf_();
         std::memcpy(&buffer[index], &item, sizeof(T));
-        tail_m.store(next_tail, std::memory_order_release);
+        tail_m.store(current_tail + 1, std::memory_order_release);
         return true;
     }
 
+    // producer calls this, pushes the longest prefix of items that fits and returns
+    // its length
+    size_type try_push_n(std::span<const T> items) {
+        size_type current_tail = tail_m.load(std::memory_order_relaxed);
+        size_type count = std::min(items.size(), free_slots_(current_tail, items.size()));
+        if (count == 0) {
+            return 0;
+        }
+
+        T* buffer = get_buf_();
+        size_type index = current_tail & mask_m;
+        size_type first = std::min(count, buffer_size_m - index);
+        std::memcpy(&buffer[index], items.data(), first * sizeof(T));
+        std::memcpy(buffer, items.data() + first, (count - first) * sizeof(T));
+        tail_m.store(current_tail + count, std::memory_order_release);
+        return count;
+    }
+
     // consumer calls this
     bool try_pop(T& item) {
         size_type current_head = head_m.load(std::memory_order_relaxed);
-        size_type current_tail = tail_m.load(std::memory_order_acquire);
-
-        if (current_head == current_tail) {
+        if (ready_(current_head, 1) == 0) {
             return false;
         }
 
@@ -59,6 +84,49 @@ public:
         return true;
     }
 
+    // consumer calls this, pops up to out.size() items and returns how many
+    size_type try_pop_n(std::span<T> out) {
+        size_type current_head = head_m.load(std::memory_order_relaxed);
+        size_type count = std::min(out.size(), ready_(current_head, out.size()));
+        if (count == 0) {
+            return 0;
+        }
+
+        T* buffer = get_buf_();
+        size_type index = current_head & mask_m;
+        size_type first = std::min(count, buffer_size_m - index);
+        std::memcpy(out.data(), &buffer[index], first * sizeof(T));
+        std::memcpy(out.data() + first, buffer, (count - first) * sizeof(T));
+        head_m.store(current_head + count, std::memory_order_release);
+        return count;
+    }
+
+    // consumer calls this, the ready items up to the end of the buffer, in place. They
+    // stay in the queue until commit().
+    std::span<const T> peek() {
+        size_type current_head = head_m.load(std::memory_order_relaxed);
+        size_type index = current_head & mask_m;
+        size_type contiguous = buffer_size_m - index;
+        T* first = get_buf_() + index;
+        return {first, std::min(ready_(current_head, contiguous), contiguous)};
+    }
+
+    // consumer calls this, releases the first count items of the last peek()
+    void commit(size_type count) {
+        size_type current_head = head_m.load(std::memory_order_relaxed);
+        head_m.store(current_head + count, std::memory_order_release);
+    }
+
+    // returns usable capacity
+    size_type capacity() const noexcept { return buffer_size_m - 1; }
+
+    bool empty() const noexcept {
+        size_type current_head = head_m.load(std::memory_order_relaxed);
+        size_type current_tail = tail_m.load(std::memory_order_acquire);
+
+        return current_head == current_tail;
+    }
+
     ~spsc_queue_shm() = default;
 
     spsc_queue_shm(const spsc_queue_shm&) = delete;
@@ -72,11 +140,31 @@ private:
     size_type mask_m;
 
     alignas(64) std::atomic<size_type> head_m; // consumer position
+    size_type tail_cache_m;                    // consumer's last view of tail_m
     alignas(64) std::atomic<size_type> tail_m; // producer position
+    size_type head_cache_m;                    // producer's last view of head_m
 
     T* get_buf_() {
         return reinterpret_cast<T*>(reinterpret_cast<char*>(this) + buffer_offset_m);
     }
+
+    // free slots, head_m is only reloaded when the cached view has fewer than wanted
+    size_type free_slots_(size_type current_tail, size_type wanted) {
+        size_type free = capacity() - (current_tail - head_cache_m);
+        if (free < wanted) {
+            head_cache_m = head_m.load(std::memory_order_acquire);
+            free = capacity() - (current_tail - head_cache_m);
+        }
+        return free;
+    }
+
+    // ready items, tail_m is only reloaded when the cached view has fewer than wanted
+    size_type ready_(size_type current_head, size_type wanted) {
+        if (tail_cache_m - current_head < wanted) {
+            tail_cache_m = tail_m.load(std::memory_order_acquire);
+        }
+        return tail_cache_m - current_head;
+    }
 };
 
 template <typename T, typename Allocator = std::allocator<T>> class spsc_queue {
@@ -109,9 +197,7 @@ public:
 
     bool try_push(const T& item) {
         size_type current_tail = tail_m.load(std::memory_order_relaxed);
-        size_type current_head = head_m.load(std::memory_order_acquire);
-
-        if (current_head - current_head >= buffer_size_m - 1) {
+        if (free_slots_(current_tail, 1) == 0) {
             return false; // full
         }
 
@@ -123,9 +209,7 @@ public:
 
     bool try_push(T&& item) {
         size_type current_tail = tail_m.load(std::memory_order_relaxed);
-        size_type current_head = head_m.load(std::memory_order_acquire);
-
-        if (current_tail - current_head >= buffer_size_m - 1) {
+        if (free_slots_(current_tail, 1) == 0) {
             return false; // full
         }
 
@@ -135,11 +219,25 @@ public:
         return true;
     }
 
+    // pushes the longest prefix of items that fits and returns its length
+    size_type try_push_n(std::span<const T> items) {
+        size_type current_tail = tail_m.load(std::memory_order_relaxed);
+        size_type count = std::min(items.size(), free_slots_(current_tail, items.size()));
+        if (count == 0) {
+            return 0;
+        }
+
+        size_type index = current_tail & mask_m;
+        size_type first = std::min(count, buffer_size_m - index);
+        std::memcpy(&buffer_m[index], items.data(), first * sizeof(T));
+        std::memcpy(buffer_m, items.data() + first, (count - first) * sizeof(T));
+        tail_m.store(current_tail + count, std::memory_order_release);
+        return count;
+    }
+
     bool try_pop(T& item) {
         size_type current_head = head_m.load(std::memory_order_relaxed);
-        size_type current_tail = tail_m.load(std::memory_order_acquire);
-
-        if (current_head == current_tail) {
+        if (ready_(current_head, 1) == 0) {
             return false;
         }
 
@@ -150,16 +248,45 @@ public:
         return true;
     }
 
+    // pops up to out.size() items and returns how many
+    size_type try_pop_n(std::span<T> out) {
+        size_type current_head = head_m.load(std::memory_order_relaxed);
+        size_type count = std::min(out.size(), ready_(current_head, out.size()));
+        if (count == 0) {
+            return 0;
+        }
+
+        size_type index = current_head & mask_m;
+        size_type first = std::min(count, buffer_size_m - index);
+        std::memcpy(out.data(), &buffer_m[index], first * sizeof(T));
+        std::memcpy(out.data() + first, buffer_m, (count - first) * sizeof(T));
+        head_m.store(current_head + count, std::memory_order_release);
+        return count;
+    }
+
+    // the ready items up to the end of the buffer, in place. They stay in the queue
+    // until commit().
+    std::span<const T> peek() {
+        size_type current_head = head_m.load(std::memory_order_relaxed);
+        size_type index = current_head & mask_m;
+        size_type contiguous = buffer_size_m - index;
+        return {buffer_m + index, std::min(ready_(current_head, contiguous), contiguous)};
+    }
+
+    // releases the first count items of the last peek()
+    void commit(size_type count) {
+        size_type current_head = head_m.load(std::memory_order_relaxed);
+        head_m.store(current_head + count, std::memory_order_release);
+    }
+
     template <typename... Args> bool try_emplace(Args&&... args) {
         size_type current_tail = tail_m.load(std::memory_order_relaxed);
-        size_type current_head = head_m.load(std::memory_order_acquire);
-        size_type next_tail = current_tail + 1;
-        if (next_tail - current_head >= buffer_size_m) {
+        if (free_slots_(current_tail, 1) == 0) {
             return false;
         }
         size_type index = current_tail & mask_m;
         new (&buffer_m[index]) T(std::forward<Args>(args)...);
-        tail_m.store(next_tail, std::memory_order_release);
+        tail_m.store(current_tail + 1, std::memory_order_release);
         return true;
     }
 
@@ -170,7 +297,7 @@ public:
         size_type approx_head = head_m.load(std::memory_order_relaxed);
         size_type approx_tail = tail_m.load(std::memory_order_relaxed);
 
-        return (approx_tail + 1) - approx_head >= buffer_size_m;
+        return approx_tail - approx_head >= capacity();
     }
 
     bool empty() const noexcept {
@@ -187,9 +314,29 @@ private:
     size_type mask_m;
 
     alignas(64) std::atomic<size_type> head_m; // consumer position
+    size_type tail_cache_m{0};                 // consumer's last view of tail_m
     alignas(64) std::atomic<size_type> tail_m; // producer position
+    size_type head_cache_m{0};                 // producer's last view of head_m
 
     [[no_unique_address]] Allocator alloc_m;
+
+    // free slots, head_m is only reloaded when the cached view has fewer than wanted
+    size_type free_slots_(size_type current_tail, size_type wanted) {
+        size_type free = capacity() - (current_tail - head_cache_m);
+        if (free < wanted) {
+            head_cache_m = head_m.load(std::memory_order_acquire);
+            free = capacity() - (current_tail - head_cache_m);
+        }
+        return free;
+    }
+
+    // ready items, tail_m is only reloaded when the cached view has fewer than wanted
+    size_type ready_(size_type current_head, size_type wanted) {
+        if (tail_cache_m - current_head < wanted) {
+            tail_cache_m = tail_m.load(std::memory_order_acquire);
+        }
+        return tail_cache_m - current_head;
+    }
 };
 
 } // namespace utils
@@ -5,5 +5,10 @@ namespace status {
 enum class HelloAckStatus : std::uint8_t { ACCEPTED = 1, REJECTED = 2 };
 enum class LogoutAckStatus : std::uint8_t { ACCEPTED = 1, REJECTED = 2 };
 enum class OrderAckStatus : std::uint8_t { ACCEPTED = 1, REJECTED = 2 };
-enum class CancelStatus : std::uint8_t { ACCEPTED = 1, REJECTED = 2 };
+enum class CancelStatus : std::uint8_t {
+    ACCEPTED = 1,
+    REJECTED = 2,
+    EXPIRED = 3,
+    SELF_TRADE = 4
+};
 } // namespace status
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <emmintrin.h>
+#include <pthread.h>
+#include <sched.h>
+
+namespace utils {
+
+// Pins the calling thread to one core, a negative cpu leaves it to the scheduler.
+// Returns false if the affinity could not be set.
+inline bool pinThisThread(int cpu) {
+    if (cpu < 0) {
+        return true;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<std::size_t>(cpu), &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+// spin loop hint, lets the sibling hyperthread run while a busy poll finds nothing
+inline void cpuRelax() noexcept { _mm_pause(); }
+
+} // namespace utils
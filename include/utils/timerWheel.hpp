@@ -0,0 +1,299 @@
+#pragma once
+
+#include "utils/occupancyBitmap.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utils {
+
+/**
+ * @brief Intrusive link of an object into a TimerWheel.
+ *
+ * Embedded in the scheduled object, so scheduling and cancelling never allocate. An
+ * unlinked hook has null links, cancelling it is a no-op.
+ */
+template <typename T> struct TimerHook {
+    TimerHook* prev{nullptr};
+    TimerHook* next{nullptr};
+    T* owner{nullptr};
+    std::uint64_t deadline{0}; // in wheel ticks
+
+    [[nodiscard]] bool linked() const noexcept { return next != nullptr; }
+};
+
+/**
+ * @brief Hierarchical timer wheel over intrusive TimerHooks.
+ *
+ * Four levels of 256 buckets, level l covers deadlines that differ from the current
+ * tick in bits [8l, 8l + 8). A hook is placed in the lowest level where its deadline
+ * shares the upper bits with the current tick and is moved one level down each time
+ * the wheel reaches the start of its bucket, so every hook is touched at most once per
+ * level. Deadlines past the 2^32 tick horizon wait in an overflow list that is
+ * redistributed whenever the top level wraps.
+ *
+ * advance() visits only the ticks where something happens: the next occupied level 0
+ * bucket or the next bucket boundary of a level above, found through an occupancy
+ * bitmap per level. A bucket the wheel reaches is spliced in O(1) onto a list of hooks
+ * to re-place (or onto the due list for level 0), and both lists are worked off one
+ * hook at a time under a step limit. A bucket holding millions of hooks, like all the
+ * orders of an end of day, is therefore spread over as many calls as the caller likes.
+ *
+ * The wheel does not own the objects, an object must be cancelled before it goes away.
+ */
+template <typename T> class TimerWheel {
+public:
+    using Hook = TimerHook<T>;
+
+    static constexpr std::size_t kLevels = 4;
+    static constexpr std::size_t kSlotBits = 8;
+    static constexpr std::size_t kSlots = std::size_t{1} << kSlotBits;
+
+    explicit TimerWheel(std::uint64_t startTick = 0)
+        : current_(startTick), lists_(kMoving + 1) {
+        for (Hook& head : lists_) {
+            head.prev = head.next = &head;
+        }
+        for (auto& bits : occupied_) {
+            bits.resize(kSlots);
+        }
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+    TimerWheel(TimerWheel&&) noexcept = default;
+    TimerWheel& operator=(TimerWheel&&) noexcept = default;
+
+    // a deadline that is not after the current tick is due on the next advance()
+    void schedule(Hook& hook, T* owner, std::uint64_t deadline) {
+        hook.owner = owner;
+        hook.deadline = deadline;
+        place_(hook);
+        ++size_;
+    }
+
+    void cancel(Hook& hook) noexcept {
+        if (!hook.linked()) {
+            return;
+        }
+        // The bucket keeps its occupancy bit even if this was its last hook. The bit is
+        // cleared once the wheel reaches the bucket, which costs one empty visit but
+        // keeps the hook from having to remember where it is linked.
+        unlink_(hook);
+        --size_;
+    }
+
+    /**
+     * @brief Moves the wheel forward to tick and expires what is due on the way.
+     *
+     * Takes at most maxSteps steps, a step being the expiry of a hook or moving one
+     * down a level. onExpire(T&) is called for the expired hooks in deadline order
+     * across buckets, the hook is unlinked before the call. Returns the number of
+     * expired hooks, pending(tick) tells whether anything was left for the next call.
+     */
+    template <typename F>
+    std::size_t advance(std::uint64_t tick, F&& onExpire, std::size_t maxSteps) {
+        std::size_t expired = 0;
+        std::size_t steps = 0;
+        for (;;) {
+            Hook& moving = lists_[kMoving];
+            while (!empty_(moving)) {
+                if (steps == maxSteps) {
+                    return expired;
+                }
+                Hook& hook = *moving.next;
+                unlink_(hook);
+                place_(hook);
+                ++steps;
+            }
+
+            Hook& due = lists_[kDue];
+            while (!empty_(due)) {
+                if (steps == maxSteps) {
+                    return expired;
+                }
+                Hook& hook = *due.next;
+                unlink_(hook);
+                --size_;
+                ++steps;
+                ++expired;
+                onExpire(*hook.owner);
+            }
+
+            if (current_ >= tick) {
+                return expired;
+            }
+
+            if (!anyInLevels_()) {
+                // Only far deadlines (if any), jump straight to tick. They differ from
+                // the current tick above the horizon and keep doing so until the jump
+                // crosses a horizon boundary, only then are they worth placing again.
+                const bool crossed = (tick & ~kHorizonMask) != (current_ & ~kHorizonMask);
+                current_ = tick;
+                if (crossed) {
+                    splice_(kOverflow, kMoving);
+                }
+                continue;
+            }
+
+            const std::uint64_t next = nextEvent_();
+            if (next > tick) {
+                current_ = tick;
+                continue;
+            }
+            current_ = next;
+
+            if ((current_ & kHorizonMask) == 0) {
+                splice_(kOverflow, kMoving);
+            }
+            for (std::size_t level = 1; level < kLevels; ++level) {
+                if ((current_ & levelMask_(level)) == 0) {
+                    splice_(takeBucket_(level), kMoving);
+                }
+            }
+            // everything in the level 0 bucket of the current tick is due
+            splice_(takeBucket_(0), kDue);
+        }
+    }
+
+    // whether advance(tick, ...) has work left, either expiries or buckets to move down
+    [[nodiscard]] bool pending(std::uint64_t tick) const noexcept {
+        if (!empty_(lists_[kDue]) || !empty_(lists_[kMoving])) {
+            return true;
+        }
+        if (size_ == 0 || current_ >= tick) {
+            return false;
+        }
+        return !anyInLevels_() || nextEvent_() <= tick;
+    }
+
+    // unlinks every hook without expiring it
+    void clear() noexcept {
+        for (Hook& head : lists_) {
+            while (!empty_(head)) {
+                unlink_(*head.next);
+            }
+        }
+        for (auto& bits : occupied_) {
+            bits.clear();
+        }
+        size_ = 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] std::uint64_t currentTick() const noexcept { return current_; }
+
+private:
+    static constexpr std::uint64_t kSlotMask = kSlots - 1;
+    static constexpr std::uint64_t kHorizonMask =
+        (std::uint64_t{1} << (kLevels * kSlotBits)) - 1;
+
+    // list heads after the level buckets
+    static constexpr std::uint32_t kDue = kLevels * kSlots;
+    static constexpr std::uint32_t kOverflow = kDue + 1;
+    // hooks of a bucket the wheel has reached, waiting to be placed one level lower
+    static constexpr std::uint32_t kMoving = kDue + 2;
+
+    static constexpr std::uint64_t levelMask_(std::size_t level) noexcept {
+        return (std::uint64_t{1} << (level * kSlotBits)) - 1;
+    }
+
+    static bool empty_(const Hook& head) noexcept { return head.next == &head; }
+
+    void link_(std::uint32_t bucket, Hook& hook) noexcept {
+        Hook& head = lists_[bucket];
+        hook.prev = head.prev;
+        hook.next = &head;
+        head.prev->next = &hook;
+        head.prev = &hook;
+    }
+
+    static void unlink_(Hook& hook) noexcept {
+        hook.prev->next = hook.next;
+        hook.next->prev = hook.prev;
+        hook.prev = hook.next = nullptr;
+    }
+
+    void place_(Hook& hook) noexcept {
+        if (hook.deadline <= current_) {
+            link_(kDue, hook);
+            return;
+        }
+
+        // the highest differing bit picks the level
+        const auto width =
+            static_cast<std::size_t>(std::bit_width(hook.deadline ^ current_));
+        const std::size_t level = (width - 1) / kSlotBits;
+        if (level >= kLevels) {
+            link_(kOverflow, hook);
+            return;
+        }
+
+        const std::size_t slot = (hook.deadline >> (level * kSlotBits)) & kSlotMask;
+        link_(static_cast<std::uint32_t>(level * kSlots + slot), hook);
+        occupied_[level].set(slot);
+    }
+
+    // appends the whole list from to the list to
+    void splice_(std::uint32_t from, std::uint32_t to) noexcept {
+        Hook& src = lists_[from];
+        if (empty_(src)) {
+            return;
+        }
+        Hook& dst = lists_[to];
+        src.next->prev = dst.prev;
+        dst.prev->next = src.next;
+        src.prev->next = &dst;
+        dst.prev = src.prev;
+        src.prev = src.next = &src;
+    }
+
+    // the bucket of level that starts at the current tick, marked empty
+    std::uint32_t takeBucket_(std::size_t level) noexcept {
+        const std::size_t slot = (current_ >> (level * kSlotBits)) & kSlotMask;
+        occupied_[level].reset(slot);
+        return static_cast<std::uint32_t>(level * kSlots + slot);
+    }
+
+    bool anyInLevels_() const noexcept {
+        for (const auto& bits : occupied_) {
+            if (bits.any()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Earliest tick after the current one where a bucket has to be looked at. Buckets
+    // of a level only hold deadlines ahead of the current slot within the rotation,
+    // so the first occupied slot after it is the next event of that level.
+    std::uint64_t nextEvent_() const noexcept {
+        for (std::size_t level = 0; level < kLevels; ++level) {
+            const std::size_t shift = level * kSlotBits;
+            const std::size_t slot = (current_ >> shift) & kSlotMask;
+            if (slot + 1 == kSlots) {
+                continue;
+            }
+            const std::size_t next = occupied_[level].findNext(slot + 1);
+            if (next != OccupancyBitmap::npos) {
+                const std::uint64_t rotation = (current_ >> (shift + kSlotBits))
+                                               << (shift + kSlotBits);
+                return rotation + (std::uint64_t{next} << shift);
+            }
+        }
+        return (current_ | kHorizonMask) + 1;
+    }
+
+    std::uint64_t current_;
+    std::size_t size_{0};
+    // level buckets, then the due and the overflow list; heap allocated so the
+    // self-referencing heads stay put when the wheel is moved
+    std::vector<Hook> lists_;
+    std::array<OccupancyBitmap, kLevels> occupied_;
+};
+
+} // namespace utils
@@ -1,12 +1,21 @@
 #pragma once
+#include "utils/flatIndex.hpp"
+#include "utils/objectPool.hpp"
+#include "utils/priceLadder.hpp"
+#include "utils/timerWheel.hpp"
 #include "utils/utils.hpp"
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
-#include <deque>
+#include <iterator>
+#include <limits>
 #include <map>
 #include <memory>
+#include <optional>
 #include <ostream>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 /**
@@ -260,7 +269,17 @@ enum class TimeInForce : std::uint8_t {
     GOOD_TILL_CANCELLED,
     FILL_OR_KILL,
     END_OF_DAY,
-    GOOD_TILL_DATE
+    GOOD_TILL_DATE,
+    IMMEDIATE_OR_CANCEL
+};
+
+// what happens when an order would trade against a resting order of the same client
+enum class SelfTradePrevention : std::uint8_t {
+    SKIP,          // pass over the resting order and match deeper in the book
+    CANCEL_NEWEST, // cancel the rest of the incoming order
+    CANCEL_OLDEST, // cancel the resting order and keep matching
+    CANCEL_BOTH,   // cancel both
+    DECREMENT      // take the smaller quantity off both, nothing trades
 };
 
 enum class OrderStatus : uint8_t {
@@ -286,8 +305,26 @@ struct Order {
     const OrderSide side;              // 1 byte
     const OrderType type;              // 1 byte
     OrderStatus status;                // 1 byte
+
+    // intrusive links into the price level queue, maintained by OrderQueue
+    Order* prev{nullptr}; // 8 bytes
+    Order* next{nullptr}; // 8 bytes
+
+    // link into the engine's expiry wheel, GOOD_TILL_DATE and END_OF_DAY orders only
+    utils::TimerHook<Order> expiry{}; // 32 bytes
+
+    // intrusive links into the client's list of resting orders, see ClientOrderList
+    Order* clientPrev{nullptr}; // 8 bytes
+    Order* clientNext{nullptr}; // 8 bytes
 };
 
+// two cache lines, the pool rounds its slots up to whole lines
+static_assert(sizeof(Order) == 128);
+
+// orders are allocated from a per-engine slab, the handle returns them on destruction
+using OrderPool = utils::ObjectPool<Order>;
+using OrderHandle = utils::PoolHandle<Order>;
+
 struct ClientOrder {
     ClientOrderID orderID;
     OrderID serverOrderID;
@@ -311,17 +348,323 @@ struct ClientOrder {
     bool isFilled() const { return status == OrderStatus::FILLED; }
 };
 
-struct Level2OrderBook {
-    std::vector<std::pair<Price, Qty>> bids;
-    std::vector<std::pair<Price, Qty>> asks;
+// aggregated view of a single price level
+struct LevelSummary {
+    Price price;
+    Qty qty;
+    std::size_t orderCount;
+
+    bool operator==(const LevelSummary&) const = default;
+};
+
+/**
+ * @brief Intrusive FIFO of the resting orders at a single price level.
+ *
+ * Orders are linked through their own prev/next pointers, so an order that is known
+ * (e.g. from the orderMap) is unlinked in O(1) without walking the level. The queue
+ * does not own the orders, they live in the engine's order pool and the engine hands
+ * them back to it once they are unlinked.
+ *
+ * The queue also keeps the level aggregates (total resting quantity and order count),
+ * so the quantity of a linked order must only be lowered through reduce().
+ */
+class OrderQueue {
+public:
+    template <typename OrderPtr> class basic_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = OrderPtr;
+        using difference_type = std::ptrdiff_t;
+        using reference = OrderPtr;
+
+        basic_iterator() = default;
+        explicit basic_iterator(OrderPtr order) : order_(order) {}
+
+        OrderPtr operator*() const { return order_; }
+        basic_iterator& operator++() {
+            order_ = order_->next;
+            return *this;
+        }
+        basic_iterator operator++(int) {
+            basic_iterator tmp = *this;
+            order_ = order_->next;
+            return tmp;
+        }
+        bool operator==(const basic_iterator&) const = default;
+
+    private:
+        OrderPtr order_{nullptr};
+    };
+
+    using iterator = basic_iterator<Order*>;
+    using const_iterator = basic_iterator<const Order*>;
+
+    OrderQueue() = default;
+
+    OrderQueue(const OrderQueue&) = delete;
+    OrderQueue& operator=(const OrderQueue&) = delete;
+
+    OrderQueue(OrderQueue&& other) noexcept
+        : head_(std::exchange(other.head_, nullptr)),
+          tail_(std::exchange(other.tail_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          totalQty_(std::exchange(other.totalQty_, Qty{0})) {}
+
+    OrderQueue& operator=(OrderQueue&& other) noexcept {
+        if (this != &other) {
+            head_ = std::exchange(other.head_, nullptr);
+            tail_ = std::exchange(other.tail_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            totalQty_ = std::exchange(other.totalQty_, Qty{0});
+        }
+        return *this;
+    }
+
+    void push_back(Order* order) {
+        order->prev = tail_;
+        order->next = nullptr;
+
+        if (tail_) {
+            tail_->next = order;
+        } else {
+            head_ = order;
+        }
+        tail_ = order;
+        ++size_;
+        totalQty_ += order->qty;
+    }
+
+    // lowers the quantity of a linked order (fill or qty-down modify)
+    void reduce(Order* order, Qty amount) noexcept {
+        order->qty -= amount;
+        totalQty_ -= amount;
+    }
+
+    // unlinks an order that is linked into this queue and returns it
+    Order* erase(Order* order) {
+        if (order->prev) {
+            order->prev->next = order->next;
+        } else {
+            head_ = order->next;
+        }
+
+        if (order->next) {
+            order->next->prev = order->prev;
+        } else {
+            tail_ = order->prev;
+        }
+
+        order->prev = nullptr;
+        order->next = nullptr;
+        --size_;
+        totalQty_ -= order->qty;
+        return order;
+    }
+
+    // drops the links to the orders, releasing them is up to the owner
+    void clear() noexcept {
+        head_ = nullptr;
+        tail_ = nullptr;
+        size_ = 0;
+        totalQty_ = Qty{0};
+    }
+
+    [[nodiscard]] Order* front() const noexcept { return head_; }
+    [[nodiscard]] Order* back() const noexcept { return tail_; }
+    [[nodiscard]] bool empty() const noexcept { return head_ == nullptr; }
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] Qty totalQty() const noexcept { return totalQty_; }
+
+    iterator begin() { return iterator{head_}; }
+    iterator end() { return iterator{}; }
+    const_iterator begin() const { return const_iterator{head_}; }
+    const_iterator end() const { return const_iterator{}; }
+
+private:
+    Order* head_{nullptr};
+    Order* tail_{nullptr};
+    std::size_t size_{0};
+    Qty totalQty_{0};
+};
+
+/**
+ * @brief Resting orders of one client, oldest first.
+ *
+ * Threads the orders through Order::clientPrev/clientNext, so an order sits in its
+ * price level queue and in its client's list at the same time and both unlink in O(1).
+ * Like OrderQueue it does not own the orders.
+ */
+class ClientOrderList {
+public:
+    void push_back(Order* order) noexcept {
+        order->clientPrev = tail_;
+        order->clientNext = nullptr;
+
+        if (tail_) {
+            tail_->clientNext = order;
+        } else {
+            head_ = order;
+        }
+        tail_ = order;
+        ++size_;
+    }
+
+    void erase(Order* order) noexcept {
+        if (order->clientPrev) {
+            order->clientPrev->clientNext = order->clientNext;
+        } else {
+            head_ = order->clientNext;
+        }
+
+        if (order->clientNext) {
+            order->clientNext->clientPrev = order->clientPrev;
+        } else {
+            tail_ = order->clientPrev;
+        }
+
+        order->clientPrev = nullptr;
+        order->clientNext = nullptr;
+        --size_;
+    }
+
+    void clear() noexcept {
+        head_ = nullptr;
+        tail_ = nullptr;
+        size_ = 0;
+    }
+
+    [[nodiscard]] Order* front() const noexcept { return head_; }
+    [[nodiscard]] bool empty() const noexcept { return head_ == nullptr; }
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+private:
+    Order* head_{nullptr};
+    Order* tail_{nullptr};
+    std::size_t size_{0};
 };
 
-using OrderQueue = std::deque<std::unique_ptr<Order>>;
+// total quantity resting at one price of a Level2OrderBook
+struct L2Level {
+    Qty qty{0};
+
+    void clear() noexcept { qty = Qty{0}; }
+};
+
+// The book sides are tick-indexed price ladders, configure with MINIEXCHANGE_MAP_BOOK
+// to fall back to the node based std::map (kept around for benchmarking)
+#ifdef MINIEXCHANGE_MAP_BOOK
+template <typename Compare> using BookSide = std::map<Price, OrderQueue, Compare>;
+template <typename Compare> using L2BookSide = std::map<Price, L2Level, Compare>;
+#else
+template <typename Compare>
+using BookSide = utils::PriceLadder<Price, OrderQueue, Compare>;
+template <typename Compare>
+using L2BookSide = utils::PriceLadder<Price, L2Level, Compare>;
+#endif
+
+template <typename Side> Side makeBookSide(const utils::PriceLadderConfig& cfg) {
+    if constexpr (std::is_constructible_v<Side, const utils::PriceLadderConfig&>) {
+        return Side(cfg);
+    } else {
+        return Side{};
+    }
+}
 
 struct Level3OrderBook {
-    std::map<Price, OrderQueue, std::less<Price>> asks;
-    std::map<Price, OrderQueue, std::greater<Price>> bids;
-    std::unordered_map<OrderID, Order*> orderMap;
+    Level3OrderBook() = default;
+    explicit Level3OrderBook(const utils::PriceLadderConfig& cfg,
+                             std::size_t orderMapCapacity = 1024)
+        : asks(makeBookSide<BookSide<std::less<Price>>>(cfg)),
+          bids(makeBookSide<BookSide<std::greater<Price>>>(cfg)),
+          orderMap(orderMapCapacity) {}
+
+    BookSide<std::less<Price>> asks;
+    BookSide<std::greater<Price>> bids;
+    utils::FlatIndex<OrderID, Order> orderMap;
+};
+
+/**
+ * @brief Price aggregated book, the L2 view kept by the observer and the feed receiver.
+ *
+ * The sides are the same price ladders as the Level3OrderBook with the total quantity
+ * of the level as payload, so a price maps straight to its level and an update costs
+ * the same however deep the book is. Iterating a side goes best to worst, depth()
+ * copies the top of it for snapshots. A level is removed once nothing is left on it.
+ */
+struct Level2OrderBook {
+    Level2OrderBook() = default;
+    explicit Level2OrderBook(const utils::PriceLadderConfig& cfg)
+        : asks(makeBookSide<L2BookSide<std::less<Price>>>(cfg)),
+          bids(makeBookSide<L2BookSide<std::greater<Price>>>(cfg)) {}
+
+    void add(OrderSide side, Price price, Qty qty) {
+        if (side == OrderSide::BUY) {
+            bids[price].qty += qty;
+        } else {
+            asks[price].qty += qty;
+        }
+    }
+
+    // lowers the level by qty, false if there is no level at the price
+    bool reduce(OrderSide side, Price price, Qty qty) {
+        return side == OrderSide::BUY ? reduce_(bids, price, qty)
+                                      : reduce_(asks, price, qty);
+    }
+
+    [[nodiscard]] Qty qtyAt(OrderSide side, Price price) const {
+        return side == OrderSide::BUY ? qtyAt_(bids, price) : qtyAt_(asks, price);
+    }
+
+    [[nodiscard]] std::size_t levelCount(OrderSide side) const {
+        return side == OrderSide::BUY ? bids.size() : asks.size();
+    }
+
+    // best first, at most maxLevels levels
+    [[nodiscard]] std::vector<std::pair<Price, Qty>>
+    depth(OrderSide side,
+          std::size_t maxLevels = std::numeric_limits<std::size_t>::max()) const {
+        return side == OrderSide::BUY ? depth_(bids, maxLevels)
+                                      : depth_(asks, maxLevels);
+    }
+
+    void clear() {
+        asks.clear();
+        bids.clear();
+    }
+
+    L2BookSide<std::less<Price>> asks;
+    L2BookSide<std::greater<Price>> bids;
+
+private:
+    template <typename Side> static bool reduce_(Side& side, Price price, Qty qty) {
+        auto it = side.find(price);
+        if (it == side.end()) {
+            return false;
+        }
+        if (it->second.qty <= qty) {
+            side.erase(it);
+        } else {
+            it->second.qty -= qty;
+        }
+        return true;
+    }
+
+    template <typename Side> static Qty qtyAt_(const Side& side, Price price) {
+        auto it = side.find(price);
+        return it == side.end() ? Qty{0} : it->second.qty;
+    }
+
+    template <typename Side>
+    static std::vector<std::pair<Price, Qty>> depth_(const Side& side,
+                                                     std::size_t maxLevels) {
+        std::vector<std::pair<Price, Qty>> levels;
+        levels.reserve(std::min(side.size(), maxLevels));
+        for (auto it = side.begin(); it != side.end() && levels.size() < maxLevels;
+             ++it) {
+            levels.emplace_back(it->first, it->second.qty);
+        }
+        return levels;
+    }
 };
 
 enum class BookUpdateEventType : std::uint8_t { ADD = 0, REDUCE = 1 };
@@ -385,6 +728,8 @@ enum class MessageType : std::uint8_t {
     MODIFY_ORDER = 0x0E,
     MODIFY_ACK = 0x0F,
     TRADE = 0x10,
+    MASS_CANCEL = 0x11,
+    MASS_CANCEL_ACK = 0x12,
 };
 
 inline std::ostream& operator<<(std::ostream& os, MessageType type) {
@@ -414,6 +759,10 @@ inline std::ostream& operator<<(std::ostream& os, MessageType type) {
             return "MODIFY_ACK";
         case TRADE:
             return "TRADE";
+        case MASS_CANCEL:
+            return "MASS_CANCEL";
+        case MASS_CANCEL_ACK:
+            return "MASS_CANCEL_ACK";
         default:
             return "UNKNOWN";
         }
@@ -490,6 +839,59 @@ inline std::ostream& operator<<(std::ostream& os, const ModifyResult& m) {
     return os;
 }
 
+// Selects the resting orders of a client that a mass cancel takes off the book, the
+// price bounds are inclusive. The default filter matches every order.
+struct MassCancelFilter {
+    std::optional<OrderSide> side{};
+    Price minPrice{0};
+    Price maxPrice{std::numeric_limits<std::uint64_t>::max()};
+
+    [[nodiscard]] bool matches(const Order& order) const noexcept {
+        return (!side || order.side == *side) && order.price >= minPrice &&
+               order.price <= maxPrice;
+    }
+};
+
+// a resting order that self-trade prevention took off the book, its owner is told
+struct SelfTradeCancel {
+    ClientID clientID;
+    OrderID orderID;
+    ClientOrderID clientOrderID;
+    InstrumentID instrumentID;
+};
+
+enum class CommandType : std::uint8_t { NEW_ORDER = 0, CANCEL, MODIFY };
+
+// One request of a MatchingEngine::processBatch() call. NEW_ORDER uses the order
+// fields, named like those of Order, an orderID of 0 lets the engine number the order;
+// CANCEL only clientID and orderID, MODIFY also qty and price as the new values.
+struct OrderCommand {
+    CommandType command{CommandType::NEW_ORDER};
+    OrderID orderID{0};
+    ClientID clientID{0};
+    ClientOrderID clientOrderID{0};
+    Qty qty{0};
+    Price price{0};
+    Timestamp goodTill{0};
+    InstrumentID instrumentID{0};
+    TimeInForce tif{TimeInForce::GOOD_TILL_CANCELLED};
+    OrderSide side{OrderSide::BUY};
+    OrderType type{OrderType::LIMIT};
+};
+
+// Outcome of one OrderCommand: match for NEW_ORDER, modify for MODIFY and cancelled
+// for CANCEL. The trades and self-trade cancels of the command end at tradeEnd and
+// selfTradeCancelEnd in the engine's buffers and start where the previous command's
+// end.
+struct CommandResult {
+    CommandType command{CommandType::NEW_ORDER};
+    bool cancelled{false};
+    MatchResult match{};
+    ModifyResult modify{};
+    std::size_t tradeEnd{0};
+    std::size_t selfTradeCancelEnd{0};
+};
+
 inline std::ostream& operator<<(std::ostream& os, OrderType type) {
     switch (type) {
     case OrderType::LIMIT:
@@ -522,6 +924,8 @@ inline std::ostream& operator<<(std::ostream& os, TimeInForce type) {
         return os << "END_OF_DAY";
     case TimeInForce::GOOD_TILL_DATE:
         return os << "GOOD_TILL_DATE";
+    case TimeInForce::IMMEDIATE_OR_CANCEL:
+        return os << "IMMEDIATE_OR_CANCEL";
     default:
         return os << "UNKNOWN";
     }
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "utils/threading.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+namespace utils {
+
+// What a ring producer or consumer does when there is nothing to do.
+enum class WaitPolicy : std::uint8_t {
+    BUSY_SPIN = 0, // cpuRelax() and poll again, lowest latency, burns the core
+    SPIN_YIELD,    // spin a little, then sched_yield() between polls
+    BLOCKING,      // spin, yield, then park on a futex with a growing timeout
+    TIMED          // sleep a fixed period between polls
+};
+
+struct WaitConfig {
+    WaitPolicy policy{WaitPolicy::SPIN_YIELD};
+    // idle rounds spent in cpuRelax() before yielding (SPIN_YIELD, BLOCKING)
+    std::uint32_t spins{64};
+    // idle rounds spent in sched_yield() before parking (BLOCKING)
+    std::uint32_t yields{16};
+    // TIMED: the sleep per idle round. BLOCKING: the longest park, the park time starts
+    // at firstPark and doubles on every idle round up to it
+    std::chrono::microseconds period{1000};
+    std::chrono::microseconds firstPark{16};
+};
+
+/**
+ * @brief Futex word a BLOCKING waiter parks on.
+ *
+ * The producer calls notify() after publishing, which costs a fence and a load while
+ * nobody is parked. A waiter registers itself before it checks for work one last time,
+ * so a notify() racing with the check either sees the waiter or the waiter sees the
+ * work. The futex is not process private, the signal may live in shared memory.
+ */
+class WaitSignal {
+public:
+    void notify() noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        epoch_.fetch_add(1, std::memory_order_release);
+        ::syscall(SYS_futex, &epoch_, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+
+    // sleeps until notify() or the timeout, unless ready() already finds work
+    template <typename Ready>
+    void park(Ready&& ready, std::chrono::microseconds timeout) {
+        sleepers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::uint32_t epoch = epoch_.load(std::memory_order_acquire);
+        if (!ready()) {
+            const auto seconds =
+                std::chrono::duration_cast<std::chrono::seconds>(timeout);
+            const timespec ts{
+                .tv_sec = seconds.count(),
+                .tv_nsec = std::chrono::nanoseconds(timeout - seconds).count()};
+            ::syscall(SYS_futex, &epoch_, FUTEX_WAIT, epoch, &ts, nullptr, 0);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+private:
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+    std::atomic<std::uint32_t> epoch_{0};
+    std::atomic<std::uint32_t> sleepers_{0};
+};
+
+/**
+ * @brief Backoff state of one polling thread.
+ *
+ * Call idle() after a poll found nothing and reset() after one found work. A BLOCKING
+ * waiter without a signal still backs off to sleeps of at most period, it just cannot
+ * be woken early.
+ */
+class Waiter {
+public:
+    explicit Waiter(const WaitConfig& config = {}, WaitSignal* signal = nullptr)
+        : config_(config), signal_(signal), park_(config.firstPark) {}
+
+    // ready() is checked once more right before parking, it should be a cheap emptiness
+    // check of the rings the thread polls
+    template <typename Ready> void idle(Ready&& ready) {
+        switch (config_.policy) {
+        case WaitPolicy::BUSY_SPIN:
+            cpuRelax();
+            return;
+        case WaitPolicy::TIMED:
+            std::this_thread::sleep_for(config_.period);
+            return;
+        case WaitPolicy::SPIN_YIELD:
+            if (rounds_ < config_.spins) {
+                ++rounds_;
+                cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+            return;
+        case WaitPolicy::BLOCKING:
+            if (rounds_ < config_.spins) {
+                ++rounds_;
+                cpuRelax();
+            } else if (rounds_ < config_.spins + config_.yields) {
+                ++rounds_;
+                std::this_thread::yield();
+            } else {
+                if (signal_) {
+                    signal_->park(ready, park_);
+                } else {
+                    std::this_thread::sleep_for(park_);
+                }
+                park_ = std::min(park_ * 2, config_.period);
+            }
+            return;
+        }
+    }
+    void idle() { idle([] { return false; }); }
+
+    void reset() noexcept {
+        rounds_ = 0;
+        park_ = config_.firstPark;
+    }
+
+    [[nodiscard]] const WaitConfig& config() const noexcept { return config_; }
+
+private:
+    WaitConfig config_;
+    WaitSignal* signal_;
+    std::uint32_t rounds_{0};
+    std::chrono::microseconds park_;
+};
+
+} // namespace utils
@@ -2,37 +2,215 @@
 #include "protocol/clientMessages.hpp"
 #include "utils/timing.hpp"
 #include "utils/types.hpp"
-#include <memory>
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+
+void MiniExchangeAPI::addEngine_(MatchingEngine& engine) {
+    const std::uint32_t index = engine.getInstrumentID().value();
+    if (index >= byInstrument_.size()) {
+        byInstrument_.resize(index + 1, nullptr);
+    }
+    if (byInstrument_[index]) {
+        throw std::invalid_argument("two engines trade the same instrument");
+    }
+    byInstrument_[index] = &engine;
+    engines_.push_back(&engine);
+}
 
 MatchResult MiniExchangeAPI::processNewOrder(const client::NewOrderPayload& payload) {
+    MatchingEngine* engine = route_(InstrumentID{payload.instrumentID});
+    if (!engine) {
+        return rejected_(payload);
+    }
+    MatchResult result = engine->processOrder(makeOrder_(*engine, payload));
+    useBuffersOf_(*engine);
+    return result;
+}
 
+OrderHandle MiniExchangeAPI::makeOrder_(MatchingEngine& engine,
+                                        const client::NewOrderPayload& payload) {
     // TODO: validate the order parameters
-    std::unique_ptr<Order> order = std::make_unique<Order>(
-        Order{.orderID = OrderID{engine_.getNextOrderID()},
-              .clientID = ClientID{payload.serverClientID},
-              .clientOrderID = ClientOrderID{payload.clientOrderID},
-              .qty = Qty{payload.qty},
-              .price = Price{payload.price},
-              .goodTill = payload.goodTillDate,
-              .timestamp = TSCClock::now(),
-              .instrumentID = InstrumentID{payload.instrumentID},
-              .tif = TimeInForce{payload.timeInForce},
-              .side = OrderSide{payload.orderSide},
-              .type = OrderType{payload.orderType},
-              .status = OrderStatus::NEW});
-
-    return engine_.processOrder(std::move(order));
+    return engine.makeOrder(Order{.orderID = OrderID{engine.getNextOrderID()},
+                                  .clientID = ClientID{payload.serverClientID},
+                                  .clientOrderID = ClientOrderID{payload.clientOrderID},
+                                  .qty = Qty{payload.qty},
+                                  .price = Price{payload.price},
+                                  .goodTill = payload.goodTillDate,
+                                  .timestamp = TSCClock::now(),
+                                  .instrumentID = InstrumentID{payload.instrumentID},
+                                  .tif = TimeInForce{payload.timeInForce},
+                                  .side = OrderSide{payload.orderSide},
+                                  .type = OrderType{payload.orderType},
+                                  .status = OrderStatus::NEW});
+}
+
+MatchResult MiniExchangeAPI::rejected_(const client::NewOrderPayload& payload) {
+    return MatchResult{.orderID = OrderID{0},
+                       .timestamp = TSCClock::now(),
+                       .remainingQty = Qty{payload.qty},
+                       .acceptedPrice = Price{0},
+                       .status = OrderStatus::REJECTED,
+                       .instrumentID = InstrumentID{payload.instrumentID},
+                       .tradeVec{}};
+}
+
+ModifyResult MiniExchangeAPI::notFound_(const client::ModifyOrderPayload& payload) {
+    return ModifyResult{.serverClientID = ClientID{payload.serverClientID},
+                        .oldOrderID = OrderID{payload.serverOrderID},
+                        .newOrderID = OrderID{0},
+                        .newQty = Qty{payload.newQty},
+                        .newPrice = Price{payload.newPrice},
+                        .status = ModifyStatus::NOT_FOUND,
+                        .instrumentID = InstrumentID{payload.instrumentID},
+                        .matchResult = std::nullopt};
+}
+
+std::size_t MiniExchangeAPI::processBatch(std::span<const OrderCommand> commands,
+                                          std::span<CommandResult> results) {
+    const std::size_t count = std::min(commands.size(), results.size());
+    batchTrades_.clear();
+    batchSelfTradeCancels_.clear();
+
+    std::size_t begin = 0;
+    while (begin < count) {
+        const InstrumentID instrumentID = commands[begin].instrumentID;
+        std::size_t end = begin + 1;
+        while (end < count && commands[end].instrumentID == instrumentID) {
+            ++end;
+        }
+
+        const auto runCommands = commands.subspan(begin, end - begin);
+        const auto runResults = results.subspan(begin, end - begin);
+        MatchingEngine* engine = route_(instrumentID);
+        if (!engine) {
+            rejectAll_(runCommands, runResults);
+        } else {
+            engine->processBatch(runCommands, runResults);
+            if (begin == 0 && end == count) {
+                // a single instrument, the engine's buffers are used as they are
+                useBuffersOf_(*engine);
+                return count;
+            }
+        }
+
+        // the ends are relative to the engine's buffers, which are collected here
+        for (CommandResult& result : runResults) {
+            result.tradeEnd += batchTrades_.size();
+            result.selfTradeCancelEnd += batchSelfTradeCancels_.size();
+        }
+        if (engine) {
+            batchTrades_.insert(batchTrades_.end(), engine->getTrades().begin(),
+                                engine->getTrades().end());
+            batchSelfTradeCancels_.insert(batchSelfTradeCancels_.end(),
+                                          engine->getSelfTradeCancels().begin(),
+                                          engine->getSelfTradeCancels().end());
+        }
+        begin = end;
+    }
+
+    trades_ = batchTrades_;
+    selfTradeCancels_ = batchSelfTradeCancels_;
+    return count;
+}
+
+void MiniExchangeAPI::rejectAll_(std::span<const OrderCommand> commands,
+                                 std::span<CommandResult> results) {
+    for (std::size_t i = 0; i < commands.size(); ++i) {
+        const OrderCommand& command = commands[i];
+        results[i] = CommandResult{.command = command.command};
+        switch (command.command) {
+        case CommandType::NEW_ORDER:
+            results[i].match = MatchResult{.orderID = OrderID{0},
+                                           .timestamp = TSCClock::now(),
+                                           .remainingQty = command.qty,
+                                           .acceptedPrice = Price{0},
+                                           .status = OrderStatus::REJECTED,
+                                           .instrumentID = command.instrumentID,
+                                           .tradeVec{}};
+            break;
+        case CommandType::CANCEL:
+            results[i].cancelled = false;
+            break;
+        case CommandType::MODIFY:
+            results[i].modify = ModifyResult{.serverClientID = command.clientID,
+                                             .oldOrderID = command.orderID,
+                                             .newOrderID = OrderID{0},
+                                             .newQty = command.qty,
+                                             .newPrice = command.price,
+                                             .status = ModifyStatus::NOT_FOUND,
+                                             .instrumentID = command.instrumentID,
+                                             .matchResult = std::nullopt};
+            break;
+        }
+    }
+}
+
+OrderCommand MiniExchangeAPI::makeCommand(const client::NewOrderPayload& payload) {
+    // the engine numbers the order and stamps the whole batch with one timestamp
+    return OrderCommand{.command = CommandType::NEW_ORDER,
+                        .orderID = OrderID{0},
+                        .clientID = ClientID{payload.serverClientID},
+                        .clientOrderID = ClientOrderID{payload.clientOrderID},
+                        .qty = Qty{payload.qty},
+                        .price = Price{payload.price},
+                        .goodTill = payload.goodTillDate,
+                        .instrumentID = InstrumentID{payload.instrumentID},
+                        .tif = TimeInForce{payload.timeInForce},
+                        .side = OrderSide{payload.orderSide},
+                        .type = OrderType{payload.orderType}};
+}
+
+OrderCommand MiniExchangeAPI::makeCommand(const client::CancelOrderPayload& payload) {
+    return OrderCommand{.command = CommandType::CANCEL,
+                        .orderID = OrderID{payload.serverOrderID},
+                        .clientID = ClientID{payload.serverClientID},
+                        .clientOrderID = ClientOrderID{payload.clientOrderID},
+                        .instrumentID = InstrumentID{payload.instrumentID}};
+}
+
+OrderCommand MiniExchangeAPI::makeCommand(const client::ModifyOrderPayload& payload) {
+    return OrderCommand{.command = CommandType::MODIFY,
+                        .orderID = OrderID{payload.serverOrderID},
+                        .clientID = ClientID{payload.serverClientID},
+                        .clientOrderID = ClientOrderID{payload.clientOrderID},
+                        .qty = Qty{payload.newQty},
+                        .price = Price{payload.newPrice},
+                        .instrumentID = InstrumentID{payload.instrumentID}};
 }
 
 bool MiniExchangeAPI::cancelOrder(const client::CancelOrderPayload& payload) {
     // TODO: validate the parameters
-    return engine_.cancelOrder(ClientID{payload.serverClientID},
-                               OrderID{payload.serverOrderID});
+    MatchingEngine* engine = route_(InstrumentID{payload.instrumentID});
+    return engine && engine->cancelOrder(ClientID{payload.serverClientID},
+                                         OrderID{payload.serverOrderID});
 }
 
 ModifyResult MiniExchangeAPI::modifyOrder(const client::ModifyOrderPayload& payload) {
     // TODO: validate the parameters
-    return engine_.modifyOrder(ClientID{payload.serverClientID},
-                               OrderID{payload.serverOrderID}, Qty{payload.newQty},
-                               Price{payload.newPrice});
+    MatchingEngine* engine = route_(InstrumentID{payload.instrumentID});
+    if (!engine) {
+        return notFound_(payload);
+    }
+    ModifyResult result = engine->modifyOrder(
+        ClientID{payload.serverClientID}, OrderID{payload.serverOrderID},
+        Qty{payload.newQty}, Price{payload.newPrice});
+    useBuffersOf_(*engine);
+    return result;
+}
+
+std::optional<MassCancelFilter>
+MiniExchangeAPI::makeFilter_(const client::MassCancelPayload& payload) {
+    MassCancelFilter filter{.minPrice = Price{payload.minPrice}};
+    if (payload.maxPrice != 0) {
+        filter.maxPrice = Price{payload.maxPrice};
+    }
+
+    if (payload.orderSide == +OrderSide::BUY || payload.orderSide == +OrderSide::SELL) {
+        filter.side = OrderSide{payload.orderSide};
+    } else if (payload.orderSide != client::MassCancelPayload::kBothSides) {
+        return std::nullopt;
+    }
+    return filter;
 }
@@ -0,0 +1,92 @@
+#include "client/mboBook.hpp"
+#include "utils/types.hpp"
+
+#include <iterator>
+
+void MBOBook::add(OrderID orderID, Price price, Qty qty, OrderSide side) {
+    if (auto it = index_.find(orderID); it != index_.end()) {
+        qty += it->second->qty;
+        erase_(it);
+    }
+
+    Level& level = side == OrderSide::BUY ? bids_[price] : asks_[price];
+    level.push_back(Entry{orderID, price, qty, side});
+    index_.emplace(orderID, std::prev(level.end()));
+}
+
+void MBOBook::reduce(OrderID orderID, Qty amount) {
+    auto it = index_.find(orderID);
+    if (it == index_.end()) {
+        return;
+    }
+
+    if (amount >= it->second->qty) {
+        erase_(it);
+    } else {
+        it->second->qty -= amount;
+    }
+}
+
+void MBOBook::cancel(OrderID orderID) {
+    if (auto it = index_.find(orderID); it != index_.end()) {
+        erase_(it);
+    }
+}
+
+void MBOBook::clear() {
+    bids_.clear();
+    asks_.clear();
+    index_.clear();
+}
+
+const MBOBook::Entry* MBOBook::find(OrderID orderID) const {
+    auto it = index_.find(orderID);
+    return it == index_.end() ? nullptr : &*it->second;
+}
+
+std::optional<Qty> MBOBook::qtyAhead(OrderID orderID) const {
+    auto it = index_.find(orderID);
+    if (it == index_.end()) {
+        return std::nullopt;
+    }
+
+    const Entry& entry = *it->second;
+    const Level& level = entry.side == OrderSide::BUY ? bids_.find(entry.price)->second
+                                                      : asks_.find(entry.price)->second;
+    Qty ahead{0};
+    for (auto other = level.begin(); other != it->second; ++other) {
+        ahead += other->qty;
+    }
+    return ahead;
+}
+
+Qty MBOBook::levelQty(OrderSide side, Price price) const {
+    auto sum = [price](const auto& bookSide) {
+        Qty total{0};
+        if (auto it = bookSide.find(price); it != bookSide.end()) {
+            for (const Entry& entry : it->second) {
+                total += entry.qty;
+            }
+        }
+        return total;
+    };
+    return side == OrderSide::BUY ? sum(bids_) : sum(asks_);
+}
+
+void MBOBook::erase_(std::unordered_map<OrderID, Level::iterator>::iterator it) {
+    const Level::iterator entry = it->second;
+    auto unlink = [entry](auto& bookSide) {
+        auto levelIt = bookSide.find(entry->price);
+        levelIt->second.erase(entry);
+        if (levelIt->second.empty()) {
+            bookSide.erase(levelIt);
+        }
+    };
+
+    if (entry->side == OrderSide::BUY) {
+        unlink(bids_);
+    } else {
+        unlink(asks_);
+    }
+    index_.erase(it);
+}
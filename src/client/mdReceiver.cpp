@@ -4,6 +4,7 @@
 #include "utils/types.hpp"
 #include "utils/utils.hpp"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <asm-generic/socket.h>
 #include <cerrno>
@@ -17,6 +18,21 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#ifndef MINIEXCHANGE_MD_LOG_LEVEL
+#define MINIEXCHANGE_MD_LOG_LEVEL 0
+#endif
+
+namespace {
+
+// Diagnostics on the receive path are compiled in through the MD_RECEIVER_LOG_LEVEL
+// CMake cache variable (cmake -DMD_RECEIVER_LOG_LEVEL=1 or 2), which sets
+// MINIEXCHANGE_MD_LOG_LEVEL. Errors are always reported.
+constexpr int kLogLevel = MINIEXCHANGE_MD_LOG_LEVEL;
+constexpr int kLogDatagrams = 1;
+constexpr int kLogHex = 2;
+
+} // namespace
+
 void MDReceiver::initialize() {
     sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);
     if (sockfd_ < 0) {
@@ -73,6 +89,18 @@ void MDReceiver::initialize() {
                                  std::string(strerror(errno)));
     }
 
+    const std::size_t batch = std::max<std::size_t>(mdConfig_.batch, 1);
+    batchBuffers_.resize(batch * mdConfig_.datagramSize);
+    batchMsgs_.resize(batch);
+    batchIovecs_.resize(batch);
+    for (std::size_t i = 0; i < batch; ++i) {
+        batchIovecs_[i].iov_base = batchBuffers_.data() + i * mdConfig_.datagramSize;
+        batchIovecs_[i].iov_len = mdConfig_.datagramSize;
+        batchMsgs_[i] = mmsghdr{};
+        batchMsgs_[i].msg_hdr.msg_iov = &batchIovecs_[i];
+        batchMsgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+
     std::cout << "MDReceiver initialized: " << mdConfig_.multicastGroup << ":"
               << mdConfig_.port << std::endl;
 
@@ -94,38 +122,92 @@ bool MDReceiver::receiveOne() {
         return false;
     }
 
-    if (bytesReceived == 0) {
-        std::cout << "Received 0-byte packet" << std::endl;
-        return false;
+    if constexpr (kLogLevel >= kLogDatagrams) {
+        std::cout << "Bytes received: " << bytesReceived << std::endl;
     }
 
-    std::cout << "Bytes received: " << bytesReceived << std::endl;
-
-    if (bytesReceived < 16) {
+    if (static_cast<std::size_t>(bytesReceived) < MarketDataHeader::traits::HEADER_SIZE) {
         return false;
     }
     processMessage_(std::span<const std::byte>(mdBuffer_.data(),
                                                static_cast<std::size_t>(bytesReceived)));
     return true;
 }
-void MDReceiver::processMessage_(std::span<const std::byte> msgBytes) {
-    utils::printHex(msgBytes);
-    if (msgBytes.size() < 16) {
-        return;
+
+std::size_t MDReceiver::pollBatch() {
+    const int received = ::recvmmsg(sockfd_, batchMsgs_.data(),
+                                    static_cast<unsigned int>(batchMsgs_.size()),
+                                    MSG_DONTWAIT, nullptr);
+    if (received < 0) {
+        if (errno != EAGAIN) {
+            std::cerr << "Error receiving data: " << strerror(errno) << std::endl;
+        }
+        return 0;
     }
 
-    auto originalData = msgBytes;
-    MarketDataHeader header = parseHeader_(msgBytes);
+    std::size_t applied = 0;
+    for (std::size_t i = 0; i < static_cast<std::size_t>(received); ++i) {
+        const std::size_t bytesReceived = batchMsgs_[i].msg_len;
+        if constexpr (kLogLevel >= kLogDatagrams) {
+            std::cout << "Bytes received: " << bytesReceived << std::endl;
+        }
+        if (bytesReceived < MarketDataHeader::traits::HEADER_SIZE) {
+            continue;
+        }
+        applied += processMessage_(std::span<const std::byte>(
+            batchBuffers_.data() + i * mdConfig_.datagramSize, bytesReceived));
+    }
+    return applied;
+}
+
+std::size_t MDReceiver::processMessage_(std::span<const std::byte> msgBytes) {
+    if constexpr (kLogLevel >= kLogHex) {
+        utils::printHex(msgBytes);
+    }
+
+    std::size_t messages = 0;
+    // a datagram carries one or more messages back to back, each framed by its header
+    while (msgBytes.size() >= MarketDataHeader::traits::HEADER_SIZE) {
+        auto hdrBytes = msgBytes;
+        MarketDataHeader header = parseHeader_(hdrBytes);
+        const std::size_t messageSize =
+            MarketDataHeader::traits::HEADER_SIZE + header.payloadLength;
+        if (messageSize > msgBytes.size()) {
+            std::cerr << "Truncated market data message" << std::endl;
+            return messages;
+        }
 
-    checkSequence_(header.sequenceNumber);
+        if (mdConfig_.instrumentID == 0 ||
+            header.instrumentID == mdConfig_.instrumentID) {
+            dispatch_(header, msgBytes.subspan(MarketDataHeader::traits::HEADER_SIZE,
+                                               header.payloadLength));
+            ++messages;
+        }
+        msgBytes = msgBytes.subspan(messageSize);
+    }
+    return messages;
+}
 
-    auto payload = originalData.subspan(MarketDataHeader::traits::HEADER_SIZE);
+void MDReceiver::dispatch_(const MarketDataHeader& header,
+                           std::span<const std::byte> payload) {
     auto msgType = static_cast<MDMsgType>(header.mdMsgType);
 
+    if (msgType == MDMsgType::DELTA || msgType == MDMsgType::SNAPSHOT) {
+        checkSequence_(expectedMDSqn_, header.sequenceNumber,
+                       &MDReceiver::markBookInvalid);
+    } else {
+        checkSequence_(expectedL3Sqn_, header.sequenceNumber,
+                       &MDReceiver::markMBOBookInvalid);
+    }
+
     if (msgType == MDMsgType::DELTA) {
         processDelta_(payload, header.sequenceNumber);
     } else if (msgType == MDMsgType::SNAPSHOT) {
         processSnapshot_(payload, header.sequenceNumber);
+    } else if (msgType == MDMsgType::ORDER_DELTA) {
+        processOrderDelta_(payload, header.sequenceNumber);
+    } else if (msgType == MDMsgType::ORDER_SNAPSHOT) {
+        processOrderSnapshot_(payload, header.sequenceNumber);
     }
 }
 
@@ -157,11 +239,11 @@ void MDReceiver::processDelta_(std::span<const std::byte> payloadBytes,
     delta.side = readByteAdvance(payloadBytes);
 
     if (delta.deltaType == +MDDeltatype::ADD) {
-        addAtPrice_(Price{delta.priceLevel}, Qty{delta.amountDelta},
-                    OrderSide{delta.side});
+        book_.add(OrderSide{delta.side}, Price{delta.priceLevel},
+                  Qty{delta.amountDelta});
     } else {
-        reduceAtPrice_(Price{delta.priceLevel}, Qty{delta.amountDelta},
-                       OrderSide{delta.side});
+        book_.reduce(OrderSide{delta.side}, Price{delta.priceLevel},
+                     Qty{delta.amountDelta});
     }
 
     if (onDelta_) {
@@ -181,8 +263,7 @@ void MDReceiver::processSnapshot_(std::span<const std::byte> payloadBytes,
     std::uint16_t askCount = readIntegerAdvance<std::uint16_t>(payloadBytes);
     std::uint32_t _ = readIntegerAdvance<std::uint32_t>(payloadBytes); // padding
 
-    book_.bids.clear();
-    book_.asks.clear();
+    book_.clear();
 
     for (std::uint16_t i = 0; i < bidCount; ++i) {
         if (payloadBytes.size() < 16) {
@@ -192,7 +273,7 @@ void MDReceiver::processSnapshot_(std::span<const std::byte> payloadBytes,
         std::uint64_t price = readIntegerAdvance<std::uint64_t>(payloadBytes);
         std::uint64_t qty = readIntegerAdvance<std::uint64_t>(payloadBytes);
 
-        book_.bids.emplace_back(Price{price}, Qty{qty});
+        book_.add(OrderSide::BUY, Price{price}, Qty{qty});
     }
 
     for (std::uint16_t i = 0; i < askCount; ++i) {
@@ -203,7 +284,7 @@ void MDReceiver::processSnapshot_(std::span<const std::byte> payloadBytes,
         std::uint64_t price = readIntegerAdvance<std::uint64_t>(payloadBytes);
         std::uint64_t qty = readIntegerAdvance<std::uint64_t>(payloadBytes);
 
-        book_.asks.emplace_back(Price{price}, Qty{qty});
+        book_.add(OrderSide::SELL, Price{price}, Qty{qty});
     }
 
     markBookValid();
@@ -213,25 +294,109 @@ void MDReceiver::processSnapshot_(std::span<const std::byte> payloadBytes,
     }
 }
 
-void MDReceiver::checkSequence_(std::uint64_t receivedSeqNum) {
-    if (!expectedMDSqn_.has_value()) {
+void MDReceiver::processOrderDelta_(std::span<const std::byte> payloadBytes,
+                                    std::uint64_t sqn) {
+    if (payloadBytes.size() < OrderDeltaPayload::traits::PAYLOAD_SIZE) {
+        std::cerr << "Order delta payload too small" << std::endl;
+        return;
+    }
+    if (!mboBookValid_) {
+        return;
+    }
+
+    OrderDeltaPayload delta{};
+    delta.orderID = readIntegerAdvance<std::uint64_t>(payloadBytes);
+    delta.price = readIntegerAdvance<std::uint64_t>(payloadBytes);
+    delta.qty = readIntegerAdvance<std::uint64_t>(payloadBytes);
+    delta.eventType = readByteAdvance(payloadBytes);
+    delta.side = readByteAdvance(payloadBytes);
+
+    const OrderID orderID{delta.orderID};
+    const auto eventType = static_cast<MDOrderEventType>(delta.eventType);
+    if (eventType == MDOrderEventType::ADD) {
+        mboBook_.add(orderID, Price{delta.price}, Qty{delta.qty}, OrderSide{delta.side});
+    } else if (eventType == MDOrderEventType::REDUCE) {
+        mboBook_.reduce(orderID, Qty{delta.qty});
+    } else {
+        mboBook_.cancel(orderID);
+    }
+
+    if (onOrderDelta_) {
+        onOrderDelta_(orderID, Price{delta.price}, Qty{delta.qty}, OrderSide{delta.side},
+                      eventType, sqn);
+    }
+}
+
+void MDReceiver::processOrderSnapshot_(std::span<const std::byte> payloadBytes,
+                                       std::uint64_t sqn) {
+    if (payloadBytes.size() < OrderSnapshotHeader::traits::SNAPSHOT_HEADER_SIZE) {
+        std::cerr << "Order snapshot payload too small" << std::endl;
+        return;
+    }
+
+    std::uint32_t orderCount = readIntegerAdvance<std::uint32_t>(payloadBytes);
+    std::uint16_t partIndex = readIntegerAdvance<std::uint16_t>(payloadBytes);
+    bool lastPart = readByteAdvance(payloadBytes) != 0;
+    readByteAdvance(payloadBytes); // padding
+
+    if (partIndex == 0) {
+        mboBook_.clear();
+        nextSnapshotPart_ = 0;
+    }
+    // joined in the middle of a snapshot, or an earlier part was lost
+    if (nextSnapshotPart_ != partIndex) {
+        return;
+    }
+
+    for (std::uint32_t i = 0; i < orderCount; ++i) {
+        if (payloadBytes.size() < SnapshotOrder::traits::ORDER_SIZE) {
+            break;
+        }
+
+        std::uint64_t orderID = readIntegerAdvance<std::uint64_t>(payloadBytes);
+        std::uint64_t price = readIntegerAdvance<std::uint64_t>(payloadBytes);
+        std::uint64_t qty = readIntegerAdvance<std::uint64_t>(payloadBytes);
+        std::uint8_t side = readByteAdvance(payloadBytes);
+        payloadBytes = payloadBytes.subspan(sizeof(SnapshotOrder::_padding));
+
+        mboBook_.add(OrderID{orderID}, Price{price}, Qty{qty}, OrderSide{side});
+    }
+
+    if (!lastPart) {
+        ++*nextSnapshotPart_;
+        return;
+    }
+
+    nextSnapshotPart_.reset();
+    markMBOBookValid();
+
+    if (onOrderSnapshot_) {
+        onOrderSnapshot_(mboBook_, sqn);
+    }
+}
+
+void MDReceiver::checkSequence_(std::optional<std::uint64_t>& expectedSqn,
+                                std::uint64_t receivedSeqNum,
+                                void (MDReceiver::*invalidate)()) {
+    if (!expectedSqn.has_value()) {
         // First message - accept any sequence number
-        expectedMDSqn_ = receivedSeqNum + 1;
+        expectedSqn = receivedSeqNum + 1;
         return;
     }
 
-    if (receivedSeqNum != *expectedMDSqn_) {
-        handleGap_(*expectedMDSqn_, receivedSeqNum);
+    if (receivedSeqNum != *expectedSqn) {
+        handleGap_(*expectedSqn, receivedSeqNum, invalidate);
     }
 
-    expectedMDSqn_ = receivedSeqNum + 1;
+    expectedSqn = receivedSeqNum + 1;
 }
 
-void MDReceiver::handleGap_(std::uint64_t expected, std::uint64_t received) {
+void MDReceiver::handleGap_(std::uint64_t expected, std::uint64_t received,
+                            void (MDReceiver::*invalidate)()) {
     std::cerr << "Gap detected: expected " << expected << "; received " << received
               << " (missed " << (received - expected) << " messages)" << std::endl;
 
-    markBookInvalid();
+    (this->*invalidate)();
 
     if (onGapDetected_) {
         onGapDetected_(expected, received);
@@ -256,47 +421,11 @@ void MDReceiver::markBookInvalid() {
     }
 }
 
-const std::vector<std::pair<Price, Qty>>& MDReceiver::getBook(OrderSide side) const {
-    return side == OrderSide::BUY ? book_.bids : book_.asks;
-}
-
-std::vector<std::pair<Price, Qty>>& MDReceiver::getBook(OrderSide side) {
-    return side == OrderSide::BUY ? book_.bids : book_.asks;
-}
-
-bool MDReceiver::priceBetterOrEqual_(Price incoming, Price resting, OrderSide side) {
-    if (side == OrderSide::BUY) {
-        return incoming >= resting;
-    } else {
-        return resting >= incoming;
-    }
+void MDReceiver::markMBOBookValid() {
+    mboBookValid_ = true;
 }
 
-void MDReceiver::addAtPrice_(Price price, Qty amount, OrderSide side) {
-    auto& book = getBook(side);
-
-    auto it = std::find_if(book.rbegin(), book.rend(), [&](const auto& level) {
-        return level.first == price || !priceBetterOrEqual_(price, level.first, side);
-    });
-
-    if (it != book.rend() && it->first == price) {
-        it->second += amount;
-        return;
-    }
-
-    auto insertIt = (it == book.rend()) ? book.begin() : it.base();
-    book.insert(insertIt, {price, amount});
-}
-
-void MDReceiver::reduceAtPrice_(Price price, Qty amount, OrderSide side) {
-    auto& book = getBook(side);
-    for (auto rIt = book.rbegin(); rIt != book.rend(); ++rIt) {
-        if (rIt->first == price) {
-            rIt->second -= amount;
-            if (rIt->second == Qty{0}) {
-                book.erase(std::next(rIt).base());
-            }
-            return;
-        }
-    }
+void MDReceiver::markMBOBookInvalid() {
+    mboBookValid_ = false;
+    nextSnapshotPart_.reset();
 }
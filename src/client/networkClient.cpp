@@ -104,7 +104,7 @@ void NetworkClient::messageLoop_() {
         }
 
         if (mdReceiver_) {
-            mdReceiver_->receiveOne();
+            mdReceiver_->pollBatch();
         }
 
         fd_set readfds, writefds;
@@ -253,6 +253,20 @@ void NetworkClient::sendModify(ClientOrderID clientOrderID, OrderID serverOrderI
     sendMessage_(MessageType::MODIFY_ORDER, payload);
 }
 
+void NetworkClient::sendMassCancel(InstrumentID instrumentID,
+                                   std::optional<OrderSide> side, Price minPrice,
+                                   Price maxPrice) {
+    client::MassCancelPayload payload{};
+    payload.serverClientID = session_.serverClientID.value();
+    payload.minPrice = minPrice.value();
+    payload.maxPrice = maxPrice.value();
+    payload.instrumentID = instrumentID.value();
+    payload.orderSide = side ? +*side : client::MassCancelPayload::kBothSides;
+    std::memset(payload.padding, 0, sizeof(payload.padding));
+
+    sendMessage_(MessageType::MASS_CANCEL, payload);
+}
+
 template <typename Payload>
 void NetworkClient::sendMessage_(MessageType type, const Payload& payload) {
     MessageHeader header;
@@ -369,6 +383,16 @@ void NetworkClient::handleMessage_(std::span<const std::byte> messageBytes) {
         }
         break;
 
+    case MessageType::MASS_CANCEL_ACK:
+        if (auto msg = deserializeMessage<server::MassCancelAckPayload>(messageBytes)) {
+            session_.serverSqn = ServerSqn32{msg->header.serverMsgSqn};
+
+            if (massCancelAckCallback_) {
+                massCancelAckCallback_(*msg);
+            }
+        }
+        break;
+
     default:
         break;
     }
@@ -403,3 +427,5 @@ template void NetworkClient::sendMessage_<client::CancelOrderPayload>(
     MessageType, const client::CancelOrderPayload&);
 template void NetworkClient::sendMessage_<client::ModifyOrderPayload>(
     MessageType, const client::ModifyOrderPayload&);
+template void NetworkClient::sendMessage_<client::MassCancelPayload>(
+    MessageType, const client::MassCancelPayload&);
@@ -33,6 +33,12 @@ TradingClient::TradingClient(const TradingConfig& config)
     network_.setTradeCallback([this](const auto& msg) {
         handleTrade_(msg);
     });
+    network_.setMassCancelAckCallback([this](const auto& msg) {
+        const bool accepted =
+            status::CancelStatus{msg.payload.status} == status::CancelStatus::ACCEPTED;
+        onMassCancelAck(InstrumentID{msg.payload.instrumentID},
+                        msg.payload.cancelledCount, accepted);
+    });
 
     if (network_.getMarketData()) {
         setupMarketDataCallbacks_();
@@ -113,6 +119,11 @@ bool TradingClient::cancelOrder(ClientOrderID clientOrderID) {
     return true;
 }
 
+void TradingClient::cancelAllOrders(InstrumentID instrumentID,
+                                    std::optional<OrderSide> side) {
+    network_.sendMassCancel(instrumentID, side);
+}
+
 void TradingClient::modifyOrder(ClientOrderID clientOrderID, Qty newQty, Price newPrice) {
     OrderID serverOrderID;
     InstrumentID instrumentID;
@@ -272,7 +283,11 @@ void TradingClient::handleCancelAck_(const Message<server::CancelAckPayload>& ms
 
         found = true;
 
-        if (cancelStatus == status::CancelStatus::ACCEPTED) {
+        // EXPIRED and SELF_TRADE acks are sent unprompted, when a GTD/EOD order runs
+        // out or self-trade prevention takes a resting order off the book
+        if (cancelStatus == status::CancelStatus::ACCEPTED ||
+            cancelStatus == status::CancelStatus::EXPIRED ||
+            cancelStatus == status::CancelStatus::SELF_TRADE) {
             auto& order = it->second;
             order.status = OrderStatus::CANCELLED;
             order.remainingQty = Qty{0};
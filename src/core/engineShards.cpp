@@ -0,0 +1,75 @@
+#include "core/engineShards.hpp"
+
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+EngineShards::EngineShards(std::span<MatchingEngine* const> engines, SessionManager& sm,
+                           EngineShardsConfig config)
+    : engines_(engines.begin(), engines.end()), sessionManager_(sm),
+      config_(std::move(config)) {
+    if (config_.cpus.empty() ||
+        config_.cpus.size() > std::numeric_limits<std::uint16_t>::max()) {
+        throw std::invalid_argument("engine shards: bad shard count");
+    }
+
+    for (std::size_t i = 0; i < engines_.size(); ++i) {
+        const std::uint32_t index = engines_[i]->getInstrumentID().value();
+        if (index >= assignment_.size()) {
+            assignment_.resize(index + 1, 0);
+        }
+        assignment_[index] = static_cast<std::uint16_t>(i % config_.cpus.size());
+    }
+    build_();
+}
+
+void EngineShards::build_() {
+    shards_.clear();
+    shards_.resize(config_.cpus.size());
+
+    std::vector<std::vector<MatchingEngine*>> owned(shards_.size());
+    for (MatchingEngine* engine : engines_) {
+        owned[shardOf(engine->getInstrumentID())].push_back(engine);
+    }
+
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        EngineThreadConfig threadConfig = config_.thread;
+        threadConfig.cpu = config_.cpus[i];
+        shards_[i].api = std::make_unique<MiniExchangeAPI>(owned[i], sessionManager_);
+        shards_[i].thread = std::make_unique<EngineThread>(*shards_[i].api, threadConfig);
+    }
+}
+
+void EngineShards::start() {
+    if (running_) {
+        return;
+    }
+    for (Shard& shard : shards_) {
+        shard.thread->start();
+    }
+    running_ = true;
+}
+
+void EngineShards::stop() {
+    for (Shard& shard : shards_) {
+        shard.thread->stop();
+    }
+    running_ = false;
+}
+
+void EngineShards::assign(InstrumentID instrumentID, std::size_t shard) {
+    if (running_) {
+        throw std::logic_error("engine shards: rebalancing needs the shards stopped");
+    }
+    const std::uint32_t index = instrumentID.value();
+    bool listed = false;
+    for (const MatchingEngine* engine : engines_) {
+        listed = listed || engine->getInstrumentID() == instrumentID;
+    }
+    if (!listed || shard >= shards_.size()) {
+        throw std::out_of_range("engine shards: unknown instrument or shard");
+    }
+
+    assignment_[index] = static_cast<std::uint16_t>(shard);
+    build_();
+}
@@ -0,0 +1,180 @@
+#include "core/engineThread.hpp"
+#include "utils/status.hpp"
+#include "utils/threading.hpp"
+#include "utils/utils.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <span>
+
+EngineThread::EngineThread(MiniExchangeAPI& api, const EngineThreadConfig& config)
+    : api_(api), config_(config), requests_(config.ringCapacity),
+      responses_(config.ringCapacity) {
+    batch_.reserve(config.maxBatch);
+    batchSessions_.reserve(config.maxBatch);
+    batchResults_.resize(config.maxBatch);
+}
+
+void EngineThread::start() {
+    thread_ = std::jthread([this](std::stop_token stop) { run_(stop); });
+}
+
+void EngineThread::stop() {
+    if (thread_.joinable()) {
+        thread_.request_stop();
+        thread_.join();
+    }
+}
+
+void EngineThread::run_(std::stop_token stop) {
+    stop_ = stop;
+    utils::pinThisThread(config_.cpu);
+    nextTimerRun_ = std::chrono::steady_clock::now();
+
+    EngineRequest request;
+    while (!stop.stop_requested()) {
+        std::size_t drained = 0;
+        while (drained < config_.maxBatch && requests_.try_pop(request)) {
+            ++drained;
+            if (request.type == EngineRequestType::ORDER) {
+                batch_.push_back(request.command);
+                batchSessions_.push_back(request.sessionID);
+                continue;
+            }
+
+            // the commands that arrived first are processed first
+            processBatch_();
+            if (request.type == EngineRequestType::MASS_CANCEL) {
+                massCancel_(request);
+            } else {
+                api_.cancelAllOrders(request.sessionID);
+            }
+        }
+        processBatch_();
+
+        if (std::chrono::steady_clock::now() >= nextTimerRun_) {
+            runTimers_();
+        }
+        if (drained == 0) {
+            utils::cpuRelax();
+        }
+    }
+}
+
+void EngineThread::processBatch_() {
+    if (batch_.empty()) {
+        return;
+    }
+
+    api_.processBatch(batch_, batchResults_);
+
+    const std::span<const TradeEvent> trades = api_.getTrades();
+    const std::span<const SelfTradeCancel> selfTradeCancels = api_.getSelfTradeCancels();
+    std::size_t tradeBegin = 0;
+    std::size_t selfTradeCancelBegin = 0;
+
+    // same order as on the gateway thread: the ack, the trades, the self-trade cancels
+    for (std::size_t i = 0; i < batch_.size(); ++i) {
+        const OrderCommand& command = batch_[i];
+        const CommandResult& result = batchResults_[i];
+
+        EngineResponse response{.sessionID = batchSessions_[i],
+                                .clientOrderID = command.clientOrderID,
+                                .instrumentID = command.instrumentID};
+        switch (command.command) {
+        case CommandType::NEW_ORDER:
+            response.type = EngineResponseType::ORDER_ACK;
+            response.status = +result.match.status;
+            response.orderID = result.match.orderID;
+            response.qty = result.match.remainingQty;
+            response.price = result.match.acceptedPrice;
+            response.timestamp = result.match.timestamp;
+            response.instrumentID = result.match.instrumentID;
+            break;
+        case CommandType::CANCEL:
+            response.type = EngineResponseType::CANCEL_ACK;
+            response.status = +(result.cancelled ? status::CancelStatus::ACCEPTED
+                                                 : status::CancelStatus::REJECTED);
+            response.orderID = command.orderID;
+            break;
+        case CommandType::MODIFY:
+            response.type = EngineResponseType::MODIFY_ACK;
+            response.status = +result.modify.status;
+            response.orderID = result.modify.oldOrderID;
+            response.newOrderID = result.modify.newOrderID;
+            response.qty = result.modify.newQty;
+            response.price = result.modify.newPrice;
+            response.instrumentID = result.modify.instrumentID;
+            break;
+        }
+        respond_(response);
+
+        for (; tradeBegin < result.tradeEnd; ++tradeBegin) {
+            respond_(EngineResponse{.type = EngineResponseType::TRADE,
+                                    .trade = trades[tradeBegin]});
+        }
+        for (; selfTradeCancelBegin < result.selfTradeCancelEnd; ++selfTradeCancelBegin) {
+            const SelfTradeCancel& cancel = selfTradeCancels[selfTradeCancelBegin];
+            respond_(EngineResponse{.type = EngineResponseType::CANCEL_ACK,
+                                    .status = +status::CancelStatus::SELF_TRADE,
+                                    .sessionID = cancel.clientID,
+                                    .clientOrderID = cancel.clientOrderID,
+                                    .orderID = cancel.orderID,
+                                    .instrumentID = cancel.instrumentID});
+        }
+    }
+
+    batch_.clear();
+    batchSessions_.clear();
+}
+
+void EngineThread::massCancel_(const EngineRequest& request) {
+    std::optional<std::size_t> cancelled =
+        api_.massCancel(request.massCancel, [this, &request](const Order& order) {
+            respond_(EngineResponse{.type = EngineResponseType::CANCEL_ACK,
+                                    .status = +status::CancelStatus::ACCEPTED,
+                                    .sessionID = request.sessionID,
+                                    .clientOrderID = order.clientOrderID,
+                                    .orderID = order.orderID,
+                                    .instrumentID = order.instrumentID});
+        });
+
+    respond_(EngineResponse{
+        .type = EngineResponseType::MASS_CANCEL_ACK,
+        .status = +(cancelled ? status::CancelStatus::ACCEPTED
+                              : status::CancelStatus::REJECTED),
+        .sessionID = request.sessionID,
+        .instrumentID = InstrumentID{request.massCancel.instrumentID},
+        .cancelledCount = cancelled.value_or(0)});
+}
+
+void EngineThread::runTimers_() {
+    const auto now = static_cast<Timestamp>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
+
+    api_.expireOrders(now, [this](const Order& order) {
+        respond_(EngineResponse{.type = EngineResponseType::CANCEL_ACK,
+                                .status = +status::CancelStatus::EXPIRED,
+                                .sessionID = order.clientID,
+                                .clientOrderID = order.clientOrderID,
+                                .orderID = order.orderID,
+                                .instrumentID = order.instrumentID});
+    });
+
+    // expiries that did not fit into the engine's time budget continue right away
+    nextTimerRun_ = api_.hasPendingExpiries(now)
+                        ? std::chrono::steady_clock::now()
+                        : std::chrono::steady_clock::now() + config_.timerInterval;
+}
+
+void EngineThread::respond_(const EngineResponse& response) {
+    while (!responses_.try_push(response)) {
+        if (stop_.stop_requested()) {
+            return;
+        }
+        utils::cpuRelax();
+    }
+}
@@ -0,0 +1,159 @@
+#include "core/instrumentDirectory.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::vector<std::string_view> splitFields(std::string_view line) {
+    std::vector<std::string_view> fields;
+    while (true) {
+        const std::size_t comma = line.find(',');
+        std::string_view field = line.substr(0, comma);
+        while (!field.empty() && (field.front() == ' ' || field.front() == '\t')) {
+            field.remove_prefix(1);
+        }
+        while (!field.empty() && (field.back() == ' ' || field.back() == '\t' ||
+                                  field.back() == '\r')) {
+            field.remove_suffix(1);
+        }
+        fields.push_back(field);
+        if (comma == std::string_view::npos) {
+            return fields;
+        }
+        line.remove_prefix(comma + 1);
+    }
+}
+
+std::uint64_t parseNumber(std::string_view field, std::size_t lineNumber) {
+    std::uint64_t value = 0;
+    const auto [end, ec] =
+        std::from_chars(field.data(), field.data() + field.size(), value);
+    if (ec != std::errc{} || end != field.data() + field.size()) {
+        throw std::runtime_error("instruments: line " + std::to_string(lineNumber) +
+                                 ": not a number: '" + std::string(field) + "'");
+    }
+    return value;
+}
+
+} // namespace
+
+InstrumentDirectory InstrumentDirectory::parse(std::istream& in) {
+    InstrumentDirectory directory;
+    std::string line;
+    std::size_t lineNumber = 0;
+
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        const std::vector<std::string_view> fields = splitFields(line);
+        if (fields.front().empty() && fields.size() == 1) {
+            continue;
+        }
+        if (fields.front().starts_with('#')) {
+            continue;
+        }
+        if (fields.size() < 5 || fields.size() > 8) {
+            throw std::runtime_error("instruments: line " + std::to_string(lineNumber) +
+                                     ": expected 5 to 8 fields");
+        }
+
+        const std::uint64_t id = parseNumber(fields[0], lineNumber);
+        if (id > kMaxInstrumentID) {
+            throw std::runtime_error("instruments: line " + std::to_string(lineNumber) +
+                                     ": instrument id out of range");
+        }
+        InstrumentSpec spec{
+            .id = InstrumentID{static_cast<std::uint32_t>(id)},
+            .symbol = std::string(fields[1]),
+            .prices = {.tickSize = parseNumber(fields[2], lineNumber),
+                       .minPrice = parseNumber(fields[3], lineNumber),
+                       .maxPrice = parseNumber(fields[4], lineNumber)},
+            .referencePrice =
+                fields.size() >= 6 ? parseNumber(fields[5], lineNumber) : 0};
+        if (fields.size() >= 7 && !fields[6].empty()) {
+            const std::uint64_t port = parseNumber(fields[6], lineNumber);
+            if (port == 0 || port > 65'535) {
+                throw std::runtime_error("instruments: line " +
+                                         std::to_string(lineNumber) +
+                                         ": market data port out of range");
+            }
+            spec.mdPort = static_cast<std::uint16_t>(port);
+        }
+        if (fields.size() == 8) {
+            spec.orderCapacity = parseNumber(fields[7], lineNumber);
+        }
+        try {
+            directory.add(std::move(spec));
+        } catch (const std::runtime_error& e) {
+            throw std::runtime_error("instruments: line " + std::to_string(lineNumber) +
+                                     ": " + e.what());
+        }
+    }
+    return directory;
+}
+
+InstrumentDirectory InstrumentDirectory::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("instruments: cannot open " + path);
+    }
+    return parse(file);
+}
+
+void InstrumentDirectory::add(InstrumentSpec spec) {
+    const std::uint32_t id = spec.id.value();
+    if (id == 0 || id > kMaxInstrumentID) {
+        throw std::runtime_error("instrument id out of range");
+    }
+    if (spec.symbol.empty()) {
+        throw std::runtime_error("empty symbol");
+    }
+    if (spec.prices.tickSize == 0) {
+        throw std::runtime_error("tick size of " + spec.symbol + " is 0");
+    }
+    if (find(spec.id) || find(spec.symbol)) {
+        throw std::runtime_error("duplicate instrument " + spec.symbol);
+    }
+
+    // every instrument publishes on ports of its own, the receivers keep one sequence
+    // per feed
+    auto end = [](std::uint32_t first) { return first + kMarketDataPorts; };
+    std::uint32_t nextPort = kFirstMarketDataPort;
+    for (const InstrumentSpec& other : specs_) {
+        nextPort = std::max(nextPort, end(other.mdPort));
+    }
+    const std::uint32_t port = spec.mdPort != 0 ? spec.mdPort : nextPort;
+    if (end(port) - 1 > 65'535) {
+        throw std::runtime_error("market data ports of " + spec.symbol + " out of range");
+    }
+    for (const InstrumentSpec& other : specs_) {
+        if (port < end(other.mdPort) && other.mdPort < end(port)) {
+            throw std::runtime_error("market data ports of " + spec.symbol +
+                                     " already used by " + other.symbol);
+        }
+    }
+    spec.mdPort = static_cast<std::uint16_t>(port);
+
+    if (id >= byID_.size()) {
+        byID_.resize(id + 1, 0);
+    }
+    specs_.push_back(std::move(spec));
+    byID_[id] = static_cast<std::uint32_t>(specs_.size());
+}
+
+const InstrumentSpec* InstrumentDirectory::find(std::string_view symbol) const noexcept {
+    for (const InstrumentSpec& spec : specs_) {
+        if (spec.symbol == symbol) {
+            return &spec;
+        }
+    }
+    return nullptr;
+}
@@ -2,29 +2,112 @@
 #include "market-data/bookEvent.hpp"
 #include "utils/timing.hpp"
 #include "utils/types.hpp"
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <span>
 #include <thread>
 
+[[nodiscard]] MatchResult MatchingEngine::processOrder(OrderHandle order) {
+    beginCommand_();
+    MatchResult result = match_(std::move(order));
+    result.tradeVec.assign(trades_.begin(), trades_.end());
+    return result;
+}
+
 [[nodiscard]] MatchResult MatchingEngine::processOrder(std::unique_ptr<Order> order) {
-    std::uint64_t currentTime = TSCClock::now();
+    return processOrder(orderPool_.make(*order));
+}
+
+[[nodiscard]] ModifyResult MatchingEngine::modifyOrder(const ClientID clientID,
+                                                       const OrderID orderID,
+                                                       const Qty newQty,
+                                                       const Price newPrice) {
+    beginCommand_();
+    ModifyResult result = modify_(clientID, orderID, newQty, newPrice);
+    if (result.matchResult) {
+        result.matchResult->tradeVec.assign(trades_.begin(), trades_.end());
+    }
+    return result;
+}
 
-    if (!isValidOrder(*order)) {
-        return MatchResult{.orderID = OrderID{0},
-                           .timestamp = currentTime,
-                           .remainingQty = order->qty,
-                           .acceptedPrice = Price{0},
-                           .status = OrderStatus::REJECTED,
-                           .instrumentID = instrumentID_,
-                           .tradeVec{}};
+std::size_t MatchingEngine::processBatch(std::span<const OrderCommand> commands,
+                                         std::span<CommandResult> results) {
+    const std::size_t count = std::min(commands.size(), results.size());
+    commands = commands.first(count);
+    beginCommand_();
+
+    // all new orders are validated up front, before the pool or the book is touched
+    for (std::size_t i = 0; i < count; ++i) {
+        const OrderCommand& command = commands[i];
+        results[i] = CommandResult{.command = command.command};
+        if (command.command == CommandType::NEW_ORDER && !isValidOrder(command)) {
+            results[i].match = rejected_(command.qty);
+        }
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        prefetchAhead_(commands, i);
+
+        const OrderCommand& command = commands[i];
+        CommandResult& result = results[i];
+        switch (command.command) {
+        case CommandType::NEW_ORDER:
+            if (result.match.status != OrderStatus::REJECTED) {
+                // numbered here so the ids follow the processing order
+                const OrderID orderID =
+                    command.orderID == OrderID{0} ? getNextOrderID() : command.orderID;
+                result.match = dispatch_(orderPool_.make(
+                    orderID, command.clientID, command.clientOrderID,
+                    command.qty, command.price, command.goodTill, eventTime_,
+                    command.instrumentID, command.tif, command.side, command.type,
+                    OrderStatus::NEW));
+            }
+            break;
+        case CommandType::CANCEL:
+            result.cancelled = cancel_(command.clientID, command.orderID);
+            break;
+        case CommandType::MODIFY:
+            result.modify =
+                modify_(command.clientID, command.orderID, command.qty, command.price);
+            break;
+        }
+        result.tradeEnd = trades_.size();
+        result.selfTradeCancelEnd = selfTradeCancels_.size();
+    }
+    return count;
+}
+
+MatchResult MatchingEngine::match_(OrderHandle order) {
+    if (order && !isValidOrder(*order)) {
+        return rejected_(order->qty);
+    }
+    return dispatch_(std::move(order));
+}
+
+MatchResult MatchingEngine::dispatch_(OrderHandle order) {
+    if (!order) {
+        // order pool exhausted
+        return rejected_(Qty{0});
     }
 
     int sideIdx = (order->side == OrderSide::BUY ? 0 : 1);
-    int typeIdx = (order->type == OrderType::LIMIT ? 0 : 1);
+    int typeIdx = policyIndex_(*order);
 
     return (this->*dispatchTable_[sideIdx][typeIdx])(std::move(order));
-};
+}
+
+MatchResult MatchingEngine::rejected_(Qty qty) const {
+    return MatchResult{.orderID = OrderID{0},
+                       .timestamp = eventTime_,
+                       .remainingQty = qty,
+                       .acceptedPrice = Price{0},
+                       .status = OrderStatus::REJECTED,
+                       .instrumentID = instrumentID_,
+                       .tradeVec{}};
+}
 
 std::optional<Price> MatchingEngine::getBestAsk() const {
     if (book.asks.empty()) return std::nullopt;
@@ -41,63 +124,179 @@ std::optional<Price> MatchingEngine::getSpread() const {
     return book.asks.begin()->first - book.bids.begin()->first;
 }
 
-void MatchingEngine::addToBook_(std::unique_ptr<Order> order) {
-    Order* raw = order.get();
+void MatchingEngine::addToBook_(OrderHandle order) {
+    // the book keeps the order until it is filled or cancelled
+    Order* raw = order.release();
 
-    emitObserverEvent_(order->price, order->qty, order->side, BookUpdateEventType::ADD);
+    if (eventQueue_) {
+        emitEvent_(EngineEventType::ORDER_ADDED, *raw, raw->qty, raw->price);
+    } else {
+        emitObserverEvent_(raw->price, raw->qty, raw->side, BookUpdateEventType::ADD);
 
-    // LEVEL 3 ADD ORDER EVENT HERE
+        // LEVEL 3 ADD ORDER EVENT HERE
 
-    L3Update update{.price = order->price,
-                    .qty = order->qty,
-                    .orderID = order->orderID,
-                    .clientOrderID = order->clientOrderID,
-                    .timestamp = TSCClock::now(),
-                    .instrumentID = instrumentID_,
-                    .eventType = L3EventType::ORDER_ADD_OR_INCREASE,
-                    .orderType = OrderType::LIMIT,
-                    .orderSide = order->side};
+        L3Update update{.price = raw->price,
+                        .qty = raw->qty,
+                        .orderID = raw->orderID,
+                        .clientOrderID = raw->clientOrderID,
+                        .timestamp = eventTime_,
+                        .instrumentID = instrumentID_,
+                        .eventType = L3EventType::ORDER_ADD_OR_INCREASE,
+                        .orderType = OrderType::LIMIT,
+                        .orderSide = raw->side};
 
-    emitL3ObserverEvent_(update);
+        emitL3ObserverEvent_(update);
+    }
 
-    if (order->side == OrderSide::BUY) {
-        book.bids[order->price].emplace_back(std::move(order));
+    if (raw->side == OrderSide::BUY) {
+        book.bids[raw->price].push_back(raw);
     } else {
-        book.asks[order->price].emplace_back(std::move(order));
+        book.asks[raw->price].push_back(raw);
+    }
+    book.orderMap.insert(raw->orderID, raw);
+    ClientBook& client = clientBook_(raw->clientID);
+    client.orders.push_back(raw);
+    trackOwn_(client, *raw);
+
+    if (raw->tif == TimeInForce::GOOD_TILL_DATE) {
+        expiry_.schedule(raw->expiry, raw, expiryTick_(raw->goodTill));
+    } else if (raw->tif == TimeInForce::END_OF_DAY && expiryConfig_.endOfDay != 0) {
+        expiry_.schedule(raw->expiry, raw, expiryTick_(expiryConfig_.endOfDay));
     }
-    book.orderMap[raw->orderID] = raw;
 }
 
 void MatchingEngine::reset() {
+    // before the orders go back to the pool, the freelist reuses their storage
+    expiry_.clear();
+    for (ClientBook& client : clientBooks_) {
+        for (const Order* order = client.orders.front(); order;
+             order = order->clientNext) {
+            untrackOwn_(client, *order);
+        }
+        client.orders.clear();
+    }
+
+    auto releaseAll = [this](auto& bookSide) {
+        for (auto& [price, queue] : bookSide) {
+            for (Order* order = queue.front(); order;) {
+                Order* next = order->next;
+                orderPool_.release(order);
+                order = next;
+            }
+        }
+    };
+
+    releaseAll(book.bids);
+    releaseAll(book.asks);
+
     book.bids.clear();
     book.asks.clear();
     book.orderMap.clear();
 }
 
+MatchingEngine::ClientBook& MatchingEngine::clientBook_(ClientID clientID) {
+    if (ClientBook* client = clientIndex_.find(clientID)) {
+        return *client;
+    }
+    ClientBook& client = clientBooks_.emplace_back();
+    clientIndex_.insert(clientID, &client);
+    return client;
+}
+
+void MatchingEngine::trackOwn_(ClientBook& client, const Order& order) {
+    auto& levels = client.levels(order.side);
+    OwnLevel* own = levels.find(order.price);
+    if (!own) {
+        own = ownLevelPool_.make().release();
+        levels.insert(order.price, own);
+    }
+    ++own->count;
+    own->qty += order.qty;
+}
+
+bool MatchingEngine::preventSelfTrade_(Order* resting, OrderQueue& queue,
+                                       Qty& remaining, Qty& decremented) {
+    switch (selfTrade_) {
+    case SelfTradePrevention::SKIP:
+        return false;
+    case SelfTradePrevention::CANCEL_NEWEST:
+        return true;
+    case SelfTradePrevention::CANCEL_OLDEST:
+        cancelSelfTrade_(resting, queue);
+        return false;
+    case SelfTradePrevention::CANCEL_BOTH:
+        cancelSelfTrade_(resting, queue);
+        return true;
+    case SelfTradePrevention::DECREMENT: {
+        const Qty amount = std::min(remaining, resting->qty);
+        remaining -= amount;
+        decremented += amount;
+        if (amount == resting->qty) {
+            cancelSelfTrade_(resting, queue);
+        } else {
+            publishReduce_(*resting, amount);
+            reduceResting_(resting, queue, amount);
+        }
+        return false;
+    }
+    }
+    return false;
+}
+
+void MatchingEngine::cancelSelfTrade_(Order* resting, OrderQueue& queue) {
+    resting->status = OrderStatus::CANCELLED;
+    selfTradeCancels_.push_back(SelfTradeCancel{.clientID = resting->clientID,
+                                                .orderID = resting->orderID,
+                                                .clientOrderID = resting->clientOrderID,
+                                                .instrumentID = instrumentID_});
+    publishReduce_(*resting, resting->qty);
+    releaseResting_(resting, queue);
+}
+
+void MatchingEngine::publishLevelReduces_() {
+    for (const LevelReduce& level : levelReduces_) {
+        if (eventQueue_) {
+            emitEvent_(EngineEventType::LEVEL_REDUCED, level.side, OrderID{0}, level.qty,
+                       level.price);
+        } else {
+            emitObserverEvent_(level.price, level.qty, level.side,
+                               BookUpdateEventType::REDUCE);
+        }
+        // erased one by one, clearing would touch every slot of the table
+        if (level.side == OrderSide::BUY) {
+            bidReduces_.erase(level.price);
+        } else {
+            askReduces_.erase(level.price);
+        }
+    }
+}
+
 [[nodiscard]] bool MatchingEngine::cancelOrder(const ClientID clientID,
                                                const OrderID orderID) {
-    auto it = book.orderMap.find(orderID);
-    if (it == book.orderMap.end()) {
+    eventTime_ = TSCClock::now();
+    return cancel_(clientID, orderID);
+}
+
+bool MatchingEngine::cancel_(const ClientID clientID, const OrderID orderID) {
+    Order* order = book.orderMap.find(orderID);
+    if (!order) {
         return false;
     }
 
-    if (it->second->clientID != clientID) {
+    if (order->clientID != clientID) {
         return false;
     }
 
-    bool removed = (it->second->side == OrderSide::BUY)
-                       ? (removeFromBook_(orderID, it->second->price, book.bids))
-                       : (removeFromBook_(orderID, it->second->price, book.asks));
+    bool removed = (order->side == OrderSide::BUY) ? (removeFromBook_(order, book.bids))
+                                                   : (removeFromBook_(order, book.asks));
 
     return removed;
 }
 
-[[nodiscard]] ModifyResult MatchingEngine::modifyOrder(const ClientID clientID,
-                                                       const OrderID orderID,
-                                                       const Qty newQty,
-                                                       const Price newPrice) {
-    auto it = book.orderMap.find(orderID);
-    if (it == book.orderMap.end()) {
+ModifyResult MatchingEngine::modify_(const ClientID clientID, const OrderID orderID,
+                                     const Qty newQty, const Price newPrice) {
+    Order* order = book.orderMap.find(orderID);
+    if (!order) {
         return {.serverClientID = clientID,
                 .oldOrderID = orderID,
                 .newOrderID = OrderID{0},
@@ -108,8 +307,7 @@ void MatchingEngine::reset() {
                 .matchResult = std::nullopt};
     }
 
-    auto& order = it->second;
-    if (order->clientID != clientID) {
+    if (order->clientID != clientID || !prices_.accepts(newPrice.value())) {
         return {.serverClientID = clientID,
                 .oldOrderID = orderID,
                 .newOrderID = OrderID{0},
@@ -132,24 +330,16 @@ void MatchingEngine::reset() {
     }
 
     if (newPrice == order->price && newQty < order->qty) {
-        order->qty = newQty;
-        order->status = OrderStatus::MODIFIED;
-
         Qty delta = order->qty - newQty;
-        emitObserverEvent_(newPrice, delta, order->side, BookUpdateEventType::REDUCE);
-
-        // REDUDE LEVEL 3 event
-        L3Update update{.price = order->price,
-                        .qty = delta,
-                        .orderID = order->orderID,
-                        .clientOrderID = order->clientOrderID,
-                        .timestamp = TSCClock::now(),
-                        .instrumentID = instrumentID_,
-                        .eventType = L3EventType::ORDER_FILL_OR_REDUCE,
-                        .orderType = OrderType::LIMIT,
-                        .orderSide = order->side};
 
-        emitL3ObserverEvent_(update);
+        OrderQueue& queue = (order->side == OrderSide::BUY)
+                                ? book.bids.find(order->price)->second
+                                : book.asks.find(order->price)->second;
+        reduceResting_(order, queue, delta);
+        order->status = OrderStatus::MODIFIED;
+
+        // REDUCE LEVEL 2 and LEVEL 3 events
+        publishReduce_(*order, delta);
 
         return {.serverClientID = clientID,
                 .oldOrderID = orderID,
@@ -161,12 +351,24 @@ void MatchingEngine::reset() {
                 .matchResult = std::nullopt};
     }
 
-    OrderSide tmpSide = order->side;
-    TimeInForce tmpTif = order->tif;
-    Timestamp tmpGoodTill = order->goodTill;
-    ClientOrderID tmpClientOrderID = order->clientOrderID;
+    // allocated up front, if the pool is exhausted the resting order stays untouched
+    OrderHandle newOrder = orderPool_.make(
+        getNextOrderID(), clientID, order->clientOrderID, newQty, newPrice,
+        order->goodTill, eventTime_, instrumentID_, order->tif, order->side,
+        OrderType::LIMIT, OrderStatus::MODIFIED);
 
-    if (!cancelOrder(clientID, orderID)) {
+    if (!newOrder) {
+        return {.serverClientID = clientID,
+                .oldOrderID = orderID,
+                .newOrderID = OrderID{0},
+                .newQty = newQty,
+                .newPrice = newPrice,
+                .status = ModifyStatus::INVALID,
+                .instrumentID = instrumentID_,
+                .matchResult = std::nullopt};
+    }
+
+    if (!cancel_(clientID, orderID)) {
         return {.serverClientID = clientID,
                 .oldOrderID = orderID,
                 .newOrderID = OrderID{0},
@@ -179,13 +381,8 @@ void MatchingEngine::reset() {
 
     // now, the order is cancelled, and the pointer [order] is invalidated
 
-    std::unique_ptr<Order> newOrder =
-        std::make_unique<Order>(getNextOrderID(), clientID, tmpClientOrderID, newQty,
-                                newPrice, tmpGoodTill, TSCClock::now(), instrumentID_,
-                                tmpTif, tmpSide, OrderType::LIMIT, OrderStatus::MODIFIED);
-
     int sideIdx = (newOrder->side == OrderSide::BUY ? 0 : 1);
-    int typeIdx = 0; // always limit
+    int typeIdx = LIMIT_POLICY; // only resting orders can be modified
 
     OrderID tmpNewOrderID = newOrder->orderID;
 
@@ -204,9 +401,5 @@ void MatchingEngine::reset() {
 }
 
 const Order* MatchingEngine::getOrder(OrderID orderID) const {
-    if (auto it = book.orderMap.find(orderID); it != book.orderMap.end()) {
-        return it->second;
-    } else {
-        return nullptr;
-    }
+    return book.orderMap.find(orderID);
 }
@@ -14,12 +14,14 @@
 #include <sys/types.h>
 #include <thread>
 #include <unistd.h>
+#include <utility>
 
 void MiniExchangeGateway::run() {
     running_.store(true, std::memory_order_relaxed);
 
+    int timeoutMs = TIMER_INTERVAL_MS;
     while (running_.load(std::memory_order_relaxed)) {
-        int nfds = epoll_wait(epollFD_, events_, MAX_EVENTS, 1000);
+        int nfds = epoll_wait(epollFD_, events_, MAX_EVENTS, timeoutMs);
 
         if (nfds < 0) {
             if (errno == EINTR) {
@@ -56,10 +58,34 @@ void MiniExchangeGateway::run() {
                 handleWrite_(fd);
             }
         }
+
+        if (handler_.usesEngineThread()) {
+            // the engine thread runs the expiry, the gateway busy-polls for its answers
+            handler_.drainResponses();
+            timeoutMs = 0;
+        } else {
+            // expiries that did not fit into the engine's time budget continue right away
+            timeoutMs = handler_.runTimers() ? 0 : TIMER_INTERVAL_MS;
+        }
+        armDirtyFDs_();
     }
     shutdown_();
 }
 
+void MiniExchangeGateway::armDirtyFDs_() {
+    // An fd stays armed until handleWrite_ has emptied its send buffer, so only the
+    // ones that turned dirty since the last pass need a modify. Swapped out, a failing
+    // modify closes the connection, which may mark other fds.
+    std::swap(arming_, handler_.getNewlyDirtyFDs());
+    for (int fd : arming_) {
+        // skips the fds that were written out or closed in the meantime
+        if (handler_.getDirtyFDs().count(fd) > 0) {
+            modifyEpoll_(fd, EPOLLIN | EPOLLOUT | EPOLLET);
+        }
+    }
+    arming_.clear();
+}
+
 void MiniExchangeGateway::handleRead_(int fd) {
     Session* session = sessionManager_.getSession(fd);
     if (!session) {
@@ -92,10 +118,6 @@ void MiniExchangeGateway::handleRead_(int fd) {
     }
 
     handler_.onMessage(fd);
-
-    if (handler_.getDirtyFDs().count(fd) > 0) {
-        modifyEpoll_(fd, EPOLLIN | EPOLLOUT | EPOLLET);
-    }
 }
 
 void MiniExchangeGateway::handleWrite_(int fd) {
@@ -114,12 +136,13 @@ void MiniExchangeGateway::handleWrite_(int fd) {
                                       session->sendBuffer.begin() + written);
         } else if (written < 0) {
             if (errno == EAGAIN) {
-                modifyEpoll_(fd, EPOLLIN | EPOLLET);
+                // stays armed for EPOLLOUT, the edge comes once the socket drains
                 return;
             } else if (errno == EINTR) {
                 continue;
             } else {
                 handleError_(fd);
+                return;
             }
         }
     }
@@ -183,6 +206,7 @@ void MiniExchangeGateway::shutdown_() {
 
     while (std::chrono::steady_clock::now() < deadline) {
         bool allEmpty = true;
+        handler_.drainResponses();
 
         auto dirty = handler_.getDirtyFDs();
         for (int fd : dirty) {
@@ -216,6 +240,8 @@ void MiniExchangeGateway::handleError_(int fd) {
 
 void MiniExchangeGateway::closeConnection_(int fd) {
     removeFromEpoll_(fd);
+    // the client's quotes must not outlive its session
+    handler_.onDisconnect(fd);
     sessionManager_.removeSession(fd);
     handler_.clearDirtyFD(fd);
     ::close(fd);
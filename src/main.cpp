@@ -1,16 +1,23 @@
 #include "api/api.hpp"
+#include "core/engineShards.hpp"
+#include "core/instrumentDirectory.hpp"
 #include "core/matchingEngine.hpp"
 #include "gateway/gateway.hpp"
 #include "market-data/MDPublisher.hpp"
 #include "market-data/bookEvent.hpp"
+#include "market-data/eventObserver.hpp"
+#include "market-data/l3Observer.hpp"
+#include "market-data/l3Publisher.hpp"
 #include "market-data/observer.hpp"
 #include "protocol/protocolHandler.hpp"
 #include "sessions/sessionManager.hpp"
 #include "utils/spsc_queue.hpp"
 #include "utils/types.hpp"
+#include "utils/waitStrategy.hpp"
 
 #include "utils/sharedRegion.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <bit>
 #include <chrono>
@@ -19,12 +26,129 @@
 #include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <vector>
 
 MiniExchangeGateway* g_gateway = nullptr;
 std::atomic<bool> g_shutdownRequested{false};
 
+// The engine of one instrument with its market data pipeline. Each instrument gets its
+// own rings so a busy book never stalls the feed of another. The engine writes a single
+// sequenced event stream, the L2 and L3 views are derived from it by eventObserver.
+// With conflation enabled a second L2 feed publishes the net level changes next to the
+// one that carries every update.
+struct InstrumentStack {
+    InstrumentStack(const InstrumentSpec& spec, const EngineConfig& base,
+                    std::size_t capacity, utils::WaitSignal* mdSignal,
+                    const market_data::ConflationConfig& conflation)
+        : config(InstrumentDirectory::engineConfig(spec, base)),
+          eventRegion(sizeof(utils::spsc_queue_shm<EngineEvent>) +
+                          sizeof(EngineEvent) * std::bit_ceil(capacity + 1),
+                      "/events_" + std::to_string(spec.id.value())),
+          eventQueue(new (eventRegion.data())
+                         utils::spsc_queue_shm<EngineEvent>(capacity)),
+          mdQueue(capacity + 1), l3MdQueue(capacity + 1),
+          conflatedMdQueue(conflation.enabled
+                               ? std::make_unique<utils::spsc_queue<L2OrderBookUpdate>>(
+                                     capacity + 1)
+                               : nullptr),
+          engine(nullptr, nullptr, spec.id, engineConfig_(config, eventQueue)),
+          level2Book(config.book), level3Book(config.book, config.orderMapCapacity),
+          observer(nullptr, nullptr, level2Book, level3Book, spec.id),
+          l3Observer(nullptr, nullptr, level3Book, spec.id, nullptr, config.orderPool),
+          eventObserver(eventQueue,
+                        {.l2 = &observer,
+                         .l2Queue = &mdQueue,
+                         .l2ConflatedQueue = conflatedMdQueue.get(),
+                         .l3 = &l3Observer,
+                         .l3Queue = &l3MdQueue},
+                        mdSignal),
+          publisher(&mdQueue, config.book, spec.id,
+                    market_data::PublisherConfig{.transport = {.port = spec.l2Port()}}),
+          l3Publisher(&l3MdQueue, config.book, spec.id,
+                      {.transport = {.port = spec.l3Port()},
+                       .orderPool = config.orderPool,
+                       .orderMapCapacity = config.orderMapCapacity}) {
+        if (conflation.enabled) {
+            conflatedPublisher = std::make_unique<market_data::MarketDataPublisher>(
+                conflatedMdQueue.get(), config.book, spec.id,
+                market_data::PublisherConfig{
+                    .conflation = conflation,
+                    .transport = {.port = spec.conflatedPort()}});
+        }
+    }
+
+    // the instrument's engine config, the books and order pools downstream of the
+    // engine are sized like the engine's own
+    EngineConfig config;
+    SharedRegion eventRegion;
+    utils::spsc_queue_shm<EngineEvent>* eventQueue;
+    utils::spsc_queue<L2OrderBookUpdate> mdQueue;
+    // L3 updates on their way to the L3 publisher
+    utils::spsc_queue<L3Update> l3MdQueue;
+    // L2 updates on their way to the conflated publisher, null without conflation
+    std::unique_ptr<utils::spsc_queue<L2OrderBookUpdate>> conflatedMdQueue;
+    MatchingEngine engine;
+    Level2OrderBook level2Book;
+    // market-by-order book, built by l3Observer
+    Level3OrderBook level3Book;
+    market_data::Observer observer;
+    market_data::L3Observer l3Observer;
+    market_data::EventObserver eventObserver;
+    // L2 feed on the instrument's InstrumentSpec::l2Port()
+    market_data::MarketDataPublisher publisher;
+    // market-by-order feed, on its own port next to the L2 feed
+    market_data::L3Publisher l3Publisher;
+    // net level changes on InstrumentSpec::conflatedPort(), null without conflation
+    std::unique_ptr<market_data::MarketDataPublisher> conflatedPublisher;
+
+private:
+    static EngineConfig engineConfig_(EngineConfig config,
+                                      utils::spsc_queue_shm<EngineEvent>* events) {
+        config.eventQueue = events;
+        return config;
+    }
+};
+
+// "2,3,5" -> {2, 3, 5}
+std::vector<int> parseCpus(std::string_view list) {
+    std::vector<int> cpus;
+    while (!list.empty()) {
+        const std::size_t comma = list.find(',');
+        cpus.push_back(std::atoi(std::string(list.substr(0, comma)).c_str()));
+        list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+    }
+    return cpus;
+}
+
+// "spin", "yield", "block[:maxParkUs]" or "timed:periodUs"
+utils::WaitConfig parseWait(std::string_view spec) {
+    utils::WaitConfig config;
+    const std::size_t colon = spec.find(':');
+    const std::string_view name = spec.substr(0, colon);
+    if (colon != std::string_view::npos) {
+        config.period = std::chrono::microseconds{
+            std::atoi(std::string(spec.substr(colon + 1)).c_str())};
+    }
+    if (name == "spin") {
+        config.policy = utils::WaitPolicy::BUSY_SPIN;
+    } else if (name == "yield") {
+        config.policy = utils::WaitPolicy::SPIN_YIELD;
+    } else if (name == "block") {
+        config.policy = utils::WaitPolicy::BLOCKING;
+    } else if (name == "timed") {
+        config.policy = utils::WaitPolicy::TIMED;
+    } else {
+        throw std::invalid_argument("unknown wait strategy: " + std::string(spec));
+    }
+    return config;
+}
+
 void signalHandler(int) {
     g_shutdownRequested.store(true, std::memory_order_relaxed);
     if (g_gateway) {
@@ -35,60 +159,155 @@ void signalHandler(int) {
 int main(int argc, char** argv) {
     try {
         uint16_t port = 12345;
-        InstrumentID instrumentID{1};
 
         if (argc > 1) {
             port = static_cast<std::uint16_t>(std::atoi(argv[1]));
         }
 
-        std::cout << "Starting MiniExchange on port " << port << std::endl;
-
-        std::size_t capacity = 1023;
-
-        std::size_t l2Size = sizeof(utils::spsc_queue_shm<L2OrderBookUpdate>) +
-                             sizeof(L2OrderBookUpdate) * std::bit_ceil(capacity + 1);
-
-        std::size_t l3Size = sizeof(utils::spsc_queue_shm<L3Update>) +
-                             sizeof(L3Update) * std::bit_ceil(capacity + 1);
-
-        SharedRegion l2Region(l2Size, "/l2queue");
-        SharedRegion l3Region(l3Size, "/l3queue");
-
-        auto* l2Queue =
-            new (l2Region.data()) utils::spsc_queue_shm<L2OrderBookUpdate>(capacity);
-        auto* l3Queue = new (l3Region.data()) utils::spsc_queue_shm<L3Update>(capacity);
-
-        auto mdQueue = std::make_unique<utils::spsc_queue<L2OrderBookUpdate>>(1024);
-
-        MatchingEngine engine(l2Queue, l3Queue, instrumentID);
-        std::cout << "Matching engine initialized" << std::endl;
+        // "--engine-thread[=cpu]" moves matching off the gateway thread,
+        // "--shards=cpu,cpu,..." spreads the instruments over one engine thread per cpu,
+        // "--instruments=<file>" lists the instruments, see InstrumentDirectory::parse,
+        // "--observer-wait=", "--publisher-wait=" and "--engine-md-wait=" pick how the
+        // observer and publisher threads idle and how an engine waits out a full market
+        // data ring, see parseWait, "--conflate[=windowUs]" adds a conflated L2 feed
+        std::optional<EngineShardsConfig> shardsConfig;
+        std::string instrumentsPath;
+        utils::WaitConfig observerWait{.policy = utils::WaitPolicy::BLOCKING};
+        utils::WaitConfig publisherWait{.policy = utils::WaitPolicy::BLOCKING};
+        utils::WaitConfig engineMdWait{};
+        market_data::ConflationConfig conflation{};
+        for (int i = 2; i < argc; ++i) {
+            constexpr std::string_view engineFlag = "--engine-thread";
+            constexpr std::string_view shardsFlag = "--shards=";
+            constexpr std::string_view instrumentsFlag = "--instruments=";
+            constexpr std::string_view observerWaitFlag = "--observer-wait=";
+            constexpr std::string_view publisherWaitFlag = "--publisher-wait=";
+            constexpr std::string_view engineMdWaitFlag = "--engine-md-wait=";
+            constexpr std::string_view conflateFlag = "--conflate";
+            std::string_view arg = argv[i];
+            if (arg.starts_with(engineFlag)) {
+                shardsConfig.emplace();
+                if (arg.size() > engineFlag.size() + 1 && arg[engineFlag.size()] == '=') {
+                    shardsConfig->cpus = parseCpus(arg.substr(engineFlag.size() + 1));
+                }
+            } else if (arg.starts_with(shardsFlag)) {
+                shardsConfig.emplace();
+                shardsConfig->cpus = parseCpus(arg.substr(shardsFlag.size()));
+            } else if (arg.starts_with(instrumentsFlag)) {
+                instrumentsPath = arg.substr(instrumentsFlag.size());
+            } else if (arg.starts_with(observerWaitFlag)) {
+                observerWait = parseWait(arg.substr(observerWaitFlag.size()));
+            } else if (arg.starts_with(publisherWaitFlag)) {
+                publisherWait = parseWait(arg.substr(publisherWaitFlag.size()));
+            } else if (arg.starts_with(engineMdWaitFlag)) {
+                engineMdWait = parseWait(arg.substr(engineMdWaitFlag.size()));
+            } else if (arg.starts_with(conflateFlag)) {
+                conflation.enabled = true;
+                if (arg.size() > conflateFlag.size() + 1 &&
+                    arg[conflateFlag.size()] == '=') {
+                    conflation.window = std::chrono::microseconds{std::atoi(
+                        std::string(arg.substr(conflateFlag.size() + 1)).c_str())};
+                }
+            }
+        }
 
-        Level2OrderBook level2Book;
-        Level3OrderBook level3book;
+        InstrumentDirectory instruments;
+        if (instrumentsPath.empty()) {
+            instruments.add(InstrumentSpec{.id = InstrumentID{1}, .symbol = "DEFAULT"});
+        } else {
+            instruments = InstrumentDirectory::load(instrumentsPath);
+        }
+        if (instruments.empty()) {
+            throw std::runtime_error("no instruments listed");
+        }
 
-        market_data::Observer observer(l2Queue, mdQueue.get(), level2Book, level3book,
-                                       instrumentID);
-        std::cout << "Observer initialized" << std::endl;
+        std::cout << "Starting MiniExchange on port " << port << " with "
+                  << instruments.size() << " instrument(s)" << std::endl;
+        for (const InstrumentSpec& spec : instruments.instruments()) {
+            std::cout << "  " << spec.symbol << ": market data on ports " << spec.l2Port()
+                      << " (L2), " << spec.l3Port() << " (L3), " << spec.conflatedPort()
+                      << " (conflated L2)" << std::endl;
+        }
 
-        market_data::UDPConfig mdConfig{};
-        market_data::PublisherConfig pubCfg{};
-        market_data::MarketDataPublisher mdPublisher(mdQueue.get(), level2Book,
-                                                     instrumentID, pubCfg);
+        std::size_t capacity = 1023;
 
-        std::cout << "Market data publisher initialized" << std::endl;
+        // END_OF_DAY orders expire at the next midnight (UTC), the engines move it on
+        // by a day once it has passed
+        const auto endOfDay =
+            std::chrono::ceil<std::chrono::days>(std::chrono::system_clock::now());
+        EngineConfig engineConfig{
+            .expiry = {.endOfDay = static_cast<Timestamp>(
+                           std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               endOfDay.time_since_epoch())
+                               .count()),
+                       .endOfDayRoll = std::chrono::days{1}},
+            .marketDataWait = engineMdWait};
+
+        // an engine wakes the observer thread, which wakes the publisher thread
+        utils::WaitSignal observerSignal;
+        utils::WaitSignal publisherSignal;
+        engineConfig.observerSignal = &observerSignal;
+
+        std::vector<std::unique_ptr<InstrumentStack>> stacks;
+        std::vector<MatchingEngine*> engines;
+        stacks.reserve(instruments.size());
+        engines.reserve(instruments.size());
+        for (const InstrumentSpec& spec : instruments.instruments()) {
+            stacks.push_back(
+                std::make_unique<InstrumentStack>(spec, engineConfig, capacity,
+                                                  &publisherSignal, conflation));
+            engines.push_back(&stacks.back()->engine);
+        }
+        std::cout << "Matching engines, observers and market data publishers initialized"
+                  << std::endl;
 
         std::jthread observerThread([&]() {
+            utils::Waiter waiter(observerWait, &observerSignal);
+            auto pending = [&stacks] {
+                return std::ranges::any_of(stacks, [](const auto& stack) {
+                    return stack->eventObserver.hasPending();
+                });
+            };
             while (!g_shutdownRequested.load(std::memory_order_relaxed)) {
-                observer.drainQueue();
-                std::this_thread::sleep_for(std::chrono::milliseconds(250));
+                std::size_t drained = 0;
+                for (auto& stack : stacks) {
+                    drained += stack->eventObserver.drainQueue();
+                }
+                if (drained == 0) {
+                    waiter.idle(pending);
+                } else {
+                    waiter.reset();
+                }
             }
             std::cout << "Observer thread shutting down" << std::endl;
         });
 
+        // parks at most publisherWait.period at a time, which also bounds how late a
+        // snapshot goes out
         std::jthread mdPublisherThread([&]() {
+            utils::Waiter waiter(publisherWait, &publisherSignal);
+            auto pending = [&stacks] {
+                return std::ranges::any_of(stacks, [](const auto& stack) {
+                    return stack->publisher.hasPending() ||
+                           stack->l3Publisher.hasPending() ||
+                           (stack->conflatedPublisher &&
+                            stack->conflatedPublisher->hasPending());
+                });
+            };
             while (!g_shutdownRequested.load(std::memory_order_relaxed)) {
-                mdPublisher.runOnce();
-                std::this_thread::sleep_for(std::chrono::milliseconds(250));
+                std::size_t published = 0;
+                for (auto& stack : stacks) {
+                    published += stack->publisher.runOnce();
+                    published += stack->l3Publisher.runOnce();
+                    if (stack->conflatedPublisher) {
+                        published += stack->conflatedPublisher->runOnce();
+                    }
+                }
+                if (published == 0) {
+                    waiter.idle(pending);
+                } else {
+                    waiter.reset();
+                }
             }
 
             std::cout << "Market data publisher thread shutting down" << std::endl;
@@ -97,10 +316,18 @@ int main(int argc, char** argv) {
         SessionManager sessions;
         std::cout << "Session manager initialized" << std::endl;
 
-        MiniExchangeAPI api(engine, sessions);
+        MiniExchangeAPI api(engines, sessions);
         std::cout << "Exchange API initialized" << std::endl;
 
-        ProtocolHandler handler(sessions, api);
+        std::unique_ptr<EngineShards> shards;
+        if (shardsConfig) {
+            shards = std::make_unique<EngineShards>(engines, sessions, *shardsConfig);
+            shards->start();
+            std::cout << "Engine threads started (" << shards->shardCount() << " shards)"
+                      << std::endl;
+        }
+
+        ProtocolHandler handler(sessions, api, shards.get());
         std::cout << "Protocol handler initialized" << std::endl;
 
         MiniExchangeGateway gateway(handler, sessions, port);
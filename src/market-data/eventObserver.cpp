@@ -0,0 +1,59 @@
+#include "market-data/eventObserver.hpp"
+#include "market-data/bookEvent.hpp"
+
+using namespace market_data;
+
+std::size_t EventObserver::drainQueue() {
+    if (!engineQueue_) {
+        return 0;
+    }
+
+    std::size_t drained = 0;
+    for (auto events = engineQueue_->peek(); !events.empty();
+         events = engineQueue_->peek()) {
+        for (const EngineEvent& event : events) {
+            apply(event);
+        }
+        engineQueue_->commit(events.size());
+        drained += events.size();
+    }
+
+    if (drained != 0 && mdSignal_) {
+        mdSignal_->notify();
+    }
+    return drained;
+}
+
+void EventObserver::apply(const EngineEvent& event) {
+    if (lastSequence_ != 0 && event.sequence != lastSequence_ + 1) {
+        ++gaps_;
+    }
+    lastSequence_ = event.sequence;
+
+    if (hasL2Update(event) && (views_.l2 || views_.l2Queue || views_.l2ConflatedQueue)) {
+        const L2OrderBookUpdate update = toL2Update(event);
+        if (views_.l2) {
+            views_.l2->apply(update);
+        }
+        if (views_.l2Queue) {
+            views_.l2Queue->try_push(update);
+        }
+        if (views_.l2ConflatedQueue) {
+            views_.l2ConflatedQueue->try_push(update);
+        }
+    }
+
+    if (hasL3Update(event) && (views_.l3 || views_.l3Queue)) {
+        const L3Update update = toL3Update(event);
+        if (views_.l3) {
+            views_.l3->apply(update);
+        }
+        if (views_.l3Queue) {
+            views_.l3Queue->try_push(update);
+        }
+    }
+
+    if (event.type == EngineEventType::TRADE && views_.trades) {
+        views_.trades->try_push(event);
+    }
+}
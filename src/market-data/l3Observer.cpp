@@ -0,0 +1,123 @@
+#include "market-data/l3Observer.hpp"
+#include "market-data/bookEvent.hpp"
+#include "utils/types.hpp"
+
+#include <cassert>
+
+using namespace market_data;
+
+std::size_t L3Observer::drainQueue() {
+    if (!engineQueue_) {
+        return 0;
+    }
+
+    std::size_t drained = 0;
+    for (auto updates = engineQueue_->peek(); !updates.empty();
+         updates = engineQueue_->peek()) {
+        for (const L3Update& update : updates) {
+            apply(update);
+        }
+
+        if (mdQueue_) {
+            mdQueue_->try_push_n(updates);
+        }
+        engineQueue_->commit(updates.size());
+        drained += updates.size();
+    }
+
+    if (drained != 0 && mdSignal_) {
+        mdSignal_->notify();
+    }
+    return drained;
+}
+
+void L3Observer::apply(const L3Update& update) {
+    if (update.instrumentID != instrumentID_) {
+        return;
+    }
+
+    switch (update.eventType) {
+    case L3EventType::ORDER_ADD_OR_INCREASE:
+        add_(update);
+        return;
+    case L3EventType::ORDER_FILL_OR_REDUCE:
+        if (Order* order = book_.orderMap.find(update.orderID)) {
+            reduce_(order, update.qty);
+        }
+        return;
+    case L3EventType::ORDER_CANCELLED:
+        if (Order* order = book_.orderMap.find(update.orderID)) {
+            remove_(order);
+        }
+        return;
+    }
+}
+
+std::optional<Qty> L3Observer::qtyAhead(OrderID orderID) const {
+    const Order* order = book_.orderMap.find(orderID);
+    if (!order) {
+        return std::nullopt;
+    }
+
+    Qty ahead{0};
+    for (const Order* other = order->prev; other; other = other->prev) {
+        ahead += other->qty;
+    }
+    return ahead;
+}
+
+void L3Observer::add_(const L3Update& update) {
+    Qty qty = update.qty;
+    // the engine gives a modified order a new id, an increase of a known one would
+    // lose its place in the queue, so it goes to the back with the summed qty
+    if (Order* known = book_.orderMap.find(update.orderID)) {
+        qty += known->qty;
+        remove_(known);
+    }
+
+    OrderHandle handle =
+        orders_.make(update.orderID, ClientID{0}, update.clientOrderID, qty, update.price,
+                     Timestamp{0}, update.timestamp, update.instrumentID,
+                     TimeInForce::GOOD_TILL_CANCELLED, update.orderSide, update.orderType,
+                     OrderStatus::NEW);
+    assert(handle && "L3 order pool exhausted");
+    Order* order = handle.release();
+
+    if (order->side == OrderSide::BUY) {
+        book_.bids[order->price].push_back(order);
+    } else {
+        book_.asks[order->price].push_back(order);
+    }
+    book_.orderMap.insert(order->orderID, order);
+}
+
+void L3Observer::reduce_(Order* order, Qty amount) {
+    if (amount >= order->qty) {
+        remove_(order);
+        return;
+    }
+
+    if (order->side == OrderSide::BUY) {
+        book_.bids.find(order->price)->second.reduce(order, amount);
+    } else {
+        book_.asks.find(order->price)->second.reduce(order, amount);
+    }
+}
+
+void L3Observer::remove_(Order* order) {
+    book_.orderMap.erase(order->orderID);
+
+    auto unlink = [this, order](auto& bookSide) {
+        auto it = bookSide.find(order->price);
+        OrderQueue& queue = it->second;
+        orders_.release(queue.erase(order));
+        if (queue.empty()) {
+            bookSide.erase(it);
+        }
+    };
+    if (order->side == OrderSide::BUY) {
+        unlink(book_.bids);
+    } else {
+        unlink(book_.asks);
+    }
+}
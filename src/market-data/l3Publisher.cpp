@@ -0,0 +1,109 @@
+#include "market-data/l3Publisher.hpp"
+#include "market-data/bookEvent.hpp"
+#include "market-data/messages.hpp"
+#include "market-data/serialization.hpp"
+#include "utils/types.hpp"
+#include "utils/utils.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+using namespace market_data;
+
+L3Publisher::L3Publisher(utils::spsc_queue<L3Update>* queue,
+                         const utils::PriceLadderConfig& book, InstrumentID instrumentID,
+                         const L3PublisherConfig& cfg)
+    : queue_(queue), instrumentID_(instrumentID), cfg_(cfg),
+      book_(book, cfg.orderMapCapacity),
+      replica_(nullptr, nullptr, book_, instrumentID, nullptr, cfg.orderPool),
+      lastSnapshot_(std::chrono::steady_clock::now()), transport_(cfg.transport) {
+    snapshotOrders_.reserve(OrderSnapshotHeader::traits::MAX_ORDERS_PER_PART);
+}
+
+std::size_t L3Publisher::runOnce() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastSnapshot_ >= cfg_.snapshotInterval) {
+        publishSnapshot();
+        lastSnapshot_ = now;
+    }
+
+    return publishDelta();
+}
+
+void L3Publisher::publishSnapshot() {
+    std::uint16_t partIndex = 0;
+    auto flush = [&](bool lastPart) {
+        auto message = serializeOrderSnapshotMessage(
+            msgSqn_++, instrumentID_.value(), partIndex++, lastPart, snapshotOrders_);
+        sendPacket_(message);
+        snapshotOrders_.clear();
+    };
+
+    auto collect = [&](const auto& bookSide) {
+        for (const auto& [price, queue] : bookSide) {
+            for (const Order* order : queue) {
+                if (snapshotOrders_.size() ==
+                    OrderSnapshotHeader::traits::MAX_ORDERS_PER_PART) {
+                    flush(false);
+                }
+
+                SnapshotOrder entry{};
+                entry.orderID = order->orderID.value();
+                entry.price = order->price.value();
+                entry.qty = order->qty.value();
+                entry.side = +order->side;
+                snapshotOrders_.push_back(entry);
+            }
+        }
+    };
+    collect(book_.bids);
+    collect(book_.asks);
+
+    // an empty book still gets its (single, empty) part
+    flush(true);
+}
+
+std::size_t L3Publisher::publishDelta() {
+    if (!queue_) {
+        return 0;
+    }
+
+    std::size_t published = 0;
+    for (auto updates = queue_->peek(); !updates.empty(); updates = queue_->peek()) {
+        for (const L3Update& update : updates) {
+            publishDelta_(update);
+        }
+        queue_->commit(updates.size());
+        published += updates.size();
+    }
+    return published;
+}
+
+void L3Publisher::publishDelta_(const L3Update& update) {
+    if (update.instrumentID != instrumentID_) {
+        return;
+    }
+    replica_.apply(update);
+
+    OrderDeltaPayload delta{};
+    delta.orderID = update.orderID.value();
+    delta.price = update.price.value();
+    delta.qty = update.qty.value();
+    delta.eventType = +update.eventType;
+    delta.side = +update.orderSide;
+    std::memset(delta._padding, 0, sizeof(delta._padding));
+
+    auto message = serializeOrderDeltaMessage(msgSqn_++, instrumentID_.value(), delta);
+
+    sendPacket_(std::span<const std::byte>(message.data(), message.size()));
+}
+
+void L3Publisher::sendPacket_(std::span<const std::byte> msgBytes) {
+    try {
+        transport_.send(msgBytes);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to send market-by-order packet " << e.what() << "\n";
+    }
+}
@@ -1,67 +1,170 @@
 #include "market-data/MDPublisher.hpp"
 #include "market-data/bookEvent.hpp"
+#include "market-data/messages.hpp"
 #include "market-data/serialization.hpp"
 #include "utils/spsc_queue.hpp"
 #include "utils/types.hpp"
 #include "utils/utils.hpp"
+#include <algorithm>
 #include <chrono>
 #include <exception>
 
 using namespace market_data;
 
+namespace {
+
+// One builder per datagram of a batch. Without packing a datagram is sized for a
+// single delta, anything larger goes out on its own.
+std::vector<PacketBuilder> makePackets(const PublisherConfig& cfg) {
+    const std::size_t capacity =
+        cfg.packing.mtu != 0
+            ? cfg.packing.mtu
+            : MarketDataHeader::traits::HEADER_SIZE + DeltaPayload::traits::PAYLOAD_SIZE;
+    return std::vector<PacketBuilder>(std::max<std::size_t>(cfg.transport.batch, 1),
+                                      PacketBuilder(capacity));
+}
+
+} // namespace
+
 MarketDataPublisher::MarketDataPublisher(utils::spsc_queue<L2OrderBookUpdate>* queue,
-                                         const Level2OrderBook& book,
+                                         const utils::PriceLadderConfig& book,
                                          InstrumentID instrumentID,
                                          PublisherConfig cfg = PublisherConfig{})
-    : queue_(queue), book_(book), instrumentID_(instrumentID), cfg_(cfg), msgSqn_(0),
-      lastSnapshot_(std::chrono::steady_clock::now()), transport_() {}
+    : queue_(queue), instrumentID_(instrumentID), cfg_(cfg), replica_(book), msgSqn_(0),
+      lastSnapshot_(std::chrono::steady_clock::now()), conflator_(book),
+      packets_(makePackets(cfg)), transport_(cfg.transport) {
+    datagrams_.reserve(packets_.size());
+}
 
-void MarketDataPublisher::runOnce() {
+std::size_t MarketDataPublisher::runOnce() {
     auto now = std::chrono::steady_clock::now();
     auto elapsed =
         std::chrono::duration_cast<std::chrono::milliseconds>(now - lastSnapshot_);
 
     if (elapsed >= cfg_.snapShotInterval) {
+        // send the pending net changes first, so the snapshot is not behind the book
+        flushConflated_(true);
         publishSnapshot();
         lastSnapshot_ = now;
     }
 
-    publishDelta();
+    return publishDelta();
 }
 
 void MarketDataPublisher::publishSnapshot() {
     if (!queue_) {
         return;
     }
-    auto message = serializeSnapshotMessage(msgSqn_++, instrumentID_.value(), book_.bids,
-                                            book_.asks, cfg_.maxDepth);
-    sendPacket_(message);
+    auto message = serializeSnapshotMessage(msgSqn_++, instrumentID_.value(), replica_,
+                                            cfg_.maxDepth);
+    sendMessage_(message);
+    flushPackets_();
 }
 
-void MarketDataPublisher::publishDelta() {
+std::size_t MarketDataPublisher::publishDelta() {
     if (!queue_) {
+        return 0;
+    }
+
+    std::size_t published = 0;
+    for (auto updates = queue_->peek(); !updates.empty(); updates = queue_->peek()) {
+        for (const L2OrderBookUpdate& update : updates) {
+            if (!cfg_.conflation.enabled) {
+                publishDelta_(update);
+                continue;
+            }
+            if (conflator_.empty()) {
+                windowStart_ = std::chrono::steady_clock::now();
+            }
+            conflator_.add(update);
+        }
+        queue_->commit(updates.size());
+        published += updates.size();
+    }
+
+    flushConflated_(false);
+    if (cfg_.packing.maxDelay.count() == 0 ||
+        std::chrono::steady_clock::now() - packetStart_ >= cfg_.packing.maxDelay) {
+        flushPackets_();
+    }
+    return published;
+}
+
+void MarketDataPublisher::flushConflated_(bool force) {
+    if (conflator_.empty()) {
+        return;
+    }
+    if (!force && cfg_.conflation.window.count() != 0 &&
+        std::chrono::steady_clock::now() - windowStart_ < cfg_.conflation.window) {
         return;
     }
+    conflator_.flush([this](const L2OrderBookUpdate& update) { publishDelta_(update); });
+}
+
+void MarketDataPublisher::publishDelta_(const L2OrderBookUpdate& update) {
+    if (update.type == BookUpdateEventType::REDUCE) {
+        replica_.reduce(update.side, update.price, update.amount);
+    } else {
+        replica_.add(update.side, update.price, update.amount);
+    }
+
+    DeltaPayload delta{};
+    delta.priceLevel = update.price.value();
+    delta.amountDelta = update.amount.value();
+    delta.deltaType = +update.type;
+    delta.side = +update.side;
+    std::memset(delta._padding, 0, sizeof(delta._padding));
+
+    auto message = serializeDeltaMessage(msgSqn_++, instrumentID_.value(), delta);
+
+    sendMessage_(std::span<const std::byte>(message.data(), message.size()));
+}
 
-    L2OrderBookUpdate update{};
-    while (queue_->try_pop(update)) {
-        DeltaPayload delta{};
-        delta.priceLevel = update.price.value();
-        delta.amountDelta = update.amount.value();
-        delta.deltaType = +update.type;
-        delta.side = +update.side;
-        std::memset(delta._padding, 0, sizeof(delta._padding));
+void MarketDataPublisher::sendMessage_(std::span<const std::byte> messageBytes) {
+    // the messages go out in sequence order, one that does not fit in a packet of its
+    // own is sent alone after the pending ones
+    if (messageBytes.size() > packets_[current_].capacity()) {
+        flushPackets_();
+        sendPacket_(messageBytes);
+        return;
+    }
 
-        auto message = serializeDeltaMessage(msgSqn_++, instrumentID_.value(), delta);
+    if (!packets_[current_].append(messageBytes)) {
+        if (++current_ == packets_.size()) {
+            flushPackets_();
+        }
+        packets_[current_].append(messageBytes);
+    }
+    if (current_ == 0 && packets_[0].messageCount() == 1 &&
+        cfg_.packing.maxDelay.count() != 0) {
+        packetStart_ = std::chrono::steady_clock::now();
+    }
+}
 
-        sendPacket_(std::span<const std::byte>(message.data(), message.size()));
+void MarketDataPublisher::flushPackets_() {
+    datagrams_.clear();
+    for (std::size_t i = 0; i <= current_ && i < packets_.size(); ++i) {
+        if (!packets_[i].empty()) {
+            datagrams_.push_back(packets_[i].data());
+        }
+    }
+    if (!datagrams_.empty()) {
+        try {
+            packetsSent_ += transport_.sendBatch(datagrams_);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to send market data packets " << e.what() << "\n";
+        }
+    }
+    for (std::size_t i = 0; i <= current_ && i < packets_.size(); ++i) {
+        packets_[i].clear();
     }
+    current_ = 0;
 }
 
 void MarketDataPublisher::sendPacket_(std::span<const std::byte> msgBytes) {
-    utils::printHex(msgBytes);
     try {
         transport_.send(msgBytes);
+        ++packetsSent_;
     } catch (const std::exception& e) {
         std::cerr << "Failed to send market data packet " << e.what() << "\n";
     }
@@ -5,46 +5,9 @@
 
 using namespace market_data;
 
-inline auto& Observer::getBook_(OrderSide side) {
-    return side == OrderSide::BUY ? l2book_.bids : l2book_.asks;
-}
-
-bool Observer::priceBetterOrEqual_(Price incoming, Price resting, OrderSide side) {
-    if (side == OrderSide::BUY) {
-        return incoming >= resting;
-    } else {
-        return resting >= incoming;
-    }
-}
-
-void Observer::addAtPrice_(Price price, Qty amount, OrderSide side) {
-    auto& book = getBook_(side);
-
-    auto it = std::find_if(book.rbegin(), book.rend(), [&](const auto& level) {
-        return level.first == price || !priceBetterOrEqual_(price, level.first, side);
-    });
-
-    if (it != book.rend() && it->first == price) {
-        it->second += amount;
-        return;
-    }
-
-    auto insertIt = (it == book.rend()) ? book.begin() : it.base();
-    book.insert(insertIt, {price, amount});
-}
-
 void Observer::reduceAtPrice_(Price price, Qty amount, OrderSide side) {
-    auto& book = getBook_(side);
-
-    for (auto rIt = book.rbegin(); rIt != book.rend(); ++rIt) {
-        if (rIt->first == price) {
-            rIt->second -= amount;
-
-            if (rIt->second == 0) {
-                book.erase(std::next(rIt).base());
-            }
-            return;
-        }
+    if (l2book_.reduce(side, price, amount)) {
+        return;
     }
 
 #ifndef NDEBUG
@@ -53,20 +16,35 @@ void Observer::reduceAtPrice_(Price price, Qty amount, OrderSide side) {
 #endif
 }
 
-void Observer::drainQueue() {
-    L2OrderBookUpdate ev{};
+void Observer::apply(const L2OrderBookUpdate& update) {
+    if (update.type == BookUpdateEventType::REDUCE) {
+        reduceAtPrice_(update.price, update.amount, update.side);
+    } else {
+        l2book_.add(update.side, update.price, update.amount);
+    }
+}
+
+std::size_t Observer::drainQueue() {
     if (!engineQueue_) {
-        return;
+        return 0;
     }
-    while (engineQueue_->try_pop(ev)) {
-        if (ev.type == BookUpdateEventType::REDUCE) {
-            reduceAtPrice_(ev.price, ev.amount, ev.side);
-        } else {
-            addAtPrice_(ev.price, ev.amount, ev.side);
+    // the updates are applied in place and forwarded in bulk, one span at a time
+    std::size_t drained = 0;
+    for (auto updates = engineQueue_->peek(); !updates.empty();
+         updates = engineQueue_->peek()) {
+        for (const L2OrderBookUpdate& ev : updates) {
+            apply(ev);
         }
 
         if (mdQueue_) {
-            mdQueue_->try_push(ev);
+            mdQueue_->try_push_n(updates);
         }
+        engineQueue_->commit(updates.size());
+        drained += updates.size();
+    }
+
+    if (drained != 0 && mdSignal_) {
+        mdSignal_->notify();
     }
+    return drained;
 }
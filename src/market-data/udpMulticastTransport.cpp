@@ -1,8 +1,8 @@
 #include "market-data/udpMulticastTransport.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
-#include <print>
 #include <span>
 #include <stdexcept>
 #include <string>
@@ -17,20 +17,53 @@ void UDPMulticastTransport::send(std::span<const std::byte> msgBytes) {
 
     ssize_t sent = ::sendto(sockfd_, msgBytes.data(), msgBytes.size(), 0,
                             reinterpret_cast<const sockaddr*>(&addr_), sizeof(addr_));
+    ++syscalls_;
 
     if (sent < 0) {
         throw std::runtime_error("Failed to send UDP packet: " +
                                  std::string(strerror(errno)));
     }
 
-    std::println("Sent bytes: {}", sent);
-
     if (static_cast<std::size_t>(sent) != msgBytes.size()) {
         throw std::runtime_error("Partial send: sent" + std::to_string(sent) +
                                  " bytes, expected " + std::to_string(msgBytes.size()));
     }
 }
 
+std::size_t
+UDPMulticastTransport::sendBatch(std::span<const std::span<const std::byte>> datagrams) {
+    if (sockfd_ < 0) {
+        throw std::runtime_error("Socket not initialized");
+    }
+    if (msgs_.size() < 2) {
+        for (std::span<const std::byte> datagram : datagrams) {
+            send(datagram);
+        }
+        return datagrams.size();
+    }
+
+    std::size_t sent = 0;
+    while (sent < datagrams.size()) {
+        const std::size_t count = std::min(datagrams.size() - sent, msgs_.size());
+        for (std::size_t i = 0; i < count; ++i) {
+            // sendmmsg only reads through iov_base
+            iovecs_[i].iov_base = const_cast<std::byte*>(datagrams[sent + i].data());
+            iovecs_[i].iov_len = datagrams[sent + i].size();
+        }
+
+        // the kernel stops at the first datagram it cannot send, the rest are retried
+        const int accepted =
+            ::sendmmsg(sockfd_, msgs_.data(), static_cast<unsigned int>(count), 0);
+        ++syscalls_;
+        if (accepted <= 0) {
+            throw std::runtime_error("Failed to send UDP packets: " +
+                                     std::string(strerror(errno)));
+        }
+        sent += static_cast<std::size_t>(accepted);
+    }
+    return sent;
+}
+
 void UDPMulticastTransport::initialize() {
     sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);
     if (sockfd_ < 0) {
@@ -69,6 +102,17 @@ void UDPMulticastTransport::initialize() {
     addr_.sin_port = htons(config_.port);
     addr_.sin_addr.s_addr = inet_addr(config_.multicastGroup.c_str());
 
+    // one header per datagram of a batch, all to the group, each with its own iovec
+    msgs_.resize(std::max<std::size_t>(config_.batch, 1));
+    iovecs_.resize(msgs_.size());
+    for (std::size_t i = 0; i < msgs_.size(); ++i) {
+        msgs_[i] = mmsghdr{};
+        msgs_[i].msg_hdr.msg_name = &addr_;
+        msgs_[i].msg_hdr.msg_namelen = sizeof(addr_);
+        msgs_[i].msg_hdr.msg_iov = &iovecs_[i];
+        msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+
     std::cout << "Binding to port: " << config_.port << std::endl;
     std::cout << "Joining group: " << config_.multicastGroup << std::endl;
     std::cout << "Interface: " << config_.interfaceIP << std::endl;
@@ -5,9 +5,11 @@
 #include "protocol/serverMessages.hpp"
 #include "utils/status.hpp"
 #include "utils/timing.hpp"
+#include "utils/threading.hpp"
 #include "utils/types.hpp"
 #include "utils/utils.hpp"
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cstring>
 #include <optional>
@@ -55,6 +57,7 @@ void ProtocolHandler::processMessages_(Session& session) {
         view = view.subspan(consumed);
         totalConsumed += consumed;
     }
+    flushBatch_(session);
 
     if (totalConsumed > 0) {
         auto newEnd =
@@ -68,6 +71,12 @@ std::size_t ProtocolHandler::handleMessage_(Session& session,
                                             std::span<const std::byte> messageBytes) {
     MessageType type = static_cast<MessageType>(messageBytes[0]);
 
+    // order messages are queued for the engine, anything else must not overtake them
+    if (type != MessageType::NEW_ORDER && type != MessageType::CANCEL_ORDER &&
+        type != MessageType::MODIFY_ORDER) {
+        flushBatch_(session);
+    }
+
     switch (type) {
     case MessageType::HELLO: {
         return handleHello_(session, messageBytes);
@@ -84,6 +93,9 @@ std::size_t ProtocolHandler::handleMessage_(Session& session,
     case MessageType::MODIFY_ORDER: {
         return handleModifyOrder_(session, messageBytes);
     }
+    case MessageType::MASS_CANCEL: {
+        return handleMassCancel_(session, messageBytes);
+    }
 
     default: {
         return 0;
@@ -141,7 +153,7 @@ std::size_t ProtocolHandler::handleHello_(Session& session,
 
     serializeMessageInto(session.sendBuffer, MessageType::HELLO_ACK, ackMsg.header,
                          ackMsg.payload);
-    dirtyFDs_.insert(session.fd);
+    markDirty_(session.fd);
 
     return sizeToBeConsumed;
 }
@@ -175,7 +187,7 @@ std::size_t ProtocolHandler::handleLogout_(Session& session,
 
     serializeMessageInto(session.sendBuffer, MessageType::LOGOUT_ACK, ackMsg.header,
                          ackMsg.payload);
-    dirtyFDs_.insert(session.fd);
+    markDirty_(session.fd);
 
     return sizeToBeConsumed;
 }
@@ -199,36 +211,7 @@ std::size_t ProtocolHandler::handleNewOrder_(Session& session,
             return sizeToBeConsumed;
         }
         session.getNextClientSqn();
-        MatchResult result = api_.processNewOrder(msgOpt->payload);
-
-        Message<server::OrderAckPayload> ackMsg =
-            makeOrderAck_(session, result, ClientOrderID{msgOpt->payload.clientOrderID});
-
-        serializeMessageInto(session.sendBuffer, MessageType::ORDER_ACK, ackMsg.header,
-                             ackMsg.payload);
-        dirtyFDs_.insert(session.fd);
-
-        for (auto& trade : result.tradeVec) {
-            Session* buyerSession = sessionManager_.getSession(trade.buyerID);
-            if (buyerSession) {
-                bool isBuyer = true;
-
-                auto tradeMsg = makeTradeMsg_(*buyerSession, trade, isBuyer);
-
-                serializeMessageInto(buyerSession->sendBuffer, MessageType::TRADE,
-                                     tradeMsg.header, tradeMsg.payload);
-                dirtyFDs_.insert(buyerSession->fd);
-            }
-
-            Session* sellerSession = sessionManager_.getSession(trade.sellerID);
-            if (sellerSession) {
-                bool isBuyer = false;
-                auto tradeMsg = makeTradeMsg_(*sellerSession, trade, isBuyer);
-                serializeMessageInto(sellerSession->sendBuffer, MessageType::TRADE,
-                                     tradeMsg.header, tradeMsg.payload);
-                dirtyFDs_.insert(sellerSession->fd);
-            }
-        }
+        batch_.push_back(MiniExchangeAPI::makeCommand(msgOpt->payload));
     }
 
     return sizeToBeConsumed;
@@ -250,34 +233,7 @@ std::size_t ProtocolHandler::handleModifyOrder_(Session& session,
             return sizeToBeConsumed;
         }
         session.getNextClientSqn();
-        ModifyResult res = api_.modifyOrder(msgOpt->payload);
-
-        auto ackMsg =
-            makeModifyAck_(session, res, ClientOrderID{msgOpt->payload.clientOrderID});
-        serializeMessageInto(session.sendBuffer, MessageType::MODIFY_ACK, ackMsg.header,
-                             ackMsg.payload);
-        dirtyFDs_.insert(session.fd);
-
-        if (res.matchResult) {
-            for (auto& trade : res.matchResult->tradeVec) {
-                Session* buyerSession = sessionManager_.getSession(trade.buyerID);
-                if (buyerSession) {
-                    bool isBuyer = true;
-                    auto tradeMsg = makeTradeMsg_(*buyerSession, trade, isBuyer);
-                    serializeMessageInto(buyerSession->sendBuffer, MessageType::TRADE,
-                                         tradeMsg.header, tradeMsg.payload);
-                    dirtyFDs_.insert(buyerSession->fd);
-                }
-                Session* sellerSession = sessionManager_.getSession(trade.sellerID);
-                if (sellerSession) {
-                    bool isBuyer = false;
-                    auto tradeMsg = makeTradeMsg_(*sellerSession, trade, isBuyer);
-                    serializeMessageInto(sellerSession->sendBuffer, MessageType::TRADE,
-                                         tradeMsg.header, tradeMsg.payload);
-                    dirtyFDs_.insert(sellerSession->fd);
-                }
-            }
-        }
+        batch_.push_back(MiniExchangeAPI::makeCommand(msgOpt->payload));
     }
 
     return sizeToBeConsumed;
@@ -299,22 +255,296 @@ std::size_t ProtocolHandler::handleCancel_(Session& session,
             return sizeToBeConsumed;
         }
         session.getNextClientSqn();
+        batch_.push_back(MiniExchangeAPI::makeCommand(msgOpt->payload));
+    }
 
-        bool success = api_.cancelOrder(msgOpt->payload);
+    return sizeToBeConsumed;
+}
 
-        Message<server::CancelAckPayload> ackMsg =
-            makeCancelAck_(session, OrderID{msgOpt->payload.serverOrderID},
-                           ClientOrderID{msgOpt->payload.clientOrderID},
-                           InstrumentID{msgOpt->payload.instrumentID}, success);
+void ProtocolHandler::flushBatch_(Session& session) {
+    if (batch_.empty()) {
+        return;
+    }
 
-        serializeMessageInto(session.sendBuffer, MessageType::CANCEL_ACK, ackMsg.header,
-                             ackMsg.payload);
-        dirtyFDs_.insert(session.fd);
+    if (shards_) {
+        for (const OrderCommand& command : batch_) {
+            pushRequest_(EngineRequest{.type = EngineRequestType::ORDER,
+                                       .sessionID = session.getClientID(),
+                                       .command = command});
+        }
+        batch_.clear();
+        return;
+    }
+
+    batchResults_.resize(batch_.size());
+    api_.processBatch(batch_, batchResults_);
+
+    const std::span<const TradeEvent> trades = api_.getTrades();
+    const std::span<const SelfTradeCancel> selfTradeCancels = api_.getSelfTradeCancels();
+    std::size_t tradeBegin = 0;
+    std::size_t selfTradeCancelBegin = 0;
+
+    // every command is answered like it was processed on its own: the ack, then its
+    // trades, then the resting orders self-trade prevention took off the book
+    for (std::size_t i = 0; i < batch_.size(); ++i) {
+        const OrderCommand& command = batch_[i];
+        const CommandResult& result = batchResults_[i];
+
+        switch (command.command) {
+        case CommandType::NEW_ORDER: {
+            auto ackMsg = makeOrderAck_(session, result.match, command.clientOrderID);
+            serializeMessageInto(session.sendBuffer, MessageType::ORDER_ACK,
+                                 ackMsg.header, ackMsg.payload);
+            break;
+        }
+        case CommandType::CANCEL: {
+            auto ackMsg = makeCancelAck_(session, command.orderID, command.clientOrderID,
+                                         command.instrumentID,
+                                         result.cancelled ? status::CancelStatus::ACCEPTED
+                                                          : status::CancelStatus::REJECTED);
+            serializeMessageInto(session.sendBuffer, MessageType::CANCEL_ACK,
+                                 ackMsg.header, ackMsg.payload);
+            break;
+        }
+        case CommandType::MODIFY: {
+            auto ackMsg = makeModifyAck_(session, result.modify, command.clientOrderID);
+            serializeMessageInto(session.sendBuffer, MessageType::MODIFY_ACK,
+                                 ackMsg.header, ackMsg.payload);
+            break;
+        }
+        }
+        markDirty_(session.fd);
+
+        sendTrades_(trades.subspan(tradeBegin, result.tradeEnd - tradeBegin));
+        sendSelfTradeCancels_(
+            selfTradeCancels.subspan(selfTradeCancelBegin,
+                                     result.selfTradeCancelEnd - selfTradeCancelBegin));
+        tradeBegin = result.tradeEnd;
+        selfTradeCancelBegin = result.selfTradeCancelEnd;
+    }
+
+    batch_.clear();
+}
+
+void ProtocolHandler::sendTrades_(std::span<const TradeEvent> trades) {
+    for (const TradeEvent& trade : trades) {
+        Session* buyerSession = sessionManager_.getSession(trade.buyerID);
+        if (buyerSession) {
+            bool isBuyer = true;
+            auto tradeMsg = makeTradeMsg_(*buyerSession, trade, isBuyer);
+            serializeMessageInto(buyerSession->sendBuffer, MessageType::TRADE,
+                                 tradeMsg.header, tradeMsg.payload);
+            markDirty_(buyerSession->fd);
+        }
+
+        Session* sellerSession = sessionManager_.getSession(trade.sellerID);
+        if (sellerSession) {
+            bool isBuyer = false;
+            auto tradeMsg = makeTradeMsg_(*sellerSession, trade, isBuyer);
+            serializeMessageInto(sellerSession->sendBuffer, MessageType::TRADE,
+                                 tradeMsg.header, tradeMsg.payload);
+            markDirty_(sellerSession->fd);
+        }
+    }
+}
+
+std::size_t ProtocolHandler::handleMassCancel_(Session& session,
+                                               std::span<const std::byte> messageBytes) {
+    constexpr std::size_t sizeToBeConsumed =
+        MessageHeader::traits::HEADER_SIZE +
+        client::MassCancelPayload::traits::payloadSize;
+
+    if (session.recvBuffer.size() < sizeToBeConsumed) {
+        return 0;
+    }
+
+    if (auto msgOpt = deserializeMessage<client::MassCancelPayload>(messageBytes)) {
+        if (!utils::isCorrectIncrement(session.getClientSqn().value(),
+                                       msgOpt->header.clientMsgSqn)) {
+            return sizeToBeConsumed;
+        }
+        session.getNextClientSqn();
+
+        if (shards_) {
+            pushRequest_(EngineRequest{.type = EngineRequestType::MASS_CANCEL,
+                                       .sessionID = session.getClientID(),
+                                       .massCancel = msgOpt->payload});
+            return sizeToBeConsumed;
+        }
+
+        // every pulled order gets its own cancel ack, the summary goes out last
+        std::optional<std::size_t> cancelled =
+            api_.massCancel(msgOpt->payload, [this, &session](const Order& order) {
+                auto ackMsg =
+                    makeCancelAck_(session, order.orderID, order.clientOrderID,
+                                   order.instrumentID, status::CancelStatus::ACCEPTED);
+                serializeMessageInto(session.sendBuffer, MessageType::CANCEL_ACK,
+                                     ackMsg.header, ackMsg.payload);
+            });
+
+        auto ackMsg = makeMassCancelAck_(
+            session, cancelled.value_or(0), InstrumentID{msgOpt->payload.instrumentID},
+            cancelled ? status::CancelStatus::ACCEPTED : status::CancelStatus::REJECTED);
+        serializeMessageInto(session.sendBuffer, MessageType::MASS_CANCEL_ACK,
+                             ackMsg.header, ackMsg.payload);
+        markDirty_(session.fd);
     }
 
     return sizeToBeConsumed;
 }
 
+void ProtocolHandler::onDisconnect(int fd) {
+    Session* session = sessionManager_.getSession(fd);
+    if (!session) {
+        return;
+    }
+
+    if (shards_) {
+        pushRequest_(EngineRequest{.type = EngineRequestType::CANCEL_ALL,
+                                   .sessionID = session->getClientID()});
+        return;
+    }
+    api_.cancelAllOrders(session->getClientID());
+}
+
+void ProtocolHandler::pushRequest_(const EngineRequest& request) {
+    if (request.type != EngineRequestType::CANCEL_ALL) {
+        pushRequest_(shards_->shardOf(request), request);
+        return;
+    }
+    for (std::size_t shard = 0; shard < shards_->shardCount(); ++shard) {
+        pushRequest_(shard, request);
+    }
+}
+
+void ProtocolHandler::pushRequest_(std::size_t shard, const EngineRequest& request) {
+    // the engine thread may itself be waiting for room in the response ring
+    while (!shards_->tryPush(shard, request)) {
+        drainResponses();
+        utils::cpuRelax();
+    }
+}
+
+std::size_t ProtocolHandler::drainResponses() {
+    if (!shards_) {
+        return 0;
+    }
+
+    std::size_t count = 0;
+    EngineResponse response;
+    for (std::size_t shard = 0; shard < shards_->shardCount(); ++shard) {
+        while (shards_->tryPop(shard, response)) {
+            handleResponse_(response);
+            ++count;
+        }
+    }
+    return count;
+}
+
+void ProtocolHandler::handleResponse_(const EngineResponse& response) {
+    if (response.type == EngineResponseType::TRADE) {
+        sendTrades_(std::span{&response.trade, 1});
+        return;
+    }
+
+    // the client may have disconnected while the engine was busy with its request
+    Session* session = sessionManager_.getSession(response.sessionID);
+    if (!session) {
+        return;
+    }
+
+    switch (response.type) {
+    case EngineResponseType::ORDER_ACK: {
+        const MatchResult result{.orderID = response.orderID,
+                                 .timestamp = response.timestamp,
+                                 .remainingQty = response.qty,
+                                 .acceptedPrice = response.price,
+                                 .status = OrderStatus{response.status},
+                                 .instrumentID = response.instrumentID,
+                                 .tradeVec{}};
+        auto ackMsg = makeOrderAck_(*session, result, response.clientOrderID);
+        serializeMessageInto(session->sendBuffer, MessageType::ORDER_ACK, ackMsg.header,
+                             ackMsg.payload);
+        break;
+    }
+    case EngineResponseType::MODIFY_ACK: {
+        const ModifyResult result{.serverClientID = response.sessionID,
+                                  .oldOrderID = response.orderID,
+                                  .newOrderID = response.newOrderID,
+                                  .newQty = response.qty,
+                                  .newPrice = response.price,
+                                  .status = ModifyStatus{response.status},
+                                  .instrumentID = response.instrumentID,
+                                  .matchResult = std::nullopt};
+        auto ackMsg = makeModifyAck_(*session, result, response.clientOrderID);
+        serializeMessageInto(session->sendBuffer, MessageType::MODIFY_ACK, ackMsg.header,
+                             ackMsg.payload);
+        break;
+    }
+    case EngineResponseType::CANCEL_ACK: {
+        auto ackMsg = makeCancelAck_(*session, response.orderID, response.clientOrderID,
+                                     response.instrumentID,
+                                     status::CancelStatus{response.status});
+        serializeMessageInto(session->sendBuffer, MessageType::CANCEL_ACK, ackMsg.header,
+                             ackMsg.payload);
+        break;
+    }
+    case EngineResponseType::MASS_CANCEL_ACK: {
+        auto ackMsg =
+            makeMassCancelAck_(*session, response.cancelledCount, response.instrumentID,
+                               status::CancelStatus{response.status});
+        serializeMessageInto(session->sendBuffer, MessageType::MASS_CANCEL_ACK,
+                             ackMsg.header, ackMsg.payload);
+        break;
+    }
+    case EngineResponseType::TRADE:
+        break;
+    }
+    markDirty_(session->fd);
+}
+
+void ProtocolHandler::sendSelfTradeCancels_(std::span<const SelfTradeCancel> cancels) {
+    for (const SelfTradeCancel& cancel : cancels) {
+        Session* session = sessionManager_.getSession(cancel.clientID);
+        if (!session) {
+            continue;
+        }
+
+        auto ackMsg =
+            makeCancelAck_(*session, cancel.orderID, cancel.clientOrderID,
+                           cancel.instrumentID, status::CancelStatus::SELF_TRADE);
+        serializeMessageInto(session->sendBuffer, MessageType::CANCEL_ACK, ackMsg.header,
+                             ackMsg.payload);
+        markDirty_(session->fd);
+    }
+}
+
+bool ProtocolHandler::runTimers() {
+    if (shards_) {
+        return false;
+    }
+
+    const auto now = static_cast<Timestamp>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
+
+    api_.expireOrders(now, [this](const Order& order) {
+        Session* session = sessionManager_.getSession(order.clientID);
+        if (!session) {
+            return;
+        }
+
+        auto ackMsg = makeCancelAck_(*session, order.orderID, order.clientOrderID,
+                                     order.instrumentID, status::CancelStatus::EXPIRED);
+        serializeMessageInto(session->sendBuffer, MessageType::CANCEL_ACK, ackMsg.header,
+                             ackMsg.payload);
+        markDirty_(session->fd);
+    });
+
+    return api_.hasPendingExpiries(now);
+}
+
 template <typename Payload> inline MessageHeader makeHeader(Session& session) {
     MessageHeader header{};
     header.messageType = +Payload::traits::type;
@@ -410,7 +640,7 @@ ProtocolHandler::makeModifyAck_(Session& session, const ModifyResult& res,
 Message<server::CancelAckPayload>
 ProtocolHandler::makeCancelAck_(Session& session, OrderID orderID,
                                 ClientOrderID clientOrderID, InstrumentID instrID,
-                                bool success) {
+                                status::CancelStatus statusCode) {
     Message<server::CancelAckPayload> msg;
     msg.header = makeHeader<server::CancelAckPayload>(session);
 
@@ -418,8 +648,24 @@ ProtocolHandler::makeCancelAck_(Session& session, OrderID orderID,
     msg.payload.serverOrderID = orderID.value();
     msg.payload.clientOrderID = clientOrderID.value();
     msg.payload.instrumentID = instrID.value();
-    msg.payload.status =
-        success ? +status::CancelStatus::ACCEPTED : +status::CancelStatus::REJECTED;
+    msg.payload.status = +statusCode;
+
+    std::memset(msg.payload.padding, 0, sizeof(msg.payload.padding));
+
+    return msg;
+}
+
+Message<server::MassCancelAckPayload>
+ProtocolHandler::makeMassCancelAck_(Session& session, std::size_t cancelledCount,
+                                    InstrumentID instrID,
+                                    status::CancelStatus statusCode) {
+    Message<server::MassCancelAckPayload> msg;
+    msg.header = makeHeader<server::MassCancelAckPayload>(session);
+
+    msg.payload.serverClientID = session.getClientID().value();
+    msg.payload.cancelledCount = cancelledCount;
+    msg.payload.instrumentID = instrID.value();
+    msg.payload.status = +statusCode;
 
     std::memset(msg.payload.padding, 0, sizeof(msg.payload.padding));
 
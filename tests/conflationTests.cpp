@@ -0,0 +1,183 @@
+#include "client/mdReceiver.hpp"
+#include "market-data/MDPublisher.hpp"
+#include "market-data/bookEvent.hpp"
+#include "market-data/conflator.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::uint16_t kTestPort = 9103;
+
+L2OrderBookUpdate makeUpdate(OrderSide side, BookUpdateEventType type, Price price,
+                             Qty amount) {
+    L2OrderBookUpdate update{};
+    update.side = side;
+    update.type = type;
+    update.price = price;
+    update.amount = amount;
+    return update;
+}
+
+void apply(Level2OrderBook& book, const L2OrderBookUpdate& update) {
+    if (update.type == BookUpdateEventType::REDUCE) {
+        book.reduce(update.side, update.price, update.amount);
+    } else {
+        book.add(update.side, update.price, update.amount);
+    }
+}
+
+// A burst on a handful of levels near the touch, every reduce takes out at most what
+// rests on its level
+std::vector<L2OrderBookUpdate> makeBurst(std::size_t count) {
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<std::uint64_t> offset(1, 8);
+    std::uniform_int_distribution<std::uint64_t> lot(1, 10);
+    Level2OrderBook shadow;
+
+    std::vector<L2OrderBookUpdate> burst;
+    burst.reserve(count);
+    while (burst.size() < count) {
+        const OrderSide side = rng() % 2 == 0 ? OrderSide::BUY : OrderSide::SELL;
+        const Price price{side == OrderSide::BUY ? 100 - offset(rng) : 100 + offset(rng)};
+        const Qty resting = shadow.qtyAt(side, price);
+        const bool add = resting == Qty{0} || rng() % 2 == 0;
+        const Qty amount = add ? Qty{lot(rng)} : Qty{std::min(resting.value(), lot(rng))};
+        burst.push_back(makeUpdate(
+            side, add ? BookUpdateEventType::ADD : BookUpdateEventType::REDUCE, price,
+            amount));
+        apply(shadow, burst.back());
+    }
+    return burst;
+}
+
+} // namespace
+
+TEST(ConflatorTest, PublishesTheNetChangeOfEachLevel) {
+    market_data::Conflator conflator;
+    conflator.add(
+        makeUpdate(OrderSide::BUY, BookUpdateEventType::ADD, Price{99}, Qty{10}));
+    conflator.add(
+        makeUpdate(OrderSide::BUY, BookUpdateEventType::REDUCE, Price{99}, Qty{4}));
+    conflator.add(
+        makeUpdate(OrderSide::BUY, BookUpdateEventType::ADD, Price{100}, Qty{5}));
+    conflator.add(
+        makeUpdate(OrderSide::SELL, BookUpdateEventType::REDUCE, Price{101}, Qty{3}));
+    // comes back to where it started and is left out
+    conflator.add(
+        makeUpdate(OrderSide::SELL, BookUpdateEventType::ADD, Price{102}, Qty{2}));
+    conflator.add(
+        makeUpdate(OrderSide::SELL, BookUpdateEventType::REDUCE, Price{102}, Qty{2}));
+    EXPECT_EQ(conflator.pending(), 6u);
+
+    std::vector<L2OrderBookUpdate> flushed;
+    EXPECT_EQ(conflator.flush([&](const L2OrderBookUpdate& u) { flushed.push_back(u); }),
+              3u);
+    EXPECT_TRUE(conflator.empty());
+
+    ASSERT_EQ(flushed.size(), 3u);
+    EXPECT_EQ(flushed[0].price, Price{100});
+    EXPECT_EQ(flushed[0].type, BookUpdateEventType::ADD);
+    EXPECT_EQ(flushed[0].amount, Qty{5});
+    EXPECT_EQ(flushed[1].price, Price{99});
+    EXPECT_EQ(flushed[1].amount, Qty{6});
+    EXPECT_EQ(flushed[2].side, OrderSide::SELL);
+    EXPECT_EQ(flushed[2].type, BookUpdateEventType::REDUCE);
+    EXPECT_EQ(flushed[2].amount, Qty{3});
+
+    EXPECT_EQ(conflator.flush([](const L2OrderBookUpdate&) { FAIL(); }), 0u);
+}
+
+TEST(ConflatorTest, ReplayedBurstEndsInTheSameBookWithFarFewerUpdates) {
+    const std::vector<L2OrderBookUpdate> burst = makeBurst(10'000);
+
+    Level2OrderBook every;
+    for (const L2OrderBookUpdate& update : burst) {
+        apply(every, update);
+    }
+
+    // flushed every 256 updates, as a drain of a busy ring would
+    Level2OrderBook conflated;
+    market_data::Conflator conflator;
+    std::size_t published = 0;
+    for (std::size_t i = 0; i < burst.size(); ++i) {
+        conflator.add(burst[i]);
+        if ((i + 1) % 256 == 0 || i + 1 == burst.size()) {
+            published += conflator.flush(
+                [&](const L2OrderBookUpdate& update) { apply(conflated, update); });
+        }
+    }
+
+    EXPECT_EQ(conflated.depth(OrderSide::BUY), every.depth(OrderSide::BUY));
+    EXPECT_EQ(conflated.depth(OrderSide::SELL), every.depth(OrderSide::SELL));
+    // 16 levels, at most 16 updates per flush
+    EXPECT_LE(published, 16 * (burst.size() / 256 + 1));
+}
+
+// ring -> conflating MarketDataPublisher -> loopback multicast -> MDReceiver
+TEST(ConflatedFeedTest, ReceiverBookMatchesWithFewerPackets) {
+    Level2OrderBook book;
+    utils::spsc_queue<L2OrderBookUpdate> queue(1024);
+    std::unique_ptr<MDReceiver> receiver;
+    std::unique_ptr<market_data::MarketDataPublisher> publisher;
+    try {
+        receiver = std::make_unique<MDReceiver>(MDConfig{.port = kTestPort});
+        receiver->initialize();
+        publisher = std::make_unique<market_data::MarketDataPublisher>(
+            &queue, utils::PriceLadderConfig{}, InstrumentID{1},
+            market_data::PublisherConfig{.conflation = {.enabled = true},
+                                         .transport = {.port = kTestPort}});
+    } catch (const std::exception& e) {
+        GTEST_SKIP() << "no loopback multicast: " << e.what();
+    }
+
+    std::size_t expected = 0;
+    auto receiveAll = [&] {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (expected > 0 && std::chrono::steady_clock::now() < deadline) {
+            if (receiver->receiveOne()) {
+                --expected;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        ASSERT_EQ(expected, 0u) << "datagrams did not arrive";
+    };
+
+    publisher->publishSnapshot();
+    expected = 1;
+    receiveAll();
+    ASSERT_TRUE(receiver->isBookValid());
+
+    const std::vector<L2OrderBookUpdate> burst = makeBurst(4096);
+    std::uint64_t packets = publisher->packetCount();
+    for (std::size_t i = 0; i < burst.size(); i += 256) {
+        for (std::size_t j = i; j < i + 256; ++j) {
+            apply(book, burst[j]);
+            ASSERT_TRUE(queue.try_push(burst[j]));
+        }
+        EXPECT_EQ(publisher->publishDelta(), 256u);
+        expected = publisher->packetCount() - packets;
+        packets = publisher->packetCount();
+        receiveAll();
+    }
+
+    EXPECT_TRUE(receiver->isBookValid());
+    EXPECT_EQ(receiver->getOrderBook().depth(OrderSide::BUY), book.depth(OrderSide::BUY));
+    EXPECT_EQ(receiver->getOrderBook().depth(OrderSide::SELL),
+              book.depth(OrderSide::SELL));
+    EXPECT_EQ(publisher->book().depth(OrderSide::BUY), book.depth(OrderSide::BUY));
+    EXPECT_EQ(publisher->book().depth(OrderSide::SELL), book.depth(OrderSide::SELL));
+    EXPECT_LT(publisher->packetCount(), burst.size() / 10);
+}
@@ -7,6 +7,7 @@
 
 #include <gtest/gtest.h>
 #include <memory>
+#include <vector>
 
 TEST_F(ObserverTest, LimitBuy) {
     auto buy = OrderBuilder{}.build();
@@ -74,3 +75,44 @@ TEST_F(ObserverTest, PartialFillLimit) {
 
     checkBooks(*engine, *observer);
 }
+
+TEST_F(ObserverTest, MassCancelPublishesOneUpdatePerLevel) {
+    constexpr ClientID kMaker{9};
+    std::uint64_t id = 0;
+    for (std::uint64_t level = 0; level < 3; ++level) {
+        for (int i = 0; i < 4; ++i) {
+            engine->processOrder(OrderBuilder{}
+                                     .withOrderID(OrderID{++id})
+                                     .withClientID(kMaker)
+                                     .withPrice(Price{1000 - level})
+                                     .build());
+            engine->processOrder(OrderBuilder{}
+                                     .withOrderID(OrderID{++id})
+                                     .withClientID(kMaker)
+                                     .withSide(OrderSide::SELL)
+                                     .withPrice(Price{1001 + level})
+                                     .build());
+        }
+    }
+    // another client keeps one bid level alive
+    engine->processOrder(
+        OrderBuilder{}.withOrderID(OrderID{++id}).withPrice(Price{999}).build());
+    observer->drainQueue();
+
+    ASSERT_EQ(engine->massCancel(kMaker), 24);
+
+    // 24 orders on 6 levels, then hand the updates on to the observer
+    std::vector<L2OrderBookUpdate> updates;
+    for (L2OrderBookUpdate update{}; queue_->try_pop(update);) {
+        updates.push_back(update);
+    }
+    EXPECT_EQ(updates.size(), 6);
+    for (const auto& update : updates) {
+        EXPECT_EQ(update.type, BookUpdateEventType::REDUCE);
+        EXPECT_EQ(update.amount, Qty{4 * OrderBuilder::Defaults::qty.value()});
+        ASSERT_TRUE(queue_->try_push(update));
+    }
+
+    observer->drainQueue();
+    checkBooks(*engine, *observer);
+}
@@ -0,0 +1,107 @@
+#include "core/engineShards.hpp"
+#include "core/matchingEngine.hpp"
+#include "sessions/sessionManager.hpp"
+#include "utils/types.hpp"
+#include "utils/utils.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+EngineRequest newOrder(InstrumentID instrumentID, ClientID clientID, OrderSide side,
+                       std::uint64_t price) {
+    return EngineRequest{.type = EngineRequestType::ORDER,
+                         .sessionID = clientID,
+                         .command = {.command = CommandType::NEW_ORDER,
+                                     .clientID = clientID,
+                                     .qty = Qty{10},
+                                     .price = Price{price},
+                                     .instrumentID = instrumentID,
+                                     .side = side}};
+}
+
+} // namespace
+
+class EngineShardsTest : public ::testing::Test {
+protected:
+    void push(const EngineRequest& request) {
+        const std::size_t shard = shards.shardOf(request);
+        while (!shards.tryPush(shard, request)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // the next count responses of one shard, fewer if they do not arrive in a second
+    std::vector<EngineResponse> collect(std::size_t shard, std::size_t count) {
+        std::vector<EngineResponse> responses;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        EngineResponse response;
+        while (responses.size() < count && std::chrono::steady_clock::now() < deadline) {
+            if (shards.tryPop(shard, response)) {
+                responses.push_back(response);
+            }
+        }
+        return responses;
+    }
+
+    MatchingEngine first{nullptr, nullptr, InstrumentID{1}};
+    MatchingEngine second{nullptr, nullptr, InstrumentID{2}};
+    MatchingEngine third{nullptr, nullptr, InstrumentID{3}};
+    std::vector<MatchingEngine*> engines{&first, &second, &third};
+    SessionManager sessions;
+    EngineShards shards{engines, sessions, {.cpus = {-1, -1}, .thread = {.ringCapacity = 16}}};
+};
+
+TEST_F(EngineShardsTest, AssignsInstrumentsRoundRobin) {
+    EXPECT_EQ(shards.shardCount(), 2u);
+    EXPECT_EQ(shards.shardOf(InstrumentID{1}), 0u);
+    EXPECT_EQ(shards.shardOf(InstrumentID{2}), 1u);
+    EXPECT_EQ(shards.shardOf(InstrumentID{3}), 0u);
+    // unknown instruments end up on shard 0, which rejects them
+    EXPECT_EQ(shards.shardOf(InstrumentID{42}), 0u);
+}
+
+TEST_F(EngineShardsTest, EachShardMatchesItsOwnInstruments) {
+    shards.start();
+    push(newOrder(InstrumentID{1}, ClientID{1}, OrderSide::SELL, 100));
+    push(newOrder(InstrumentID{2}, ClientID{2}, OrderSide::BUY, 100));
+    push(newOrder(InstrumentID{1}, ClientID{2}, OrderSide::BUY, 100));
+    push(newOrder(InstrumentID{42}, ClientID{2}, OrderSide::BUY, 100));
+
+    auto shard0 = collect(0, 4);
+    ASSERT_EQ(shard0.size(), 4u);
+    EXPECT_EQ(shard0[1].status, +OrderStatus::FILLED);
+    EXPECT_EQ(shard0[2].type, EngineResponseType::TRADE);
+    EXPECT_EQ(shard0[2].trade.instrumentID, InstrumentID{1});
+    EXPECT_EQ(shard0[3].status, +OrderStatus::REJECTED);
+
+    auto shard1 = collect(1, 1);
+    ASSERT_EQ(shard1.size(), 1u);
+    EXPECT_EQ(shard1[0].status, +OrderStatus::NEW);
+    EXPECT_EQ(shard1[0].instrumentID, InstrumentID{2});
+}
+
+TEST_F(EngineShardsTest, RebalancesOnlyWhileStopped) {
+    shards.start();
+    EXPECT_THROW(shards.assign(InstrumentID{3}, 1), std::logic_error);
+    shards.stop();
+
+    EXPECT_THROW(shards.assign(InstrumentID{42}, 1), std::out_of_range);
+    EXPECT_THROW(shards.assign(InstrumentID{3}, 2), std::out_of_range);
+
+    shards.assign(InstrumentID{3}, 1);
+    EXPECT_EQ(shards.shardOf(InstrumentID{3}), 1u);
+
+    shards.start();
+    push(newOrder(InstrumentID{3}, ClientID{1}, OrderSide::BUY, 100));
+    auto responses = collect(1, 1);
+    ASSERT_EQ(responses.size(), 1u);
+    EXPECT_EQ(responses[0].status, +OrderStatus::NEW);
+    EXPECT_EQ(responses[0].instrumentID, InstrumentID{3});
+}
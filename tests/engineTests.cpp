@@ -1,6 +1,13 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <gtest/gtest.h>
 #include <memory>
+#include <random>
+#include <span>
 #include <utility>
+#include <vector>
 
 #include "core/matchingEngine.hpp"
 #include "utils/orderBuilder.hpp"
@@ -721,3 +728,930 @@ TEST_F(MatchingEngineTest, GetOrder_AfterModify) {
     EXPECT_EQ(modifiedOrder->qty, Qty{150});
     EXPECT_EQ(modifiedOrder->price, Price{2001});
 }
+
+TEST_F(MatchingEngineTest, CancelFromMiddleKeepsTimePriority) {
+    for (std::uint64_t id = 1; id <= 3; ++id) {
+        auto buy = OrderBuilder{}.withOrderID(OrderID{id}).withQty(Qty{10}).build();
+        engine->processOrder(std::move(buy));
+    }
+
+    EXPECT_TRUE(engine->cancelOrder(OrderBuilder::Defaults::clientID, OrderID{2}));
+    EXPECT_EQ(engine->getOrder(OrderID{2}), nullptr);
+
+    auto sell = OrderBuilder{}
+                    .withOrderID(OrderID{4})
+                    .withClientID(ClientID{9})
+                    .withSide(OrderSide::SELL)
+                    .withQty(Qty{15})
+                    .build();
+    auto res = engine->processOrder(std::move(sell));
+
+    ASSERT_EQ(res.tradeVec.size(), 2);
+    EXPECT_EQ(res.tradeVec.at(0).buyerOrderID, OrderID{1});
+    EXPECT_EQ(res.tradeVec.at(0).qty, Qty{10});
+    EXPECT_EQ(res.tradeVec.at(1).buyerOrderID, OrderID{3});
+    EXPECT_EQ(res.tradeVec.at(1).qty, Qty{5});
+    EXPECT_EQ(engine->getOrder(OrderID{3})->qty, Qty{5});
+}
+
+TEST_F(MatchingEngineTest, OrdersReturnToPool) {
+    for (std::uint64_t id = 1; id <= 3; ++id) {
+        auto buy = OrderBuilder{}.withOrderID(OrderID{id}).withQty(Qty{10}).build();
+        engine->processOrder(std::move(buy));
+    }
+    EXPECT_EQ(engine->getOrderPoolStats().inUse, 3);
+
+    // fills two resting orders, the incoming one is fully filled as well
+    auto sell = OrderBuilder{}
+                    .withOrderID(OrderID{4})
+                    .withClientID(ClientID{9})
+                    .withSide(OrderSide::SELL)
+                    .withQty(Qty{20})
+                    .build();
+    engine->processOrder(std::move(sell));
+    EXPECT_EQ(engine->getOrderPoolStats().inUse, 1);
+
+    EXPECT_TRUE(engine->cancelOrder(OrderBuilder::Defaults::clientID, OrderID{3}));
+    EXPECT_EQ(engine->getOrderPoolStats().inUse, 0);
+    EXPECT_EQ(engine->getOrderPoolStats().highWaterMark, 4);
+}
+
+TEST_F(MatchingEngineTest, ResetReleasesRestingOrders) {
+    for (std::uint64_t id = 1; id <= 3; ++id) {
+        auto buy = OrderBuilder{}
+                       .withOrderID(OrderID{id})
+                       .withPrice(Price{100 + id})
+                       .withQty(Qty{10})
+                       .build();
+        engine->processOrder(std::move(buy));
+    }
+
+    engine->reset();
+    EXPECT_EQ(engine->getOrderPoolStats().inUse, 0);
+    EXPECT_FALSE(engine->getBestBid().has_value());
+}
+
+TEST(MatchingEnginePoolTest, ExhaustedPoolRejects) {
+    MatchingEngine engine(nullptr, nullptr, InstrumentID{1},
+                          EngineConfig{.orderPool = {.initialCapacity = 1,
+                                                     .maxCapacity = 1}});
+
+    auto first = OrderBuilder{}.withOrderID(OrderID{1}).build();
+    EXPECT_EQ(engine.processOrder(std::move(first)).status, OrderStatus::NEW);
+
+    auto second = OrderBuilder{}.withOrderID(OrderID{2}).build();
+    EXPECT_EQ(engine.processOrder(std::move(second)).status, OrderStatus::REJECTED);
+    EXPECT_EQ(engine.getOrderPoolStats().inUse, 1);
+}
+
+TEST_F(MatchingEngineTest, TradeSinkReceivesTrades) {
+    for (std::uint64_t id = 1; id <= 3; ++id) {
+        auto sell = OrderBuilder{}
+                        .withOrderID(OrderID{id})
+                        .withClientID(ClientID{2})
+                        .withSide(OrderSide::SELL)
+                        .withPrice(Price{100 + id})
+                        .withQty(Qty{10})
+                        .build();
+        engine->processOrder(std::move(sell));
+    }
+
+    std::vector<TradeEvent> trades;
+    auto buy = engine->makeOrder(*OrderBuilder{}
+                                      .withOrderID(OrderID{4})
+                                      .withPrice(Price{103})
+                                      .withQty(Qty{25})
+                                      .build());
+    MatchResult res = engine->processOrder(
+        std::move(buy), [&trades](const TradeEvent& trade) { trades.push_back(trade); });
+
+    EXPECT_EQ(res.status, OrderStatus::FILLED);
+    EXPECT_TRUE(res.tradeVec.empty());
+    ASSERT_EQ(trades.size(), 3);
+    EXPECT_EQ(trades[0].price, Price{101});
+    EXPECT_EQ(trades[2].price, Price{103});
+    EXPECT_EQ(trades[2].qty, Qty{5});
+}
+
+TEST_F(MatchingEngineTest, ModifyTradeSinkReceivesTrades) {
+    auto sell = OrderBuilder{}
+                    .withOrderID(OrderID{1})
+                    .withClientID(ClientID{2})
+                    .withSide(OrderSide::SELL)
+                    .withPrice(Price{110})
+                    .withQty(Qty{10})
+                    .build();
+    engine->processOrder(std::move(sell));
+
+    auto buy = OrderBuilder{}.withOrderID(OrderID{2}).withPrice(Price{100}).build();
+    engine->processOrder(std::move(buy));
+
+    std::size_t count = 0;
+    ModifyResult res =
+        engine->modifyOrder(OrderBuilder::Defaults::clientID, OrderID{2}, Qty{10},
+                            Price{110}, [&count](const TradeEvent&) { ++count; });
+
+    EXPECT_EQ(res.status, ModifyStatus::ACCEPTED);
+    ASSERT_TRUE(res.matchResult.has_value());
+    EXPECT_TRUE(res.matchResult->tradeVec.empty());
+    EXPECT_EQ(count, 1);
+}
+
+TEST_F(MatchingEngineTest, LevelAggregatesFollowFillsCancelsAndModifies) {
+    for (std::uint64_t id = 1; id <= 3; ++id) {
+        auto buy = OrderBuilder{}
+                       .withOrderID(OrderID{id})
+                       .withPrice(Price{100})
+                       .withQty(Qty{10})
+                       .build();
+        engine->processOrder(std::move(buy));
+    }
+    auto deeper = OrderBuilder{}
+                      .withOrderID(OrderID{4})
+                      .withPrice(Price{99})
+                      .withQty(Qty{7})
+                      .build();
+    engine->processOrder(std::move(deeper));
+
+    auto depth = engine->getDepth<OrderSide::BUY>(8);
+    ASSERT_EQ(depth.size(), 2);
+    EXPECT_EQ(depth[0], (LevelSummary{Price{100}, Qty{30}, 3}));
+    EXPECT_EQ(depth[1], (LevelSummary{Price{99}, Qty{7}, 1}));
+
+    // partial fill of the first order in the queue
+    auto sell = OrderBuilder{}
+                    .withOrderID(OrderID{5})
+                    .withClientID(ClientID{9})
+                    .withSide(OrderSide::SELL)
+                    .withPrice(Price{100})
+                    .withQty(Qty{4})
+                    .build();
+    engine->processOrder(std::move(sell));
+    EXPECT_EQ(engine->getDepth<OrderSide::BUY>(1).at(0),
+              (LevelSummary{Price{100}, Qty{26}, 3}));
+
+    EXPECT_TRUE(engine->cancelOrder(OrderBuilder::Defaults::clientID, OrderID{2}));
+    EXPECT_EQ(engine->getDepth<OrderSide::BUY>(1).at(0),
+              (LevelSummary{Price{100}, Qty{16}, 2}));
+
+    auto res = engine->modifyOrder(OrderBuilder::Defaults::clientID, OrderID{3}, Qty{1},
+                                   Price{100});
+    EXPECT_EQ(res.status, ModifyStatus::ACCEPTED);
+    EXPECT_EQ(engine->getDepth<OrderSide::BUY>(1).at(0),
+              (LevelSummary{Price{100}, Qty{7}, 2}));
+
+    auto snapshot = engine->getSnapshot<OrderSide::BUY>();
+    ASSERT_EQ(snapshot.size(), 2);
+    EXPECT_EQ(snapshot[1].second, Qty{7});
+}
+
+TEST_F(MatchingEngineTest, DepthIsBoundedByTheOutputBuffer) {
+    for (std::uint64_t id = 1; id <= 5; ++id) {
+        auto sell = OrderBuilder{}
+                        .withOrderID(OrderID{id})
+                        .withSide(OrderSide::SELL)
+                        .withPrice(Price{200 + id})
+                        .withQty(Qty{id})
+                        .build();
+        engine->processOrder(std::move(sell));
+    }
+
+    std::array<LevelSummary, 3> out{};
+    ASSERT_EQ(engine->getDepth<OrderSide::SELL>(std::span<LevelSummary>{out}), 3);
+    EXPECT_EQ(out[0], (LevelSummary{Price{201}, Qty{1}, 1}));
+    EXPECT_EQ(out[2], (LevelSummary{Price{203}, Qty{3}, 1}));
+
+    EXPECT_EQ(engine->getDepth<OrderSide::SELL>(10).size(), 5);
+    EXPECT_TRUE(engine->getDepth<OrderSide::BUY>(10).empty());
+}
+
+class TimeInForceTest : public MatchingEngineTest {
+protected:
+    void addAsk(std::uint64_t id, std::uint64_t price, std::uint64_t qty,
+                ClientID clientID = ClientID{2}) {
+        auto sell = OrderBuilder{}
+                        .withOrderID(OrderID{id})
+                        .withClientID(clientID)
+                        .withSide(OrderSide::SELL)
+                        .withPrice(Price{price})
+                        .withQty(Qty{qty})
+                        .build();
+        ASSERT_EQ(engine->processOrder(std::move(sell)).status, OrderStatus::NEW);
+    }
+
+    MatchResult buy(std::uint64_t id, std::uint64_t price, std::uint64_t qty,
+                    TimeInForce tif) {
+        OrderBuilder builder;
+        builder.withOrderID(OrderID{id}).withQty(Qty{qty}).withTIF(tif);
+        if (price == 0) {
+            builder.withType(OrderType::MARKET);
+        } else {
+            builder.withPrice(Price{price});
+        }
+        return engine->processOrder(builder.build());
+    }
+};
+
+TEST_F(TimeInForceTest, ImmediateOrCancelDropsTheRemainder) {
+    addAsk(1, 101, 10);
+
+    auto res = buy(2, 101, 15, TimeInForce::IMMEDIATE_OR_CANCEL);
+    EXPECT_EQ(res.status, OrderStatus::PARTIALLY_FILLED);
+    EXPECT_EQ(res.remainingQty, Qty{5});
+    EXPECT_EQ(res.tradeVec.size(), 1);
+    EXPECT_FALSE(engine->getBestBid().has_value());
+    EXPECT_FALSE(engine->getBestAsk().has_value());
+    EXPECT_EQ(engine->getOrderPoolStats().inUse, 0);
+}
+
+TEST_F(TimeInForceTest, ImmediateOrCancelWithoutCrossIsCancelled) {
+    addAsk(1, 105, 10);
+
+    auto res = buy(2, 101, 10, TimeInForce::IMMEDIATE_OR_CANCEL);
+    EXPECT_EQ(res.status, OrderStatus::CANCELLED);
+    EXPECT_TRUE(res.tradeVec.empty());
+    EXPECT_FALSE(engine->getBestBid().has_value());
+    EXPECT_EQ(engine->getDepth<OrderSide::SELL>(1).at(0),
+              (LevelSummary{Price{105}, Qty{10}, 1}));
+}
+
+TEST_F(TimeInForceTest, FillOrKillFillsAcrossLevels) {
+    addAsk(1, 101, 10);
+    addAsk(2, 102, 10);
+
+    auto res = buy(3, 102, 15, TimeInForce::FILL_OR_KILL);
+    EXPECT_EQ(res.status, OrderStatus::FILLED);
+    EXPECT_EQ(res.remainingQty, Qty{0});
+    ASSERT_EQ(res.tradeVec.size(), 2);
+    EXPECT_EQ(res.tradeVec[1].qty, Qty{5});
+    EXPECT_EQ(engine->getDepth<OrderSide::SELL>(1).at(0),
+              (LevelSummary{Price{102}, Qty{5}, 1}));
+}
+
+TEST_F(TimeInForceTest, FillOrKillKillLeavesTheBookUntouched) {
+    addAsk(1, 101, 10);
+    addAsk(2, 102, 10);
+    addAsk(3, 103, 10);
+
+    // 30 is on the book, but only 20 of it at or below the limit
+    auto res = buy(4, 102, 25, TimeInForce::FILL_OR_KILL);
+    EXPECT_EQ(res.status, OrderStatus::CANCELLED);
+    EXPECT_EQ(res.remainingQty, Qty{25});
+    EXPECT_TRUE(res.tradeVec.empty());
+
+    auto depth = engine->getDepth<OrderSide::SELL>(8);
+    ASSERT_EQ(depth.size(), 3);
+    EXPECT_EQ(depth[0], (LevelSummary{Price{101}, Qty{10}, 1}));
+    EXPECT_EQ(depth[1], (LevelSummary{Price{102}, Qty{10}, 1}));
+    EXPECT_FALSE(engine->getBestBid().has_value());
+    EXPECT_EQ(engine->getOrderPoolStats().inUse, 3);
+}
+
+TEST_F(TimeInForceTest, FillOrKillDoesNotCountOwnOrders) {
+    addAsk(1, 101, 10, OrderBuilder::Defaults::clientID);
+    addAsk(2, 101, 10);
+
+    auto killed = buy(3, 101, 15, TimeInForce::FILL_OR_KILL);
+    EXPECT_EQ(killed.status, OrderStatus::CANCELLED);
+    EXPECT_EQ(engine->getDepth<OrderSide::SELL>(1).at(0),
+              (LevelSummary{Price{101}, Qty{20}, 2}));
+
+    auto filled = buy(4, 101, 10, TimeInForce::FILL_OR_KILL);
+    EXPECT_EQ(filled.status, OrderStatus::FILLED);
+    ASSERT_EQ(filled.tradeVec.size(), 1);
+    EXPECT_EQ(filled.tradeVec[0].sellerOrderID, OrderID{2});
+}
+
+TEST_F(TimeInForceTest, FillOrKillSweepsPastALevelOfOwnOrders) {
+    addAsk(1, 101, 10, OrderBuilder::Defaults::clientID);
+    addAsk(2, 102, 10);
+
+    auto res = buy(3, 102, 10, TimeInForce::FILL_OR_KILL);
+    EXPECT_EQ(res.status, OrderStatus::FILLED);
+    ASSERT_EQ(res.tradeVec.size(), 1);
+    EXPECT_EQ(res.tradeVec[0].sellerOrderID, OrderID{2});
+    EXPECT_NE(engine->getOrder(OrderID{1}), nullptr);
+}
+
+TEST_F(TimeInForceTest, MarketFillOrKill) {
+    addAsk(1, 101, 10);
+    addAsk(2, 150, 10);
+
+    EXPECT_EQ(buy(3, 0, 25, TimeInForce::FILL_OR_KILL).status, OrderStatus::CANCELLED);
+    EXPECT_EQ(engine->getDepth<OrderSide::SELL>(8).size(), 2);
+
+    auto res = buy(4, 0, 20, TimeInForce::FILL_OR_KILL);
+    EXPECT_EQ(res.status, OrderStatus::FILLED);
+    EXPECT_EQ(res.tradeVec.size(), 2);
+    EXPECT_FALSE(engine->getBestAsk().has_value());
+}
+
+TEST_F(TimeInForceTest, UnknownTimeInForceIsRejected) {
+    addAsk(1, 101, 10);
+
+    auto res = buy(2, 101, 10, TimeInForce{42});
+    EXPECT_EQ(res.status, OrderStatus::REJECTED);
+    EXPECT_EQ(engine->getDepth<OrderSide::SELL>(1).at(0).qty, Qty{10});
+}
+
+class ExpiryTest : public ::testing::Test {
+protected:
+    static constexpr Timestamp kEndOfDay = 50'000;
+
+    MatchingEngine engine{
+        nullptr, nullptr, InstrumentID{1},
+        EngineConfig{.expiry = {.tickNs = 10, .endOfDay = kEndOfDay, .budget = {}}}};
+    std::vector<OrderID> expired;
+
+    auto collect() {
+        return [this](const Order& order) {
+            EXPECT_EQ(order.status, OrderStatus::CANCELLED);
+            expired.push_back(order.orderID);
+        };
+    }
+
+    MatchResult add(std::uint64_t id, OrderSide side, TimeInForce tif,
+                    Timestamp goodTill = 0) {
+        return engine.processOrder(OrderBuilder{}
+                                       .withOrderID(OrderID{id})
+                                       .withSide(side)
+                                       .withTIF(tif)
+                                       .withGoodTill(goodTill)
+                                       .build());
+    }
+};
+
+TEST_F(ExpiryTest, GoodTillDateOrderExpires) {
+    ASSERT_EQ(add(1, OrderSide::BUY, TimeInForce::GOOD_TILL_DATE, 1'005).status,
+              OrderStatus::NEW);
+    ASSERT_EQ(add(2, OrderSide::BUY, TimeInForce::GOOD_TILL_CANCELLED).status,
+              OrderStatus::NEW);
+    EXPECT_EQ(engine.getScheduledExpiryCount(), 1);
+
+    // never before goodTill, even though it falls inside a wheel tick
+    EXPECT_EQ(engine.expireOrders(1'004, collect()), 0);
+    EXPECT_NE(engine.getOrder(OrderID{1}), nullptr);
+
+    EXPECT_EQ(engine.expireOrders(1'010, collect()), 1);
+    EXPECT_EQ(expired, std::vector<OrderID>{OrderID{1}});
+    EXPECT_EQ(engine.getOrder(OrderID{1}), nullptr);
+    EXPECT_EQ(engine.getDepth<OrderSide::BUY>(1).at(0).orderCount, 1);
+    EXPECT_EQ(engine.getOrderPoolStats().inUse, 1);
+    EXPECT_EQ(engine.getScheduledExpiryCount(), 0);
+}
+
+TEST_F(ExpiryTest, FilledAndCancelledOrdersLeaveTheWheel) {
+    add(1, OrderSide::BUY, TimeInForce::GOOD_TILL_DATE, 1'000);
+    add(2, OrderSide::BUY, TimeInForce::GOOD_TILL_DATE, 1'000);
+    EXPECT_EQ(engine.getScheduledExpiryCount(), 2);
+
+    auto sell = OrderBuilder{}
+                    .withOrderID(OrderID{3})
+                    .withClientID(ClientID{9})
+                    .withSide(OrderSide::SELL)
+                    .build();
+    EXPECT_EQ(engine.processOrder(std::move(sell)).status, OrderStatus::FILLED);
+    EXPECT_EQ(engine.getScheduledExpiryCount(), 1);
+
+    EXPECT_TRUE(engine.cancelOrder(OrderBuilder::Defaults::clientID, OrderID{2}));
+    EXPECT_EQ(engine.getScheduledExpiryCount(), 0);
+
+    EXPECT_EQ(engine.expireOrders(10'000, collect()), 0);
+    EXPECT_TRUE(expired.empty());
+}
+
+TEST_F(ExpiryTest, RepricedOrderKeepsItsExpiry) {
+    add(1, OrderSide::BUY, TimeInForce::GOOD_TILL_DATE, 2'000);
+
+    auto res = engine.modifyOrder(OrderBuilder::Defaults::clientID, OrderID{1},
+                                  OrderBuilder::Defaults::qty, Price{900});
+    ASSERT_EQ(res.status, ModifyStatus::ACCEPTED);
+    EXPECT_EQ(engine.getScheduledExpiryCount(), 1);
+
+    EXPECT_EQ(engine.expireOrders(2'000, collect()), 1);
+    EXPECT_EQ(expired, std::vector<OrderID>{res.newOrderID});
+    EXPECT_FALSE(engine.getBestBid().has_value());
+}
+
+TEST_F(ExpiryTest, EndOfDayPurgeIsSplitIntoBatches) {
+    constexpr std::uint64_t kOrders = 200;
+    for (std::uint64_t id = 1; id <= kOrders; ++id) {
+        add(id, OrderSide::SELL, TimeInForce::END_OF_DAY);
+    }
+    // nothing expires before the end of day, the orders only move down the wheel
+    while (engine.hasPendingExpiries(kEndOfDay - 10)) {
+        EXPECT_EQ(engine.expireOrders(kEndOfDay - 10, collect()), 0);
+    }
+
+    // with no time budget every call expires a single batch
+    std::size_t calls = 0;
+    std::size_t total = 0;
+    while (engine.hasPendingExpiries(kEndOfDay)) {
+        std::size_t n = engine.expireOrders(kEndOfDay, collect());
+        EXPECT_LE(n, 64);
+        total += n;
+        ++calls;
+    }
+    EXPECT_EQ(total, kOrders);
+    EXPECT_GT(calls, 1);
+    EXPECT_FALSE(engine.getBestAsk().has_value());
+    EXPECT_EQ(engine.getOrderPoolStats().inUse, 0);
+}
+
+TEST(EndOfDayRollTest, OrderAddedAfterTheRollWaitsForTheNextEndOfDay) {
+    MatchingEngine engine{nullptr, nullptr, InstrumentID{1},
+                          EngineConfig{.expiry = {.tickNs = 10,
+                                                  .endOfDay = 50'000,
+                                                  .endOfDayRoll =
+                                                      std::chrono::nanoseconds{100'000},
+                                                  .budget = {}}}};
+    auto add = [&](std::uint64_t id) {
+        return engine.processOrder(OrderBuilder{}
+                                       .withOrderID(OrderID{id})
+                                       .withTIF(TimeInForce::END_OF_DAY)
+                                       .build());
+    };
+    auto expireUpTo = [&](Timestamp now) {
+        std::size_t expired = 0;
+        do {
+            expired += engine.expireOrders(now, [](const Order&) {});
+        } while (engine.hasPendingExpiries(now));
+        return expired;
+    };
+
+    ASSERT_EQ(add(1).status, OrderStatus::NEW);
+    EXPECT_EQ(expireUpTo(50'000), 1);
+
+    // placed after the first end of day went by, it stays until the next one
+    ASSERT_EQ(add(2).status, OrderStatus::NEW);
+    EXPECT_EQ(expireUpTo(50'010), 0);
+    EXPECT_EQ(expireUpTo(149'990), 0);
+    EXPECT_NE(engine.getOrder(OrderID{2}), nullptr);
+
+    EXPECT_EQ(expireUpTo(150'000), 1);
+    EXPECT_EQ(engine.getOrder(OrderID{2}), nullptr);
+}
+
+TEST_F(ExpiryTest, ResetClearsTheWheel) {
+    add(1, OrderSide::BUY, TimeInForce::GOOD_TILL_DATE, 1'000);
+    add(2, OrderSide::SELL, TimeInForce::END_OF_DAY);
+    engine.reset();
+
+    EXPECT_EQ(engine.getScheduledExpiryCount(), 0);
+    EXPECT_EQ(engine.expireOrders(kEndOfDay, collect()), 0);
+}
+
+TEST_F(ExpiryTest, GoodTillDateWithoutTimeIsRejected) {
+    EXPECT_EQ(add(1, OrderSide::BUY, TimeInForce::GOOD_TILL_DATE).status,
+              OrderStatus::REJECTED);
+}
+
+class MassCancelTest : public ::testing::Test {
+protected:
+    MatchingEngine engine;
+
+    MatchResult add(std::uint64_t id, ClientID clientID, OrderSide side,
+                    std::uint64_t price, std::uint64_t qty = 10) {
+        return engine.processOrder(OrderBuilder{}
+                                       .withOrderID(OrderID{id})
+                                       .withClientID(clientID)
+                                       .withSide(side)
+                                       .withPrice(Price{price})
+                                       .withQty(Qty{qty})
+                                       .build());
+    }
+};
+
+TEST_F(MassCancelTest, CancelsOnlyTheClientsOrders) {
+    add(1, ClientID{1}, OrderSide::BUY, 99);
+    add(2, ClientID{2}, OrderSide::BUY, 99);
+    add(3, ClientID{1}, OrderSide::SELL, 101);
+    add(4, ClientID{1}, OrderSide::BUY, 98);
+    ASSERT_EQ(engine.getClientOrderCount(ClientID{1}), 3);
+
+    std::vector<OrderID> cancelled;
+    EXPECT_EQ(engine.massCancel(ClientID{1}, {},
+                                [&cancelled](const Order& order) {
+                                    EXPECT_EQ(order.status, OrderStatus::CANCELLED);
+                                    cancelled.push_back(order.orderID);
+                                }),
+              3);
+
+    EXPECT_EQ(cancelled, (std::vector<OrderID>{OrderID{1}, OrderID{3}, OrderID{4}}));
+    EXPECT_EQ(engine.getClientOrderCount(ClientID{1}), 0);
+    EXPECT_EQ(engine.getClientOrderCount(ClientID{2}), 1);
+    EXPECT_EQ(engine.getBestBid(), Price{99});
+    EXPECT_FALSE(engine.getBestAsk().has_value());
+    EXPECT_EQ(engine.getOrderPoolStats().inUse, 1);
+}
+
+TEST_F(MassCancelTest, FilterBySideAndPriceRange) {
+    add(1, ClientID{1}, OrderSide::BUY, 95);
+    add(2, ClientID{1}, OrderSide::BUY, 97);
+    add(3, ClientID{1}, OrderSide::BUY, 99);
+    add(4, ClientID{1}, OrderSide::SELL, 97);
+
+    EXPECT_EQ(engine.massCancel(ClientID{1}, {.side = OrderSide::BUY,
+                                              .minPrice = Price{96},
+                                              .maxPrice = Price{99}}),
+              2);
+    EXPECT_NE(engine.getOrder(OrderID{1}), nullptr);
+    EXPECT_EQ(engine.getOrder(OrderID{2}), nullptr);
+    EXPECT_EQ(engine.getOrder(OrderID{3}), nullptr);
+    EXPECT_NE(engine.getOrder(OrderID{4}), nullptr);
+}
+
+TEST_F(MassCancelTest, FilledAndCancelledOrdersLeaveTheClientList) {
+    add(1, ClientID{1}, OrderSide::SELL, 100);
+    add(2, ClientID{1}, OrderSide::SELL, 101);
+    add(3, ClientID{1}, OrderSide::SELL, 102);
+    ASSERT_TRUE(engine.cancelOrder(ClientID{1}, OrderID{3}));
+
+    // fills the first ask and half of the second
+    ASSERT_EQ(add(4, ClientID{2}, OrderSide::BUY, 101, 15).status, OrderStatus::FILLED);
+    EXPECT_EQ(engine.getClientOrderCount(ClientID{1}), 1);
+
+    EXPECT_EQ(engine.massCancel(ClientID{1}), 1);
+    EXPECT_EQ(engine.getOrderPoolStats().inUse, 0);
+}
+
+TEST_F(MassCancelTest, UnknownClientCancelsNothing) {
+    add(1, ClientID{1}, OrderSide::BUY, 99);
+    EXPECT_EQ(engine.massCancel(ClientID{7}), 0);
+    EXPECT_EQ(engine.getClientOrderCount(ClientID{1}), 1);
+}
+
+TEST_F(MassCancelTest, ResetEmptiesTheClientLists) {
+    add(1, ClientID{1}, OrderSide::BUY, 99);
+    engine.reset();
+    EXPECT_EQ(engine.getClientOrderCount(ClientID{1}), 0);
+
+    add(2, ClientID{1}, OrderSide::BUY, 99);
+    EXPECT_EQ(engine.massCancel(ClientID{1}), 1);
+}
+
+class SelfTradeTest : public ::testing::Test {
+protected:
+    static constexpr ClientID kSelf{1};
+    static constexpr ClientID kOther{2};
+
+    void SetUp() override { useMode(SelfTradePrevention::SKIP); }
+
+    void useMode(SelfTradePrevention mode) {
+        engine = std::make_unique<MatchingEngine>(nullptr, nullptr, InstrumentID{1},
+                                                  EngineConfig{.selfTrade = mode});
+    }
+
+    void addAsk(std::uint64_t id, std::uint64_t price, std::uint64_t qty,
+                ClientID clientID) {
+        auto sell = OrderBuilder{}
+                        .withOrderID(OrderID{id})
+                        .withClientID(clientID)
+                        .withSide(OrderSide::SELL)
+                        .withPrice(Price{price})
+                        .withQty(Qty{qty})
+                        .build();
+        ASSERT_EQ(engine->processOrder(std::move(sell)).status, OrderStatus::NEW);
+    }
+
+    MatchResult buy(std::uint64_t id, std::uint64_t price, std::uint64_t qty,
+                    TimeInForce tif = TimeInForce::GOOD_TILL_CANCELLED) {
+        return engine->processOrder(OrderBuilder{}
+                                        .withOrderID(OrderID{id})
+                                        .withClientID(kSelf)
+                                        .withPrice(Price{price})
+                                        .withQty(Qty{qty})
+                                        .withTIF(tif)
+                                        .build());
+    }
+
+    std::vector<OrderID> selfTradeCancels() const {
+        std::vector<OrderID> ids;
+        for (const SelfTradeCancel& cancel : engine->getSelfTradeCancels()) {
+            EXPECT_EQ(cancel.clientID, kSelf);
+            ids.push_back(cancel.orderID);
+        }
+        return ids;
+    }
+
+    std::unique_ptr<MatchingEngine> engine;
+};
+
+TEST_F(SelfTradeTest, SkipSweepsPastLevelsOfOwnOrders) {
+    for (std::uint64_t id = 1; id <= 3; ++id) {
+        addAsk(id, 101, 10, kSelf);
+    }
+    addAsk(4, 102, 5, kOther);
+    addAsk(5, 103, 5, kOther);
+
+    auto res = buy(6, 103, 10);
+    EXPECT_EQ(res.status, OrderStatus::FILLED);
+    ASSERT_EQ(res.tradeVec.size(), 2);
+    EXPECT_EQ(res.tradeVec[0].sellerOrderID, OrderID{4});
+    EXPECT_EQ(res.tradeVec[1].sellerOrderID, OrderID{5});
+    EXPECT_TRUE(selfTradeCancels().empty());
+    EXPECT_EQ(engine->getDepth<OrderSide::SELL>(8),
+              (std::vector<LevelSummary>{{Price{101}, Qty{30}, 3}}));
+}
+
+TEST_F(SelfTradeTest, SkipKeepsOwnOrdersOfAMixedLevel) {
+    addAsk(1, 101, 10, kSelf);
+    addAsk(2, 101, 10, kOther);
+    addAsk(3, 101, 10, kSelf);
+
+    auto res = buy(4, 101, 15);
+    EXPECT_EQ(res.status, OrderStatus::PARTIALLY_FILLED);
+    EXPECT_EQ(res.remainingQty, Qty{5});
+    ASSERT_EQ(res.tradeVec.size(), 1);
+    EXPECT_EQ(res.tradeVec[0].sellerOrderID, OrderID{2});
+
+    // the rest of the buy crosses the own asks, it rests like it did before
+    EXPECT_EQ(engine->getBestBid(), Price{101});
+    EXPECT_EQ(engine->getDepth<OrderSide::SELL>(1).at(0),
+              (LevelSummary{Price{101}, Qty{20}, 2}));
+    EXPECT_EQ(engine->getClientOrderCount(kSelf), 3);
+}
+
+TEST_F(SelfTradeTest, CancelNewestCancelsTheIncomingOrder) {
+    useMode(SelfTradePrevention::CANCEL_NEWEST);
+    addAsk(1, 101, 5, kOther);
+    addAsk(2, 101, 10, kSelf);
+    addAsk(3, 101, 10, kOther);
+
+    auto res = buy(4, 101, 20);
+    EXPECT_EQ(res.status, OrderStatus::PARTIALLY_FILLED);
+    EXPECT_EQ(res.remainingQty, Qty{15});
+    EXPECT_EQ(res.tradeVec.size(), 1);
+    EXPECT_FALSE(engine->getBestBid().has_value());
+    EXPECT_EQ(engine->getDepth<OrderSide::SELL>(1).at(0),
+              (LevelSummary{Price{101}, Qty{20}, 2}));
+
+    EXPECT_EQ(buy(5, 101, 5).status, OrderStatus::CANCELLED);
+    EXPECT_TRUE(selfTradeCancels().empty());
+}
+
+TEST_F(SelfTradeTest, CancelOldestCancelsTheRestingOrder) {
+    useMode(SelfTradePrevention::CANCEL_OLDEST);
+    addAsk(1, 101, 10, kSelf);
+    addAsk(2, 102, 10, kOther);
+
+    auto res = buy(3, 102, 10);
+    EXPECT_EQ(res.status, OrderStatus::FILLED);
+    ASSERT_EQ(res.tradeVec.size(), 1);
+    EXPECT_EQ(res.tradeVec[0].sellerOrderID, OrderID{2});
+    EXPECT_EQ(selfTradeCancels(), std::vector<OrderID>{OrderID{1}});
+    EXPECT_FALSE(engine->getBestAsk().has_value());
+    EXPECT_EQ(engine->getClientOrderCount(kSelf), 0);
+    EXPECT_EQ(engine->getOrderPoolStats().inUse, 0);
+}
+
+TEST_F(SelfTradeTest, CancelBothCancelsBoth) {
+    useMode(SelfTradePrevention::CANCEL_BOTH);
+    addAsk(1, 101, 10, kSelf);
+    addAsk(2, 101, 10, kSelf);
+    addAsk(3, 101, 10, kOther);
+
+    auto res = buy(4, 101, 10);
+    EXPECT_EQ(res.status, OrderStatus::CANCELLED);
+    EXPECT_TRUE(res.tradeVec.empty());
+    EXPECT_EQ(selfTradeCancels(), std::vector<OrderID>{OrderID{1}});
+    EXPECT_FALSE(engine->getBestBid().has_value());
+    EXPECT_EQ(engine->getDepth<OrderSide::SELL>(1).at(0),
+              (LevelSummary{Price{101}, Qty{20}, 2}));
+}
+
+TEST_F(SelfTradeTest, DecrementTakesTheSmallerQuantityOffBoth) {
+    useMode(SelfTradePrevention::DECREMENT);
+    addAsk(1, 101, 4, kSelf);
+    addAsk(2, 101, 10, kSelf);
+    addAsk(3, 101, 10, kOther);
+
+    // 4 off the first own ask, which goes, and 6 off the second
+    auto res = buy(4, 101, 10);
+    EXPECT_EQ(res.status, OrderStatus::CANCELLED);
+    EXPECT_EQ(res.remainingQty, Qty{0});
+    EXPECT_TRUE(res.tradeVec.empty());
+    EXPECT_EQ(selfTradeCancels(), std::vector<OrderID>{OrderID{1}});
+    EXPECT_EQ(engine->getOrder(OrderID{2})->qty, Qty{4});
+    EXPECT_EQ(engine->getDepth<OrderSide::SELL>(1).at(0),
+              (LevelSummary{Price{101}, Qty{14}, 2}));
+
+    // decrements the last 4 and trades the rest
+    res = buy(5, 101, 10);
+    EXPECT_EQ(res.status, OrderStatus::PARTIALLY_FILLED);
+    EXPECT_EQ(res.remainingQty, Qty{0});
+    ASSERT_EQ(res.tradeVec.size(), 1);
+    EXPECT_EQ(res.tradeVec[0].qty, Qty{6});
+    EXPECT_EQ(engine->getClientOrderCount(kSelf), 0);
+    EXPECT_FALSE(engine->getBestBid().has_value());
+}
+
+TEST_F(SelfTradeTest, FillOrKillFollowsTheMode) {
+    addAsk(1, 101, 10, kOther);
+    addAsk(2, 101, 10, kSelf);
+    addAsk(3, 102, 10, kOther);
+
+    // SKIP and CANCEL_OLDEST sweep past the own ask
+    EXPECT_EQ(buy(4, 102, 20, TimeInForce::FILL_OR_KILL).status, OrderStatus::FILLED);
+
+    useMode(SelfTradePrevention::CANCEL_NEWEST);
+    addAsk(1, 101, 10, kOther);
+    addAsk(2, 101, 10, kSelf);
+    addAsk(3, 102, 10, kOther);
+
+    // matching would stop at the own ask after 10
+    EXPECT_EQ(buy(4, 102, 20, TimeInForce::FILL_OR_KILL).status, OrderStatus::CANCELLED);
+    EXPECT_EQ(engine->getDepth<OrderSide::SELL>(1).at(0),
+              (LevelSummary{Price{101}, Qty{20}, 2}));
+    EXPECT_EQ(buy(5, 102, 10, TimeInForce::FILL_OR_KILL).status, OrderStatus::FILLED);
+}
+
+TEST_F(SelfTradeTest, ResetDropsTheOwnLevels) {
+    addAsk(1, 101, 10, kSelf);
+    engine->reset();
+    addAsk(2, 101, 10, kOther);
+
+    auto res = buy(3, 101, 10);
+    EXPECT_EQ(res.status, OrderStatus::FILLED);
+    EXPECT_EQ(res.tradeVec.size(), 1);
+}
+
+class BatchTest : public ::testing::Test {
+protected:
+    static OrderCommand newOrder(std::uint64_t id, ClientID clientID, OrderSide side,
+                                 std::uint64_t price, std::uint64_t qty) {
+        return OrderCommand{.command = CommandType::NEW_ORDER,
+                            .orderID = OrderID{id},
+                            .clientID = clientID,
+                            .clientOrderID = ClientOrderID{id},
+                            .qty = Qty{qty},
+                            .price = Price{price},
+                            .instrumentID = InstrumentID{1},
+                            .side = side};
+    }
+
+    static OrderCommand cancel(std::uint64_t id, ClientID clientID) {
+        return OrderCommand{.command = CommandType::CANCEL,
+                            .orderID = OrderID{id},
+                            .clientID = clientID};
+    }
+
+    static OrderCommand modify(std::uint64_t id, ClientID clientID, std::uint64_t price,
+                               std::uint64_t qty) {
+        return OrderCommand{.command = CommandType::MODIFY,
+                            .orderID = OrderID{id},
+                            .clientID = clientID,
+                            .qty = Qty{qty},
+                            .price = Price{price}};
+    }
+
+    MatchingEngine engine;
+};
+
+TEST_F(BatchTest, CommandsAreProcessedInOrder) {
+    const std::vector<OrderCommand> commands{
+        newOrder(1, ClientID{1}, OrderSide::SELL, 101, 10),
+        newOrder(2, ClientID{1}, OrderSide::SELL, 102, 10),
+        cancel(2, ClientID{1}),
+        newOrder(3, ClientID{2}, OrderSide::BUY, 101, 4),
+        modify(1, ClientID{1}, 101, 3),
+        newOrder(4, ClientID{2}, OrderSide::BUY, 101, 5),
+        cancel(2, ClientID{1}),
+    };
+    std::vector<CommandResult> results(commands.size());
+
+    ASSERT_EQ(engine.processBatch(commands, results), commands.size());
+
+    EXPECT_EQ(results[0].match.status, OrderStatus::NEW);
+    EXPECT_TRUE(results[2].cancelled);
+    EXPECT_EQ(results[3].match.status, OrderStatus::FILLED);
+    EXPECT_EQ(results[4].modify.status, ModifyStatus::ACCEPTED);
+    EXPECT_EQ(results[5].match.status, OrderStatus::PARTIALLY_FILLED);
+    EXPECT_EQ(results[5].match.remainingQty, Qty{2});
+    EXPECT_FALSE(results[6].cancelled);
+    EXPECT_EQ(results[6].command, CommandType::CANCEL);
+
+    // the trades of each command follow on from the previous one's
+    auto trades = engine.getTrades();
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(results[2].tradeEnd, 0);
+    EXPECT_EQ(results[3].tradeEnd, 1);
+    EXPECT_EQ(results[4].tradeEnd, 1);
+    EXPECT_EQ(results[5].tradeEnd, 2);
+    EXPECT_EQ(trades[0].qty, Qty{4});
+    EXPECT_EQ(trades[1].qty, Qty{3});
+
+    EXPECT_EQ(engine.getBestBid(), Price{101});
+    EXPECT_FALSE(engine.getBestAsk().has_value());
+}
+
+TEST_F(BatchTest, InvalidOrdersAreRejectedWithoutTheirNeighbours) {
+    const std::vector<OrderCommand> commands{
+        newOrder(1, ClientID{1}, OrderSide::SELL, 101, 10),
+        newOrder(2, ClientID{1}, OrderSide::SELL, 101, 0),
+        newOrder(3, ClientID{1}, OrderSide{7}, 101, 10),
+        newOrder(4, ClientID{1}, OrderSide::SELL, 101, 10),
+    };
+    std::vector<CommandResult> results(commands.size());
+    engine.processBatch(commands, results);
+
+    EXPECT_EQ(results[0].match.status, OrderStatus::NEW);
+    EXPECT_EQ(results[1].match.status, OrderStatus::REJECTED);
+    EXPECT_EQ(results[2].match.status, OrderStatus::REJECTED);
+    EXPECT_EQ(results[3].match.status, OrderStatus::NEW);
+    EXPECT_EQ(engine.getOrderPoolStats().inUse, 2);
+}
+
+TEST_F(BatchTest, StopsAtTheEndOfTheResultBuffer) {
+    const std::vector<OrderCommand> commands{
+        newOrder(1, ClientID{1}, OrderSide::SELL, 101, 10),
+        newOrder(2, ClientID{1}, OrderSide::SELL, 102, 10),
+    };
+    std::vector<CommandResult> results(1);
+
+    EXPECT_EQ(engine.processBatch(commands, results), 1);
+    EXPECT_EQ(engine.getOrder(OrderID{2}), nullptr);
+}
+
+TEST_F(BatchTest, MatchesOneCallPerCommand) {
+    std::mt19937_64 rng(5);
+    std::vector<OrderCommand> commands;
+    // clear of the ids the engines hand out to modified orders
+    constexpr std::uint64_t kFirstID = 1'000'000;
+    std::uint64_t orders = 0;
+    for (std::size_t i = 0; i < 5'000; ++i) {
+        const auto clientID = ClientID{1 + rng() % 3};
+        const std::uint64_t roll = rng() % 10;
+        if (roll < 6 || orders == 0) {
+            commands.push_back(newOrder(kFirstID + orders++, clientID,
+                                        rng() % 2 ? OrderSide::BUY : OrderSide::SELL,
+                                        95 + rng() % 10, 1 + rng() % 20));
+        } else if (roll < 9) {
+            commands.push_back(cancel(kFirstID + rng() % orders, clientID));
+        } else {
+            commands.push_back(modify(kFirstID + rng() % orders, clientID,
+                                      95 + rng() % 10, 1 + rng() % 20));
+        }
+    }
+
+    MatchingEngine reference;
+    std::vector<TradeEvent> referenceTrades;
+    auto collect = [&referenceTrades](const TradeEvent& trade) {
+        referenceTrades.push_back(trade);
+    };
+    std::vector<CommandResult> expected(commands.size());
+    for (std::size_t i = 0; i < commands.size(); ++i) {
+        const OrderCommand& command = commands[i];
+        switch (command.command) {
+        case CommandType::NEW_ORDER:
+            expected[i].match = reference.processOrder(
+                reference.makeOrder(command.orderID, command.clientID,
+                                    command.clientOrderID, command.qty, command.price,
+                                    Timestamp{0}, Timestamp{0}, command.instrumentID,
+                                    command.tif, command.side, command.type,
+                                    OrderStatus::NEW),
+                collect);
+            break;
+        case CommandType::CANCEL:
+            expected[i].cancelled = reference.cancelOrder(command.clientID, command.orderID);
+            break;
+        case CommandType::MODIFY:
+            expected[i].modify = reference.modifyOrder(command.clientID, command.orderID,
+                                                       command.qty, command.price, collect);
+            break;
+        }
+        expected[i].tradeEnd = referenceTrades.size();
+    }
+
+    // in bursts of 64 like the gateway would hand them over
+    std::vector<CommandResult> results(commands.size());
+    std::vector<TradeEvent> trades;
+    for (std::size_t begin = 0; begin < commands.size(); begin += 64) {
+        const std::size_t count = std::min<std::size_t>(64, commands.size() - begin);
+        ASSERT_EQ(engine.processBatch(std::span{commands}.subspan(begin, count),
+                                      std::span{results}.subspan(begin, count)),
+                  count);
+        for (std::size_t i = begin; i < begin + count; ++i) {
+            results[i].tradeEnd += trades.size();
+        }
+        trades.insert(trades.end(), engine.getTrades().begin(), engine.getTrades().end());
+    }
+
+    for (std::size_t i = 0; i < commands.size(); ++i) {
+        ASSERT_EQ(results[i].match.status, expected[i].match.status) << i;
+        ASSERT_EQ(results[i].match.remainingQty, expected[i].match.remainingQty) << i;
+        ASSERT_EQ(results[i].cancelled, expected[i].cancelled) << i;
+        ASSERT_EQ(results[i].modify.status, expected[i].modify.status) << i;
+        ASSERT_EQ(results[i].tradeEnd, expected[i].tradeEnd) << i;
+    }
+    ASSERT_EQ(trades.size(), referenceTrades.size());
+    for (std::size_t i = 0; i < trades.size(); ++i) {
+        EXPECT_EQ(trades[i].qty, referenceTrades[i].qty);
+        EXPECT_EQ(trades[i].price, referenceTrades[i].price);
+        EXPECT_EQ(trades[i].buyerOrderID, referenceTrades[i].buyerOrderID);
+        EXPECT_EQ(trades[i].sellerOrderID, referenceTrades[i].sellerOrderID);
+    }
+    EXPECT_EQ(engine.getDepth<OrderSide::BUY>(16), reference.getDepth<OrderSide::BUY>(16));
+    EXPECT_EQ(engine.getDepth<OrderSide::SELL>(16),
+              reference.getDepth<OrderSide::SELL>(16));
+}
@@ -0,0 +1,145 @@
+#include "api/api.hpp"
+#include "core/engineThread.hpp"
+#include "core/matchingEngine.hpp"
+#include "sessions/sessionManager.hpp"
+#include "utils/status.hpp"
+#include "utils/types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+EngineRequest newOrder(ClientID clientID, OrderSide side, std::uint64_t price,
+                       std::uint64_t qty) {
+    return EngineRequest{.type = EngineRequestType::ORDER,
+                         .sessionID = clientID,
+                         .command = {.command = CommandType::NEW_ORDER,
+                                     .clientID = clientID,
+                                     .clientOrderID = ClientOrderID{price},
+                                     .qty = Qty{qty},
+                                     .price = Price{price},
+                                     .instrumentID = InstrumentID{1},
+                                     .side = side}};
+}
+
+EngineRequest cancel(ClientID clientID, OrderID orderID) {
+    return EngineRequest{.type = EngineRequestType::ORDER,
+                         .sessionID = clientID,
+                         .command = {.command = CommandType::CANCEL,
+                                     .orderID = orderID,
+                                     .clientID = clientID,
+                                     .instrumentID = InstrumentID{1}}};
+}
+
+} // namespace
+
+class EngineThreadTest : public ::testing::Test {
+protected:
+    void push(const EngineRequest& request) {
+        while (!engineThread.tryPush(request)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // the next count responses, fewer if they do not arrive within a second
+    std::vector<EngineResponse> collect(std::size_t count) {
+        std::vector<EngineResponse> responses;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        EngineResponse response;
+        while (responses.size() < count && std::chrono::steady_clock::now() < deadline) {
+            if (engineThread.tryPop(response)) {
+                responses.push_back(response);
+            }
+        }
+        return responses;
+    }
+
+    MatchingEngine engine;
+    SessionManager sessions;
+    MiniExchangeAPI api{engine, sessions};
+    EngineThread engineThread{api, {.ringCapacity = 16}};
+};
+
+TEST_F(EngineThreadTest, AcksAndTradesComeBackInOrder) {
+    engineThread.start();
+    push(newOrder(ClientID{1}, OrderSide::SELL, 100, 10));
+    push(newOrder(ClientID{2}, OrderSide::BUY, 100, 10));
+
+    auto responses = collect(3);
+    ASSERT_EQ(responses.size(), 3);
+
+    EXPECT_EQ(responses[0].type, EngineResponseType::ORDER_ACK);
+    EXPECT_EQ(responses[0].sessionID, ClientID{1});
+    EXPECT_EQ(responses[0].status, +OrderStatus::NEW);
+    EXPECT_EQ(responses[0].orderID, OrderID{1});
+
+    EXPECT_EQ(responses[1].type, EngineResponseType::ORDER_ACK);
+    EXPECT_EQ(responses[1].sessionID, ClientID{2});
+    EXPECT_EQ(responses[1].status, +OrderStatus::FILLED);
+    EXPECT_EQ(responses[1].orderID, OrderID{2});
+
+    EXPECT_EQ(responses[2].type, EngineResponseType::TRADE);
+    EXPECT_EQ(responses[2].trade.sellerOrderID, OrderID{1});
+    EXPECT_EQ(responses[2].trade.buyerOrderID, OrderID{2});
+    EXPECT_EQ(responses[2].trade.qty, Qty{10});
+}
+
+TEST_F(EngineThreadTest, MassCancelWaitsForTheOrdersAheadOfIt) {
+    engineThread.start();
+    push(newOrder(ClientID{1}, OrderSide::BUY, 99, 10));
+    push(newOrder(ClientID{1}, OrderSide::BUY, 98, 10));
+    push(EngineRequest{.type = EngineRequestType::MASS_CANCEL,
+                       .sessionID = ClientID{1},
+                       .massCancel = {.serverClientID = 1,
+                                      .minPrice = 0,
+                                      .maxPrice = 0,
+                                      .instrumentID = 1,
+                                      .orderSide = client::MassCancelPayload::kBothSides}});
+
+    auto responses = collect(5);
+    ASSERT_EQ(responses.size(), 5);
+    EXPECT_EQ(responses[2].type, EngineResponseType::CANCEL_ACK);
+    EXPECT_EQ(responses[3].type, EngineResponseType::CANCEL_ACK);
+    EXPECT_EQ(responses[4].type, EngineResponseType::MASS_CANCEL_ACK);
+    EXPECT_EQ(responses[4].status, +status::CancelStatus::ACCEPTED);
+    EXPECT_EQ(responses[4].cancelledCount, 2);
+}
+
+TEST_F(EngineThreadTest, CancelAllIsNotAnswered) {
+    engineThread.start();
+    push(newOrder(ClientID{1}, OrderSide::BUY, 99, 10));
+    push(EngineRequest{.type = EngineRequestType::CANCEL_ALL, .sessionID = ClientID{1}});
+    push(cancel(ClientID{1}, OrderID{1}));
+
+    auto responses = collect(2);
+    ASSERT_EQ(responses.size(), 2);
+    EXPECT_EQ(responses[1].type, EngineResponseType::CANCEL_ACK);
+    EXPECT_EQ(responses[1].status, +status::CancelStatus::REJECTED);
+}
+
+TEST_F(EngineThreadTest, WaitsWhenTheResponseRingIsFull) {
+    engineThread.start();
+    // far more than both rings hold, the engine has to wait for the consumer
+    constexpr std::size_t kOrders = 1'000;
+    std::vector<EngineResponse> responses;
+    EngineResponse response;
+    for (std::size_t i = 0; i < kOrders; ++i) {
+        while (!engineThread.tryPush(newOrder(ClientID{1}, OrderSide::BUY, 50 + i % 40, 1))) {
+            while (engineThread.tryPop(response)) {
+                responses.push_back(response);
+            }
+        }
+    }
+    auto rest = collect(kOrders - responses.size());
+    responses.insert(responses.end(), rest.begin(), rest.end());
+
+    ASSERT_EQ(responses.size(), kOrders);
+    for (std::size_t i = 0; i < kOrders; ++i) {
+        EXPECT_EQ(responses[i].orderID, OrderID{i + 1});
+    }
+}
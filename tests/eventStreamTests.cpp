@@ -0,0 +1,235 @@
+#include "core/matchingEngine.hpp"
+#include "market-data/bookEvent.hpp"
+#include "market-data/eventObserver.hpp"
+#include "market-data/l3Observer.hpp"
+#include "market-data/observer.hpp"
+#include "utils/orderBuilder.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+
+#include "tests/observerTests.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+class EventStreamTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        constexpr std::size_t qCap = 1023;
+        rawMem_ = std::malloc(sizeof(utils::spsc_queue_shm<EngineEvent>) +
+                              sizeof(EngineEvent) * std::bit_ceil(qCap + 1));
+        if (!rawMem_) {
+            throw std::runtime_error("Malloc failed");
+        }
+        queue_ = new (rawMem_) utils::spsc_queue_shm<EngineEvent>(qCap);
+
+        engine = std::make_unique<MatchingEngine>(nullptr, nullptr, InstrumentID{1},
+                                                  EngineConfig{.eventQueue = queue_});
+        l2 = std::make_unique<market_data::Observer>(nullptr, nullptr, l2Book, l3Book,
+                                                     InstrumentID{1});
+        l3 = std::make_unique<market_data::L3Observer>(nullptr, nullptr, l3Book,
+                                                       InstrumentID{1});
+        events = std::make_unique<market_data::EventObserver>(
+            queue_, market_data::EventViews{.l2 = l2.get(),
+                                            .l2Queue = &l2Queue,
+                                            .l3 = l3.get(),
+                                            .l3Queue = &l3Queue,
+                                            .trades = &tradeQueue});
+    }
+
+    void TearDown() override {
+        events.reset();
+        engine.reset();
+        queue_->~spsc_queue_shm<EngineEvent>();
+        std::free(rawMem_);
+    }
+
+    OrderID submit(OrderSide side, Price price, Qty qty,
+                   ClientID clientID = ClientID{1}) {
+        const OrderID id = engine->getNextOrderID();
+        MatchResult result = engine->processOrder(OrderBuilder{}
+                                                      .withOrderID(id)
+                                                      .withSide(side)
+                                                      .withPrice(price)
+                                                      .withQty(qty)
+                                                      .withClientID(clientID)
+                                                      .build());
+        trades.insert(trades.end(), result.tradeVec.begin(), result.tradeVec.end());
+        ids_.push_back(id);
+        return id;
+    }
+
+    std::vector<EngineEvent> take() {
+        std::vector<EngineEvent> taken;
+        for (EngineEvent event{}; queue_->try_pop(event);) {
+            taken.push_back(event);
+        }
+        return taken;
+    }
+
+    // the L2 book against the engine's levels, the L3 book order by order
+    void checkViews() {
+        checkBooks(*engine, *l2);
+        std::size_t resting = 0;
+        for (OrderID id : ids_) {
+            const Order* order = engine->getOrder(id);
+            const Order* seen = l3->findOrder(id);
+            if (!order) {
+                EXPECT_EQ(seen, nullptr);
+                continue;
+            }
+            ++resting;
+            ASSERT_NE(seen, nullptr);
+            EXPECT_EQ(seen->qty, order->qty);
+        }
+        EXPECT_EQ(l3->orderCount(), resting);
+    }
+
+    std::unique_ptr<MatchingEngine> engine;
+    Level2OrderBook l2Book;
+    Level3OrderBook l3Book;
+    std::unique_ptr<market_data::Observer> l2;
+    std::unique_ptr<market_data::L3Observer> l3;
+    utils::spsc_queue<L2OrderBookUpdate> l2Queue{8192};
+    utils::spsc_queue<L3Update> l3Queue{8192};
+    utils::spsc_queue<EngineEvent> tradeQueue{8192};
+    std::unique_ptr<market_data::EventObserver> events;
+    std::vector<TradeEvent> trades;
+    std::vector<OrderID> ids_;
+
+private:
+    void* rawMem_ = nullptr;
+    utils::spsc_queue_shm<EngineEvent>* queue_ = nullptr;
+};
+
+TEST_F(EventStreamTest, OneSequencedRecordPerBookChangeAndTrade) {
+    const OrderID first = submit(OrderSide::SELL, Price{100}, Qty{10});
+    const OrderID second = submit(OrderSide::SELL, Price{101}, Qty{10});
+    const OrderID buy = submit(OrderSide::BUY, Price{101}, Qty{25}, ClientID{2});
+    ASSERT_TRUE(engine->cancelOrder(ClientID{2}, buy));
+
+    const std::vector<EngineEvent> stream = take();
+    ASSERT_EQ(stream.size(), 6u);
+    for (std::size_t i = 0; i < stream.size(); ++i) {
+        EXPECT_EQ(stream[i].sequence, i + 1);
+        EXPECT_EQ(stream[i].instrumentID, InstrumentID{1});
+    }
+    EXPECT_EQ(engine->getEventSequence(), 6u);
+
+    EXPECT_EQ(stream[0].type, EngineEventType::ORDER_ADDED);
+    EXPECT_EQ(stream[1].type, EngineEventType::ORDER_ADDED);
+
+    // one record per fill, carrying the trade id the session saw
+    ASSERT_EQ(trades.size(), 2u);
+    EXPECT_EQ(stream[2].type, EngineEventType::TRADE);
+    EXPECT_EQ(stream[2].orderID, first);
+    EXPECT_EQ(stream[2].aggressorOrderID, buy);
+    EXPECT_EQ(stream[2].tradeID, trades[0].tradeID);
+    EXPECT_EQ(stream[2].side, OrderSide::SELL);
+    EXPECT_EQ(stream[3].type, EngineEventType::TRADE);
+    EXPECT_EQ(stream[3].orderID, second);
+    EXPECT_EQ(stream[3].price, Price{101});
+    EXPECT_EQ(stream[3].tradeID, trades[1].tradeID);
+
+    // the rest of the buy rests and is cancelled
+    EXPECT_EQ(stream[4].type, EngineEventType::ORDER_ADDED);
+    EXPECT_EQ(stream[4].qty, Qty{5});
+    EXPECT_EQ(stream[5].type, EngineEventType::ORDER_REDUCED);
+    EXPECT_EQ(stream[5].orderID, buy);
+    EXPECT_EQ(stream[5].qty, Qty{5});
+}
+
+TEST_F(EventStreamTest, MassCancelPublishesOneL2UpdatePerLevel) {
+    for (int i = 0; i < 3; ++i) {
+        submit(OrderSide::BUY, Price{100}, Qty{10});
+    }
+    submit(OrderSide::BUY, Price{99}, Qty{5});
+    submit(OrderSide::BUY, Price{99}, Qty{5});
+    submit(OrderSide::SELL, Price{105}, Qty{7});
+    submit(OrderSide::BUY, Price{100}, Qty{4}, ClientID{2});
+    events->drainQueue();
+    for (L2OrderBookUpdate update{}; l2Queue.try_pop(update);) {
+    }
+    for (L3Update update{}; l3Queue.try_pop(update);) {
+    }
+
+    ASSERT_EQ(engine->massCancel(ClientID{1}), 6u);
+    const std::uint64_t before = events->lastSequence();
+    events->drainQueue();
+    EXPECT_EQ(events->lastSequence() - before, 9u);
+
+    std::vector<L2OrderBookUpdate> levels;
+    for (L2OrderBookUpdate update{}; l2Queue.try_pop(update);) {
+        levels.push_back(update);
+    }
+    ASSERT_EQ(levels.size(), 3u);
+    for (const L2OrderBookUpdate& level : levels) {
+        EXPECT_EQ(level.type, BookUpdateEventType::REDUCE);
+        EXPECT_EQ(level.amount, level.price == Price{100}  ? Qty{30}
+                                : level.price == Price{99} ? Qty{10}
+                                                           : Qty{7});
+    }
+
+    std::size_t orders = 0;
+    for (L3Update update{}; l3Queue.try_pop(update); ++orders) {
+        EXPECT_NE(update.orderID, OrderID{0});
+    }
+    EXPECT_EQ(orders, 6u);
+
+    checkViews();
+    EXPECT_EQ(l2Book.qtyAt(OrderSide::BUY, Price{100}), Qty{4});
+    EXPECT_EQ(events->gapCount(), 0u);
+}
+
+TEST_F(EventStreamTest, DerivedViewsFollowTheEngine) {
+    std::uint64_t state = 42;
+    auto next = [&state](std::uint64_t bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (state >> 33) % bound;
+    };
+
+    std::vector<OrderID> live;
+    for (int i = 0; i < 3000; ++i) {
+        const std::uint64_t action = next(10);
+        const ClientID client{1 + next(4)};
+        if (action < 6 || live.empty()) {
+            const bool buy = next(2) == 0;
+            const Price price{buy ? 95 + next(10) : 100 + next(10)};
+            live.push_back(submit(buy ? OrderSide::BUY : OrderSide::SELL, price,
+                                  Qty{1 + next(20)}, client));
+        } else if (action < 8) {
+            const OrderID id = live[next(live.size())];
+            if (const Order* order = engine->getOrder(id)) {
+                engine->cancelOrder(order->clientID, id);
+            }
+        } else if (action < 9) {
+            const OrderID id = live[next(live.size())];
+            if (const Order* order = engine->getOrder(id)) {
+                const ModifyResult modified = engine->modifyOrder(
+                    order->clientID, id, Qty{1 + next(order->qty.value())},
+                    Price{order->price.value() + next(3) - 1});
+                ids_.push_back(modified.newOrderID);
+                live.push_back(modified.newOrderID);
+            }
+        } else {
+            engine->massCancel(client);
+        }
+        events->drainQueue();
+    }
+
+    checkViews();
+    EXPECT_EQ(events->gapCount(), 0u);
+    EXPECT_EQ(events->lastSequence(), engine->getEventSequence());
+
+    std::size_t tradeRecords = 0;
+    for (EngineEvent trade{}; tradeQueue.try_pop(trade); ++tradeRecords) {
+        EXPECT_EQ(trade.type, EngineEventType::TRADE);
+    }
+    EXPECT_GT(tradeRecords, 0u);
+}
@@ -0,0 +1,141 @@
+#include "utils/flatIndex.hpp"
+#include "utils/types.hpp"
+
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Entry {
+    std::uint64_t id;
+};
+
+using Index = utils::FlatIndex<OrderID, Entry>;
+
+} // namespace
+
+TEST(FlatIndexTest, InsertFindErase) {
+    Index index(8);
+    Entry a{1}, b{2};
+
+    index.insert(OrderID{1}, &a);
+    index.insert(OrderID{2}, &b);
+
+    EXPECT_EQ(index.size(), 2);
+    EXPECT_EQ(index.find(OrderID{1}), &a);
+    EXPECT_EQ(index.find(OrderID{2}), &b);
+    EXPECT_EQ(index.find(OrderID{3}), nullptr);
+
+    EXPECT_TRUE(index.erase(OrderID{1}));
+    EXPECT_FALSE(index.erase(OrderID{1}));
+    EXPECT_EQ(index.find(OrderID{1}), nullptr);
+    EXPECT_EQ(index.find(OrderID{2}), &b);
+    EXPECT_EQ(index.size(), 1);
+}
+
+TEST(FlatIndexTest, InsertOverwrites) {
+    Index index(8);
+    Entry a{1}, b{2};
+
+    index.insert(OrderID{5}, &a);
+    index.insert(OrderID{5}, &b);
+
+    EXPECT_EQ(index.size(), 1);
+    EXPECT_EQ(index.find(OrderID{5}), &b);
+}
+
+TEST(FlatIndexTest, EraseInsideClusterKeepsOthersReachable) {
+    Index index(16);
+    std::vector<Entry> entries(4);
+
+    // 3, 19 and 35 share home slot 3, 4 is displaced behind them
+    index.insert(OrderID{3}, &entries[0]);
+    index.insert(OrderID{19}, &entries[1]);
+    index.insert(OrderID{35}, &entries[2]);
+    index.insert(OrderID{4}, &entries[3]);
+    EXPECT_EQ(index.stats().maxProbe, 2);
+
+    EXPECT_TRUE(index.erase(OrderID{19}));
+    EXPECT_EQ(index.find(OrderID{3}), &entries[0]);
+    EXPECT_EQ(index.find(OrderID{35}), &entries[2]);
+    EXPECT_EQ(index.find(OrderID{4}), &entries[3]);
+
+    EXPECT_TRUE(index.erase(OrderID{3}));
+    EXPECT_EQ(index.find(OrderID{35}), &entries[2]);
+    EXPECT_EQ(index.find(OrderID{4}), &entries[3]);
+    // both survivors were shifted back into their home slots
+    EXPECT_EQ(index.stats().maxProbe, 0);
+}
+
+TEST(FlatIndexTest, WrapsAroundTheEnd) {
+    Index index(8);
+    std::vector<Entry> entries(3);
+
+    index.insert(OrderID{7}, &entries[0]);
+    index.insert(OrderID{15}, &entries[1]); // wraps to slot 0
+    index.insert(OrderID{0}, &entries[2]);  // pushed to slot 1
+
+    EXPECT_TRUE(index.erase(OrderID{7}));
+    EXPECT_EQ(index.find(OrderID{15}), &entries[1]);
+    EXPECT_EQ(index.find(OrderID{0}), &entries[2]);
+    EXPECT_EQ(index.stats().maxProbe, 0);
+}
+
+TEST(FlatIndexTest, GrowsPastMaxLoad) {
+    Index index(8);
+    std::vector<Entry> entries(100);
+
+    for (std::uint64_t i = 0; i < entries.size(); ++i) {
+        index.insert(OrderID{i + 1}, &entries[i]);
+    }
+
+    EXPECT_EQ(index.size(), 100);
+    EXPECT_LE(index.loadFactor(), 0.7);
+    for (std::uint64_t i = 0; i < entries.size(); ++i) {
+        EXPECT_EQ(index.find(OrderID{i + 1}), &entries[i]);
+    }
+}
+
+TEST(FlatIndexTest, SlidingWindowHasNoCollisions) {
+    Index index(1024);
+    std::vector<Entry> entries(500);
+
+    for (std::uint64_t id = 1; id <= 10'000; ++id) {
+        index.insert(OrderID{id}, &entries[id % entries.size()]);
+        if (id > entries.size()) {
+            index.erase(OrderID{id - entries.size()});
+        }
+    }
+
+    auto stats = index.stats();
+    EXPECT_EQ(stats.size, 500);
+    EXPECT_EQ(stats.capacity, 1024);
+    EXPECT_EQ(stats.maxProbe, 0);
+}
+
+TEST(FlatIndexTest, MatchesUnorderedMapUnderRandomOps) {
+    Index index(8);
+    std::unordered_map<std::uint64_t, Entry*> reference;
+    std::vector<Entry> entries(64);
+
+    std::mt19937_64 rng(3);
+    for (int step = 0; step < 20'000; ++step) {
+        std::uint64_t key = rng() % 256;
+        if (rng() % 3 == 0) {
+            EXPECT_EQ(index.erase(OrderID{key}), reference.erase(key) == 1);
+        } else {
+            Entry* value = &entries[rng() % entries.size()];
+            index.insert(OrderID{key}, value);
+            reference[key] = value;
+        }
+    }
+
+    EXPECT_EQ(index.size(), reference.size());
+    for (std::uint64_t key = 0; key < 256; ++key) {
+        auto it = reference.find(key);
+        EXPECT_EQ(index.find(OrderID{key}), it == reference.end() ? nullptr : it->second);
+    }
+}
@@ -0,0 +1,278 @@
+#include "api/api.hpp"
+#include "core/instrumentDirectory.hpp"
+#include "core/matchingEngine.hpp"
+#include "protocol/clientMessages.hpp"
+#include "sessions/sessionManager.hpp"
+#include "utils/types.hpp"
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+InstrumentDirectory parse(const char* text) {
+    std::istringstream in(text);
+    return InstrumentDirectory::parse(in);
+}
+
+client::NewOrderPayload newOrder(std::uint32_t instrumentID, OrderSide side,
+                                 std::uint64_t price, std::uint64_t qty) {
+    client::NewOrderPayload payload{};
+    payload.serverClientID = side == OrderSide::BUY ? 1 : 2;
+    payload.instrumentID = instrumentID;
+    payload.orderSide = +side;
+    payload.orderType = +OrderType::LIMIT;
+    payload.timeInForce = +TimeInForce::GOOD_TILL_CANCELLED;
+    payload.qty = qty;
+    payload.price = price;
+    return payload;
+}
+
+} // namespace
+
+TEST(InstrumentDirectoryTest, ParsesInstruments) {
+    const InstrumentDirectory directory = parse("# id,symbol,tick,min,max,reference\n"
+                                                "1,AAPL,5,100,100000,18000\n"
+                                                "\n"
+                                                "7, MSFT , 1, 0, 0\n");
+
+    ASSERT_EQ(directory.size(), 2u);
+    const InstrumentSpec* aapl = directory.find(InstrumentID{1});
+    ASSERT_NE(aapl, nullptr);
+    EXPECT_EQ(aapl->symbol, "AAPL");
+    EXPECT_EQ(aapl->prices.tickSize, 5u);
+    EXPECT_EQ(aapl->prices.minPrice, 100u);
+    EXPECT_EQ(aapl->prices.maxPrice, 100'000u);
+    EXPECT_EQ(aapl->referencePrice, 18'000u);
+
+    EXPECT_EQ(directory.find("MSFT"), directory.find(InstrumentID{7}));
+    EXPECT_EQ(directory.find(InstrumentID{2}), nullptr);
+    EXPECT_EQ(directory.find(InstrumentID{1'000'000}), nullptr);
+    EXPECT_EQ(directory.find("GOOG"), nullptr);
+}
+
+TEST(InstrumentDirectoryTest, GivesEveryInstrumentMarketDataPortsOfItsOwn) {
+    const InstrumentDirectory directory = parse("1,AAPL,1,0,0\n"
+                                                "2,MSFT,1,0,0,0,9101\n"
+                                                "3,IBM,1,0,0\n");
+
+    const InstrumentSpec* aapl = directory.find(InstrumentID{1});
+    EXPECT_EQ(aapl->l2Port(), InstrumentDirectory::kFirstMarketDataPort);
+    EXPECT_EQ(aapl->l3Port(), 9002);
+    EXPECT_EQ(aapl->conflatedPort(), 9003);
+    EXPECT_EQ(directory.find(InstrumentID{2})->l2Port(), 9101);
+    // after the highest ports taken so far
+    EXPECT_EQ(directory.find(InstrumentID{3})->l2Port(), 9104);
+
+    EXPECT_THROW(parse("1,AAPL,1,0,0\n2,MSFT,1,0,0,0,9002\n"), std::runtime_error);
+    EXPECT_THROW(parse("1,AAPL,1,0,0,0,0\n"), std::runtime_error);
+    EXPECT_THROW(parse("1,AAPL,1,0,0,0,65534\n"), std::runtime_error);
+}
+
+TEST(InstrumentDirectoryTest, SizesOrderPoolsPerInstrument) {
+    const InstrumentDirectory directory = parse("1,AAPL,1,0,0\n"
+                                                "2,MSFT,1,0,0,0,,5000\n");
+
+    const EngineConfig defaults{};
+    const EngineConfig aapl =
+        InstrumentDirectory::engineConfig(*directory.find(InstrumentID{1}));
+    EXPECT_EQ(aapl.orderPool.initialCapacity, defaults.orderPool.initialCapacity);
+    EXPECT_EQ(aapl.orderMapCapacity, defaults.orderMapCapacity);
+
+    const InstrumentSpec* msft = directory.find(InstrumentID{2});
+    EXPECT_EQ(msft->orderCapacity, 5000u);
+    EXPECT_EQ(msft->l2Port(), 9004);
+    const EngineConfig config = InstrumentDirectory::engineConfig(*msft);
+    EXPECT_EQ(config.orderPool.initialCapacity, 5000u);
+    // room for all of them below the index's 70% load limit
+    EXPECT_GE(config.orderMapCapacity * 7, 5000u * 10);
+
+    MatchingEngine engine(nullptr, nullptr, msft->id, config);
+    EXPECT_EQ(engine.getOrderPoolStats().capacity, 5000u);
+    EXPECT_GE(engine.getOrderMapStats().capacity, config.orderMapCapacity);
+
+    EXPECT_THROW(parse("1,AAPL,1,0,0,0,9101,x\n"), std::runtime_error);
+    EXPECT_THROW(parse("1,AAPL,1,0,0,0,9101,5000,1\n"), std::runtime_error);
+}
+
+TEST(InstrumentDirectoryTest, RejectsMalformedLines) {
+    EXPECT_THROW(parse("1,AAPL,5,100\n"), std::runtime_error);
+    EXPECT_THROW(parse("1,AAPL,x,100,200\n"), std::runtime_error);
+    EXPECT_THROW(parse("0,AAPL,1,0,0\n"), std::runtime_error);
+    EXPECT_THROW(parse("70000,AAPL,1,0,0\n"), std::runtime_error);
+    EXPECT_THROW(parse("1,AAPL,0,0,0\n"), std::runtime_error);
+    EXPECT_THROW(parse("1,AAPL,1,0,0\n1,MSFT,1,0,0\n"), std::runtime_error);
+    EXPECT_THROW(parse("1,AAPL,1,0,0\n2,AAPL,1,0,0\n"), std::runtime_error);
+
+    try {
+        parse("1,AAPL,1,0,0\n\n3,IBM,1,0\n");
+        FAIL() << "expected a parse error";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("line 3"), std::string::npos) << e.what();
+    }
+}
+
+TEST(InstrumentDirectoryTest, EnforcesTickSizeAndPriceBand) {
+    const InstrumentDirectory directory = parse("1,AAPL,5,100,200\n");
+    const InstrumentSpec& spec = *directory.find(InstrumentID{1});
+    MatchingEngine engine(nullptr, nullptr, spec.id,
+                          InstrumentDirectory::engineConfig(spec));
+    SessionManager sessions;
+    MiniExchangeAPI api(engine, sessions);
+
+    EXPECT_EQ(api.processNewOrder(newOrder(1, OrderSide::BUY, 103, 1)).status,
+              OrderStatus::REJECTED);
+    EXPECT_EQ(api.processNewOrder(newOrder(1, OrderSide::BUY, 95, 1)).status,
+              OrderStatus::REJECTED);
+    EXPECT_EQ(api.processNewOrder(newOrder(1, OrderSide::BUY, 205, 1)).status,
+              OrderStatus::REJECTED);
+
+    const MatchResult accepted = api.processNewOrder(newOrder(1, OrderSide::BUY, 150, 1));
+    EXPECT_EQ(accepted.status, OrderStatus::NEW);
+
+    // a modify has to land on the grid and inside the band as well
+    client::ModifyOrderPayload modify{};
+    modify.serverClientID = 1;
+    modify.serverOrderID = accepted.orderID.value();
+    modify.instrumentID = 1;
+    modify.newQty = 1;
+    modify.newPrice = 152;
+    EXPECT_EQ(api.modifyOrder(modify).status, ModifyStatus::INVALID);
+    modify.newPrice = 155;
+    EXPECT_EQ(api.modifyOrder(modify).status, ModifyStatus::ACCEPTED);
+}
+
+TEST(InstrumentDirectoryTest, BookWindowSpansTicksOfTheTickSize) {
+    const InstrumentDirectory directory = parse("1,AAPL,5,100,100000,18000\n");
+    const EngineConfig config =
+        InstrumentDirectory::engineConfig(*directory.find(InstrumentID{1}));
+    EXPECT_EQ(config.book.tickSize, 5u);
+
+    // 4096 ticks of 5 reach 10'000 either side of the reference price
+    Level2OrderBook book(config.book);
+    for (std::uint64_t price = 18'005; price <= 28'000; price += 995) {
+        book.add(OrderSide::SELL, Price{price}, Qty{1});
+        book.add(OrderSide::BUY, Price{36'000 - price}, Qty{1});
+    }
+    EXPECT_EQ(book.levelCount(OrderSide::SELL), 11u);
+    EXPECT_EQ(book.depth(OrderSide::BUY, 1).front().first, Price{17'995});
+#ifndef MINIEXCHANGE_MAP_BOOK
+    EXPECT_EQ(book.asks.overflowSize(), 0u);
+    EXPECT_EQ(book.bids.overflowSize(), 0u);
+#endif
+}
+
+TEST(InstrumentDirectoryTest, RoutesOrdersByInstrument) {
+    MatchingEngine first(nullptr, nullptr, InstrumentID{1});
+    MatchingEngine second(nullptr, nullptr, InstrumentID{2});
+    const std::vector<MatchingEngine*> engines{&first, &second};
+    SessionManager sessions;
+    MiniExchangeAPI api(engines, sessions);
+
+    EXPECT_EQ(api.getEngine(InstrumentID{2}), &second);
+    EXPECT_EQ(api.getEngine(InstrumentID{3}), nullptr);
+
+    ASSERT_EQ(api.processNewOrder(newOrder(1, OrderSide::BUY, 100, 5)).status,
+              OrderStatus::NEW);
+    // the same price on another instrument does not cross
+    ASSERT_EQ(api.processNewOrder(newOrder(2, OrderSide::SELL, 100, 5)).status,
+              OrderStatus::NEW);
+    EXPECT_TRUE(api.getTrades().empty());
+
+    EXPECT_EQ(api.processNewOrder(newOrder(3, OrderSide::BUY, 100, 5)).status,
+              OrderStatus::REJECTED);
+
+    const MatchResult fill = api.processNewOrder(newOrder(1, OrderSide::SELL, 100, 5));
+    EXPECT_EQ(fill.status, OrderStatus::FILLED);
+    ASSERT_EQ(api.getTrades().size(), 1u);
+    EXPECT_EQ(api.getTrades()[0].instrumentID, InstrumentID{1});
+}
+
+TEST(InstrumentDirectoryTest, BatchSplitsByInstrument) {
+    MatchingEngine first(nullptr, nullptr, InstrumentID{1});
+    MatchingEngine second(nullptr, nullptr, InstrumentID{2});
+    const std::vector<MatchingEngine*> engines{&first, &second};
+    SessionManager sessions;
+    MiniExchangeAPI api(engines, sessions);
+
+    const std::vector<OrderCommand> commands{
+        MiniExchangeAPI::makeCommand(newOrder(1, OrderSide::BUY, 100, 5)),
+        MiniExchangeAPI::makeCommand(newOrder(1, OrderSide::SELL, 100, 2)),
+        MiniExchangeAPI::makeCommand(newOrder(9, OrderSide::BUY, 100, 5)),
+        MiniExchangeAPI::makeCommand(newOrder(2, OrderSide::BUY, 50, 3)),
+        MiniExchangeAPI::makeCommand(newOrder(2, OrderSide::SELL, 50, 3)),
+    };
+    std::vector<CommandResult> results(commands.size());
+
+    ASSERT_EQ(api.processBatch(commands, results), commands.size());
+    EXPECT_EQ(results[0].match.status, OrderStatus::NEW);
+    EXPECT_EQ(results[1].match.status, OrderStatus::FILLED);
+    EXPECT_EQ(results[2].match.status, OrderStatus::REJECTED);
+    EXPECT_EQ(results[4].match.status, OrderStatus::FILLED);
+
+    // the trade ranges index the trades of the whole batch
+    const auto trades = api.getTrades();
+    ASSERT_EQ(trades.size(), 2u);
+    EXPECT_EQ(results[1].tradeEnd, 1u);
+    EXPECT_EQ(results[2].tradeEnd, 1u);
+    EXPECT_EQ(results[3].tradeEnd, 1u);
+    EXPECT_EQ(results[4].tradeEnd, 2u);
+    EXPECT_EQ(trades[0].instrumentID, InstrumentID{1});
+    EXPECT_EQ(trades[1].instrumentID, InstrumentID{2});
+    EXPECT_EQ(trades[1].qty, Qty{3});
+}
+
+TEST(InstrumentDirectoryTest, ExpiriesShareOneBudgetAcrossEngines) {
+    constexpr Timestamp kEndOfDay = 50'000;
+    const EngineConfig config{
+        .expiry = {.tickNs = 10, .endOfDay = kEndOfDay, .budget = {}}};
+    std::vector<std::unique_ptr<MatchingEngine>> owned;
+    std::vector<MatchingEngine*> engines;
+    for (std::uint32_t id = 1; id <= 3; ++id) {
+        owned.push_back(
+            std::make_unique<MatchingEngine>(nullptr, nullptr, InstrumentID{id}, config));
+        engines.push_back(owned.back().get());
+    }
+    SessionManager sessions;
+    MiniExchangeAPI api(engines, sessions);
+
+    constexpr std::size_t kOrdersPerEngine = 100;
+    for (std::uint32_t id = 1; id <= 3; ++id) {
+        for (std::size_t i = 0; i < kOrdersPerEngine; ++i) {
+            client::NewOrderPayload order = newOrder(id, OrderSide::BUY, 100, 1);
+            order.timeInForce = +TimeInForce::END_OF_DAY;
+            ASSERT_EQ(api.processNewOrder(order).status, OrderStatus::NEW);
+        }
+    }
+
+    // with no budget a call expires one batch of one engine, the next call picks up
+    // where it stopped
+    std::vector<std::uint32_t> order;
+    std::size_t total = 0;
+    while (api.hasPendingExpiries(kEndOfDay)) {
+        std::vector<std::uint32_t> instruments;
+        const std::size_t expired = api.expireOrders(kEndOfDay, [&](const Order& o) {
+            instruments.push_back(o.instrumentID.value());
+        });
+        total += expired;
+        if (instruments.empty()) {
+            continue;
+        }
+        EXPECT_LE(expired, 64u);
+        EXPECT_TRUE(std::ranges::all_of(
+            instruments, [&](std::uint32_t id) { return id == instruments.front(); }));
+        order.push_back(instruments.front());
+    }
+
+    EXPECT_EQ(total, 3 * kOrdersPerEngine);
+    EXPECT_TRUE(std::ranges::is_sorted(order));
+    EXPECT_EQ(order.front(), 1u);
+    EXPECT_EQ(order.back(), 3u);
+}
@@ -0,0 +1,198 @@
+#include "client/mboBook.hpp"
+#include "client/mdReceiver.hpp"
+#include "core/matchingEngine.hpp"
+#include "market-data/bookEvent.hpp"
+#include "market-data/l3Observer.hpp"
+#include "market-data/l3Publisher.hpp"
+#include "utils/orderBuilder.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::uint16_t kTestPort = 9102;
+
+} // namespace
+
+// engine -> L3 ring -> L3Observer -> L3Publisher -> loopback multicast -> MDReceiver
+class L3FeedTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        try {
+            receiver = std::make_unique<MDReceiver>(MDConfig{.port = kTestPort});
+            receiver->initialize();
+            publisher = std::make_unique<market_data::L3Publisher>(
+                &mdQueue, utils::PriceLadderConfig{}, InstrumentID{1},
+                market_data::L3PublisherConfig{.transport = {.port = kTestPort}});
+        } catch (const std::exception& e) {
+            GTEST_SKIP() << "no loopback multicast: " << e.what();
+        }
+
+        constexpr std::size_t qCap = 1023;
+        rawMem_ = std::malloc(sizeof(utils::spsc_queue_shm<L3Update>) +
+                              sizeof(L3Update) * std::bit_ceil(qCap + 1));
+        if (!rawMem_) {
+            throw std::runtime_error("Malloc failed");
+        }
+        queue_ = new (rawMem_) utils::spsc_queue_shm<L3Update>(qCap);
+
+        engine = std::make_unique<MatchingEngine>(nullptr, queue_, InstrumentID{1});
+        observer = std::make_unique<market_data::L3Observer>(queue_, &mdQueue, book,
+                                                             InstrumentID{1});
+    }
+
+    void TearDown() override {
+        observer.reset();
+        engine.reset();
+        if (queue_) {
+            queue_->~spsc_queue_shm<L3Update>();
+            std::free(rawMem_);
+        }
+    }
+
+    // moves the pending updates through the pipeline and reads the datagrams they
+    // turned into, a little at a time so the socket buffer never overflows
+    void pump() {
+        observer->drainQueue();
+        const std::size_t sent = publisher->publishDelta();
+        receiveAll_(sent);
+    }
+
+    void snapshot() {
+        const std::size_t parts =
+            book.orderMap.size() / OrderSnapshotHeader::traits::MAX_ORDERS_PER_PART + 1;
+        publisher->publishSnapshot();
+        receiveAll_(parts);
+    }
+
+    OrderID submit(OrderSide side, Price price, Qty qty,
+                   ClientID clientID = ClientID{1}) {
+        auto result = engine->processOrder(OrderBuilder{}
+                                               .withOrderID(engine->getNextOrderID())
+                                               .withSide(side)
+                                               .withPrice(price)
+                                               .withQty(qty)
+                                               .withClientID(clientID)
+                                               .build());
+        pump();
+        ids_.push_back(result.orderID);
+        return result.orderID;
+    }
+
+    // the receiver's book matches the engine order by order, queue position included
+    void checkBooks() {
+        const MBOBook& received = receiver->getMBOBook();
+        std::size_t resting = 0;
+        for (OrderID id : ids_) {
+            const Order* order = engine->getOrder(id);
+            const MBOBook::Entry* seen = received.find(id);
+            if (!order) {
+                EXPECT_EQ(seen, nullptr);
+                continue;
+            }
+            ++resting;
+            ASSERT_NE(seen, nullptr);
+            EXPECT_EQ(seen->qty, order->qty);
+            EXPECT_EQ(seen->price, order->price);
+            EXPECT_EQ(seen->side, order->side);
+            EXPECT_EQ(received.qtyAhead(id), observer->qtyAhead(id));
+        }
+        EXPECT_EQ(received.orderCount(), resting);
+    }
+
+    std::unique_ptr<MDReceiver> receiver;
+    std::unique_ptr<market_data::L3Publisher> publisher;
+    utils::spsc_queue<L3Update> mdQueue{4096};
+    Level3OrderBook book;
+    std::unique_ptr<MatchingEngine> engine;
+    std::unique_ptr<market_data::L3Observer> observer;
+    std::vector<OrderID> ids_;
+
+private:
+    void receiveAll_(std::size_t datagrams) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (datagrams > 0 && std::chrono::steady_clock::now() < deadline) {
+            if (receiver->receiveOne()) {
+                --datagrams;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        ASSERT_EQ(datagrams, 0u) << "datagrams did not arrive";
+    }
+
+    void* rawMem_ = nullptr;
+    utils::spsc_queue_shm<L3Update>* queue_ = nullptr;
+};
+
+TEST_F(L3FeedTest, ReceiverRebuildsTheBookFromSnapshotAndDeltas) {
+    submit(OrderSide::BUY, Price{100}, Qty{10});
+    submit(OrderSide::SELL, Price{105}, Qty{7});
+    EXPECT_FALSE(receiver->isMBOBookValid());
+
+    snapshot();
+    ASSERT_TRUE(receiver->isMBOBookValid());
+    checkBooks();
+
+    const OrderID queued = submit(OrderSide::BUY, Price{100}, Qty{20});
+    const OrderID deeper = submit(OrderSide::BUY, Price{99}, Qty{5});
+    submit(OrderSide::SELL, Price{100}, Qty{15}, ClientID{2});
+    checkBooks();
+    EXPECT_EQ(receiver->getMBOBook().find(queued)->qty, Qty{15});
+
+    ASSERT_TRUE(engine->cancelOrder(ClientID{1}, deeper));
+    const ModifyResult moved =
+        engine->modifyOrder(ClientID{1}, queued, Qty{30}, Price{101});
+    pump();
+    ids_.push_back(moved.newOrderID);
+    checkBooks();
+    EXPECT_EQ(receiver->getMBOBook().levelQty(OrderSide::BUY, Price{101}), Qty{30});
+    EXPECT_EQ(receiver->getMBOBook().levelQty(OrderSide::BUY, Price{99}), Qty{0});
+}
+
+TEST_F(L3FeedTest, SnapshotSpansSeveralParts) {
+    for (std::uint64_t i = 0; i < 1500; ++i) {
+        submit(i % 2 == 0 ? OrderSide::BUY : OrderSide::SELL,
+               Price{i % 2 == 0 ? 100 - i % 20 : 101 + i % 20}, Qty{1 + i % 3});
+    }
+    EXPECT_FALSE(receiver->isMBOBookValid());
+
+    std::size_t snapshots = 0;
+    receiver->setOnOrderSnapshot(
+        [&snapshots](const MBOBook&, std::uint64_t) { ++snapshots; });
+    snapshot();
+    ASSERT_TRUE(receiver->isMBOBookValid());
+    EXPECT_EQ(snapshots, 1u);
+    EXPECT_EQ(receiver->getMBOBook().orderCount(), 1500u);
+    checkBooks();
+}
+
+TEST(MBOBookTest, IncreaseMovesTheOrderToTheBack) {
+    MBOBook book;
+    book.add(OrderID{1}, Price{50}, Qty{10}, OrderSide::SELL);
+    book.add(OrderID{2}, Price{50}, Qty{20}, OrderSide::SELL);
+    EXPECT_EQ(book.qtyAhead(OrderID{2}), Qty{10});
+
+    book.add(OrderID{1}, Price{50}, Qty{5}, OrderSide::SELL);
+    EXPECT_EQ(book.find(OrderID{1})->qty, Qty{15});
+    EXPECT_EQ(book.qtyAhead(OrderID{1}), Qty{20});
+    EXPECT_EQ(book.qtyAhead(OrderID{2}), Qty{0});
+
+    book.reduce(OrderID{2}, Qty{20});
+    EXPECT_EQ(book.find(OrderID{2}), nullptr);
+    book.cancel(OrderID{1});
+    EXPECT_EQ(book.orderCount(), 0u);
+    EXPECT_TRUE(book.asks().empty());
+}
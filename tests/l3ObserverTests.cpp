@@ -0,0 +1,143 @@
+#include "core/matchingEngine.hpp"
+#include "market-data/bookEvent.hpp"
+#include "market-data/l3Observer.hpp"
+#include "utils/orderBuilder.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+class L3ObserverTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        constexpr std::size_t qCap = 1023;
+        rawMem_ = std::malloc(sizeof(utils::spsc_queue_shm<L3Update>) +
+                              sizeof(L3Update) * std::bit_ceil(qCap + 1));
+        if (!rawMem_) {
+            throw std::runtime_error("Malloc failed");
+        }
+        queue_ = new (rawMem_) utils::spsc_queue_shm<L3Update>(qCap);
+
+        engine = std::make_unique<MatchingEngine>(nullptr, queue_, InstrumentID{1});
+        observer = std::make_unique<market_data::L3Observer>(queue_, &mdQueue, book,
+                                                             InstrumentID{1});
+    }
+
+    void TearDown() override {
+        observer.reset();
+        engine.reset();
+        queue_->~spsc_queue_shm<L3Update>();
+        std::free(rawMem_);
+    }
+
+    OrderID submit(OrderSide side, Price price, Qty qty,
+                   ClientID clientID = ClientID{1}) {
+        auto result = engine->processOrder(OrderBuilder{}
+                                               .withOrderID(engine->getNextOrderID())
+                                               .withSide(side)
+                                               .withPrice(price)
+                                               .withQty(qty)
+                                               .withClientID(clientID)
+                                               .build());
+        observer->drainQueue();
+        ids_.push_back(result.orderID);
+        return result.orderID;
+    }
+
+    // every order the engine still rests is in the observer's book with the same qty
+    void checkBooks() {
+        std::size_t resting = 0;
+        for (OrderID id : ids_) {
+            const Order* order = engine->getOrder(id);
+            const Order* seen = observer->findOrder(id);
+            if (!order) {
+                EXPECT_EQ(seen, nullptr);
+                continue;
+            }
+            ++resting;
+            ASSERT_NE(seen, nullptr);
+            EXPECT_EQ(seen->qty, order->qty);
+            EXPECT_EQ(seen->price, order->price);
+            EXPECT_EQ(seen->side, order->side);
+        }
+        EXPECT_EQ(observer->orderCount(), resting);
+    }
+
+    std::vector<OrderID> ids_;
+    void* rawMem_ = nullptr;
+    utils::spsc_queue_shm<L3Update>* queue_ = nullptr;
+    utils::spsc_queue<L3Update> mdQueue{4096};
+    Level3OrderBook book;
+    std::unique_ptr<MatchingEngine> engine;
+    std::unique_ptr<market_data::L3Observer> observer;
+};
+
+TEST_F(L3ObserverTest, TracksAddsFillsAndCancels) {
+    const OrderID first = submit(OrderSide::BUY, Price{100}, Qty{10});
+    const OrderID second = submit(OrderSide::BUY, Price{100}, Qty{20});
+    const OrderID third = submit(OrderSide::BUY, Price{99}, Qty{5});
+    checkBooks();
+    EXPECT_EQ(observer->qtyAhead(first), Qty{0});
+    EXPECT_EQ(observer->qtyAhead(second), Qty{10});
+
+    // fills all of the first order and part of the second
+    submit(OrderSide::SELL, Price{100}, Qty{15}, ClientID{2});
+    checkBooks();
+    EXPECT_EQ(observer->findOrder(first), nullptr);
+    EXPECT_EQ(observer->findOrder(second)->qty, Qty{15});
+    EXPECT_EQ(observer->qtyAhead(second), Qty{0});
+
+    ASSERT_TRUE(engine->cancelOrder(ClientID{1}, third));
+    observer->drainQueue();
+    checkBooks();
+    EXPECT_EQ(observer->findOrder(third), nullptr);
+    EXPECT_EQ(observer->qtyAhead(third), std::nullopt);
+    EXPECT_TRUE(book.bids.find(Price{99}) == book.bids.end());
+}
+
+TEST_F(L3ObserverTest, ModifyDownKeepsPlaceAndRepriceMovesToTheBack) {
+    const OrderID first = submit(OrderSide::SELL, Price{200}, Qty{10});
+    const OrderID second = submit(OrderSide::SELL, Price{200}, Qty{10});
+    const OrderID third = submit(OrderSide::SELL, Price{201}, Qty{10});
+
+    engine->modifyOrder(ClientID{1}, first, Qty{4}, Price{200});
+    observer->drainQueue();
+    checkBooks();
+    EXPECT_EQ(observer->qtyAhead(second), Qty{4});
+
+    const ModifyResult moved =
+        engine->modifyOrder(ClientID{1}, third, Qty{10}, Price{200});
+    observer->drainQueue();
+    ids_.push_back(moved.newOrderID);
+    checkBooks();
+    EXPECT_EQ(observer->findOrder(third), nullptr);
+    EXPECT_EQ(observer->qtyAhead(moved.newOrderID), Qty{14});
+}
+
+TEST_F(L3ObserverTest, ForwardsUpdatesAndKeepsTheEngineUnblocked) {
+    // far more events than the ring holds, drained as they come
+    std::vector<OrderID> ids;
+    for (std::uint64_t i = 0; i < 3000; ++i) {
+        ids.push_back(submit(OrderSide::BUY, Price{100 + i % 50}, Qty{1}));
+    }
+    for (OrderID id : ids) {
+        engine->cancelOrder(ClientID{1}, id);
+        observer->drainQueue();
+    }
+    checkBooks();
+    EXPECT_EQ(observer->orderCount(), 0u);
+    EXPECT_TRUE(book.bids.empty());
+
+    std::size_t forwarded = 0;
+    for (L3Update update{}; mdQueue.try_pop(update);) {
+        ++forwarded;
+    }
+    EXPECT_EQ(forwarded, mdQueue.capacity());
+}
@@ -0,0 +1,63 @@
+#include "utils/types.hpp"
+
+#include <gtest/gtest.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Levels = std::vector<std::pair<Price, Qty>>;
+
+constexpr utils::PriceLadderConfig kConfig{.referencePrice = 100, .ticks = 20};
+
+} // namespace
+
+TEST(Level2OrderBookTest, MergesQtyAtAPriceAndListsBestFirst) {
+    Level2OrderBook book(kConfig);
+    book.add(OrderSide::BUY, Price{98}, Qty{5});
+    book.add(OrderSide::BUY, Price{99}, Qty{10});
+    book.add(OrderSide::BUY, Price{98}, Qty{7});
+    book.add(OrderSide::SELL, Price{102}, Qty{3});
+    book.add(OrderSide::SELL, Price{101}, Qty{4});
+
+    EXPECT_EQ(book.depth(OrderSide::BUY),
+              (Levels{{Price{99}, Qty{10}}, {Price{98}, Qty{12}}}));
+    EXPECT_EQ(book.depth(OrderSide::SELL),
+              (Levels{{Price{101}, Qty{4}}, {Price{102}, Qty{3}}}));
+    EXPECT_EQ(book.depth(OrderSide::SELL, 1), (Levels{{Price{101}, Qty{4}}}));
+    EXPECT_EQ(book.qtyAt(OrderSide::BUY, Price{98}), Qty{12});
+    EXPECT_EQ(book.levelCount(OrderSide::BUY), 2u);
+}
+
+TEST(Level2OrderBookTest, ReduceRemovesALevelOnceNothingIsLeft) {
+    Level2OrderBook book(kConfig);
+    book.add(OrderSide::SELL, Price{101}, Qty{10});
+    book.add(OrderSide::SELL, Price{103}, Qty{10});
+
+    EXPECT_TRUE(book.reduce(OrderSide::SELL, Price{101}, Qty{4}));
+    EXPECT_EQ(book.qtyAt(OrderSide::SELL, Price{101}), Qty{6});
+
+    EXPECT_TRUE(book.reduce(OrderSide::SELL, Price{101}, Qty{6}));
+    EXPECT_EQ(book.depth(OrderSide::SELL), (Levels{{Price{103}, Qty{10}}}));
+
+    EXPECT_FALSE(book.reduce(OrderSide::SELL, Price{101}, Qty{1}));
+    EXPECT_FALSE(book.reduce(OrderSide::BUY, Price{103}, Qty{1}));
+    EXPECT_EQ(book.qtyAt(OrderSide::SELL, Price{101}), Qty{0});
+}
+
+TEST(Level2OrderBookTest, KeepsPricesOutsideTheTickWindowInOrder) {
+    Level2OrderBook book(kConfig);
+    book.add(OrderSide::BUY, Price{95}, Qty{1});
+    book.add(OrderSide::BUY, Price{500}, Qty{2});
+    book.add(OrderSide::BUY, Price{10}, Qty{3});
+
+    EXPECT_EQ(book.depth(OrderSide::BUY),
+              (Levels{{Price{500}, Qty{2}}, {Price{95}, Qty{1}}, {Price{10}, Qty{3}}}));
+
+    EXPECT_TRUE(book.reduce(OrderSide::BUY, Price{500}, Qty{2}));
+    EXPECT_EQ(book.depth(OrderSide::BUY, 1), (Levels{{Price{95}, Qty{1}}}));
+
+    book.clear();
+    EXPECT_EQ(book.levelCount(OrderSide::BUY), 0u);
+    EXPECT_TRUE(book.depth(OrderSide::SELL).empty());
+}
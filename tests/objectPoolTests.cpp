@@ -0,0 +1,127 @@
+#include "utils/objectPool.hpp"
+
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Widget {
+    std::uint64_t a;
+    std::uint64_t b;
+};
+
+using WidgetPool = utils::ObjectPool<Widget>;
+using WidgetHandle = utils::PoolHandle<Widget>;
+
+} // namespace
+
+TEST(ObjectPoolTest, SlotsAreCacheLineAligned) {
+    WidgetPool pool(utils::ObjectPoolConfig{.initialCapacity = 4});
+    EXPECT_EQ(WidgetPool::slotSize() % 64, 0);
+
+    std::vector<WidgetHandle> handles;
+    for (int i = 0; i < 4; ++i) {
+        handles.push_back(pool.make(Widget{1, 2}));
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(handles.back().get()) % 64, 0);
+    }
+}
+
+TEST(ObjectPoolTest, HandleReturnsSlotOnDestruction) {
+    WidgetPool pool(utils::ObjectPoolConfig{.initialCapacity = 2});
+
+    Widget* first = nullptr;
+    {
+        WidgetHandle h = pool.make(Widget{7, 8});
+        first = h.get();
+        EXPECT_EQ(h->a, 7);
+        EXPECT_EQ(pool.stats().inUse, 1);
+    }
+    EXPECT_EQ(pool.stats().inUse, 0);
+
+    // LIFO freelist, the slot that was just freed comes back first
+    WidgetHandle again = pool.make(Widget{9, 9});
+    EXPECT_EQ(again.get(), first);
+}
+
+TEST(ObjectPoolTest, MovedFromHandleDoesNotRelease) {
+    WidgetPool pool(utils::ObjectPoolConfig{.initialCapacity = 2});
+
+    WidgetHandle a = pool.make(Widget{1, 1});
+    WidgetHandle b = std::move(a);
+    EXPECT_FALSE(a);
+    EXPECT_TRUE(b);
+    EXPECT_EQ(pool.stats().inUse, 1);
+
+    b.reset();
+    EXPECT_EQ(pool.stats().inUse, 0);
+}
+
+TEST(ObjectPoolTest, ReleaseAfterHandleRelease) {
+    WidgetPool pool(utils::ObjectPoolConfig{.initialCapacity = 2});
+
+    WidgetHandle h = pool.make(Widget{1, 1});
+    Widget* raw = h.release();
+    EXPECT_FALSE(h);
+    EXPECT_EQ(pool.stats().inUse, 1);
+
+    pool.release(raw);
+    EXPECT_EQ(pool.stats().inUse, 0);
+}
+
+TEST(ObjectPoolTest, DoublesWhenExhausted) {
+    WidgetPool pool(utils::ObjectPoolConfig{.initialCapacity = 4});
+
+    std::vector<WidgetHandle> handles;
+    std::set<Widget*> distinct;
+    for (int i = 0; i < 9; ++i) {
+        handles.push_back(pool.make(Widget{}));
+        distinct.insert(handles.back().get());
+    }
+
+    EXPECT_EQ(distinct.size(), 9);
+    EXPECT_EQ(pool.stats().capacity, 16); // 4 -> 8 -> 16
+    EXPECT_EQ(pool.stats().chunks, 3);
+    EXPECT_EQ(pool.stats().highWaterMark, 9);
+
+    handles.clear();
+    EXPECT_EQ(pool.stats().inUse, 0);
+    EXPECT_EQ(pool.stats().highWaterMark, 9);
+    EXPECT_EQ(pool.stats().acquired, 9);
+}
+
+TEST(ObjectPoolTest, FixedGrowthAndCap) {
+    WidgetPool pool(
+        utils::ObjectPoolConfig{.initialCapacity = 2, .growBy = 3, .maxCapacity = 6});
+
+    std::vector<WidgetHandle> handles;
+    for (int i = 0; i < 6; ++i) {
+        handles.push_back(pool.make(Widget{}));
+        ASSERT_TRUE(handles.back());
+    }
+    EXPECT_EQ(pool.stats().capacity, 6); // 2 + 3 + 1 (clamped to the cap)
+
+    WidgetHandle overflow = pool.make(Widget{});
+    EXPECT_FALSE(overflow);
+    EXPECT_EQ(pool.stats().inUse, 6);
+
+    handles.pop_back();
+    EXPECT_TRUE(pool.make(Widget{}));
+}
+
+TEST(ObjectPoolTest, InitialCapacityIsClampedToTheCap) {
+    utils::ObjectPool<Widget> pool(
+        utils::ObjectPoolConfig{.initialCapacity = 8, .growBy = 4, .maxCapacity = 5});
+    EXPECT_EQ(pool.stats().capacity, 5);
+
+    std::vector<WidgetHandle> handles;
+    for (int i = 0; i < 5; ++i) {
+        handles.push_back(pool.make(Widget{}));
+        ASSERT_TRUE(handles.back());
+    }
+    EXPECT_FALSE(pool.make(Widget{}));
+    EXPECT_EQ(pool.stats().capacity, 5);
+    EXPECT_EQ(pool.stats().chunks, 1);
+}
@@ -0,0 +1,79 @@
+#include "utils/occupancyBitmap.hpp"
+
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+
+using utils::OccupancyBitmap;
+
+TEST(OccupancyBitmapTest, EmptyHasNoNext) {
+    OccupancyBitmap bitmap(4096);
+    EXPECT_FALSE(bitmap.any());
+    EXPECT_EQ(bitmap.findNext(0), OccupancyBitmap::npos);
+    EXPECT_EQ(bitmap.findNext(5000), OccupancyBitmap::npos);
+}
+
+TEST(OccupancyBitmapTest, FindsNextAcrossWordsAndLevels) {
+    OccupancyBitmap bitmap(300'000); // three levels
+    bitmap.set(3);
+    bitmap.set(64);
+    bitmap.set(4095);
+    bitmap.set(4096);
+    bitmap.set(299'999);
+
+    EXPECT_EQ(bitmap.findNext(0), 3);
+    EXPECT_EQ(bitmap.findNext(3), 3);
+    EXPECT_EQ(bitmap.findNext(4), 64);
+    EXPECT_EQ(bitmap.findNext(65), 4095);
+    EXPECT_EQ(bitmap.findNext(4096), 4096);
+    EXPECT_EQ(bitmap.findNext(4097), 299'999);
+    EXPECT_EQ(bitmap.findNext(300'000), OccupancyBitmap::npos);
+}
+
+TEST(OccupancyBitmapTest, ResetClearsSummaryBits) {
+    OccupancyBitmap bitmap(8192);
+    bitmap.set(100);
+    bitmap.set(5000);
+
+    bitmap.reset(100);
+    EXPECT_FALSE(bitmap.test(100));
+    EXPECT_EQ(bitmap.findNext(0), 5000);
+
+    bitmap.reset(5000);
+    EXPECT_FALSE(bitmap.any());
+    EXPECT_EQ(bitmap.findNext(0), OccupancyBitmap::npos);
+}
+
+TEST(OccupancyBitmapTest, ResetKeepsNeighboursInTheSameWord) {
+    OccupancyBitmap bitmap(128);
+    bitmap.set(10);
+    bitmap.set(11);
+    bitmap.reset(10);
+
+    EXPECT_TRUE(bitmap.any());
+    EXPECT_EQ(bitmap.findNext(0), 11);
+}
+
+TEST(OccupancyBitmapTest, MatchesStdSet) {
+    constexpr std::size_t kSize = 70'000;
+    OccupancyBitmap bitmap(kSize);
+    std::set<std::size_t> reference;
+
+    std::mt19937_64 rng(9);
+    for (int step = 0; step < 20'000; ++step) {
+        std::size_t pos = rng() % kSize;
+        if (rng() % 2) {
+            bitmap.set(pos);
+            reference.insert(pos);
+        } else {
+            bitmap.reset(pos);
+            reference.erase(pos);
+        }
+
+        std::size_t from = rng() % kSize;
+        auto it = reference.lower_bound(from);
+        const std::size_t expected = it == reference.end() ? OccupancyBitmap::npos : *it;
+        EXPECT_EQ(bitmap.findNext(from), expected);
+    }
+}
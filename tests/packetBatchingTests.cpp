@@ -0,0 +1,256 @@
+#include "client/mdReceiver.hpp"
+#include "market-data/MDPublisher.hpp"
+#include "market-data/bookEvent.hpp"
+#include "market-data/packetBuilder.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr std::uint16_t kTestPort = 9104;
+
+L2OrderBookUpdate makeUpdate(OrderSide side, BookUpdateEventType type, Price price,
+                             Qty amount) {
+    L2OrderBookUpdate update{};
+    update.side = side;
+    update.type = type;
+    update.price = price;
+    update.amount = amount;
+    return update;
+}
+
+} // namespace
+
+TEST(PacketBuilderTest, AppendsWholeMessagesUpToTheCapacity) {
+    market_data::PacketBuilder packet(100);
+    const std::array<std::byte, 40> message{std::byte{1}};
+
+    EXPECT_TRUE(packet.empty());
+    EXPECT_TRUE(packet.append(message));
+    EXPECT_TRUE(packet.append(message));
+    EXPECT_FALSE(packet.append(message));
+    EXPECT_EQ(packet.size(), 80u);
+    EXPECT_EQ(packet.messageCount(), 2u);
+    EXPECT_EQ(packet.data()[40], std::byte{1});
+
+    packet.clear();
+    EXPECT_TRUE(packet.empty());
+    EXPECT_EQ(packet.messageCount(), 0u);
+}
+
+// ring -> MarketDataPublisher -> loopback multicast -> MDReceiver, the receiver walks
+// every message of a datagram. Parametrized on the mtu and on the datagrams a send
+// call takes.
+class PacketBatchingTest
+    : public ::testing::TestWithParam<std::tuple<std::size_t, std::size_t>> {
+protected:
+    void SetUp() override {
+        try {
+            receiver = std::make_unique<MDReceiver>(MDConfig{.port = kTestPort});
+            receiver->initialize();
+            publisher = std::make_unique<market_data::MarketDataPublisher>(
+                &queue, utils::PriceLadderConfig{}, InstrumentID{1},
+                market_data::PublisherConfig{
+                    .packing = {.mtu = std::get<0>(GetParam())},
+                    .transport = {.port = kTestPort, .batch = std::get<1>(GetParam())}});
+        } catch (const std::exception& e) {
+            GTEST_SKIP() << "no loopback multicast: " << e.what();
+        }
+    }
+
+    void push(const L2OrderBookUpdate& update) {
+        if (update.type == BookUpdateEventType::REDUCE) {
+            book.reduce(update.side, update.price, update.amount);
+        } else {
+            book.add(update.side, update.price, update.amount);
+        }
+        ASSERT_TRUE(queue.try_push(update));
+    }
+
+    // reads the datagrams sent since the last call
+    void receiveAll() {
+        std::uint64_t expected = publisher->packetCount() - received_;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (expected > 0 && std::chrono::steady_clock::now() < deadline) {
+            if (receiver->receiveOne()) {
+                --expected;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        ASSERT_EQ(expected, 0u) << "datagrams did not arrive";
+        received_ = publisher->packetCount();
+    }
+
+    Level2OrderBook book;
+    utils::spsc_queue<L2OrderBookUpdate> queue{1024};
+    std::unique_ptr<MDReceiver> receiver;
+    std::unique_ptr<market_data::MarketDataPublisher> publisher;
+
+private:
+    std::uint64_t received_{0};
+};
+
+TEST_P(PacketBatchingTest, ReceiverAppliesEveryMessageOfAPacket) {
+    push(makeUpdate(OrderSide::BUY, BookUpdateEventType::ADD, Price{99}, Qty{10}));
+    publisher->publishDelta();
+    publisher->publishSnapshot();
+    receiveAll();
+    ASSERT_TRUE(receiver->isBookValid());
+
+    // a few drains, so that one datagram per update still fits in the socket buffer
+    constexpr std::size_t kDrains = 7;
+    constexpr std::size_t kUpdates = 100;
+    for (std::size_t drain = 0; drain < kDrains; ++drain) {
+        for (std::uint64_t i = 0; i < kUpdates; ++i) {
+            const bool buy = i % 2 == 0;
+            push(makeUpdate(buy ? OrderSide::BUY : OrderSide::SELL,
+                            BookUpdateEventType::ADD,
+                            Price{buy ? 99 - i % 10 : 101 + i % 10}, Qty{1 + drain}));
+        }
+        EXPECT_EQ(publisher->publishDelta(), kUpdates);
+        receiveAll();
+    }
+
+    EXPECT_TRUE(receiver->isBookValid());
+    EXPECT_EQ(receiver->getOrderBook().depth(OrderSide::BUY), book.depth(OrderSide::BUY));
+    EXPECT_EQ(receiver->getOrderBook().depth(OrderSide::SELL),
+              book.depth(OrderSide::SELL));
+
+    // the first delta and the snapshot went out on their own, then 35 deltas a packet
+    const std::size_t perPacket = std::get<0>(GetParam()) == 0 ? 1 : 35;
+    const std::size_t packetsPerDrain = (kUpdates + perPacket - 1) / perPacket;
+    EXPECT_EQ(publisher->packetCount(), 2 + kDrains * packetsPerDrain);
+
+    // the packets of a drain leave together, batch at a time
+    const std::size_t batch = std::get<1>(GetParam());
+    EXPECT_EQ(publisher->syscallCount(),
+              2 + kDrains * ((packetsPerDrain + batch - 1) / batch));
+}
+
+TEST_P(PacketBatchingTest, PollBatchAppliesTheMessagesOfSeveralDatagrams) {
+    push(makeUpdate(OrderSide::BUY, BookUpdateEventType::ADD, Price{99}, Qty{10}));
+    publisher->publishDelta();
+    publisher->publishSnapshot();
+
+    constexpr std::size_t kUpdates = 200;
+    for (std::uint64_t i = 0; i < kUpdates; ++i) {
+        const bool buy = i % 2 == 0;
+        push(makeUpdate(buy ? OrderSide::BUY : OrderSide::SELL,
+                        BookUpdateEventType::ADD, Price{buy ? 99 - i % 10 : 101 + i % 10},
+                        Qty{1 + i % 3}));
+    }
+    ASSERT_EQ(publisher->publishDelta(), kUpdates);
+
+    // the first delta, the snapshot and the deltas, MDConfig::batch datagrams a poll
+    std::size_t expected = kUpdates + 2;
+    std::size_t polls = 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (expected > 0 && std::chrono::steady_clock::now() < deadline) {
+        const std::size_t applied = receiver->pollBatch();
+        if (applied == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_LE(applied, expected);
+        expected -= applied;
+        ++polls;
+    }
+    ASSERT_EQ(expected, 0u) << "messages did not arrive";
+    EXPECT_LT(polls, publisher->packetCount());
+
+    EXPECT_TRUE(receiver->isBookValid());
+    EXPECT_EQ(receiver->getOrderBook().depth(OrderSide::BUY), book.depth(OrderSide::BUY));
+    EXPECT_EQ(receiver->getOrderBook().depth(OrderSide::SELL),
+              book.depth(OrderSide::SELL));
+    EXPECT_EQ(receiver->pollBatch(), 0u);
+}
+
+TEST_P(PacketBatchingTest, SnapshotHoldsOnlyTheDeltasSent) {
+    push(makeUpdate(OrderSide::BUY, BookUpdateEventType::ADD, Price{99}, Qty{10}));
+    publisher->publishDelta();
+    // still in the ring when the snapshot is taken, it reaches the receiver as a delta
+    push(makeUpdate(OrderSide::BUY, BookUpdateEventType::ADD, Price{98}, Qty{5}));
+    push(makeUpdate(OrderSide::BUY, BookUpdateEventType::ADD, Price{99}, Qty{1}));
+    publisher->publishSnapshot();
+    EXPECT_EQ(publisher->book().depth(OrderSide::BUY),
+              (std::vector<std::pair<Price, Qty>>{{Price{99}, Qty{10}}}));
+
+    EXPECT_EQ(publisher->publishDelta(), 2u);
+    receiveAll();
+    EXPECT_TRUE(receiver->isBookValid());
+    EXPECT_EQ(receiver->getOrderBook().depth(OrderSide::BUY), book.depth(OrderSide::BUY));
+    EXPECT_EQ(publisher->book().depth(OrderSide::BUY), book.depth(OrderSide::BUY));
+}
+
+// two instruments publishing to the same group and port, the receiver only applies the
+// one it is set up for and sees no gaps from the other's sequence numbers
+TEST(InstrumentFilterTest, ReceiverSkipsOtherInstruments) {
+    Level2OrderBook books[2];
+    using L2Queue = utils::spsc_queue<L2OrderBookUpdate>;
+    L2Queue queues[2]{L2Queue(64), L2Queue(64)};
+    std::unique_ptr<MDReceiver> receiver;
+    std::unique_ptr<market_data::MarketDataPublisher> publishers[2];
+    try {
+        receiver = std::make_unique<MDReceiver>(
+            MDConfig{.port = kTestPort, .instrumentID = 1});
+        receiver->initialize();
+        for (std::uint32_t i = 0; i < 2; ++i) {
+            publishers[i] = std::make_unique<market_data::MarketDataPublisher>(
+                &queues[i], utils::PriceLadderConfig{}, InstrumentID{i + 1},
+                market_data::PublisherConfig{.transport = {.port = kTestPort}});
+        }
+    } catch (const std::exception& e) {
+        GTEST_SKIP() << "no loopback multicast: " << e.what();
+    }
+    std::size_t gaps = 0;
+    receiver->setOnGapDetected([&](std::uint64_t, std::uint64_t) { ++gaps; });
+
+    for (std::uint32_t i = 0; i < 2; ++i) {
+        publishers[i]->publishSnapshot();
+    }
+    for (std::uint64_t n = 0; n < 20; ++n) {
+        for (std::uint32_t i = 0; i < 2; ++i) {
+            const auto update =
+                makeUpdate(OrderSide::BUY, BookUpdateEventType::ADD,
+                           Price{90 + n % 5 + 10 * i}, Qty{1 + n});
+            books[i].add(update.side, update.price, update.amount);
+            ASSERT_TRUE(queues[i].try_push(update));
+            publishers[i]->publishDelta();
+        }
+    }
+
+    std::uint64_t expected = publishers[0]->packetCount() + publishers[1]->packetCount();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (expected > 0 && std::chrono::steady_clock::now() < deadline) {
+        if (receiver->receiveOne()) {
+            --expected;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    ASSERT_EQ(expected, 0u) << "datagrams did not arrive";
+
+    EXPECT_EQ(gaps, 0u);
+    EXPECT_TRUE(receiver->isBookValid());
+    EXPECT_EQ(receiver->getOrderBook().depth(OrderSide::BUY),
+              books[0].depth(OrderSide::BUY));
+}
+
+INSTANTIATE_TEST_SUITE_P(MtuAndBatch, PacketBatchingTest,
+                         ::testing::Combine(::testing::Values(std::size_t{0},
+                                                              std::size_t{1400}),
+                                            ::testing::Values(std::size_t{1},
+                                                              std::size_t{64})));
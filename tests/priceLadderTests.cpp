@@ -0,0 +1,168 @@
+#include "utils/priceLadder.hpp"
+#include "utils/types.hpp"
+
+#include <deque>
+#include <functional>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+using Level = std::deque<int>;
+using AskLadder = utils::PriceLadder<Price, Level, std::less<Price>>;
+using BidLadder = utils::PriceLadder<Price, Level, std::greater<Price>>;
+
+template <typename Ladder> std::vector<std::uint64_t> prices(const Ladder& ladder) {
+    std::vector<std::uint64_t> out;
+    for (const auto& [price, level] : ladder) {
+        out.push_back(price.value());
+    }
+    return out;
+}
+
+constexpr utils::PriceLadderConfig kConfig{.referencePrice = 100, .ticks = 20};
+
+} // namespace
+
+TEST(PriceLadderTest, EmptyLadder) {
+    AskLadder ladder(kConfig);
+    EXPECT_TRUE(ladder.empty());
+    EXPECT_EQ(ladder.size(), 0);
+    EXPECT_EQ(ladder.begin(), ladder.end());
+}
+
+TEST(PriceLadderTest, AsksIterateLowestFirst) {
+    AskLadder ladder(kConfig);
+    ladder[Price{105}].push_back(1);
+    ladder[Price{95}].push_back(2);
+    ladder[Price{100}].push_back(3);
+
+    EXPECT_EQ(ladder.size(), 3);
+    EXPECT_EQ(ladder.begin()->first, Price{95});
+    EXPECT_EQ(prices(ladder), (std::vector<std::uint64_t>{95, 100, 105}));
+}
+
+TEST(PriceLadderTest, BidsIterateHighestFirst) {
+    BidLadder ladder(kConfig);
+    ladder[Price{105}].push_back(1);
+    ladder[Price{95}].push_back(2);
+    ladder[Price{100}].push_back(3);
+
+    EXPECT_EQ(ladder.begin()->first, Price{105});
+    EXPECT_EQ(prices(ladder), (std::vector<std::uint64_t>{105, 100, 95}));
+}
+
+TEST(PriceLadderTest, OverflowLevelsKeepOrder) {
+    AskLadder asks(kConfig);
+    asks[Price{100}].push_back(1);
+    asks[Price{5}].push_back(2);    // in front of the window
+    asks[Price{5000}].push_back(3); // behind the window
+    asks[Price{4}].push_back(4);
+
+    EXPECT_EQ(asks.overflowSize(), 3);
+    EXPECT_EQ(prices(asks), (std::vector<std::uint64_t>{4, 5, 100, 5000}));
+
+    BidLadder bids(kConfig);
+    bids[Price{100}].push_back(1);
+    bids[Price{5}].push_back(2);
+    bids[Price{5000}].push_back(3);
+
+    EXPECT_EQ(prices(bids), (std::vector<std::uint64_t>{5000, 100, 5}));
+}
+
+TEST(PriceLadderTest, EraseBestMovesToNextLevel) {
+    AskLadder ladder(kConfig);
+    ladder[Price{99}].push_back(1);
+    ladder[Price{103}].push_back(2);
+    ladder[Price{5000}].push_back(3);
+
+    EXPECT_EQ(ladder.erase(Price{99}), 1);
+    EXPECT_EQ(ladder.begin()->first, Price{103});
+
+    auto it = ladder.erase(ladder.begin());
+    ASSERT_NE(it, ladder.end());
+    EXPECT_EQ(it->first, Price{5000});
+    EXPECT_EQ(ladder.begin()->first, Price{5000});
+
+    ladder.erase(it);
+    EXPECT_TRUE(ladder.empty());
+}
+
+TEST(PriceLadderTest, FindAndEraseMissing) {
+    AskLadder ladder(kConfig);
+    ladder[Price{101}].push_back(1);
+
+    EXPECT_NE(ladder.find(Price{101}), ladder.end());
+    EXPECT_EQ(ladder.find(Price{102}), ladder.end());
+    EXPECT_EQ(ladder.find(Price{9999}), ladder.end());
+    EXPECT_EQ(ladder.erase(Price{102}), 0);
+    EXPECT_EQ(ladder.size(), 1);
+}
+
+TEST(PriceLadderTest, ReinsertedLevelStartsEmpty) {
+    AskLadder ladder(kConfig);
+    ladder[Price{101}].push_back(1);
+    ladder.erase(Price{101});
+
+    EXPECT_TRUE(ladder[Price{101}].empty());
+}
+
+TEST(PriceLadderTest, AnchorsOnFirstInsert) {
+    BidLadder ladder(utils::PriceLadderConfig{.referencePrice = 0, .ticks = 8});
+    ladder[Price{1000}].push_back(1);
+    ladder[Price{1003}].push_back(2);
+    ladder[Price{10}].push_back(3);
+
+    EXPECT_EQ(ladder.overflowSize(), 1);
+    EXPECT_EQ(prices(ladder), (std::vector<std::uint64_t>{1003, 1000, 10}));
+}
+
+TEST(PriceLadderTest, Clear) {
+    AskLadder ladder(kConfig);
+    ladder[Price{101}].push_back(1);
+    ladder[Price{1}].push_back(1);
+    ladder.clear();
+
+    EXPECT_TRUE(ladder.empty());
+    EXPECT_EQ(ladder.begin(), ladder.end());
+    EXPECT_TRUE(ladder[Price{101}].empty());
+}
+
+TEST(PriceLadderTest, TickSizeWidensTheWindow) {
+    const utils::PriceLadderConfig config{
+        .referencePrice = 1'000, .ticks = 20, .tickSize = 10};
+    AskLadder asks(config);
+    BidLadder bids(config);
+    for (std::uint64_t price : {900u, 1'090u, 1'000u, 950u}) {
+        asks[Price{price}].push_back(1);
+        bids[Price{price}].push_back(1);
+    }
+
+    EXPECT_EQ(asks.overflowSize(), 0);
+    EXPECT_EQ(bids.overflowSize(), 0);
+    EXPECT_EQ(prices(asks), (std::vector<std::uint64_t>{900, 950, 1'000, 1'090}));
+    EXPECT_EQ(prices(bids), (std::vector<std::uint64_t>{1'090, 1'000, 950, 900}));
+
+    // one tick past the window
+    asks[Price{1'100}].push_back(2);
+    EXPECT_EQ(asks.overflowSize(), 1);
+    EXPECT_EQ(prices(asks), (std::vector<std::uint64_t>{900, 950, 1'000, 1'090, 1'100}));
+    EXPECT_EQ(asks.erase(Price{950}), 1);
+    EXPECT_EQ(asks.find(Price{950}), asks.end());
+}
+
+TEST(PriceLadderTest, WideGapsInsideTheWindow) {
+    AskLadder ladder(
+        utils::PriceLadderConfig{.referencePrice = 100'000, .ticks = 1 << 17});
+    ladder[Price{60'000}].push_back(1);
+    ladder[Price{99'000}].push_back(2);
+    ladder[Price{150'000}].push_back(3);
+
+    EXPECT_EQ(ladder.overflowSize(), 0);
+    EXPECT_EQ(prices(ladder), (std::vector<std::uint64_t>{60'000, 99'000, 150'000}));
+
+    ladder.erase(ladder.begin());
+    EXPECT_EQ(ladder.begin()->first, Price{99'000});
+    ladder.erase(ladder.begin());
+    EXPECT_EQ(ladder.begin()->first, Price{150'000});
+}
@@ -158,6 +158,11 @@ TEST(ClientPayloadLayout, ModifyOrderPayload_Layout) {
     expectStandardPackedLayout(payload);
 }
 
+TEST(ClientPayloadLayout, MassCancelPayload_Layout) {
+    client::MassCancelPayload payload{};
+    expectStandardPackedLayout(payload);
+}
+
 TEST(ServerPayloadLayout, HelloAckPayload_Layout) {
     server::HelloAckPayload payload{};
     expectStandardPackedLayout(payload);
@@ -187,3 +192,8 @@ TEST(ServerPayloadLayout, TradePayload_Layout) {
     server::TradePayload payload{};
     expectStandardPackedLayout(payload);
 }
+
+TEST(ServerPayloadLayout, MassCancelAckPayload_Layout) {
+    server::MassCancelAckPayload payload{};
+    expectStandardPackedLayout(payload);
+}
@@ -0,0 +1,175 @@
+#include "market-data/bookEvent.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/types.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <memory>
+#include <new>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace {
+
+L2OrderBookUpdate update(std::uint64_t price) {
+    L2OrderBookUpdate update{};
+    update.price = Price{price};
+    update.amount = Qty{1};
+    return update;
+}
+
+// spsc_queue_shm expects its buffer right behind the object, as in a SharedRegion
+class ShmQueue {
+public:
+    explicit ShmQueue(std::size_t capacity)
+        : memory_(new (std::align_val_t{64}) std::byte[sizeof(Queue) +
+                                                        sizeof(L2OrderBookUpdate) *
+                                                            std::bit_ceil(capacity + 1)]),
+          queue_(new (memory_) Queue(capacity)) {}
+    ~ShmQueue() {
+        queue_->~Queue();
+        ::operator delete[](memory_, std::align_val_t{64});
+    }
+
+    auto* operator->() { return queue_; }
+
+private:
+    using Queue = utils::spsc_queue_shm<L2OrderBookUpdate>;
+    std::byte* memory_;
+    Queue* queue_;
+};
+
+} // namespace
+
+TEST(SpscQueueTest, ReportsFullAtCapacity) {
+    utils::spsc_queue<int> queue(8);
+    ASSERT_EQ(queue.capacity(), 7u);
+
+    for (int i = 0; i < 7; ++i) {
+        EXPECT_TRUE(queue.try_push(i));
+    }
+    EXPECT_TRUE(queue.full());
+    EXPECT_FALSE(queue.try_push(7));
+    EXPECT_FALSE(queue.try_emplace(7));
+
+    int value = -1;
+    ASSERT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(queue.try_push(7));
+    EXPECT_FALSE(queue.try_push(8));
+}
+
+TEST(SpscQueueTest, BulkPushStopsAtFreeSlotsAndWraps) {
+    utils::spsc_queue<int> queue(8);
+    const std::array<int, 10> items{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+    EXPECT_EQ(queue.try_push_n(std::span(items).first(5)), 5u);
+    std::array<int, 4> out{};
+    EXPECT_EQ(queue.try_pop_n(out), 4u);
+    EXPECT_EQ(out, (std::array<int, 4>{0, 1, 2, 3}));
+
+    // one item left at slot 4, six more fit and wrap around the end of the buffer
+    EXPECT_EQ(queue.try_push_n(std::span(items).subspan(5)), 5u);
+    EXPECT_EQ(queue.try_push_n(items), 1u);
+    EXPECT_EQ(queue.try_push_n(items), 0u);
+
+    std::array<int, 10> all{};
+    EXPECT_EQ(queue.try_pop_n(all), 7u);
+    EXPECT_EQ(std::vector<int>(all.begin(), all.begin() + 7),
+              (std::vector<int>{4, 5, 6, 7, 8, 9, 0}));
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.try_pop_n(all), 0u);
+}
+
+TEST(SpscQueueTest, PeekStopsAtTheEndOfTheBuffer) {
+    utils::spsc_queue<int> queue(8);
+    const std::array<int, 6> items{0, 1, 2, 3, 4, 5};
+    ASSERT_EQ(queue.try_push_n(items), 6u);
+    std::array<int, 6> out{};
+    ASSERT_EQ(queue.try_pop_n(out), 6u);
+    ASSERT_EQ(queue.try_push_n(items), 6u);
+
+    auto first = queue.peek();
+    ASSERT_EQ(first.size(), 2u);
+    EXPECT_EQ(first[0], 0);
+    EXPECT_EQ(first[1], 1);
+    // nothing is released before commit()
+    EXPECT_EQ(queue.peek().size(), 2u);
+    queue.commit(first.size());
+
+    auto second = queue.peek();
+    ASSERT_EQ(second.size(), 4u);
+    EXPECT_EQ(second[3], 5);
+    queue.commit(1);
+    EXPECT_EQ(queue.peek().size(), 3u);
+    EXPECT_EQ(queue.peek()[0], 3);
+}
+
+TEST(SpscQueueTest, ShmQueueBulkRoundTrip) {
+    ShmQueue queue(6);
+    ASSERT_EQ(queue->capacity(), 7u);
+
+    std::vector<L2OrderBookUpdate> items;
+    for (std::uint64_t price = 1; price <= 9; ++price) {
+        items.push_back(update(price));
+    }
+    EXPECT_EQ(queue->try_push_n(items), 7u);
+    EXPECT_FALSE(queue->try_push(update(10)));
+
+    std::array<L2OrderBookUpdate, 3> out{};
+    EXPECT_EQ(queue->try_pop_n(out), 3u);
+    EXPECT_EQ(out[2].price, Price{3});
+
+    EXPECT_EQ(queue->try_push_n(std::span(items).subspan(7)), 2u);
+    L2OrderBookUpdate single{};
+    ASSERT_TRUE(queue->try_pop(single));
+    EXPECT_EQ(single.price, Price{4});
+
+    std::vector<std::uint64_t> prices;
+    for (auto ready = queue->peek(); !ready.empty(); ready = queue->peek()) {
+        for (const L2OrderBookUpdate& item : ready) {
+            prices.push_back(item.price.value());
+        }
+        queue->commit(ready.size());
+    }
+    EXPECT_EQ(prices, (std::vector<std::uint64_t>{5, 6, 7, 8, 9}));
+}
+
+TEST(SpscQueueTest, BulkTransferAcrossThreadsKeepsOrder) {
+    constexpr std::uint64_t kItems = 50'000;
+    utils::spsc_queue<std::uint64_t> queue(64);
+
+    std::jthread producer([&queue] {
+        std::array<std::uint64_t, 16> chunk{};
+        for (std::uint64_t next = 0; next < kItems;) {
+            std::size_t count = 0;
+            for (; count < chunk.size() && next + count < kItems; ++count) {
+                chunk[count] = next + count;
+            }
+            const std::size_t pushed = queue.try_push_n(std::span(chunk).first(count));
+            if (pushed == 0) {
+                std::this_thread::yield();
+            }
+            next += pushed;
+        }
+    });
+
+    std::uint64_t expected = 0;
+    bool ordered = true;
+    std::array<std::uint64_t, 24> out{};
+    while (expected < kItems) {
+        const std::size_t count = queue.try_pop_n(out);
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            ordered = ordered && out[i] == expected++;
+        }
+    }
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(queue.empty());
+}
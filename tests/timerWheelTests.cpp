@@ -0,0 +1,161 @@
+#include "utils/timerWheel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Timer {
+    std::uint64_t deadline{0};
+    utils::TimerHook<Timer> hook{};
+};
+
+using Wheel = utils::TimerWheel<Timer>;
+
+std::vector<std::uint64_t> advanceAll(Wheel& wheel, std::uint64_t tick) {
+    std::vector<std::uint64_t> expired;
+    wheel.advance(
+        tick, [&expired](Timer& timer) { expired.push_back(timer.deadline); },
+        static_cast<std::size_t>(-1));
+    return expired;
+}
+
+} // namespace
+
+TEST(TimerWheelTest, ExpiresAtTheDeadline) {
+    Wheel wheel(100);
+    Timer a{.deadline = 105};
+    Timer b{.deadline = 400};
+    wheel.schedule(a.hook, &a, a.deadline);
+    wheel.schedule(b.hook, &b, b.deadline);
+
+    EXPECT_TRUE(advanceAll(wheel, 104).empty());
+    EXPECT_EQ(advanceAll(wheel, 105), std::vector<std::uint64_t>{105});
+    EXPECT_FALSE(a.hook.linked());
+    EXPECT_TRUE(advanceAll(wheel, 399).empty());
+    EXPECT_EQ(advanceAll(wheel, 1000), std::vector<std::uint64_t>{400});
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, PastDeadlineIsDueRightAway) {
+    Wheel wheel(50);
+    Timer late{.deadline = 10};
+    wheel.schedule(late.hook, &late, late.deadline);
+
+    EXPECT_TRUE(wheel.pending(50));
+    EXPECT_EQ(advanceAll(wheel, 50), std::vector<std::uint64_t>{10});
+}
+
+TEST(TimerWheelTest, CancelledTimersDoNotFire) {
+    Wheel wheel;
+    Timer a{.deadline = 70'000};
+    Timer b{.deadline = 70'001};
+    wheel.schedule(a.hook, &a, a.deadline);
+    wheel.schedule(b.hook, &b, b.deadline);
+
+    wheel.cancel(a.hook);
+    wheel.cancel(a.hook); // unlinked, no-op
+    EXPECT_EQ(wheel.size(), 1);
+    EXPECT_EQ(advanceAll(wheel, 80'000), std::vector<std::uint64_t>{70'001});
+}
+
+TEST(TimerWheelTest, DeadlinesPastTheHorizon) {
+    Wheel wheel(0);
+    Timer far{.deadline = (std::uint64_t{1} << 40) + 3};
+    Timer near{.deadline = 1'000};
+    wheel.schedule(far.hook, &far, far.deadline);
+    wheel.schedule(near.hook, &near, near.deadline);
+
+    EXPECT_EQ(advanceAll(wheel, 1 << 20), std::vector<std::uint64_t>{1'000});
+    EXPECT_TRUE(advanceAll(wheel, far.deadline - 1).empty());
+    EXPECT_EQ(advanceAll(wheel, far.deadline), std::vector<std::uint64_t>{far.deadline});
+}
+
+TEST(TimerWheelTest, FarDeadlinesStayPutWithinTheHorizon) {
+    Wheel wheel(0);
+    Timer far{.deadline = (std::uint64_t{1} << 40) + 3};
+    wheel.schedule(far.hook, &far, far.deadline);
+
+    // no step budget at all: jumps inside the horizon have nothing to re-place
+    auto none = [](Timer&) {};
+    for (std::uint64_t tick = 1'000; tick <= 100'000; tick += 1'000) {
+        EXPECT_EQ(wheel.advance(tick, none, 0), 0);
+        EXPECT_FALSE(wheel.pending(tick));
+        EXPECT_EQ(wheel.currentTick(), tick);
+    }
+
+    // crossing the horizon brings the far deadline back for placing
+    const std::uint64_t horizon = std::uint64_t{1} << 32;
+    EXPECT_EQ(wheel.advance(horizon, none, 0), 0);
+    EXPECT_TRUE(wheel.pending(horizon));
+    EXPECT_TRUE(advanceAll(wheel, horizon).empty());
+    EXPECT_EQ(advanceAll(wheel, far.deadline), std::vector<std::uint64_t>{far.deadline});
+}
+
+TEST(TimerWheelTest, BatchesAreBoundedAndResumable) {
+    Wheel wheel;
+    std::vector<Timer> timers(300);
+    for (auto& timer : timers) {
+        timer.deadline = 5'000;
+        wheel.schedule(timer.hook, &timer, timer.deadline);
+    }
+
+    // moving the bucket down a level counts against the limit as well
+    std::size_t total = 0;
+    std::size_t calls = 0;
+    auto count = [&total](Timer&) { ++total; };
+    while (wheel.pending(6'000)) {
+        EXPECT_LE(wheel.advance(6'000, count, 128), 128);
+        ++calls;
+    }
+    EXPECT_EQ(total, 300);
+    EXPECT_EQ(calls, 5); // 300 moves and 300 expiries
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, MatchesOrderedReference) {
+    constexpr std::size_t kTimers = 5'000;
+    std::mt19937_64 rng(11);
+
+    Wheel wheel(1'000);
+    std::vector<Timer> timers(kTimers);
+    std::multimap<std::uint64_t, Timer*> reference;
+
+    for (auto& timer : timers) {
+        // spread over every level and a few past the horizon
+        const int shift = static_cast<int>(rng() % 34);
+        timer.deadline = 1'000 + (rng() & ((std::uint64_t{1} << shift) - 1));
+        wheel.schedule(timer.hook, &timer, timer.deadline);
+        reference.emplace(timer.deadline, &timer);
+    }
+    for (std::size_t i = 0; i < kTimers; i += 7) {
+        wheel.cancel(timers[i].hook);
+        auto [first, last] = reference.equal_range(timers[i].deadline);
+        for (auto it = first; it != last; ++it) {
+            if (it->second == &timers[i]) {
+                reference.erase(it);
+                break;
+            }
+        }
+    }
+
+    std::uint64_t tick = 1'000;
+    while (!reference.empty()) {
+        tick += 1 + (rng() % (std::uint64_t{1} << (rng() % 30)));
+        std::vector<std::uint64_t> expected;
+        while (!reference.empty() && reference.begin()->first <= tick) {
+            expected.push_back(reference.begin()->first);
+            reference.erase(reference.begin());
+        }
+
+        auto expired = advanceAll(wheel, tick);
+        std::ranges::sort(expired);
+        ASSERT_EQ(expired, expected) << "tick " << tick;
+    }
+    EXPECT_TRUE(wheel.empty());
+}
@@ -0,0 +1,76 @@
+#include "utils/waitStrategy.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+utils::WaitConfig blocking(std::chrono::microseconds period) {
+    return utils::WaitConfig{.policy = utils::WaitPolicy::BLOCKING,
+                             .spins = 0,
+                             .yields = 0,
+                             .period = period,
+                             .firstPark = period};
+}
+
+} // namespace
+
+TEST(WaitStrategyTest, NotifyWakesAParkedWaiter) {
+    utils::WaitSignal signal;
+    utils::Waiter waiter(blocking(10s), &signal);
+    std::atomic<bool> ready{false};
+
+    std::jthread producer([&] {
+        std::this_thread::sleep_for(20ms);
+        ready.store(true, std::memory_order_release);
+        signal.notify();
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    while (!ready.load(std::memory_order_acquire)) {
+        waiter.idle([&] { return ready.load(std::memory_order_acquire); });
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+}
+
+TEST(WaitStrategyTest, DoesNotParkWhenWorkArrivedBeforeTheLastCheck) {
+    utils::WaitSignal signal;
+    utils::Waiter waiter(blocking(10s), &signal);
+
+    const auto start = std::chrono::steady_clock::now();
+    waiter.idle([] { return true; });
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+}
+
+TEST(WaitStrategyTest, BlockingWithoutSignalBacksOffToThePeriod) {
+    utils::Waiter waiter(utils::WaitConfig{.policy = utils::WaitPolicy::BLOCKING,
+                                           .spins = 0,
+                                           .yields = 0,
+                                           .period = 2ms,
+                                           .firstPark = 1ms});
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; ++i) {
+        waiter.idle();
+    }
+    // 1ms, then 2ms twice
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 5ms);
+
+    waiter.reset();
+    const auto afterReset = std::chrono::steady_clock::now();
+    waiter.idle();
+    EXPECT_GE(std::chrono::steady_clock::now() - afterReset, 1ms);
+}
+
+TEST(WaitStrategyTest, TimedSleepsThePeriod) {
+    utils::Waiter waiter(
+        utils::WaitConfig{.policy = utils::WaitPolicy::TIMED, .period = 3ms});
+
+    const auto start = std::chrono::steady_clock::now();
+    waiter.idle();
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 3ms);
+}